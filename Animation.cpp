@@ -3,6 +3,7 @@
 #include "Images.h"
 #include "SafeRelease.h"
 #include "HRException.h"
+#include "AssetPack.h"
 
 namespace Ice2D
 {
@@ -67,6 +68,16 @@ namespace Ice2D
         m_frameDelta = std::chrono::nanoseconds(1'000'000'000 / frameRate);
     }
 
+    unsigned int IBasicAnimation::GetFrameCount() const
+    {
+        return m_frameCount;
+    }
+
+    unsigned int IBasicAnimation::GetCurrentFrame() const
+    {
+        return m_currentFrame;
+    }
+
     ImageSequence::ImageSequence() : m_pFrames(nullptr)
     {
     }
@@ -112,13 +123,7 @@ namespace Ice2D
         m_pFrames = new ID2D1Bitmap*[frameCount];
         for (unsigned int i = 0; i < frameCount; ++i)
         {
-            auto pSource = GetSourceFromFile(arr_paths[i]);
-            D2D1_BITMAP_PROPERTIES bitmapProperties = {};
-            bitmapProperties.pixelFormat = { DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED };
-            HRESULT hr =
-                m_pManager->GetRenderTarget()->CreateBitmapFromWicBitmap(pSource, &bitmapProperties, m_pFrames + i);
-            CheckHR(hr);
-            SafeRelease(pSource);
+            m_pFrames[i] = GetBitmapFromFile(arr_paths[i]);
         }
 
         auto size = m_pFrames[0]->GetSize();
@@ -132,7 +137,7 @@ namespace Ice2D
         IBasicAnimation(other), m_pFrames(other.m_pFrames)
     {
         other.m_pFrames = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     ImageSequence& ImageSequence::operator=(ImageSequence&& other) noexcept
@@ -152,7 +157,7 @@ namespace Ice2D
 		m_frameDelta = other.m_frameDelta;
 		m_currentFrame = other.m_currentFrame;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -180,6 +185,13 @@ namespace Ice2D
         return m_pFrames[m_currentFrame];
     }
 
+    ID2D1Bitmap* ImageSequence::GetFrame(unsigned int index) const
+    {
+        if (!m_pFrames) throw std::runtime_error("Image sequence is null.");
+        if (index >= m_frameCount) throw std::out_of_range("Frame index out of range.");
+        return m_pFrames[index];
+    }
+
     AnimationSheet::AnimationSheet() : m_pSheet(nullptr), 
         m_rows(0u), m_cols(0u), m_spriteWidth(0u), m_spriteHeight(0u)
     {
@@ -205,13 +217,7 @@ namespace Ice2D
         unsigned int rows, unsigned int cols, unsigned int frameCount, unsigned int frameRate) :
         IBasicAnimation(pManager, frameCount, frameRate), m_rows(rows), m_cols(cols)
     {
-        auto pSource = GetSourceFromFile(path);
-        D2D1_BITMAP_PROPERTIES bitmapProperties = {};
-        bitmapProperties.pixelFormat = { DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED };
-        HRESULT hr =
-            m_pManager->GetRenderTarget()->CreateBitmapFromWicBitmap(pSource, &bitmapProperties, &m_pSheet);
-        CheckHR(hr);
-        SafeRelease(pSource);
+        m_pSheet = GetBitmapFromFile(path);
 
         auto size = m_pSheet->GetSize();
         m_width = (unsigned int)size.width;
@@ -222,12 +228,31 @@ namespace Ice2D
         OnLoad();
     }
 
+    AnimationSheet::AnimationSheet(ResourceManager* pManager, const AssetPack& pack, const char* name) :
+        IBasicAnimation(pManager, 1u, 1u), m_rows(0u), m_cols(0u)
+    {
+        // The layout comes from the pack, the sheet is uploaded straight from its mapping
+        AssetPack::SheetData sheet = pack.GetSheet(name);
+        m_frameCount = sheet.frameCount;
+        SetFrameRate(sheet.frameRate);
+        m_rows = sheet.rows;
+        m_cols = sheet.cols;
+        m_pSheet = GetBitmapFromMemory(sheet.image.width, sheet.image.height, sheet.image.pPixels, sheet.image.stride);
+
+        m_width = sheet.image.width;
+        m_height = sheet.image.height;
+        m_spriteWidth = m_width / m_cols;
+        m_spriteHeight = m_height / m_rows;
+
+        OnLoad();
+    }
+
     AnimationSheet::AnimationSheet(AnimationSheet&& other) noexcept : IBasicAnimation(other),
         m_pSheet(other.m_pSheet), m_rows(other.m_rows), m_cols(other.m_cols),
         m_spriteWidth(other.m_spriteWidth), m_spriteHeight(other.m_spriteHeight)
     {
         other.m_pSheet = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     AnimationSheet& AnimationSheet::operator=(AnimationSheet&& other) noexcept
@@ -252,7 +277,7 @@ namespace Ice2D
         m_rows = other.m_rows;
         m_cols = other.m_cols;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
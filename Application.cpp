@@ -2,12 +2,27 @@
 
 #include "Application.h"
 #include "HRException.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 
 Ice2D::Application::Application(HINSTANCE hInstance, 
 	const unsigned int clientWidth, const unsigned int clientHeight, 
 	LPCWSTR title, const DWORD windowStyle, const int nCmdShow) : 
 	Graphics(hInstance, clientWidth, clientHeight, title, windowStyle, nCmdShow),
-	manager(GetRT()), deltaTime(), currentTime()
+	manager(GetRT()), deltaTime(), currentTime(), interpolationAlpha(1.0f), idle(false),
+	m_fixedStep(false), m_waitWhenIdle(false), m_setupDone(false), m_loadBudget(2000), m_headlessFrames(0u),
+	m_headlessFrameTime(std::chrono::microseconds(16667))
+{
+}
+
+Ice2D::Application::Application(const unsigned int width, const unsigned int height) :
+	Graphics(width, height),
+	manager(GetRT()), deltaTime(), currentTime(), interpolationAlpha(1.0f), idle(false),
+	m_fixedStep(false), m_waitWhenIdle(false), m_setupDone(false), m_loadBudget(2000), m_headlessFrames(0u),
+	m_headlessFrameTime(std::chrono::microseconds(16667))
 {
 }
 
@@ -19,34 +34,220 @@ int Ice2D::Application::Start()
 {
 	try
 	{
-		Setup();
-		auto prevTime = currentTime = std::chrono::high_resolution_clock::now();
-		while (Ice2D::Window::HandleMessages())
+		RunSetup();
+		currentTime = std::chrono::high_resolution_clock::now();
+		timestep.Reset();
+		pacer.Reset();
+		if (IsHeadless())
+		{
+			// No messages and no pacing, time advances by a fixed step so every run draws the same frames
+			for (unsigned int frame = 0; !m_quitRequested && (m_headlessFrames == 0u || frame < m_headlessFrames);
+				++frame)
+			{
+				ICE2D_PROFILE_FRAME();
+				{
+					ICE2D_PROFILE_SCOPE("PumpLoads");
+					manager.PumpLoads(m_loadBudget);
+				}
+				RunFrame(currentTime + m_headlessFrameTime);
+			}
+			return 0;
+		}
+		while (true)
 		{
-			currentTime = std::chrono::high_resolution_clock::now();
-			deltaTime = currentTime - prevTime;
-			prevTime = currentTime;
+			ICE2D_PROFILE_FRAME();
+			bool running;
+			{
+				ICE2D_PROFILE_SCOPE("HandleMessages");
+				running = Ice2D::Window::HandleMessages();
+			}
+			if (!running) break;
 
-			Update();
-			HRESULT hr = Draw();
-			CheckHR(hr);
+			{
+				// Finish background loads, the budget keeps a burst of completions from causing a hitch
+				ICE2D_PROFILE_SCOPE("PumpLoads");
+				manager.PumpLoads(m_loadBudget);
+			}
+
+			RunFrame(std::chrono::high_resolution_clock::now());
+
+			bool loading = manager.GetLoadQueue().GetPendingCount() > 0u;
+			if (m_waitWhenIdle && !loading && (idle || IsIconic(hwnd)))
+			{
+				// Nothing to animate, sleep until there is input and don't count the wait as frame time
+				ICE2D_PROFILE_SCOPE("WaitForMessages");
+				Ice2D::Window::WaitForMessages();
+				currentTime = std::chrono::high_resolution_clock::now();
+				pacer.Reset();
+			}
+			else
+			{
+				ICE2D_PROFILE_SCOPE("FramePacer");
+				pacer.Wait();
+			}
 		}
 	}
 	catch (const HRException& e)
 	{
-		HRException::ErrorBox(e);
+		ReportError(e.GetErrorMessage(), L"HR Exception Thrown");
 		return -1;
 	}
 	catch (const std::exception& e)
 	{
-		HRException::ErrorBox(e);
+		ReportError(std::wstring(e.what(), e.what() + strlen(e.what())), L"Exception Thrown");
 		return -1;
 	}
 	catch (...)
 	{
-		HRException::ErrorBox(L"Unknown Error", L"Cooked...");
+		ReportError(L"Unknown Error", L"Cooked...");
 		return -1;
 	}
 
 	return 0;
 }
+
+Ice2D::Application::BenchmarkResult Ice2D::Application::Benchmark(unsigned int frameCount, unsigned int warmupFrames)
+{
+	// Frames run back to back without the pacer, the warmup frames aren't measured
+	RunSetup();
+	std::vector<double> times;
+	times.reserve(frameCount);
+	currentTime = std::chrono::high_resolution_clock::now();
+	timestep.Reset();
+	auto start = currentTime;
+	for (unsigned int i = 0; i < warmupFrames + frameCount && !m_quitRequested; ++i)
+	{
+		if (!IsHeadless() && !Ice2D::Window::HandleMessages()) break;
+		auto frameStart = std::chrono::high_resolution_clock::now();
+		if (i == warmupFrames) start = frameStart;
+		manager.PumpLoads(m_loadBudget);
+		RunFrame(IsHeadless() ? currentTime + m_headlessFrameTime : frameStart);
+		if (i >= warmupFrames)
+		{
+			times.push_back(std::chrono::duration<double, std::milli>(
+				std::chrono::high_resolution_clock::now() - frameStart).count());
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	BenchmarkResult result = {};
+	result.frameCount = (unsigned int)times.size();
+	if (times.empty()) return result;
+	result.seconds = std::chrono::duration<double>(end - start).count();
+	result.framesPerSecond = result.seconds > 0.0 ? result.frameCount / result.seconds : 0.0;
+
+	// Nearest rank percentiles, the same as the profiler's frame stats
+	double total = 0.0;
+	for (double time : times) total += time;
+	std::sort(times.begin(), times.end());
+	auto percentile = [&times](double p)
+	{
+		size_t rank = (size_t)(p * times.size() + 0.5);
+		if (rank < 1) rank = 1;
+		if (rank > times.size()) rank = times.size();
+		return times[rank - 1];
+	};
+	result.average = total / times.size();
+	result.min = times.front();
+	result.max = times.back();
+	result.p50 = percentile(0.50);
+	result.p95 = percentile(0.95);
+	result.p99 = percentile(0.99);
+	return result;
+}
+
+void Ice2D::Application::RunFrame(std::chrono::high_resolution_clock::time_point now)
+{
+	auto elapsed = now - currentTime;
+	currentTime = now;
+
+	if (m_fixedStep)
+	{
+		// Run the simulation in whole ticks, Draw() blends between the last two with the alpha
+		unsigned int steps = timestep.Advance(elapsed);
+		deltaTime = timestep.GetStep();
+
+		// Input waits for a frame that ticks, and its edges are only seen by the first tick
+		if (steps > 0) inputState.Update(GetInputQueue());
+		for (unsigned int i = 0; i < steps; ++i)
+		{
+			if (i > 0) inputState.ClearEdges();
+			ICE2D_PROFILE_SCOPE("Update");
+			Update();
+		}
+		interpolationAlpha = timestep.GetAlpha();
+	}
+	else
+	{
+		deltaTime = elapsed;
+		inputState.Update(GetInputQueue());
+		ICE2D_PROFILE_SCOPE("Update");
+		Update();
+		interpolationAlpha = 1.0f;
+	}
+
+	ICE2D_PROFILE_SCOPE("Draw");
+	HRESULT hr = Draw();
+	CheckHR(hr);
+}
+
+void Ice2D::Application::EnableFixedTimestep(unsigned int tickRate, unsigned int maxSteps)
+{
+	timestep.SetTickRate(tickRate);
+	timestep.SetMaxSteps(maxSteps);
+	m_fixedStep = true;
+}
+
+void Ice2D::Application::DisableFixedTimestep()
+{
+	m_fixedStep = false;
+}
+
+bool Ice2D::Application::IsFixedTimestep() const
+{
+	return m_fixedStep;
+}
+
+void Ice2D::Application::SetFrameLimit(unsigned int fps)
+{
+	pacer.SetTargetFPS(fps);
+}
+
+void Ice2D::Application::SetWaitWhenIdle(bool enable)
+{
+	m_waitWhenIdle = enable;
+}
+
+void Ice2D::Application::SetLoadBudget(std::chrono::microseconds budget)
+{
+	m_loadBudget = budget;
+}
+
+void Ice2D::Application::SetHeadlessFrames(unsigned int frameCount)
+{
+	// 0 runs until Quit() is called
+	m_headlessFrames = frameCount;
+}
+
+void Ice2D::Application::SetHeadlessFrameTime(std::chrono::microseconds frameTime)
+{
+	m_headlessFrameTime = frameTime;
+}
+
+void Ice2D::Application::RunSetup()
+{
+	if (m_setupDone) return;
+	m_setupDone = true;
+	Setup();
+}
+
+void Ice2D::Application::ReportError(const std::wstring& message, const wchar_t* title)
+{
+	// A headless run has nobody to click a message box away
+	if (IsHeadless())
+	{
+		fwprintf(stderr, L"%ls: %ls\n", title, message.c_str());
+		return;
+	}
+	HRException::ErrorBox(message, title);
+}
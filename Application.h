@@ -1,7 +1,10 @@
 #pragma once
 #include "ResourceManager.h"
 #include "Graphics.h"
+#include "Timestep.h"
+#include "FramePacer.h"
 #include <chrono>
+#include <string>
 
 namespace Ice2D
 {
@@ -14,16 +17,48 @@ namespace Ice2D
 			const DWORD windowStyle = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX,
 			const int nCmdShow = SW_SHOWNORMAL
 		);
+		Application(const unsigned int width, const unsigned int height);
 		Application(const Application& other) = delete;
 		Application& operator=(const Application& other) = delete;
 		~Application();
+		struct BenchmarkResult
+		{
+			unsigned int frameCount;
+			double seconds, framesPerSecond;
+			double average, min, max, p50, p95, p99;
+		};
 		int Start();
+		BenchmarkResult Benchmark(unsigned int frameCount, unsigned int warmupFrames = 10u);
+		void SetHeadlessFrames(unsigned int frameCount);
+		void SetHeadlessFrameTime(std::chrono::microseconds frameTime);
+		using Graphics::IsHeadless;
+		using Graphics::CopyFrame;
+		using Graphics::SaveFrame;
+		void EnableFixedTimestep(unsigned int tickRate, unsigned int maxSteps = 5u);
+		void DisableFixedTimestep();
+		bool IsFixedTimestep() const;
+		void SetFrameLimit(unsigned int fps);
+		void SetWaitWhenIdle(bool enable);
+		void SetLoadBudget(std::chrono::microseconds budget);
 	protected:
 		ResourceManager manager;
 		virtual void Setup()  {}
 		virtual HRESULT Draw() { return S_OK; }
 		virtual void Update() {}
+		void RunFrame(std::chrono::high_resolution_clock::time_point now);
 		std::chrono::high_resolution_clock::time_point currentTime;
 		std::chrono::duration<float> deltaTime;
+		float interpolationAlpha;
+		FixedTimestep timestep;
+		FramePacer pacer;
+		InputState inputState;
+		bool idle;
+	private:
+		bool m_fixedStep, m_waitWhenIdle, m_setupDone;
+		std::chrono::microseconds m_loadBudget;
+		unsigned int m_headlessFrames;
+		std::chrono::high_resolution_clock::duration m_headlessFrameTime;
+		void RunSetup();
+		void ReportError(const std::wstring& message, const wchar_t* title);
 	};
 }
\ No newline at end of file
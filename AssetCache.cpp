@@ -0,0 +1,235 @@
+#include "pch.h"
+
+#include "AssetCache.h"
+#include "SafeRelease.h"
+
+namespace Ice2D
+{
+    AssetCache::AssetCache(size_t budget) :
+        m_budget(budget), m_bytes(0u), m_hits(0ull), m_misses(0ull), m_evictions(0ull)
+    {
+    }
+
+    AssetCache::~AssetCache()
+    {
+        Clear();
+    }
+
+    void AssetCache::SetBudget(size_t bytes)
+    {
+        m_budget = bytes;
+        Trim();
+    }
+
+    size_t AssetCache::GetBudget() const
+    {
+        return m_budget;
+    }
+
+    bool AssetCache::IsEnabled() const
+    {
+        return m_budget > 0u;
+    }
+
+    ID2D1Bitmap* AssetCache::FindBitmap(const wchar_t* path)
+    {
+        Entry* pEntry = Find(Kind::D2DBitmap, path);
+        if (!pEntry) return nullptr;
+        pEntry->pObject->AddRef();
+        return static_cast<ID2D1Bitmap*>(pEntry->pObject);
+    }
+
+    void AssetCache::InsertBitmap(const wchar_t* path, ID2D1Bitmap* pBitmap)
+    {
+        if (!IsEnabled() || !pBitmap) return;
+        auto size = pBitmap->GetPixelSize();
+
+        Entry entry = {};
+        entry.kind = Kind::D2DBitmap;
+        entry.key = MakeKey(Kind::D2DBitmap, path);
+        entry.pObject = pBitmap;
+        entry.bytes = (size_t)size.width * size.height * 4u;
+        pBitmap->AddRef();
+        Insert(std::move(entry));
+    }
+
+    IWICBitmap* AssetCache::FindWICBitmap(const wchar_t* path)
+    {
+        Entry* pEntry = Find(Kind::WICBitmap, path);
+        if (!pEntry) return nullptr;
+        pEntry->pObject->AddRef();
+        return static_cast<IWICBitmap*>(pEntry->pObject);
+    }
+
+    void AssetCache::InsertWICBitmap(const wchar_t* path, IWICBitmap* pBitmap)
+    {
+        if (!IsEnabled() || !pBitmap) return;
+        UINT width = 0u, height = 0u;
+        pBitmap->GetSize(&width, &height);
+
+        Entry entry = {};
+        entry.kind = Kind::WICBitmap;
+        entry.key = MakeKey(Kind::WICBitmap, path);
+        entry.pObject = pBitmap;
+        entry.bytes = (size_t)width * height * 4u;
+        pBitmap->AddRef();
+        Insert(std::move(entry));
+    }
+
+    bool AssetCache::FindSound(const wchar_t* path, SoundData& sound)
+    {
+        Entry* pEntry = Find(Kind::Sound, path);
+        if (!pEntry) return false;
+        sound = pEntry->sound;
+        return true;
+    }
+
+    void AssetCache::InsertSound(const wchar_t* path, const SoundData& sound)
+    {
+        if (!IsEnabled() || !sound.pData) return;
+
+        Entry entry = {};
+        entry.kind = Kind::Sound;
+        entry.key = MakeKey(Kind::Sound, path);
+        entry.pObject = nullptr;
+        entry.sound = sound;
+        entry.bytes = sound.size;
+        Insert(std::move(entry));
+    }
+
+    bool AssetCache::ContainsBitmap(const wchar_t* path) const
+    {
+        // Doesn't count as a hit or touch the LRU order
+        return IsEnabled() && m_index.count(MakeKey(Kind::D2DBitmap, path)) > 0u;
+    }
+
+    bool AssetCache::ContainsSound(const wchar_t* path) const
+    {
+        return IsEnabled() && m_index.count(MakeKey(Kind::Sound, path)) > 0u;
+    }
+
+    void AssetCache::Evict(const wchar_t* path)
+    {
+        for (Kind kind : { Kind::D2DBitmap, Kind::WICBitmap, Kind::Sound })
+        {
+            auto found = m_index.find(MakeKey(kind, path));
+            if (found != m_index.end()) Remove(found->second);
+        }
+    }
+
+    void AssetCache::Clear()
+    {
+        while (!m_lru.empty()) Remove(m_lru.begin());
+    }
+
+    void AssetCache::ClearDeviceResources()
+    {
+        // Direct2D bitmaps belong to a render target, everything else can stay
+        for (auto it = m_lru.begin(); it != m_lru.end();)
+        {
+            auto next = std::next(it);
+            if (it->kind == Kind::D2DBitmap) Remove(it);
+            it = next;
+        }
+    }
+
+    AssetCache::Stats AssetCache::GetStats() const
+    {
+        Stats stats = {};
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.bytes = m_bytes;
+        stats.budget = m_budget;
+        stats.entries = (unsigned int)m_lru.size();
+        return stats;
+    }
+
+    void AssetCache::ResetStats()
+    {
+        m_hits = m_misses = m_evictions = 0ull;
+    }
+
+    std::wstring AssetCache::MakeKey(Kind kind, const wchar_t* path)
+    {
+        // Resolve relative paths and ignore case, so different spellings of a file share one entry
+        std::wstring key(1, L'0' + (wchar_t)kind);
+        wchar_t fullPath[MAX_PATH];
+        DWORD length = GetFullPathNameW(path, MAX_PATH, fullPath, nullptr);
+        if (length > 0 && length < MAX_PATH)
+        {
+            CharLowerBuffW(fullPath, length);
+            key.append(fullPath, length);
+        }
+        else
+        {
+            key.append(path);
+        }
+        return key;
+    }
+
+    AssetCache::Entry* AssetCache::Find(Kind kind, const wchar_t* path)
+    {
+        if (!IsEnabled()) return nullptr;
+        auto found = m_index.find(MakeKey(kind, path));
+        if (found == m_index.end())
+        {
+            ++m_misses;
+            return nullptr;
+        }
+
+        // Move to the front of the LRU list, iterators stay valid
+        ++m_hits;
+        m_lru.splice(m_lru.begin(), m_lru, found->second);
+        return &m_lru.front();
+    }
+
+    void AssetCache::Insert(Entry&& entry)
+    {
+        auto found = m_index.find(entry.key);
+        if (found != m_index.end()) Remove(found->second);
+
+        m_bytes += entry.bytes;
+        m_lru.push_front(std::move(entry));
+        m_index[m_lru.front().key] = m_lru.begin();
+        Trim();
+    }
+
+    void AssetCache::Remove(std::list<Entry>::iterator it)
+    {
+        m_bytes -= it->bytes;
+        SafeRelease(it->pObject);
+        m_index.erase(it->key);
+        m_lru.erase(it);
+    }
+
+    void AssetCache::Trim()
+    {
+        // Evict cold entries nobody else holds first, they actually give memory back
+        for (auto it = m_lru.end(); m_bytes > m_budget && it != m_lru.begin();)
+        {
+            --it;
+            if (InUse(*it)) continue;
+            auto victim = it++;
+            Remove(victim);
+            ++m_evictions;
+        }
+
+        // Still over budget, drop the cache's reference to entries that are in use
+        while (m_bytes > m_budget && !m_lru.empty())
+        {
+            Remove(std::prev(m_lru.end()));
+            ++m_evictions;
+        }
+    }
+
+    bool AssetCache::InUse(const Entry& entry)
+    {
+        if (entry.pObject)
+        {
+            entry.pObject->AddRef();
+            return entry.pObject->Release() > 1u;
+        }
+        return entry.sound.pData.use_count() > 1;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <d2d1.h>
+#include <wincodec.h>
+#include <xaudio2.h>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace Ice2D
+{
+	class AssetCache
+	{
+	public:
+		struct Stats
+		{
+			unsigned long long hits, misses, evictions;
+			size_t bytes, budget;
+			unsigned int entries;
+		};
+		struct SoundData
+		{
+			std::shared_ptr<BYTE> pData;
+			UINT32 size;
+			WAVEFORMATEXTENSIBLE format;
+		};
+		AssetCache(size_t budget = 256u * 1024u * 1024u);
+		AssetCache(const AssetCache& other) = delete;
+		AssetCache& operator=(const AssetCache& other) = delete;
+		~AssetCache();
+		void SetBudget(size_t bytes);
+		size_t GetBudget() const;
+		bool IsEnabled() const;
+		ID2D1Bitmap* FindBitmap(const wchar_t* path);
+		void InsertBitmap(const wchar_t* path, ID2D1Bitmap* pBitmap);
+		IWICBitmap* FindWICBitmap(const wchar_t* path);
+		void InsertWICBitmap(const wchar_t* path, IWICBitmap* pBitmap);
+		bool FindSound(const wchar_t* path, SoundData& sound);
+		void InsertSound(const wchar_t* path, const SoundData& sound);
+		bool ContainsBitmap(const wchar_t* path) const;
+		bool ContainsSound(const wchar_t* path) const;
+		void Evict(const wchar_t* path);
+		void Clear();
+		void ClearDeviceResources();
+		Stats GetStats() const;
+		void ResetStats();
+	private:
+		enum class Kind { D2DBitmap, WICBitmap, Sound };
+		struct Entry
+		{
+			Kind kind;
+			std::wstring key;
+			IUnknown* pObject;
+			SoundData sound;
+			size_t bytes;
+		};
+		std::list<Entry> m_lru;
+		std::unordered_map<std::wstring, std::list<Entry>::iterator> m_index;
+		size_t m_budget, m_bytes;
+		unsigned long long m_hits, m_misses, m_evictions;
+		static std::wstring MakeKey(Kind kind, const wchar_t* path);
+		Entry* Find(Kind kind, const wchar_t* path);
+		void Insert(Entry&& entry);
+		void Remove(std::list<Entry>::iterator it);
+		void Trim();
+		static bool InUse(const Entry& entry);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include "pch.h"
+
+#include "AssetPack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Ice2D
+{
+    AssetPack::AssetPack() : m_pData(nullptr), m_size(0u), m_pIndex(nullptr), m_pNames(nullptr), m_count(0u)
+    {
+    }
+
+    AssetPack::AssetPack(const char* path) : AssetPack()
+    {
+        m_pFile = std::make_shared<MappedFile>(path);
+        m_pData = m_pFile->GetData();
+        m_size = m_pFile->GetSize();
+        Parse();
+    }
+
+    AssetPack::AssetPack(const wchar_t* path) : AssetPack()
+    {
+        m_pFile = std::make_shared<MappedFile>(path);
+        m_pData = m_pFile->GetData();
+        m_size = m_pFile->GetSize();
+        Parse();
+    }
+
+    AssetPack::AssetPack(const void* pData, size_t size) : AssetPack()
+    {
+        // The memory isn't copied, it has to outlive the pack and everything made from it
+        if (!pData) throw std::runtime_error("Asset pack data is null.");
+        m_pData = static_cast<const unsigned char*>(pData);
+        m_size = size;
+        Parse();
+    }
+
+    size_t AssetPack::GetCount() const
+    {
+        return m_count;
+    }
+
+    AssetPack::Entry AssetPack::GetEntry(size_t index) const
+    {
+        if (index >= m_count) throw std::out_of_range("Asset index out of range.");
+        const IndexEntry& source = m_pIndex[index];
+        Entry entry;
+        entry.name = m_pNames + source.nameOffset;
+        entry.type = (Type)source.type;
+        entry.pData = m_pData + source.offset;
+        entry.size = source.size;
+        std::memcpy(entry.params, source.params, sizeof(entry.params));
+        return entry;
+    }
+
+    bool AssetPack::Find(const char* name, Entry& entry) const
+    {
+        // The index is sorted by name when the pack is built
+        if (!name) return false;
+        size_t low = 0u, high = m_count;
+        while (low < high)
+        {
+            size_t middle = low + (high - low) / 2u;
+            int order = std::strcmp(m_pNames + m_pIndex[middle].nameOffset, name);
+            if (order == 0)
+            {
+                entry = GetEntry(middle);
+                return true;
+            }
+            if (order < 0) low = middle + 1u;
+            else high = middle;
+        }
+        return false;
+    }
+
+    bool AssetPack::Contains(const char* name) const
+    {
+        Entry entry;
+        return Find(name, entry);
+    }
+
+    AssetPack::ImageData AssetPack::GetImage(const char* name) const
+    {
+        Entry entry = Get(name, Type::Image);
+        return { entry.pData, entry.params[0], entry.params[1], entry.params[2] };
+    }
+
+    AssetPack::SheetData AssetPack::GetSheet(const char* name) const
+    {
+        Entry entry = Get(name, Type::Sheet);
+        return { { entry.pData, entry.params[0], entry.params[1], entry.params[2] },
+            entry.params[3], entry.params[4], entry.params[5], entry.params[6] };
+    }
+
+    AssetPack::SoundData AssetPack::GetSound(const char* name) const
+    {
+        Entry entry = Get(name, Type::Sound);
+        return { entry.pData, entry.params[0], entry.pData + entry.params[1], entry.params[2] };
+    }
+
+    const std::shared_ptr<MappedFile>& AssetPack::GetFile() const
+    {
+        return m_pFile;
+    }
+
+    void AssetPack::Parse()
+    {
+        // Everything is checked once here, so lookups can trust the index
+        Header header;
+        if (reinterpret_cast<uintptr_t>(m_pData) % alignof(IndexEntry) != 0u)
+        {
+            throw std::runtime_error("Asset pack data is not aligned.");
+        }
+        if (m_size < sizeof(Header)) throw std::runtime_error("Asset pack is truncated.");
+        std::memcpy(&header, m_pData, sizeof(Header));
+        if (header.magic != MAGIC) throw std::runtime_error("Not an asset pack.");
+        if (header.version != VERSION) throw std::runtime_error("Unsupported asset pack version.");
+
+        if (header.indexOffset % alignof(IndexEntry) != 0u || header.indexOffset > m_size ||
+            header.entryCount > (m_size - header.indexOffset) / sizeof(IndexEntry))
+        {
+            throw std::runtime_error("Asset pack index is out of bounds.");
+        }
+        if (header.namesOffset > m_size || header.namesSize > m_size - header.namesOffset ||
+            (header.namesSize > 0u && m_pData[header.namesOffset + header.namesSize - 1u] != '\0'))
+        {
+            throw std::runtime_error("Asset pack names are out of bounds.");
+        }
+
+        m_pIndex = reinterpret_cast<const IndexEntry*>(m_pData + header.indexOffset);
+        m_pNames = reinterpret_cast<const char*>(m_pData + header.namesOffset);
+        m_count = header.entryCount;
+        for (uint32_t i = 0u; i < m_count; ++i)
+        {
+            const IndexEntry& entry = m_pIndex[i];
+            if ((uint64_t)entry.nameOffset + entry.nameLength >= header.namesSize ||
+                m_pNames[entry.nameOffset + entry.nameLength] != '\0')
+            {
+                throw std::runtime_error("Asset pack name is out of bounds.");
+            }
+            if (i > 0u && std::strcmp(m_pNames + m_pIndex[i - 1u].nameOffset, m_pNames + entry.nameOffset) >= 0)
+            {
+                throw std::runtime_error("Asset pack index is not sorted.");
+            }
+            if (entry.offset > m_size || entry.size > m_size - entry.offset)
+            {
+                throw std::runtime_error("Asset pack entry is out of bounds.");
+            }
+
+            switch ((Type)entry.type)
+            {
+            case Type::Blob:
+                break;
+            case Type::Image:
+            case Type::Sheet:
+                if (entry.params[2] < (uint64_t)entry.params[0] * 4u ||
+                    (uint64_t)entry.params[2] * entry.params[1] > entry.size)
+                {
+                    throw std::runtime_error("Asset pack image is out of bounds.");
+                }
+                if ((Type)entry.type == Type::Sheet && (entry.params[3] == 0u || entry.params[4] == 0u ||
+                    entry.params[5] > (uint64_t)entry.params[3] * entry.params[4] || entry.params[6] == 0u))
+                {
+                    throw std::runtime_error("Asset pack sheet is invalid.");
+                }
+                break;
+            case Type::Sound:
+                if (entry.params[0] < 16u || entry.params[0] > entry.params[1] ||
+                    (uint64_t)entry.params[1] + entry.params[2] > entry.size)
+                {
+                    throw std::runtime_error("Asset pack sound is out of bounds.");
+                }
+                break;
+            default:
+                throw std::runtime_error("Unknown asset pack entry type.");
+            }
+        }
+    }
+
+    AssetPack::Entry AssetPack::Get(const char* name, Type type) const
+    {
+        Entry entry;
+        if (!Find(name, entry)) throw std::runtime_error("Asset not found in pack.");
+        if (entry.type != type) throw std::runtime_error("Asset has a different type.");
+        return entry;
+    }
+
+    void AssetPackWriter::AddBlob(const std::string& name, const void* pData, size_t size)
+    {
+        Item& item = Add(name, AssetPack::Type::Blob);
+        const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+        item.data.assign(pBytes, pBytes + size);
+    }
+
+    void AssetPackWriter::AddImage(const std::string& name, uint32_t width, uint32_t height,
+        const void* pPixels, uint32_t stride)
+    {
+        Item& item = Add(name, AssetPack::Type::Image);
+        AddPixels(item, width, height, pPixels, stride);
+    }
+
+    void AssetPackWriter::AddSheet(const std::string& name, uint32_t width, uint32_t height, const void* pPixels,
+        uint32_t stride, uint32_t rows, uint32_t cols, uint32_t frameCount, uint32_t frameRate)
+    {
+        if (rows == 0u || cols == 0u || frameCount > rows * cols || frameRate == 0u)
+        {
+            throw std::runtime_error("Invalid sprite sheet layout.");
+        }
+        Item& item = Add(name, AssetPack::Type::Sheet);
+        AddPixels(item, width, height, pPixels, stride);
+        item.params[3] = rows;
+        item.params[4] = cols;
+        item.params[5] = frameCount;
+        item.params[6] = frameRate;
+    }
+
+    void AssetPackWriter::AddSound(const std::string& name, const void* pFormat, uint32_t formatSize,
+        const void* pSamples, uint32_t size)
+    {
+        if (formatSize < 16u) throw std::runtime_error("Sound format is too small.");
+        Item& item = Add(name, AssetPack::Type::Sound);
+
+        // The format goes first, the samples start on the next aligned offset
+        uint32_t sampleOffset = (formatSize + 15u) & ~15u;
+        item.data.resize((size_t)sampleOffset + size);
+        std::memcpy(item.data.data(), pFormat, formatSize);
+        if (size > 0u) std::memcpy(item.data.data() + sampleOffset, pSamples, size);
+        item.params[0] = formatSize;
+        item.params[1] = sampleOffset;
+        item.params[2] = size;
+    }
+
+    size_t AssetPackWriter::GetCount() const
+    {
+        return m_items.size();
+    }
+
+    std::vector<unsigned char> AssetPackWriter::Build() const
+    {
+        std::vector<const Item*> items;
+        AssetPack::Header header;
+        std::vector<AssetPack::IndexEntry> index;
+        uint64_t size = Layout(items, header, index);
+
+        std::vector<unsigned char> pack((size_t)size);
+        std::memcpy(pack.data(), &header, sizeof(header));
+        for (size_t i = 0u; i < items.size(); ++i)
+        {
+            const std::string& name = items[i]->name;
+            std::memcpy(pack.data() + header.namesOffset + index[i].nameOffset, name.c_str(), name.size() + 1u);
+            if (!items[i]->data.empty())
+            {
+                std::memcpy(pack.data() + index[i].offset, items[i]->data.data(), items[i]->data.size());
+            }
+        }
+        if (!index.empty())
+        {
+            std::memcpy(pack.data() + header.indexOffset, index.data(), index.size() * sizeof(AssetPack::IndexEntry));
+        }
+        return pack;
+    }
+
+    void AssetPackWriter::Write(const char* path) const
+    {
+        std::vector<const Item*> items;
+        AssetPack::Header header;
+        std::vector<AssetPack::IndexEntry> index;
+        Layout(items, header, index);
+
+        // Streamed in file order, so a large pack is never held in memory twice
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("Failed to open asset pack for writing.");
+        uint64_t position = 0u;
+        auto write = [&file, &position](const void* pData, uint64_t size, uint64_t offset)
+        {
+            static const char zeros[AssetPack::ALIGNMENT] = {};
+            while (position < offset)
+            {
+                uint64_t count = offset - position < sizeof(zeros) ? offset - position : sizeof(zeros);
+                file.write(zeros, (std::streamsize)count);
+                position += count;
+            }
+            file.write(static_cast<const char*>(pData), (std::streamsize)size);
+            position += size;
+        };
+
+        write(&header, sizeof(header), 0u);
+        for (const Item* pItem : items) write(pItem->name.c_str(), pItem->name.size() + 1u, position);
+        write(index.data(), index.size() * sizeof(AssetPack::IndexEntry), header.indexOffset);
+        for (size_t i = 0u; i < items.size(); ++i) write(items[i]->data.data(), items[i]->data.size(), index[i].offset);
+        if (!file) throw std::runtime_error("Failed to write asset pack.");
+    }
+
+    uint64_t AssetPackWriter::Layout(std::vector<const Item*>& items, AssetPack::Header& header,
+        std::vector<AssetPack::IndexEntry>& index) const
+    {
+        items.clear();
+        items.reserve(m_items.size());
+        for (const Item& item : m_items) items.push_back(&item);
+        std::sort(items.begin(), items.end(), [](const Item* a, const Item* b) { return a->name < b->name; });
+        for (size_t i = 1u; i < items.size(); ++i)
+        {
+            if (items[i - 1u]->name == items[i]->name) throw std::runtime_error("Asset name is in the pack twice.");
+        }
+
+        auto align = [](uint64_t offset, uint64_t alignment) { return (offset + alignment - 1u) & ~(alignment - 1u); };
+
+        // Header, names, index, then the blobs, each starting on an aligned offset
+        header = {};
+        header.magic = AssetPack::MAGIC;
+        header.version = AssetPack::VERSION;
+        header.entryCount = (uint32_t)items.size();
+        header.alignment = AssetPack::ALIGNMENT;
+        header.namesOffset = sizeof(AssetPack::Header);
+        for (const Item* pItem : items) header.namesSize += pItem->name.size() + 1u;
+        header.indexOffset = align(header.namesOffset + header.namesSize, alignof(AssetPack::IndexEntry));
+
+        index.resize(items.size());
+        uint64_t nameOffset = 0u;
+        uint64_t offset = header.indexOffset + index.size() * sizeof(AssetPack::IndexEntry);
+        for (size_t i = 0u; i < items.size(); ++i)
+        {
+            offset = align(offset, AssetPack::ALIGNMENT);
+            AssetPack::IndexEntry& entry = index[i];
+            entry = {};
+            entry.nameOffset = (uint32_t)nameOffset;
+            entry.nameLength = (uint32_t)items[i]->name.size();
+            entry.type = (uint32_t)items[i]->type;
+            entry.offset = offset;
+            entry.size = items[i]->data.size();
+            std::memcpy(entry.params, items[i]->params, sizeof(entry.params));
+            nameOffset += entry.nameLength + 1u;
+            offset += entry.size;
+        }
+        return offset;
+    }
+
+    AssetPackWriter::Item& AssetPackWriter::Add(const std::string& name, AssetPack::Type type)
+    {
+        if (name.empty()) throw std::runtime_error("Asset name is empty.");
+        m_items.emplace_back();
+        Item& item = m_items.back();
+        item.name = name;
+        item.type = type;
+        std::memset(item.params, 0, sizeof(item.params));
+        return item;
+    }
+
+    void AssetPackWriter::AddPixels(Item& item, uint32_t width, uint32_t height, const void* pPixels, uint32_t stride)
+    {
+        // Rows are stored tightly packed
+        const uint32_t rowSize = width * 4u;
+        item.data.resize((size_t)rowSize * height);
+        const unsigned char* pSrc = static_cast<const unsigned char*>(pPixels);
+        for (uint32_t y = 0u; y < height; ++y)
+        {
+            std::memcpy(item.data.data() + (size_t)y * rowSize, pSrc + (size_t)y * stride, rowSize);
+        }
+        item.params[0] = width;
+        item.params[1] = height;
+        item.params[2] = rowSize;
+    }
+}
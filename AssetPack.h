@@ -0,0 +1,104 @@
+#pragma once
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Ice2D
+{
+	class AssetPack
+	{
+	public:
+		enum class Type : uint32_t { Blob, Image, Sheet, Sound };
+		struct Entry
+		{
+			const char* name;
+			Type type;
+			const unsigned char* pData;
+			uint64_t size;
+			uint32_t params[8];
+		};
+		struct ImageData
+		{
+			const void* pPixels;
+			uint32_t width, height, stride;
+		};
+		struct SheetData
+		{
+			ImageData image;
+			uint32_t rows, cols, frameCount, frameRate;
+		};
+		struct SoundData
+		{
+			const void* pFormat;
+			uint32_t formatSize;
+			const void* pSamples;
+			uint32_t size;
+		};
+		static const uint32_t MAGIC = 0x50443249u; // "I2DP"
+		static const uint32_t VERSION = 1u;
+		static const uint32_t ALIGNMENT = 64u;
+		AssetPack();
+		AssetPack(const char* path);
+		AssetPack(const wchar_t* path);
+		AssetPack(const void* pData, size_t size);
+		size_t GetCount() const;
+		Entry GetEntry(size_t index) const;
+		bool Find(const char* name, Entry& entry) const;
+		bool Contains(const char* name) const;
+		ImageData GetImage(const char* name) const;
+		SheetData GetSheet(const char* name) const;
+		SoundData GetSound(const char* name) const;
+		const std::shared_ptr<MappedFile>& GetFile() const;
+	private:
+		struct Header
+		{
+			uint32_t magic, version, entryCount, alignment;
+			uint64_t indexOffset, namesOffset, namesSize;
+		};
+		struct IndexEntry
+		{
+			uint32_t nameOffset, nameLength, type, reserved;
+			uint64_t offset, size;
+			uint32_t params[8];
+		};
+		friend class AssetPackWriter;
+		std::shared_ptr<MappedFile> m_pFile;
+		const unsigned char* m_pData;
+		size_t m_size;
+		const IndexEntry* m_pIndex;
+		const char* m_pNames;
+		uint32_t m_count;
+		void Parse();
+		Entry Get(const char* name, Type type) const;
+	};
+
+	class AssetPackWriter
+	{
+	public:
+		void AddBlob(const std::string& name, const void* pData, size_t size);
+		void AddImage(const std::string& name, uint32_t width, uint32_t height, const void* pPixels, uint32_t stride);
+		void AddSheet(const std::string& name, uint32_t width, uint32_t height, const void* pPixels, uint32_t stride,
+			uint32_t rows, uint32_t cols, uint32_t frameCount, uint32_t frameRate);
+		void AddSound(const std::string& name, const void* pFormat, uint32_t formatSize,
+			const void* pSamples, uint32_t size);
+		size_t GetCount() const;
+		std::vector<unsigned char> Build() const;
+		void Write(const char* path) const;
+	private:
+		struct Item
+		{
+			std::string name;
+			AssetPack::Type type;
+			std::vector<unsigned char> data;
+			uint32_t params[8];
+		};
+		std::vector<Item> m_items;
+		Item& Add(const std::string& name, AssetPack::Type type);
+		uint64_t Layout(std::vector<const Item*>& items, AssetPack::Header& header,
+			std::vector<AssetPack::IndexEntry>& index) const;
+		static void AddPixels(Item& item, uint32_t width, uint32_t height, const void* pPixels, uint32_t stride);
+	};
+}
@@ -0,0 +1,222 @@
+#include "pch.h"
+
+#include "AtlasPacker.h"
+
+namespace Ice2D
+{
+    AtlasPacker::AtlasPacker(unsigned int pageWidth, unsigned int pageHeight,
+        unsigned int maxPageWidth, unsigned int maxPageHeight, unsigned int padding) :
+        m_pageWidth(pageWidth), m_pageHeight(pageHeight), m_maxPageWidth(maxPageWidth),
+        m_maxPageHeight(maxPageHeight), m_padding(padding), m_stats()
+    {
+        if (pageWidth == 0u || pageHeight == 0u || pageWidth > maxPageWidth || pageHeight > maxPageHeight)
+        {
+            throw std::runtime_error("Invalid atlas page size.");
+        }
+    }
+
+    bool AtlasPacker::Insert(unsigned int width, unsigned int height, Region& region)
+    {
+        // Every image reserves its padding on all sides, the caller fills it by extruding the edges
+        unsigned int paddedWidth = width + 2u * m_padding;
+        unsigned int paddedHeight = height + 2u * m_padding;
+        if (width == 0u || height == 0u || paddedWidth > m_maxPageWidth || paddedHeight > m_maxPageHeight)
+        {
+            ++m_stats.failures;
+            return false;
+        }
+
+        unsigned int x = 0u, y = 0u;
+        size_t index = 0u;
+        unsigned int page = 0u;
+        bool found = false;
+
+        // Older pages first so they fill up, then grow the newest page, then start a new one
+        for (; page < (unsigned int)m_pages.size() && !found; ++page)
+        {
+            found = Fit(m_pages[page], paddedWidth, paddedHeight, x, y, index);
+        }
+        if (found)
+        {
+            --page;
+        }
+        else
+        {
+            if (m_pages.empty()) AddPage();
+            page = (unsigned int)m_pages.size() - 1u;
+            while (!(found = Fit(m_pages[page], paddedWidth, paddedHeight, x, y, index)) && Grow(m_pages[page]))
+            {
+            }
+            if (!found)
+            {
+                AddPage();
+                page = (unsigned int)m_pages.size() - 1u;
+                while (!(found = Fit(m_pages[page], paddedWidth, paddedHeight, x, y, index)) && Grow(m_pages[page]))
+                {
+                }
+            }
+        }
+
+        if (!found)
+        {
+            ++m_stats.failures;
+            return false;
+        }
+
+        Place(m_pages[page], index, x, y, paddedWidth, paddedHeight);
+        region = { page, x + m_padding, y + m_padding, width, height };
+        m_stats.usedArea += (unsigned long long)width * height;
+        ++m_stats.inserts;
+        return true;
+    }
+
+    void AtlasPacker::Clear()
+    {
+        m_pages.clear();
+        m_stats = Stats();
+    }
+
+    unsigned int AtlasPacker::GetPageCount() const
+    {
+        return (unsigned int)m_pages.size();
+    }
+
+    unsigned int AtlasPacker::GetPageWidth(unsigned int page) const
+    {
+        return m_pages.at(page).width;
+    }
+
+    unsigned int AtlasPacker::GetPageHeight(unsigned int page) const
+    {
+        return m_pages.at(page).height;
+    }
+
+    unsigned int AtlasPacker::GetPadding() const
+    {
+        return m_padding;
+    }
+
+    float AtlasPacker::GetOccupancy() const
+    {
+        return m_stats.pageArea ? (float)((double)m_stats.usedArea / (double)m_stats.pageArea) : 0.0f;
+    }
+
+    const AtlasPacker::Stats& AtlasPacker::GetStats() const
+    {
+        return m_stats;
+    }
+
+    bool AtlasPacker::Fit(const Page& page, unsigned int width, unsigned int height,
+        unsigned int& x, unsigned int& y, size_t& index)
+    {
+        // Skyline bottom-left: the lowest top edge wins, then the leftmost position
+        unsigned int bestTop = ~0u, bestX = 0u, bestY = 0u;
+        size_t bestIndex = 0u;
+        const std::vector<Segment>& skyline = page.skyline;
+        for (size_t i = 0u; i < skyline.size(); ++i)
+        {
+            unsigned int left = skyline[i].x;
+            if (left + width > page.width) break;
+
+            unsigned int top = 0u;
+            for (size_t j = i; j < skyline.size() && skyline[j].x < left + width; ++j)
+            {
+                if (skyline[j].y > top) top = skyline[j].y;
+            }
+            if (top + height > page.height || top + height >= bestTop) continue;
+
+            bestTop = top + height;
+            bestX = left;
+            bestY = top;
+            bestIndex = i;
+        }
+
+        if (bestTop == ~0u) return false;
+        x = bestX;
+        y = bestY;
+        index = bestIndex;
+        return true;
+    }
+
+    void AtlasPacker::Place(Page& page, size_t index, unsigned int x, unsigned int y,
+        unsigned int width, unsigned int height)
+    {
+        std::vector<Segment>& skyline = page.skyline;
+        skyline.insert(skyline.begin() + index, { x, y + height, width });
+
+        // Trim or remove the segments the new one now covers
+        unsigned int right = x + width;
+        size_t i = index + 1u;
+        while (i < skyline.size() && skyline[i].x < right)
+        {
+            unsigned int end = skyline[i].x + skyline[i].width;
+            if (end <= right)
+            {
+                skyline.erase(skyline.begin() + i);
+            }
+            else
+            {
+                skyline[i].width = end - right;
+                skyline[i].x = right;
+                break;
+            }
+        }
+
+        // Neighbours at the same height become one segment
+        for (size_t j = 0u; j + 1u < skyline.size();)
+        {
+            if (skyline[j].y == skyline[j + 1u].y)
+            {
+                skyline[j].width += skyline[j + 1u].width;
+                skyline.erase(skyline.begin() + j + 1u);
+            }
+            else
+            {
+                ++j;
+            }
+        }
+    }
+
+    bool AtlasPacker::Grow(Page& page)
+    {
+        // Doubles the shorter side, so pages stay close to square
+        bool growWidth = page.width <= page.height ? page.width < m_maxPageWidth : page.height >= m_maxPageHeight;
+        if (growWidth && page.width < m_maxPageWidth)
+        {
+            unsigned int width = page.width * 2u < m_maxPageWidth ? page.width * 2u : m_maxPageWidth;
+            Segment& last = page.skyline.back();
+            if (last.y == 0u)
+            {
+                last.width += width - page.width;
+            }
+            else
+            {
+                page.skyline.push_back({ page.width, 0u, width - page.width });
+            }
+            m_stats.pageArea += (unsigned long long)(width - page.width) * page.height;
+            page.width = width;
+        }
+        else if (page.height < m_maxPageHeight)
+        {
+            unsigned int height = page.height * 2u < m_maxPageHeight ? page.height * 2u : m_maxPageHeight;
+            m_stats.pageArea += (unsigned long long)(height - page.height) * page.width;
+            page.height = height;
+        }
+        else
+        {
+            return false;
+        }
+        ++m_stats.grows;
+        return true;
+    }
+
+    void AtlasPacker::AddPage()
+    {
+        Page page;
+        page.width = m_pageWidth;
+        page.height = m_pageHeight;
+        page.skyline.push_back({ 0u, 0u, m_pageWidth });
+        m_pages.push_back(page);
+        m_stats.pageArea += (unsigned long long)m_pageWidth * m_pageHeight;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace Ice2D
+{
+	class AtlasPacker
+	{
+	public:
+		struct Region
+		{
+			unsigned int page, x, y, width, height;
+		};
+		struct Stats
+		{
+			unsigned long long usedArea, pageArea;
+			unsigned int inserts, failures, grows;
+		};
+		AtlasPacker(unsigned int pageWidth = 256u, unsigned int pageHeight = 256u,
+			unsigned int maxPageWidth = 2048u, unsigned int maxPageHeight = 2048u, unsigned int padding = 1u);
+		bool Insert(unsigned int width, unsigned int height, Region& region);
+		void Clear();
+		unsigned int GetPageCount() const;
+		unsigned int GetPageWidth(unsigned int page) const;
+		unsigned int GetPageHeight(unsigned int page) const;
+		unsigned int GetPadding() const;
+		float GetOccupancy() const;
+		const Stats& GetStats() const;
+	private:
+		struct Segment
+		{
+			unsigned int x, y, width;
+		};
+		struct Page
+		{
+			unsigned int width, height;
+			std::vector<Segment> skyline;
+		};
+		std::vector<Page> m_pages;
+		unsigned int m_pageWidth, m_pageHeight, m_maxPageWidth, m_maxPageHeight, m_padding;
+		Stats m_stats;
+		static bool Fit(const Page& page, unsigned int width, unsigned int height,
+			unsigned int& x, unsigned int& y, size_t& index);
+		static void Place(Page& page, size_t index, unsigned int x, unsigned int y,
+			unsigned int width, unsigned int height);
+		bool Grow(Page& page);
+		void AddPage();
+	};
+}
@@ -0,0 +1,228 @@
+#include "pch.h"
+
+#include "AudioStream.h"
+
+namespace Ice2D
+{
+    AudioStream::AudioStream(Reader reader, uint64_t size, AudioStreamSink* pSink, uint32_t blockSize,
+        unsigned int blockCount, uint32_t blockAlign) : m_reader(std::move(reader)), m_pSink(pSink), m_size(size),
+        m_readPosition(0u), m_playPosition(0u), m_seekPosition(0u), m_blockSize(blockSize), m_blockAlign(1u), m_queued(0u), m_generation(0u),
+        m_looping(false), m_ended(false), m_failed(false), m_seekPending(false), m_stopping(false), m_stats()
+    {
+        if (!m_reader) throw std::runtime_error("Audio stream reader is null.");
+        if (!pSink) throw std::runtime_error("Audio stream sink is null.");
+        if (blockCount < 2u) throw std::runtime_error("Audio stream needs at least two blocks.");
+        if (blockAlign == 0u) blockAlign = 1u;
+        m_blockAlign = blockAlign;
+
+        // Blocks hold whole sample frames, so a block boundary never splits a sample
+        m_blockSize = blockSize - blockSize % blockAlign;
+        if (m_blockSize == 0u) m_blockSize = blockAlign;
+        m_size = size - size % blockAlign;
+        m_ended = m_size == 0u;
+
+        m_blocks.resize(blockCount);
+        for (unsigned int i = 0u; i < blockCount; ++i)
+        {
+            m_blocks[i].data.resize(m_blockSize);
+            m_blocks[i].position = 0u;
+            m_blocks[i].size = 0u;
+            m_blocks[i].generation = 0u;
+            m_blocks[i].queued = false;
+            m_free.push_back(blockCount - 1u - i);
+        }
+    }
+
+    AudioStream::~AudioStream()
+    {
+        Stop();
+    }
+
+    void AudioStream::Start()
+    {
+        if (m_thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = false;
+        }
+        m_thread = std::thread(&AudioStream::Run, this);
+    }
+
+    void AudioStream::Stop()
+    {
+        if (!m_thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        m_thread.join();
+    }
+
+    void AudioStream::Recycle(unsigned int block)
+    {
+        // Called by the sink once a block has played or was flushed, usually from the audio thread.
+        // Notifies under the lock, so the stream can be destroyed as soon as IsFinished() sees the last block.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (block >= m_blocks.size() || !m_blocks[block].queued) return;
+        Block& b = m_blocks[block];
+        b.queued = false;
+        --m_queued;
+        m_free.push_back(block);
+        if (b.generation == m_generation)
+        {
+            m_playPosition = b.position + b.size;
+            if (m_queued == 0u && !m_ended) ++m_stats.underruns;
+        }
+        m_wake.notify_all();
+    }
+
+    void AudioStream::Seek(uint64_t position)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            position -= position % m_blockAlign;
+            m_seekPosition = position < m_size ? position : m_size;
+            m_seekPending = true;
+        }
+        m_wake.notify_all();
+    }
+
+    void AudioStream::SetLooping(bool looping)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_looping = looping;
+        }
+        m_wake.notify_all();
+    }
+
+    bool AudioStream::IsLooping() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_looping;
+    }
+
+    bool AudioStream::IsFinished() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_ended && m_queued == 0u && !m_seekPending;
+    }
+
+    bool AudioStream::HasFailed() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_failed;
+    }
+
+    uint64_t AudioStream::GetSize() const
+    {
+        return m_size;
+    }
+
+    uint64_t AudioStream::GetPlayPosition() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_playPosition;
+    }
+
+    unsigned int AudioStream::GetQueuedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queued;
+    }
+
+    AudioStream::Stats AudioStream::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    void AudioStream::Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_wake.wait(lock, [this]() { return m_stopping || m_seekPending || (!m_free.empty() && !m_ended); });
+            if (m_stopping) break;
+
+            if (m_seekPending)
+            {
+                // Blocks of the old position come back through Recycle and are ignored for the play position
+                m_seekPending = false;
+                ++m_generation;
+                m_readPosition = m_seekPosition;
+                m_playPosition = m_seekPosition;
+                m_ended = m_readPosition >= m_size && !m_looping;
+                if (m_readPosition >= m_size && m_looping) m_readPosition = 0u;
+                lock.unlock();
+                m_pSink->Flush();
+                lock.lock();
+                continue;
+            }
+
+            unsigned int index = m_free.back();
+            m_free.pop_back();
+            Block& block = m_blocks[index];
+            const unsigned int generation = m_generation;
+            const uint64_t position = m_readPosition;
+            const uint64_t remaining = m_size - position;
+            const uint32_t size = remaining < m_blockSize ? (uint32_t)remaining : m_blockSize;
+
+            // The file is read without holding the lock, so the sink can recycle meanwhile
+            lock.unlock();
+            size_t read = 0u;
+            bool failed = false;
+            try
+            {
+                read = m_reader(position, block.data.data(), size);
+            }
+            catch (...)
+            {
+                failed = true;
+            }
+            lock.lock();
+
+            if (generation != m_generation || m_stopping)
+            {
+                m_free.push_back(index);
+                continue;
+            }
+            if (failed || read != size)
+            {
+                // A short read ends the stream after whatever did arrive
+                m_failed = true;
+                read = failed ? 0u : read < size ? read : size;
+            }
+
+            m_readPosition = position + read;
+            if (m_failed || (m_readPosition >= m_size && !m_looping))
+            {
+                m_ended = true;
+            }
+            else if (m_readPosition >= m_size)
+            {
+                m_readPosition = 0u;
+            }
+
+            if (read == 0u)
+            {
+                m_free.push_back(index);
+                continue;
+            }
+
+            block.position = position;
+            block.size = (uint32_t)read;
+            block.generation = generation;
+            block.queued = true;
+            ++m_queued;
+            ++m_stats.blocksRead;
+            m_stats.bytesRead += read;
+            const bool endOfStream = m_ended;
+
+            lock.unlock();
+            m_pSink->Submit(block.data.data(), block.size, index, endOfStream);
+            lock.lock();
+        }
+    }
+}
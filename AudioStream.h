@@ -0,0 +1,68 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Ice2D
+{
+	class AudioStreamSink
+	{
+	public:
+		virtual ~AudioStreamSink() {}
+		virtual void Submit(const unsigned char* pData, uint32_t size, unsigned int block, bool endOfStream) = 0;
+		virtual void Flush() = 0;
+	};
+
+	class AudioStream
+	{
+	public:
+		typedef std::function<size_t(uint64_t offset, void* pBuffer, size_t size)> Reader;
+		struct Stats
+		{
+			unsigned long long blocksRead, bytesRead, underruns;
+		};
+		AudioStream(Reader reader, uint64_t size, AudioStreamSink* pSink, uint32_t blockSize = 65536u,
+			unsigned int blockCount = 3u, uint32_t blockAlign = 1u);
+		AudioStream(const AudioStream& other) = delete;
+		AudioStream& operator=(const AudioStream& other) = delete;
+		~AudioStream();
+		void Start();
+		void Stop();
+		void Recycle(unsigned int block);
+		void Seek(uint64_t position);
+		void SetLooping(bool looping);
+		bool IsLooping() const;
+		bool IsFinished() const;
+		bool HasFailed() const;
+		uint64_t GetSize() const;
+		uint64_t GetPlayPosition() const;
+		unsigned int GetQueuedCount() const;
+		Stats GetStats() const;
+	private:
+		struct Block
+		{
+			std::vector<unsigned char> data;
+			uint64_t position;
+			uint32_t size;
+			unsigned int generation;
+			bool queued;
+		};
+		Reader m_reader;
+		AudioStreamSink* m_pSink;
+		uint64_t m_size, m_readPosition, m_playPosition, m_seekPosition;
+		uint32_t m_blockSize, m_blockAlign;
+		std::vector<Block> m_blocks;
+		std::vector<unsigned int> m_free;
+		unsigned int m_queued, m_generation;
+		bool m_looping, m_ended, m_failed, m_seekPending, m_stopping;
+		Stats m_stats;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::thread m_thread;
+		void Run();
+	};
+}
@@ -0,0 +1,174 @@
+#include "pch.h"
+
+#include "BitmapFont.h"
+#include "MappedFile.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+#include <string>
+
+namespace Ice2D
+{
+    static std::wstring Widen(const std::string& text)
+    {
+        int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), nullptr, 0);
+        std::wstring result((size_t)length, L'\0');
+        if (length > 0) MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), &result[0], length);
+        return result;
+    }
+
+    BitmapFont::BitmapFont()
+    {
+    }
+
+    BitmapFont::BitmapFont(ResourceManager* pManager, const wchar_t* path) : IBasicResource(pManager)
+    {
+        MappedFile file(path);
+        if (!file.IsOpen()) throw std::runtime_error("Bitmap font file could not be opened.");
+        Parse(file.GetData(), file.GetSize());
+
+        // Page files are named relative to the font file
+        std::wstring directory(path);
+        size_t slash = directory.find_last_of(L"\\/");
+        directory = slash == std::wstring::npos ? std::wstring() : directory.substr(0u, slash + 1u);
+        for (unsigned int i = 0u; i < m_table.GetPageCount(); ++i)
+        {
+            m_pages.emplace_back(pManager, (directory + Widen(m_table.GetPage(i))).c_str());
+        }
+        OnLoad();
+    }
+
+    BitmapFont::BitmapFont(ResourceManager* pManager, const AssetPack& pack, const char* name) :
+        IBasicResource(pManager)
+    {
+        AssetPack::Entry entry;
+        if (!pack.Find(name, entry)) throw std::runtime_error("Bitmap font is not in the pack.");
+        Parse(entry.pData, (size_t)entry.size);
+
+        // Page images are named relative to the font, like files next to it
+        std::string directory(name);
+        size_t slash = directory.find_last_of("\\/");
+        directory = slash == std::string::npos ? std::string() : directory.substr(0u, slash + 1u);
+        for (unsigned int i = 0u; i < m_table.GetPageCount(); ++i)
+        {
+            m_pages.emplace_back(pManager, pack, (directory + m_table.GetPage(i)).c_str());
+        }
+        OnLoad();
+    }
+
+    BitmapFont::BitmapFont(ResourceManager* pManager, const GlyphTable& table, std::vector<D2DImage>&& pages) :
+        IBasicResource(pManager), m_table(table), m_pages(std::move(pages))
+    {
+        if (m_pages.size() < m_table.GetPageCount()) throw std::runtime_error("Bitmap font is missing pages.");
+        OnLoad();
+    }
+
+    BitmapFont::BitmapFont(BitmapFont&& other) noexcept : IBasicResource(other), m_table(std::move(other.m_table)),
+        m_pages(std::move(other.m_pages)), m_quads(std::move(other.m_quads))
+    {
+        OnMove(other);
+    }
+
+    BitmapFont& BitmapFont::operator=(BitmapFont&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_pManager = other.m_pManager;
+        Release();
+        m_table = std::move(other.m_table);
+        m_pages = std::move(other.m_pages);
+        m_quads = std::move(other.m_quads);
+
+        OnMove(other);
+        return *this;
+    }
+
+    BitmapFont::~BitmapFont()
+    {
+        Release();
+    }
+
+    void BitmapFont::Release()
+    {
+        // The pages are tracked too, so they're only released here, FreeAll may be walking the registry
+        for (D2DImage& page : m_pages) page.Release();
+        m_table.Clear();
+        OnUnload();
+    }
+
+    void BitmapFont::Draw(SpriteBatch& batch, const wchar_t* text, unsigned int length, float x, float y,
+        float scale, float opacity, int layer)
+    {
+        m_quads.clear();
+        m_table.Layout(text, length, x, y, scale, m_quads);
+        Submit(batch, opacity, layer);
+    }
+
+    void BitmapFont::Draw(SpriteBatch& batch, const char* text, unsigned int length, float x, float y,
+        float scale, float opacity, int layer)
+    {
+        m_quads.clear();
+        m_table.Layout(text, length, x, y, scale, m_quads);
+        Submit(batch, opacity, layer);
+    }
+
+    void BitmapFont::Draw(const wchar_t* text, unsigned int length, float x, float y, float scale, float opacity)
+    {
+        // One bitmap per glyph, for a few strings, anything more should go through a sprite batch
+        m_quads.clear();
+        m_table.Layout(text, length, x, y, scale, m_quads);
+        ID2D1RenderTarget* pRT = m_pManager->GetRenderTarget();
+        for (const GlyphTable::Quad& quad : m_quads)
+        {
+            D2D1_RECT_F source = D2D1::RectF((float)quad.sourceLeft, (float)quad.sourceTop,
+                (float)quad.sourceRight, (float)quad.sourceBottom);
+            pRT->DrawBitmap(GetPage(quad.page), D2D1::RectF(quad.left, quad.top, quad.right, quad.bottom), opacity,
+                D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, &source);
+        }
+    }
+
+    D2D1_SIZE_F BitmapFont::Measure(const wchar_t* text, unsigned int length, float scale) const
+    {
+        GlyphTable::Size size = m_table.Measure(text, length, scale);
+        return D2D1::SizeF(size.width, size.height);
+    }
+
+    D2D1_SIZE_F BitmapFont::Measure(const char* text, unsigned int length, float scale) const
+    {
+        GlyphTable::Size size = m_table.Measure(text, length, scale);
+        return D2D1::SizeF(size.width, size.height);
+    }
+
+    const GlyphTable& BitmapFont::GetTable() const
+    {
+        return m_table;
+    }
+
+    unsigned int BitmapFont::GetPageCount() const
+    {
+        return (unsigned int)m_pages.size();
+    }
+
+    ID2D1Bitmap* BitmapFont::GetPage(unsigned int page) const
+    {
+        return m_pages.at(page).Get();
+    }
+
+    void BitmapFont::Parse(const void* pData, size_t size)
+    {
+        GlyphTable::Result result = m_table.Parse(pData, size);
+        if (result != GlyphTable::Result::Ok)
+        {
+            throw std::runtime_error(std::string("Bitmap font: ") + GlyphTable::GetResultName(result) + ".");
+        }
+    }
+
+    void BitmapFont::Submit(SpriteBatch& batch, float opacity, int layer)
+    {
+        // Glyphs of a page share its bitmap, so a sorted batch draws a whole page of text at once
+        for (const GlyphTable::Quad& quad : m_quads)
+        {
+            D2D1_RECT_U source = D2D1::RectU(quad.sourceLeft, quad.sourceTop, quad.sourceRight, quad.sourceBottom);
+            batch.Draw(GetPage(quad.page), D2D1::RectF(quad.left, quad.top, quad.right, quad.bottom), &source,
+                opacity, layer);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "ResourceManager.h"
+#include "GlyphTable.h"
+#include "Images.h"
+#include "SpriteBatch.h"
+#include "AssetPack.h"
+#include <vector>
+
+namespace Ice2D
+{
+	class BitmapFont : private IBasicResource
+	{
+	public:
+		BitmapFont();
+		BitmapFont(ResourceManager* pManager, const wchar_t* path);
+		BitmapFont(ResourceManager* pManager, const AssetPack& pack, const char* name);
+		BitmapFont(ResourceManager* pManager, const GlyphTable& table, std::vector<D2DImage>&& pages);
+		BitmapFont(const BitmapFont& other) = delete;
+		BitmapFont& operator=(const BitmapFont& other) = delete;
+		BitmapFont(BitmapFont&& other) noexcept;
+		BitmapFont& operator=(BitmapFont&& other) noexcept;
+		~BitmapFont();
+		void Release() override;
+		void Draw(SpriteBatch& batch, const wchar_t* text, unsigned int length, float x, float y,
+			float scale = 1.0f, float opacity = 1.0f, int layer = 0);
+		void Draw(SpriteBatch& batch, const char* text, unsigned int length, float x, float y,
+			float scale = 1.0f, float opacity = 1.0f, int layer = 0);
+		void Draw(const wchar_t* text, unsigned int length, float x, float y, float scale = 1.0f, float opacity = 1.0f);
+		D2D1_SIZE_F Measure(const wchar_t* text, unsigned int length, float scale = 1.0f) const;
+		D2D1_SIZE_F Measure(const char* text, unsigned int length, float scale = 1.0f) const;
+		const GlyphTable& GetTable() const;
+		unsigned int GetPageCount() const;
+		ID2D1Bitmap* GetPage(unsigned int page) const;
+	private:
+		GlyphTable m_table;
+		std::vector<D2DImage> m_pages;
+		std::vector<GlyphTable::Quad> m_quads;
+		void Parse(const void* pData, size_t size);
+		void Submit(SpriteBatch& batch, float opacity, int layer);
+	};
+}
@@ -6,39 +6,32 @@
 
 namespace Ice2D
 {
-    SolidBrush::SolidBrush() : m_pBrush(nullptr)
+    SolidBrush::SolidBrush() : m_color()
     {
     }
 
-    SolidBrush::SolidBrush(ResourceManager* pManager, const D2D1_COLOR_F& color) : IBasicResource(pManager)
+    // Brushes of the same color are shared through the manager's cache, so the brush itself is never changed
+    SolidBrush::SolidBrush(ResourceManager* pManager, const D2D1_COLOR_F& color) : IBasicResource(pManager),
+        m_color(color)
     {
-        HRESULT hr = pManager->GetRenderTarget()->CreateSolidColorBrush(color, &m_pBrush);
-		CheckHR(hr);
+        m_brush = pManager->GetBrushCache().GetSolid(pManager->GetRenderTarget(), color);
         OnLoad();
     }
 
     SolidBrush::SolidBrush(ResourceManager* pManager, const float r, const float g, const float b, const float a) :
-        IBasicResource(pManager)
+        SolidBrush(pManager, D2D1::ColorF(r, g, b, a))
     {
-        HRESULT hr = pManager->GetRenderTarget()->CreateSolidColorBrush(D2D1::ColorF(r, g, b, a), &m_pBrush);
-		CheckHR(hr);
-        OnLoad();
     }
 
     SolidBrush::SolidBrush(ResourceManager* pManager, const float brightness, const float a) :
-        IBasicResource(pManager)
+        SolidBrush(pManager, D2D1::ColorF(brightness, brightness, brightness, a))
     {
-        HRESULT hr = pManager->GetRenderTarget()->CreateSolidColorBrush(
-            D2D1::ColorF(brightness, brightness, brightness, a), &m_pBrush
-        );
-		CheckHR(hr);
-        OnLoad();
     }
 
-    SolidBrush::SolidBrush(SolidBrush&& other) noexcept : IBasicResource(other), m_pBrush(other.m_pBrush)
+    SolidBrush::SolidBrush(SolidBrush&& other) noexcept : IBasicResource(other), m_brush(std::move(other.m_brush)),
+        m_color(other.m_color)
     {
-        other.m_pBrush = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     SolidBrush& SolidBrush::operator=(SolidBrush&& other) noexcept
@@ -46,10 +39,10 @@ namespace Ice2D
         if (this == &other) return *this;
         m_pManager = other.m_pManager;
         Release();
-        m_pBrush = other.m_pBrush;
-        other.m_pBrush = nullptr;
+        m_brush = std::move(other.m_brush);
+        m_color = other.m_color;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -60,38 +53,42 @@ namespace Ice2D
 
     void SolidBrush::Release()
     {
-        SafeRelease(m_pBrush);
+        m_brush.Reset();
         OnUnload();
     }
 
-    ID2D1SolidColorBrush* SolidBrush::Get() const
+    ID2D1Brush* SolidBrush::Get() const
     {
-        if (!m_pBrush) throw std::runtime_error("Solid brush is null.");
-        return m_pBrush;
+        if (!m_brush) throw std::runtime_error("Solid brush is null.");
+        return m_brush.Get();
+    }
+
+    const D2D1_COLOR_F& SolidBrush::GetColor() const
+    {
+        return m_color;
     }
 
     void SolidBrush::SetColor(const D2D1_COLOR_F& color)
     {
-        if (!m_pBrush) throw std::runtime_error("Solid brush is null.");
-        m_pBrush->SetColor(color);
+        // Swaps to the cached brush of the new color, others holding the old one keep their color
+        if (!m_brush) throw std::runtime_error("Solid brush is null.");
+        m_brush = m_pManager->GetBrushCache().GetSolid(m_pManager->GetRenderTarget(), color);
+        m_color = color;
     }
 
     void SolidBrush::SetColor(const float r, const float g, const float b, const float a)
     {
-        if (!m_pBrush) throw std::runtime_error("Solid brush is null.");
-        m_pBrush->SetColor(D2D1::ColorF(r, g, b, a));
+        SetColor(D2D1::ColorF(r, g, b, a));
     }
 
     void SolidBrush::SetColor(const float brightness, const float a)
     {
-        if (!m_pBrush) throw std::runtime_error("Solid brush is null.");
-        m_pBrush->SetColor(D2D1::ColorF(brightness, brightness, brightness, a));
+        SetColor(D2D1::ColorF(brightness, brightness, brightness, a));
     }
 
     void SolidBrush::SetColor(const SolidBrush& other)
     {
-        if (!m_pBrush) throw std::runtime_error("Solid brush is null.");
-        m_pBrush->SetColor(other.m_pBrush->GetColor());
+        SetColor(other.m_color);
     }
 
     BitmapBrush::BitmapBrush() : m_pBrush(nullptr)
@@ -125,7 +122,7 @@ namespace Ice2D
     BitmapBrush::BitmapBrush(BitmapBrush&& other) noexcept : IBasicResource(other), m_pBrush(other.m_pBrush)
     {
         other.m_pBrush = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     BitmapBrush& BitmapBrush::operator=(BitmapBrush&& other) noexcept
@@ -136,7 +133,7 @@ namespace Ice2D
         m_pBrush = other.m_pBrush;
         other.m_pBrush = nullptr;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -174,10 +171,11 @@ namespace Ice2D
         OnLoad();
     }
 
-    GradientStops::GradientStops(GradientStops&& other) noexcept : IBasicResource(other), m_pStops(nullptr)
+    GradientStops::GradientStops(GradientStops&& other) noexcept : IBasicResource(other), m_pStops(other.m_pStops)
     {
-        m_vecStops = other.m_vecStops;
-        OnLoad();
+        other.m_pStops = nullptr;
+        m_vecStops = std::move(other.m_vecStops);
+        OnMove(other);
     }
 
     GradientStops& GradientStops::operator=(GradientStops&& other) noexcept
@@ -185,7 +183,11 @@ namespace Ice2D
         if (this == &other) return *this;
         m_pManager = other.m_pManager;
         Release();
-        m_vecStops = other.m_vecStops;
+        m_pStops = other.m_pStops;
+        other.m_pStops = nullptr;
+        m_vecStops = std::move(other.m_vecStops);
+
+        OnMove(other);
         return *this;
     }
 
@@ -205,6 +207,11 @@ namespace Ice2D
 		return m_vecStops.size();
     }
 
+    const std::vector<D2D1_GRADIENT_STOP>& GradientStops::GetStops() const
+    {
+        return m_vecStops;
+    }
+
     void GradientStops::CopyFrom(const GradientStops& other)
     {
         m_vecStops = other.m_vecStops;
@@ -262,7 +269,7 @@ namespace Ice2D
         IBasicResource(other), m_pBrush(other.m_pBrush)
     {
         other.m_pBrush = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     LinearBrush& LinearBrush::operator=(LinearBrush&& other) noexcept
@@ -273,7 +280,7 @@ namespace Ice2D
         m_pBrush = other.m_pBrush;
         other.m_pBrush = nullptr;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -332,7 +339,7 @@ namespace Ice2D
         IBasicResource(other), m_pBrush(other.m_pBrush)
     {
         other.m_pBrush = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     RadialBrush& RadialBrush::operator=(RadialBrush&& other) noexcept
@@ -343,7 +350,7 @@ namespace Ice2D
         m_pBrush = other.m_pBrush;
         other.m_pBrush = nullptr;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
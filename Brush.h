@@ -18,13 +18,15 @@ namespace Ice2D
 		SolidBrush& operator=(SolidBrush&& other) noexcept;
 		~SolidBrush();
 		void Release() override;
-		ID2D1SolidColorBrush* Get() const;
+		ID2D1Brush* Get() const;
+		const D2D1_COLOR_F& GetColor() const;
 		void SetColor(const D2D1_COLOR_F& color);
 		void SetColor(const float r, const float g, const float b, const float a = 1.0f);
 		void SetColor(const float brightness, const float a = 1.0f);
 		void SetColor(const SolidBrush& other);
 	private:
-		ID2D1SolidColorBrush* m_pBrush;
+		SharedBrush m_brush;
+		D2D1_COLOR_F m_color;
 	};
 
 	class BitmapBrush : private IBasicResource
@@ -64,6 +66,7 @@ namespace Ice2D
 		ID2D1GradientStopCollection* Get();
 		void Release() override;
 		size_t StopCount() const;
+		const std::vector<D2D1_GRADIENT_STOP>& GetStops() const;
 	private:
 		ID2D1GradientStopCollection* m_pStops;
 		std::vector<D2D1_GRADIENT_STOP> m_vecStops;
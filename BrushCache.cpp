@@ -0,0 +1,316 @@
+#include "pch.h"
+
+#include "BrushCache.h"
+#include "Brush.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+#include <cstring>
+
+namespace Ice2D
+{
+    static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static const uint64_t FNV_PRIME = 1099511628211ull;
+
+    BrushCache::BrushCache(unsigned int capacity) :
+        m_capacity(capacity), m_hits(0ull), m_misses(0ull), m_evictions(0ull)
+    {
+    }
+
+    BrushCache::~BrushCache()
+    {
+        Clear();
+    }
+
+    void BrushCache::SetCapacity(unsigned int capacity)
+    {
+        m_capacity = capacity;
+        Trim();
+    }
+
+    unsigned int BrushCache::GetCapacity() const
+    {
+        return m_capacity;
+    }
+
+    bool BrushCache::IsEnabled() const
+    {
+        return m_capacity > 0u;
+    }
+
+    SharedBrush BrushCache::GetSolid(ID2D1RenderTarget* pRenderTarget, const D2D1_COLOR_F& color)
+    {
+        if (!pRenderTarget) throw std::runtime_error("Render target is null.");
+        Begin(Kind::Solid);
+        Append(color);
+        const uint64_t key = MakeKey();
+        IUnknown* pFound = Find(key);
+        if (pFound) return SharedBrush(static_cast<ID2D1SolidColorBrush*>(pFound));
+
+        ID2D1SolidColorBrush* pBrush = nullptr;
+        HRESULT hr = pRenderTarget->CreateSolidColorBrush(color, &pBrush);
+        CheckHR(hr);
+        // The handle owns the new brush before Insert() gets a chance to throw
+        SharedBrush brush(pBrush);
+        Insert(key, m_scratch, pBrush);
+        return brush;
+    }
+
+    SharedGradientStops BrushCache::GetGradientStops(ID2D1RenderTarget* pRenderTarget,
+        const D2D1_GRADIENT_STOP* pStops, unsigned int count, D2D1_EXTEND_MODE extendMode)
+    {
+        if (!pRenderTarget) throw std::runtime_error("Render target is null.");
+        if (!pStops || count == 0u) throw std::runtime_error("No gradient stops were given.");
+        Begin(Kind::Stops);
+        AppendStops(pStops, count, extendMode);
+        const uint64_t key = MakeKey();
+        IUnknown* pFound = Find(key);
+        if (pFound) return SharedGradientStops(static_cast<ID2D1GradientStopCollection*>(pFound));
+
+        ID2D1GradientStopCollection* pCollection = nullptr;
+        HRESULT hr = pRenderTarget->CreateGradientStopCollection(pStops, count, D2D1_GAMMA_2_2, extendMode,
+            &pCollection);
+        CheckHR(hr);
+        SharedGradientStops collection(pCollection);
+        Insert(key, m_scratch, pCollection);
+        return collection;
+    }
+
+    SharedBrush BrushCache::GetLinear(ID2D1RenderTarget* pRenderTarget,
+        const D2D1_GRADIENT_STOP* pStops, unsigned int count, const D2D1_LINEAR_GRADIENT_BRUSH_PROPERTIES& properties,
+        D2D1_EXTEND_MODE extendMode)
+    {
+        if (!pRenderTarget) throw std::runtime_error("Render target is null.");
+        if (!pStops || count == 0u) throw std::runtime_error("No gradient stops were given.");
+        Begin(Kind::Linear);
+        AppendStops(pStops, count, extendMode);
+        Append(properties.startPoint);
+        Append(properties.endPoint);
+        const uint64_t key = MakeKey();
+        IUnknown* pFound = Find(key);
+        if (pFound) return SharedBrush(static_cast<ID2D1LinearGradientBrush*>(pFound));
+
+        // Looking up the stops reuses the scratch key, so keep this one
+        const std::vector<uint32_t> data(m_scratch);
+        SharedGradientStops collection = GetGradientStops(pRenderTarget, pStops, count, extendMode);
+        ID2D1LinearGradientBrush* pBrush = nullptr;
+        HRESULT hr = pRenderTarget->CreateLinearGradientBrush(properties, collection.Get(), &pBrush);
+        CheckHR(hr);
+        SharedBrush brush(pBrush);
+        Insert(key, data, pBrush);
+        return brush;
+    }
+
+    SharedBrush BrushCache::GetLinear(ID2D1RenderTarget* pRenderTarget, const GradientStops& stops,
+        const D2D1_LINEAR_GRADIENT_BRUSH_PROPERTIES& properties, D2D1_EXTEND_MODE extendMode)
+    {
+        const std::vector<D2D1_GRADIENT_STOP>& vecStops = stops.GetStops();
+        return GetLinear(pRenderTarget, vecStops.data(), (unsigned int)vecStops.size(), properties, extendMode);
+    }
+
+    SharedBrush BrushCache::GetRadial(ID2D1RenderTarget* pRenderTarget,
+        const D2D1_GRADIENT_STOP* pStops, unsigned int count, const D2D1_RADIAL_GRADIENT_BRUSH_PROPERTIES& properties,
+        D2D1_EXTEND_MODE extendMode)
+    {
+        if (!pRenderTarget) throw std::runtime_error("Render target is null.");
+        if (!pStops || count == 0u) throw std::runtime_error("No gradient stops were given.");
+        Begin(Kind::Radial);
+        AppendStops(pStops, count, extendMode);
+        Append(properties.center);
+        Append(properties.gradientOriginOffset);
+        Append(properties.radiusX);
+        Append(properties.radiusY);
+        const uint64_t key = MakeKey();
+        IUnknown* pFound = Find(key);
+        if (pFound) return SharedBrush(static_cast<ID2D1RadialGradientBrush*>(pFound));
+
+        const std::vector<uint32_t> data(m_scratch);
+        SharedGradientStops collection = GetGradientStops(pRenderTarget, pStops, count, extendMode);
+        ID2D1RadialGradientBrush* pBrush = nullptr;
+        HRESULT hr = pRenderTarget->CreateRadialGradientBrush(properties, collection.Get(), &pBrush);
+        CheckHR(hr);
+        SharedBrush brush(pBrush);
+        Insert(key, data, pBrush);
+        return brush;
+    }
+
+    SharedBrush BrushCache::GetRadial(ID2D1RenderTarget* pRenderTarget, const GradientStops& stops,
+        const D2D1_RADIAL_GRADIENT_BRUSH_PROPERTIES& properties, D2D1_EXTEND_MODE extendMode)
+    {
+        const std::vector<D2D1_GRADIENT_STOP>& vecStops = stops.GetStops();
+        return GetRadial(pRenderTarget, vecStops.data(), (unsigned int)vecStops.size(), properties, extendMode);
+    }
+
+    unsigned long long BrushCache::GetUseCount(ID2D1Brush* pBrush) const
+    {
+        for (const Entry& entry : m_lru)
+        {
+            if (entry.pObject == static_cast<IUnknown*>(pBrush)) return entry.uses;
+        }
+        return 0ull;
+    }
+
+    void BrushCache::Clear()
+    {
+        while (!m_lru.empty()) Remove(m_lru.begin());
+    }
+
+    void BrushCache::ClearDeviceResources()
+    {
+        // Brushes and stop collections all belong to a render target
+        Clear();
+    }
+
+    BrushCache::Stats BrushCache::GetStats() const
+    {
+        Stats stats = {};
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.entries = (unsigned int)m_lru.size();
+        stats.capacity = m_capacity;
+        return stats;
+    }
+
+    void BrushCache::ResetStats()
+    {
+        m_hits = m_misses = m_evictions = 0ull;
+    }
+
+    void BrushCache::Begin(Kind kind)
+    {
+        // The scratch key keeps its capacity, so a lookup that hits doesn't allocate
+        m_scratch.clear();
+        m_scratch.push_back((uint32_t)kind);
+    }
+
+    void BrushCache::Append(uint32_t word)
+    {
+        m_scratch.push_back(word);
+    }
+
+    void BrushCache::Append(float value)
+    {
+        // Adding zero turns -0 into +0, both draw the same
+        value += 0.0f;
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        Append(bits);
+    }
+
+    void BrushCache::Append(const D2D1_POINT_2F& point)
+    {
+        Append(point.x);
+        Append(point.y);
+    }
+
+    void BrushCache::Append(const D2D1_COLOR_F& color)
+    {
+        Append(color.r);
+        Append(color.g);
+        Append(color.b);
+        Append(color.a);
+    }
+
+    void BrushCache::AppendStops(const D2D1_GRADIENT_STOP* pStops, unsigned int count, D2D1_EXTEND_MODE extendMode)
+    {
+        Append((uint32_t)extendMode);
+        Append(count);
+        for (unsigned int i = 0u; i < count; ++i)
+        {
+            Append(pStops[i].position);
+            Append(pStops[i].color);
+        }
+    }
+
+    uint64_t BrushCache::MakeKey() const
+    {
+        uint64_t key = FNV_OFFSET;
+        for (uint32_t word : m_scratch)
+        {
+            for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+            {
+                key ^= (word >> shift) & 0xFFu;
+                key *= FNV_PRIME;
+            }
+        }
+        return key;
+    }
+
+    IUnknown* BrushCache::Find(uint64_t key)
+    {
+        if (!IsEnabled()) return nullptr;
+
+        // The key is only a hash, the words behind it decide, a collision is just a miss
+        auto found = m_index.find(key);
+        if (found == m_index.end() || found->second->data != m_scratch)
+        {
+            ++m_misses;
+            return nullptr;
+        }
+
+        ++m_hits;
+        ++found->second->uses;
+        m_lru.splice(m_lru.begin(), m_lru, found->second);
+        m_lru.front().pObject->AddRef();
+        return m_lru.front().pObject;
+    }
+
+    void BrushCache::Insert(uint64_t key, const std::vector<uint32_t>& data, IUnknown* pObject)
+    {
+        if (!IsEnabled()) return;
+        auto found = m_index.find(key);
+        if (found != m_index.end()) Remove(found->second);
+
+        Entry entry = { key, data, pObject, 1ull };
+        m_lru.push_front(std::move(entry));
+        pObject->AddRef();
+        m_index[key] = m_lru.begin();
+        Trim();
+    }
+
+    void BrushCache::Remove(std::list<Entry>::iterator it)
+    {
+        SafeRelease(it->pObject);
+        m_index.erase(it->key);
+        m_lru.erase(it);
+    }
+
+    void BrushCache::Trim()
+    {
+        // Unheld entries that were asked for once go first, the ones asked for often get a second chance
+        for (auto it = m_lru.end(); m_lru.size() > m_capacity && it != m_lru.begin();)
+        {
+            --it;
+            if (InUse(*it)) continue;
+            if (it->uses > 1ull)
+            {
+                it->uses >>= 1;
+                continue;
+            }
+            auto victim = it++;
+            Remove(victim);
+            ++m_evictions;
+        }
+
+        for (auto it = m_lru.end(); m_lru.size() > m_capacity && it != m_lru.begin();)
+        {
+            --it;
+            if (InUse(*it)) continue;
+            auto victim = it++;
+            Remove(victim);
+            ++m_evictions;
+        }
+
+        while (m_lru.size() > m_capacity)
+        {
+            Remove(std::prev(m_lru.end()));
+            ++m_evictions;
+        }
+    }
+
+    bool BrushCache::InUse(const Entry& entry)
+    {
+        entry.pObject->AddRef();
+        return entry.pObject->Release() > 1u;
+    }
+}
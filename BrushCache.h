@@ -0,0 +1,151 @@
+#pragma once
+#include <d2d1.h>
+#include <cstdint>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace Ice2D
+{
+	class GradientStops;
+	class BrushCache;
+
+	// One reference to a cached brush or stop collection, released when the handle goes away
+	template <typename Interface>
+	class CachedRef
+	{
+		friend class BrushCache;
+	public:
+		CachedRef();
+		CachedRef(const CachedRef& other) = delete;
+		CachedRef& operator=(const CachedRef& other) = delete;
+		CachedRef(CachedRef&& other) noexcept;
+		CachedRef& operator=(CachedRef&& other) noexcept;
+		~CachedRef();
+		void Reset();
+		Interface* Get() const;
+		explicit operator bool() const;
+	private:
+		explicit CachedRef(Interface* pObject);
+		Interface* m_pObject;
+	};
+
+	// Brushes are shared with everyone asking for the same one, so only the base interface is handed out
+	typedef CachedRef<ID2D1Brush> SharedBrush;
+	typedef CachedRef<ID2D1GradientStopCollection> SharedGradientStops;
+
+	class BrushCache
+	{
+	public:
+		struct Stats
+		{
+			unsigned long long hits, misses, evictions;
+			unsigned int entries, capacity;
+		};
+		BrushCache(unsigned int capacity = 256u);
+		BrushCache(const BrushCache& other) = delete;
+		BrushCache& operator=(const BrushCache& other) = delete;
+		~BrushCache();
+		void SetCapacity(unsigned int capacity);
+		unsigned int GetCapacity() const;
+		bool IsEnabled() const;
+		SharedBrush GetSolid(ID2D1RenderTarget* pRenderTarget, const D2D1_COLOR_F& color);
+		SharedGradientStops GetGradientStops(ID2D1RenderTarget* pRenderTarget,
+			const D2D1_GRADIENT_STOP* pStops, unsigned int count, D2D1_EXTEND_MODE extendMode = D2D1_EXTEND_MODE_CLAMP);
+		SharedBrush GetLinear(ID2D1RenderTarget* pRenderTarget, const D2D1_GRADIENT_STOP* pStops,
+			unsigned int count, const D2D1_LINEAR_GRADIENT_BRUSH_PROPERTIES& properties,
+			D2D1_EXTEND_MODE extendMode = D2D1_EXTEND_MODE_CLAMP);
+		SharedBrush GetLinear(ID2D1RenderTarget* pRenderTarget, const GradientStops& stops,
+			const D2D1_LINEAR_GRADIENT_BRUSH_PROPERTIES& properties, D2D1_EXTEND_MODE extendMode = D2D1_EXTEND_MODE_CLAMP);
+		SharedBrush GetRadial(ID2D1RenderTarget* pRenderTarget, const D2D1_GRADIENT_STOP* pStops,
+			unsigned int count, const D2D1_RADIAL_GRADIENT_BRUSH_PROPERTIES& properties,
+			D2D1_EXTEND_MODE extendMode = D2D1_EXTEND_MODE_CLAMP);
+		SharedBrush GetRadial(ID2D1RenderTarget* pRenderTarget, const GradientStops& stops,
+			const D2D1_RADIAL_GRADIENT_BRUSH_PROPERTIES& properties, D2D1_EXTEND_MODE extendMode = D2D1_EXTEND_MODE_CLAMP);
+		unsigned long long GetUseCount(ID2D1Brush* pBrush) const;
+		void Clear();
+		void ClearDeviceResources();
+		Stats GetStats() const;
+		void ResetStats();
+	private:
+		enum class Kind : uint32_t { Solid, Stops, Linear, Radial };
+		struct Entry
+		{
+			uint64_t key;
+			std::vector<uint32_t> data;
+			IUnknown* pObject;
+			unsigned long long uses;
+		};
+		std::list<Entry> m_lru;
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+		std::vector<uint32_t> m_scratch;
+		unsigned int m_capacity;
+		unsigned long long m_hits, m_misses, m_evictions;
+		void Begin(Kind kind);
+		void Append(uint32_t word);
+		void Append(float value);
+		void Append(const D2D1_POINT_2F& point);
+		void Append(const D2D1_COLOR_F& color);
+		void AppendStops(const D2D1_GRADIENT_STOP* pStops, unsigned int count, D2D1_EXTEND_MODE extendMode);
+		uint64_t MakeKey() const;
+		IUnknown* Find(uint64_t key);
+		void Insert(uint64_t key, const std::vector<uint32_t>& data, IUnknown* pObject);
+		void Remove(std::list<Entry>::iterator it);
+		void Trim();
+		static bool InUse(const Entry& entry);
+	};
+
+	template <typename Interface>
+	CachedRef<Interface>::CachedRef() : m_pObject(nullptr)
+	{
+	}
+
+	template <typename Interface>
+	CachedRef<Interface>::CachedRef(Interface* pObject) : m_pObject(pObject)
+	{
+	}
+
+	template <typename Interface>
+	CachedRef<Interface>::CachedRef(CachedRef&& other) noexcept : m_pObject(other.m_pObject)
+	{
+		other.m_pObject = nullptr;
+	}
+
+	template <typename Interface>
+	CachedRef<Interface>& CachedRef<Interface>::operator=(CachedRef&& other) noexcept
+	{
+		if (this == &other) return *this;
+		Reset();
+		m_pObject = other.m_pObject;
+		other.m_pObject = nullptr;
+		return *this;
+	}
+
+	template <typename Interface>
+	CachedRef<Interface>::~CachedRef()
+	{
+		Reset();
+	}
+
+	template <typename Interface>
+	void CachedRef<Interface>::Reset()
+	{
+		if (!m_pObject) return;
+		m_pObject->Release();
+		m_pObject = nullptr;
+	}
+
+	template <typename Interface>
+	Interface* CachedRef<Interface>::Get() const
+	{
+		if (!m_pObject) throw std::runtime_error("Cached brush is null.");
+		return m_pObject;
+	}
+
+	template <typename Interface>
+	CachedRef<Interface>::operator bool() const
+	{
+		return m_pObject != nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "pch.h"
+
+#include "CachedLayer.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+
+namespace Ice2D
+{
+    CachedLayer::CachedLayer() : m_pTarget(nullptr), m_width(0u), m_height(0u), m_renderCount(0u), m_isDirty(true)
+    {
+    }
+
+    CachedLayer::CachedLayer(ResourceManager* pManager, unsigned int width, unsigned int height) :
+        IBasicResource(pManager), m_pTarget(nullptr), m_width(width), m_height(height), m_renderCount(0u),
+        m_isDirty(true)
+    {
+        if (width == 0u || height == 0u) throw std::runtime_error("Layer size is zero.");
+        OnLoad();
+    }
+
+    CachedLayer::CachedLayer(CachedLayer&& other) noexcept : IBasicResource(other), m_image(std::move(other.m_image)),
+        m_commands(std::move(other.m_commands)), m_pTarget(other.m_pTarget), m_width(other.m_width),
+        m_height(other.m_height), m_renderCount(other.m_renderCount), m_isDirty(other.m_isDirty)
+    {
+        other.m_pTarget = nullptr;
+        OnMove(other);
+    }
+
+    CachedLayer& CachedLayer::operator=(CachedLayer&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_pManager = other.m_pManager;
+        Release();
+        m_image = std::move(other.m_image);
+        m_commands = std::move(other.m_commands);
+        m_pTarget = other.m_pTarget;
+        m_width = other.m_width;
+        m_height = other.m_height;
+        m_renderCount = other.m_renderCount;
+        m_isDirty = other.m_isDirty;
+        other.m_pTarget = nullptr;
+
+        OnMove(other);
+        return *this;
+    }
+
+    CachedLayer::~CachedLayer()
+    {
+        Release();
+    }
+
+    void CachedLayer::Release()
+    {
+        m_image.Release();
+        m_commands.Reset();
+        SafeRelease(m_pTarget);
+        m_isDirty = true;
+        OnUnload();
+    }
+
+    CommandList& CachedLayer::Record()
+    {
+        m_commands.Reset();
+        m_isDirty = true;
+        return m_commands;
+    }
+
+    const CommandList& CachedLayer::GetCommands() const
+    {
+        return m_commands;
+    }
+
+    void CachedLayer::Invalidate()
+    {
+        m_isDirty = true;
+    }
+
+    bool CachedLayer::IsDirty() const
+    {
+        return m_isDirty;
+    }
+
+    void CachedLayer::Update()
+    {
+        if (!m_pManager) throw std::runtime_error("Resource manager is null.");
+
+        // The image has to be compatible with the render target it gets drawn onto
+        ID2D1RenderTarget* pRT = m_pManager->GetRenderTarget();
+        if (pRT != m_pTarget)
+        {
+            m_image = ImageRenderTarget(m_pManager, m_width, m_height);
+            SafeRelease(m_pTarget);
+            m_pTarget = pRT;
+            m_pTarget->AddRef();
+            m_isDirty = true;
+        }
+        if (!m_isDirty) return;
+
+        ID2D1RenderTarget* pImageRT = m_image.GetRT();
+        pImageRT->BeginDraw();
+        pImageRT->SetTransform(D2D1::Matrix3x2F::Identity());
+        pImageRT->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+        try
+        {
+            m_commands.Replay(pImageRT);
+        }
+        catch (...)
+        {
+            pImageRT->EndDraw();
+            throw;
+        }
+        HRESULT hr = pImageRT->EndDraw();
+        if (hr == D2DERR_RECREATE_TARGET)
+        {
+            // Stays dirty, the next update starts over with a new image
+            m_image.Release();
+            SafeRelease(m_pTarget);
+            return;
+        }
+        CheckHR(hr);
+        m_isDirty = false;
+        ++m_renderCount;
+    }
+
+    void CachedLayer::Draw(const D2D1_RECT_F& dest, float opacity)
+    {
+        Update();
+        if (!m_pTarget) return;
+        m_pTarget->DrawBitmap(m_image.GetBitmap(), dest, opacity, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR);
+    }
+
+    void CachedLayer::Draw(float x, float y, float opacity)
+    {
+        Draw(D2D1::RectF(x, y, x + (float)m_width, y + (float)m_height), opacity);
+    }
+
+    ID2D1Bitmap* CachedLayer::GetBitmap()
+    {
+        Update();
+        return m_image.GetBitmap();
+    }
+
+    unsigned int CachedLayer::GetWidth() const
+    {
+        return m_width;
+    }
+
+    unsigned int CachedLayer::GetHeight() const
+    {
+        return m_height;
+    }
+
+    unsigned int CachedLayer::GetRenderCount() const
+    {
+        return m_renderCount;
+    }
+}
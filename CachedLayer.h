@@ -0,0 +1,37 @@
+#pragma once
+#include "ResourceManager.h"
+#include "Images.h"
+#include "CommandList.h"
+
+namespace Ice2D
+{
+	class CachedLayer : private IBasicResource
+	{
+	public:
+		CachedLayer();
+		CachedLayer(ResourceManager* pManager, unsigned int width, unsigned int height);
+		CachedLayer(const CachedLayer& other) = delete;
+		CachedLayer& operator=(const CachedLayer& other) = delete;
+		CachedLayer(CachedLayer&& other) noexcept;
+		CachedLayer& operator=(CachedLayer&& other) noexcept;
+		~CachedLayer();
+		void Release() override;
+		CommandList& Record();
+		const CommandList& GetCommands() const;
+		void Invalidate();
+		bool IsDirty() const;
+		void Update();
+		void Draw(const D2D1_RECT_F& dest, float opacity = 1.0f);
+		void Draw(float x, float y, float opacity = 1.0f);
+		ID2D1Bitmap* GetBitmap();
+		unsigned int GetWidth() const;
+		unsigned int GetHeight() const;
+		unsigned int GetRenderCount() const;
+	private:
+		ImageRenderTarget m_image;
+		CommandList m_commands;
+		ID2D1RenderTarget* m_pTarget;
+		unsigned int m_width, m_height, m_renderCount;
+		bool m_isDirty;
+	};
+}
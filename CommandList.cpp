@@ -0,0 +1,482 @@
+#include "pch.h"
+
+#include "CommandList.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+#include <cstring>
+
+namespace Ice2D
+{
+    CommandTarget::Brush::Brush(ID2D1Brush* pBrush) : pBrush(pBrush), color(D2D1::ColorF(D2D1::ColorF::Black))
+    {
+        if (!pBrush) throw std::runtime_error("Brush is null.");
+    }
+
+    CommandTarget::Brush::Brush(const D2D1_COLOR_F& color) : pBrush(nullptr), color(color)
+    {
+    }
+
+    D2DCommandTarget::D2DCommandTarget(ID2D1RenderTarget* pRenderTarget) : m_pRT(pRenderTarget),
+        m_pSolidBrush(nullptr)
+    {
+        if (!m_pRT) throw std::runtime_error("Render target is null.");
+        m_pRT->AddRef();
+        m_pRT->GetTransform(&m_base);
+    }
+
+    D2DCommandTarget::~D2DCommandTarget()
+    {
+        m_pRT->SetTransform(m_base);
+        SafeRelease(m_pSolidBrush);
+        SafeRelease(m_pRT);
+    }
+
+    void D2DCommandTarget::Clear(const D2D1_COLOR_F& color)
+    {
+        m_pRT->Clear(color);
+    }
+
+    void D2DCommandTarget::SetTransform(const D2D1_MATRIX_3X2_F& transform)
+    {
+        // Recorded transforms apply on top of whatever transform the render target had when replay started
+        m_pRT->SetTransform(*D2D1::Matrix3x2F::ReinterpretBaseType(&transform) *
+            *D2D1::Matrix3x2F::ReinterpretBaseType(&m_base));
+    }
+
+    void D2DCommandTarget::FillRectangle(const D2D1_RECT_F& rect, const Brush& brush)
+    {
+        m_pRT->FillRectangle(rect, Resolve(brush));
+    }
+
+    void D2DCommandTarget::DrawRectangle(const D2D1_RECT_F& rect, const Brush& brush, float strokeWidth)
+    {
+        m_pRT->DrawRectangle(rect, Resolve(brush), strokeWidth);
+    }
+
+    void D2DCommandTarget::FillRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush)
+    {
+        m_pRT->FillRoundedRectangle(rect, Resolve(brush));
+    }
+
+    void D2DCommandTarget::DrawRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush, float strokeWidth)
+    {
+        m_pRT->DrawRoundedRectangle(rect, Resolve(brush), strokeWidth);
+    }
+
+    void D2DCommandTarget::FillEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush)
+    {
+        m_pRT->FillEllipse(ellipse, Resolve(brush));
+    }
+
+    void D2DCommandTarget::DrawEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush, float strokeWidth)
+    {
+        m_pRT->DrawEllipse(ellipse, Resolve(brush), strokeWidth);
+    }
+
+    void D2DCommandTarget::DrawLine(const D2D1_POINT_2F& start, const D2D1_POINT_2F& end, const Brush& brush,
+        float strokeWidth)
+    {
+        m_pRT->DrawLine(start, end, Resolve(brush), strokeWidth);
+    }
+
+    void D2DCommandTarget::DrawBitmap(ID2D1Bitmap* pBitmap, const D2D1_RECT_F& dest, float opacity,
+        D2D1_BITMAP_INTERPOLATION_MODE interpolation, const D2D1_RECT_F* pSource)
+    {
+        m_pRT->DrawBitmap(pBitmap, dest, opacity, interpolation, pSource);
+    }
+
+    void D2DCommandTarget::FillGeometry(ID2D1Geometry* pGeometry, const Brush& brush)
+    {
+        m_pRT->FillGeometry(pGeometry, Resolve(brush));
+    }
+
+    void D2DCommandTarget::DrawGeometry(ID2D1Geometry* pGeometry, const Brush& brush, float strokeWidth)
+    {
+        m_pRT->DrawGeometry(pGeometry, Resolve(brush), strokeWidth);
+    }
+
+    void D2DCommandTarget::FillMesh(ID2D1Mesh* pMesh, const Brush& brush)
+    {
+        // Meshes are aliased geometry, Direct2D refuses to fill them with antialiasing on
+        D2D1_ANTIALIAS_MODE antialiasMode = m_pRT->GetAntialiasMode();
+        m_pRT->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+        m_pRT->FillMesh(pMesh, Resolve(brush));
+        m_pRT->SetAntialiasMode(antialiasMode);
+    }
+
+    void D2DCommandTarget::DrawText(const wchar_t* text, unsigned int length, IDWriteTextFormat* pFormat,
+        const D2D1_RECT_F& rect, const Brush& brush)
+    {
+        m_pRT->DrawText(text, length, pFormat, rect, Resolve(brush));
+    }
+
+    void D2DCommandTarget::PushClip(const D2D1_RECT_F& rect, D2D1_ANTIALIAS_MODE antialiasMode)
+    {
+        m_pRT->PushAxisAlignedClip(rect, antialiasMode);
+    }
+
+    void D2DCommandTarget::PopClip()
+    {
+        m_pRT->PopAxisAlignedClip();
+    }
+
+    ID2D1Brush* D2DCommandTarget::Resolve(const Brush& brush)
+    {
+        if (brush.pBrush) return brush.pBrush;
+
+        // Recorded colors share one solid brush that is recolored per command
+        if (!m_pSolidBrush)
+        {
+            HRESULT hr = m_pRT->CreateSolidColorBrush(brush.color, &m_pSolidBrush);
+            CheckHR(hr);
+        }
+        else
+        {
+            m_pSolidBrush->SetColor(brush.color);
+        }
+        return m_pSolidBrush;
+    }
+
+    CommandList::CommandList() : m_commandCount(0u), m_clipDepth(0u)
+    {
+    }
+
+    CommandList::CommandList(CommandList&& other) noexcept : m_data(std::move(other.m_data)),
+        m_resources(std::move(other.m_resources)), m_resourceIds(std::move(other.m_resourceIds)),
+        m_commandCount(other.m_commandCount), m_clipDepth(other.m_clipDepth)
+    {
+        other.m_resources.clear();
+        other.m_resourceIds.clear();
+        other.m_data.clear();
+        other.m_commandCount = 0u;
+        other.m_clipDepth = 0u;
+    }
+
+    CommandList& CommandList::operator=(CommandList&& other) noexcept
+    {
+        if (this == &other) return *this;
+        Reset();
+        m_data = std::move(other.m_data);
+        m_resources = std::move(other.m_resources);
+        m_resourceIds = std::move(other.m_resourceIds);
+        m_commandCount = other.m_commandCount;
+        m_clipDepth = other.m_clipDepth;
+        other.m_resources.clear();
+        other.m_resourceIds.clear();
+        other.m_data.clear();
+        other.m_commandCount = 0u;
+        other.m_clipDepth = 0u;
+        return *this;
+    }
+
+    CommandList::~CommandList()
+    {
+        Reset();
+    }
+
+    void CommandList::Reset()
+    {
+        // Keeps the capacity, so re-recording a list of the same size doesn't allocate
+        for (IUnknown* pResource : m_resources) pResource->Release();
+        m_resources.clear();
+        m_resourceIds.clear();
+        m_data.clear();
+        m_commandCount = 0u;
+        m_clipDepth = 0u;
+    }
+
+    void CommandList::Reserve(size_t bytes)
+    {
+        m_data.reserve(bytes);
+    }
+
+    void CommandList::Clear(const D2D1_COLOR_F& color)
+    {
+        Write(Op::Clear, &color, sizeof(color));
+    }
+
+    void CommandList::SetTransform(const D2D1_MATRIX_3X2_F& transform)
+    {
+        Write(Op::SetTransform, &transform, sizeof(transform));
+    }
+
+    void CommandList::FillRectangle(const D2D1_RECT_F& rect, const Brush& brush)
+    {
+        WriteShape(Op::FillRectangle, rect, brush, 0.0f);
+    }
+
+    void CommandList::DrawRectangle(const D2D1_RECT_F& rect, const Brush& brush, float strokeWidth)
+    {
+        WriteShape(Op::DrawRectangle, rect, brush, strokeWidth);
+    }
+
+    void CommandList::FillRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush)
+    {
+        WriteShape(Op::FillRoundedRectangle, rect, brush, 0.0f);
+    }
+
+    void CommandList::DrawRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush, float strokeWidth)
+    {
+        WriteShape(Op::DrawRoundedRectangle, rect, brush, strokeWidth);
+    }
+
+    void CommandList::FillEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush)
+    {
+        WriteShape(Op::FillEllipse, ellipse, brush, 0.0f);
+    }
+
+    void CommandList::DrawEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush, float strokeWidth)
+    {
+        WriteShape(Op::DrawEllipse, ellipse, brush, strokeWidth);
+    }
+
+    void CommandList::DrawLine(const D2D1_POINT_2F& start, const D2D1_POINT_2F& end, const Brush& brush,
+        float strokeWidth)
+    {
+        D2D1_POINT_2F points[2] = { start, end };
+        WriteShape(Op::DrawLine, points, brush, strokeWidth);
+    }
+
+    void CommandList::DrawBitmap(ID2D1Bitmap* pBitmap, const D2D1_RECT_F& dest, float opacity,
+        D2D1_BITMAP_INTERPOLATION_MODE interpolation, const D2D1_RECT_F* pSource)
+    {
+        if (!pBitmap) throw std::runtime_error("Bitmap is null.");
+        BitmapData data;
+        data.bitmap = AddResource(pBitmap);
+        data.interpolation = (uint32_t)interpolation;
+        data.hasSource = pSource ? 1u : 0u;
+        data.opacity = opacity;
+        data.dest = dest;
+        data.source = pSource ? *pSource : D2D1::RectF();
+        Write(Op::DrawBitmap, &data, sizeof(data));
+    }
+
+    void CommandList::FillGeometry(ID2D1Geometry* pGeometry, const Brush& brush)
+    {
+        if (!pGeometry) throw std::runtime_error("Geometry is null.");
+        GeometryData data = { AddResource(pGeometry), { AddBrush(brush), 0.0f } };
+        Write(Op::FillGeometry, &data, sizeof(data));
+    }
+
+    void CommandList::DrawGeometry(ID2D1Geometry* pGeometry, const Brush& brush, float strokeWidth)
+    {
+        if (!pGeometry) throw std::runtime_error("Geometry is null.");
+        GeometryData data = { AddResource(pGeometry), { AddBrush(brush), strokeWidth } };
+        Write(Op::DrawGeometry, &data, sizeof(data));
+    }
+
+    void CommandList::FillMesh(ID2D1Mesh* pMesh, const Brush& brush)
+    {
+        if (!pMesh) throw std::runtime_error("Mesh is null.");
+        GeometryData data = { AddResource(pMesh), { AddBrush(brush), 0.0f } };
+        Write(Op::FillMesh, &data, sizeof(data));
+    }
+
+    void CommandList::DrawText(const wchar_t* text, unsigned int length, IDWriteTextFormat* pFormat,
+        const D2D1_RECT_F& rect, const Brush& brush)
+    {
+        if (!pFormat) throw std::runtime_error("Text format is null.");
+        if (!text && length) throw std::runtime_error("Text is null.");
+
+        // The characters are stored inline, so the caller's string doesn't have to outlive the list
+        TextData data;
+        data.format = AddResource(pFormat);
+        data.length = length;
+        data.rect = rect;
+        data.brush = AddBrush(brush);
+        Write(Op::DrawText, &data, sizeof(data), text, length * sizeof(wchar_t));
+    }
+
+    void CommandList::PushClip(const D2D1_RECT_F& rect, D2D1_ANTIALIAS_MODE antialiasMode)
+    {
+        ClipData data = { rect, (uint32_t)antialiasMode };
+        Write(Op::PushClip, &data, sizeof(data));
+        ++m_clipDepth;
+    }
+
+    void CommandList::PopClip()
+    {
+        if (m_clipDepth == 0u) throw std::runtime_error("Command list has no clip to pop.");
+        Write(Op::PopClip, nullptr, 0u);
+        --m_clipDepth;
+    }
+
+    void CommandList::Replay(CommandTarget& target) const
+    {
+        if (m_clipDepth != 0u) throw std::runtime_error("Command list has unbalanced clips.");
+
+        const uint8_t* pData = m_data.data();
+        size_t offset = 0u;
+        while (offset < m_data.size())
+        {
+            const Header& header = *reinterpret_cast<const Header*>(pData + offset);
+            const uint8_t* pPayload = pData + offset + sizeof(Header);
+            switch (header.op)
+            {
+            case Op::Clear:
+                target.Clear(*reinterpret_cast<const D2D1_COLOR_F*>(pPayload));
+                break;
+            case Op::SetTransform:
+                target.SetTransform(*reinterpret_cast<const D2D1_MATRIX_3X2_F*>(pPayload));
+                break;
+            case Op::FillRectangle:
+            case Op::DrawRectangle:
+            {
+                const ShapeData& shape = *reinterpret_cast<const ShapeData*>(pPayload);
+                const D2D1_RECT_F& rect = *reinterpret_cast<const D2D1_RECT_F*>(pPayload + sizeof(ShapeData));
+                if (header.op == Op::FillRectangle) target.FillRectangle(rect, GetBrush(shape.brush));
+                else target.DrawRectangle(rect, GetBrush(shape.brush), shape.strokeWidth);
+                break;
+            }
+            case Op::FillRoundedRectangle:
+            case Op::DrawRoundedRectangle:
+            {
+                const ShapeData& shape = *reinterpret_cast<const ShapeData*>(pPayload);
+                const D2D1_ROUNDED_RECT& rect =
+                    *reinterpret_cast<const D2D1_ROUNDED_RECT*>(pPayload + sizeof(ShapeData));
+                if (header.op == Op::FillRoundedRectangle) target.FillRoundedRectangle(rect, GetBrush(shape.brush));
+                else target.DrawRoundedRectangle(rect, GetBrush(shape.brush), shape.strokeWidth);
+                break;
+            }
+            case Op::FillEllipse:
+            case Op::DrawEllipse:
+            {
+                const ShapeData& shape = *reinterpret_cast<const ShapeData*>(pPayload);
+                const D2D1_ELLIPSE& ellipse = *reinterpret_cast<const D2D1_ELLIPSE*>(pPayload + sizeof(ShapeData));
+                if (header.op == Op::FillEllipse) target.FillEllipse(ellipse, GetBrush(shape.brush));
+                else target.DrawEllipse(ellipse, GetBrush(shape.brush), shape.strokeWidth);
+                break;
+            }
+            case Op::DrawLine:
+            {
+                const ShapeData& shape = *reinterpret_cast<const ShapeData*>(pPayload);
+                const D2D1_POINT_2F* pPoints = reinterpret_cast<const D2D1_POINT_2F*>(pPayload + sizeof(ShapeData));
+                target.DrawLine(pPoints[0], pPoints[1], GetBrush(shape.brush), shape.strokeWidth);
+                break;
+            }
+            case Op::DrawBitmap:
+            {
+                const BitmapData& data = *reinterpret_cast<const BitmapData*>(pPayload);
+                target.DrawBitmap(static_cast<ID2D1Bitmap*>(m_resources[data.bitmap]), data.dest, data.opacity,
+                    (D2D1_BITMAP_INTERPOLATION_MODE)data.interpolation, data.hasSource ? &data.source : nullptr);
+                break;
+            }
+            case Op::FillGeometry:
+            case Op::DrawGeometry:
+            {
+                const GeometryData& data = *reinterpret_cast<const GeometryData*>(pPayload);
+                ID2D1Geometry* pGeometry = static_cast<ID2D1Geometry*>(m_resources[data.geometry]);
+                if (header.op == Op::FillGeometry) target.FillGeometry(pGeometry, GetBrush(data.shape.brush));
+                else target.DrawGeometry(pGeometry, GetBrush(data.shape.brush), data.shape.strokeWidth);
+                break;
+            }
+            case Op::FillMesh:
+            {
+                const GeometryData& data = *reinterpret_cast<const GeometryData*>(pPayload);
+                target.FillMesh(static_cast<ID2D1Mesh*>(m_resources[data.geometry]), GetBrush(data.shape.brush));
+                break;
+            }
+            case Op::DrawText:
+            {
+                const TextData& data = *reinterpret_cast<const TextData*>(pPayload);
+                const wchar_t* text = reinterpret_cast<const wchar_t*>(pPayload + sizeof(TextData));
+                target.DrawText(text, data.length, static_cast<IDWriteTextFormat*>(m_resources[data.format]),
+                    data.rect, GetBrush(data.brush));
+                break;
+            }
+            case Op::PushClip:
+            {
+                const ClipData& data = *reinterpret_cast<const ClipData*>(pPayload);
+                target.PushClip(data.rect, (D2D1_ANTIALIAS_MODE)data.antialiasMode);
+                break;
+            }
+            case Op::PopClip:
+                target.PopClip();
+                break;
+            default:
+                throw std::runtime_error("Command list is corrupt.");
+            }
+            offset += header.size;
+        }
+    }
+
+    void CommandList::Replay(ID2D1RenderTarget* pRenderTarget) const
+    {
+        D2DCommandTarget target(pRenderTarget);
+        Replay(target);
+    }
+
+    bool CommandList::IsEmpty() const
+    {
+        return m_commandCount == 0u;
+    }
+
+    size_t CommandList::GetCommandCount() const
+    {
+        return m_commandCount;
+    }
+
+    const std::vector<uint8_t>& CommandList::GetData() const
+    {
+        return m_data;
+    }
+
+    size_t CommandList::GetResourceCount() const
+    {
+        return m_resources.size();
+    }
+
+    IUnknown* CommandList::GetResource(uint32_t index) const
+    {
+        if (index >= m_resources.size()) throw std::runtime_error("Resource index is out of range.");
+        return m_resources[index];
+    }
+
+    uint32_t CommandList::AddResource(IUnknown* pResource)
+    {
+        // Every resource is referenced once, commands only store its index
+        auto found = m_resourceIds.find(pResource);
+        if (found != m_resourceIds.end()) return found->second;
+
+        uint32_t index = (uint32_t)m_resources.size();
+        m_resources.push_back(pResource);
+        m_resourceIds.emplace(pResource, index);
+        pResource->AddRef();
+        return index;
+    }
+
+    CommandList::BrushData CommandList::AddBrush(const Brush& brush)
+    {
+        BrushData data;
+        data.resource = brush.pBrush ? AddResource(brush.pBrush) : NO_RESOURCE;
+        data.color = brush.color;
+        return data;
+    }
+
+    CommandList::Brush CommandList::GetBrush(const BrushData& brush) const
+    {
+        if (brush.resource == NO_RESOURCE) return Brush(brush.color);
+        return Brush(static_cast<ID2D1Brush*>(m_resources[brush.resource]));
+    }
+
+    void CommandList::Write(Op op, const void* pPayload, size_t payloadSize, const void* pExtra, size_t extraSize)
+    {
+        // Commands are padded to 4 bytes, so every payload can be read in place
+        size_t size = (sizeof(Header) + payloadSize + extraSize + 3u) & ~(size_t)3u;
+        if (size > 0xFFFFu) throw std::runtime_error("Command is too large.");
+
+        size_t offset = m_data.size();
+        m_data.resize(offset + size, 0u);
+        Header header = { op, (uint16_t)size };
+        std::memcpy(&m_data[offset], &header, sizeof(Header));
+        if (payloadSize) std::memcpy(&m_data[offset + sizeof(Header)], pPayload, payloadSize);
+        if (extraSize) std::memcpy(&m_data[offset + sizeof(Header) + payloadSize], pExtra, extraSize);
+        ++m_commandCount;
+    }
+
+    template <typename T> void CommandList::WriteShape(Op op, const T& shape, const Brush& brush, float strokeWidth)
+    {
+        ShapeData data = { AddBrush(brush), strokeWidth };
+        Write(op, &data, sizeof(data), &shape, sizeof(T));
+    }
+}
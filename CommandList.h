@@ -0,0 +1,171 @@
+#pragma once
+#include <d2d1.h>
+#include <dwrite.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Ice2D
+{
+	class CommandTarget
+	{
+	public:
+		struct Brush
+		{
+			Brush(ID2D1Brush* pBrush);
+			Brush(const D2D1_COLOR_F& color);
+			ID2D1Brush* pBrush;
+			D2D1_COLOR_F color;
+		};
+		virtual ~CommandTarget() {}
+		virtual void Clear(const D2D1_COLOR_F& color) = 0;
+		virtual void SetTransform(const D2D1_MATRIX_3X2_F& transform) = 0;
+		virtual void FillRectangle(const D2D1_RECT_F& rect, const Brush& brush) = 0;
+		virtual void DrawRectangle(const D2D1_RECT_F& rect, const Brush& brush, float strokeWidth) = 0;
+		virtual void FillRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush) = 0;
+		virtual void DrawRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush, float strokeWidth) = 0;
+		virtual void FillEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush) = 0;
+		virtual void DrawEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush, float strokeWidth) = 0;
+		virtual void DrawLine(const D2D1_POINT_2F& start, const D2D1_POINT_2F& end, const Brush& brush,
+			float strokeWidth) = 0;
+		virtual void DrawBitmap(ID2D1Bitmap* pBitmap, const D2D1_RECT_F& dest, float opacity,
+			D2D1_BITMAP_INTERPOLATION_MODE interpolation, const D2D1_RECT_F* pSource) = 0;
+		virtual void FillGeometry(ID2D1Geometry* pGeometry, const Brush& brush) = 0;
+		virtual void DrawGeometry(ID2D1Geometry* pGeometry, const Brush& brush, float strokeWidth) = 0;
+		virtual void FillMesh(ID2D1Mesh* pMesh, const Brush& brush) = 0;
+		virtual void DrawText(const wchar_t* text, unsigned int length, IDWriteTextFormat* pFormat,
+			const D2D1_RECT_F& rect, const Brush& brush) = 0;
+		virtual void PushClip(const D2D1_RECT_F& rect, D2D1_ANTIALIAS_MODE antialiasMode) = 0;
+		virtual void PopClip() = 0;
+	};
+
+	class D2DCommandTarget : public CommandTarget
+	{
+	public:
+		D2DCommandTarget(ID2D1RenderTarget* pRenderTarget);
+		D2DCommandTarget(const D2DCommandTarget& other) = delete;
+		D2DCommandTarget& operator=(const D2DCommandTarget& other) = delete;
+		~D2DCommandTarget();
+		void Clear(const D2D1_COLOR_F& color) override;
+		void SetTransform(const D2D1_MATRIX_3X2_F& transform) override;
+		void FillRectangle(const D2D1_RECT_F& rect, const Brush& brush) override;
+		void DrawRectangle(const D2D1_RECT_F& rect, const Brush& brush, float strokeWidth) override;
+		void FillRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush) override;
+		void DrawRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush, float strokeWidth) override;
+		void FillEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush) override;
+		void DrawEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush, float strokeWidth) override;
+		void DrawLine(const D2D1_POINT_2F& start, const D2D1_POINT_2F& end, const Brush& brush,
+			float strokeWidth) override;
+		void DrawBitmap(ID2D1Bitmap* pBitmap, const D2D1_RECT_F& dest, float opacity,
+			D2D1_BITMAP_INTERPOLATION_MODE interpolation, const D2D1_RECT_F* pSource) override;
+		void FillGeometry(ID2D1Geometry* pGeometry, const Brush& brush) override;
+		void DrawGeometry(ID2D1Geometry* pGeometry, const Brush& brush, float strokeWidth) override;
+		void FillMesh(ID2D1Mesh* pMesh, const Brush& brush) override;
+		void DrawText(const wchar_t* text, unsigned int length, IDWriteTextFormat* pFormat,
+			const D2D1_RECT_F& rect, const Brush& brush) override;
+		void PushClip(const D2D1_RECT_F& rect, D2D1_ANTIALIAS_MODE antialiasMode) override;
+		void PopClip() override;
+	private:
+		ID2D1RenderTarget* m_pRT;
+		ID2D1SolidColorBrush* m_pSolidBrush;
+		D2D1_MATRIX_3X2_F m_base;
+		ID2D1Brush* Resolve(const Brush& brush);
+	};
+
+	class CommandList
+	{
+	public:
+		using Brush = CommandTarget::Brush;
+		enum class Op : uint16_t
+		{
+			Clear, SetTransform, FillRectangle, DrawRectangle, FillRoundedRectangle, DrawRoundedRectangle,
+			FillEllipse, DrawEllipse, DrawLine, DrawBitmap, FillGeometry, DrawGeometry, FillMesh, DrawText,
+			PushClip, PopClip
+		};
+		struct Header
+		{
+			Op op;
+			uint16_t size;
+		};
+		CommandList();
+		CommandList(const CommandList& other) = delete;
+		CommandList& operator=(const CommandList& other) = delete;
+		CommandList(CommandList&& other) noexcept;
+		CommandList& operator=(CommandList&& other) noexcept;
+		~CommandList();
+		void Reset();
+		void Reserve(size_t bytes);
+		void Clear(const D2D1_COLOR_F& color);
+		void SetTransform(const D2D1_MATRIX_3X2_F& transform);
+		void FillRectangle(const D2D1_RECT_F& rect, const Brush& brush);
+		void DrawRectangle(const D2D1_RECT_F& rect, const Brush& brush, float strokeWidth = 1.0f);
+		void FillRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush);
+		void DrawRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush, float strokeWidth = 1.0f);
+		void FillEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush);
+		void DrawEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush, float strokeWidth = 1.0f);
+		void DrawLine(const D2D1_POINT_2F& start, const D2D1_POINT_2F& end, const Brush& brush,
+			float strokeWidth = 1.0f);
+		void DrawBitmap(ID2D1Bitmap* pBitmap, const D2D1_RECT_F& dest, float opacity = 1.0f,
+			D2D1_BITMAP_INTERPOLATION_MODE interpolation = D2D1_BITMAP_INTERPOLATION_MODE_LINEAR,
+			const D2D1_RECT_F* pSource = nullptr);
+		void FillGeometry(ID2D1Geometry* pGeometry, const Brush& brush);
+		void DrawGeometry(ID2D1Geometry* pGeometry, const Brush& brush, float strokeWidth = 1.0f);
+		void FillMesh(ID2D1Mesh* pMesh, const Brush& brush);
+		void DrawText(const wchar_t* text, unsigned int length, IDWriteTextFormat* pFormat,
+			const D2D1_RECT_F& rect, const Brush& brush);
+		void PushClip(const D2D1_RECT_F& rect, D2D1_ANTIALIAS_MODE antialiasMode = D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+		void PopClip();
+		void Replay(CommandTarget& target) const;
+		void Replay(ID2D1RenderTarget* pRenderTarget) const;
+		bool IsEmpty() const;
+		size_t GetCommandCount() const;
+		const std::vector<uint8_t>& GetData() const;
+		size_t GetResourceCount() const;
+		IUnknown* GetResource(uint32_t index) const;
+		static const uint32_t NO_RESOURCE = 0xFFFFFFFFu;
+	private:
+		struct BrushData
+		{
+			uint32_t resource;
+			D2D1_COLOR_F color;
+		};
+		struct ShapeData
+		{
+			BrushData brush;
+			float strokeWidth;
+		};
+		struct BitmapData
+		{
+			uint32_t bitmap, interpolation, hasSource;
+			float opacity;
+			D2D1_RECT_F dest, source;
+		};
+		struct GeometryData
+		{
+			uint32_t geometry;
+			ShapeData shape;
+		};
+		struct TextData
+		{
+			uint32_t format, length;
+			D2D1_RECT_F rect;
+			BrushData brush;
+		};
+		struct ClipData
+		{
+			D2D1_RECT_F rect;
+			uint32_t antialiasMode;
+		};
+		std::vector<uint8_t> m_data;
+		std::vector<IUnknown*> m_resources;
+		std::unordered_map<IUnknown*, uint32_t> m_resourceIds;
+		size_t m_commandCount;
+		unsigned int m_clipDepth;
+		uint32_t AddResource(IUnknown* pResource);
+		BrushData AddBrush(const Brush& brush);
+		Brush GetBrush(const BrushData& brush) const;
+		void Write(Op op, const void* pPayload, size_t payloadSize, const void* pExtra = nullptr, size_t extraSize = 0u);
+		template <typename T> void WriteShape(Op op, const T& shape, const Brush& brush, float strokeWidth);
+	};
+}
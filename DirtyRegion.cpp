@@ -0,0 +1,183 @@
+#include "pch.h"
+
+#include "DirtyRegion.h"
+#include <algorithm>
+
+namespace Ice2D
+{
+    unsigned long long DirtyRegion::Rect::Area() const
+    {
+        return (unsigned long long)(right - left) * (bottom - top);
+    }
+
+    DirtyRegion::DirtyRegion(unsigned int maxRects) :
+        m_width(0u), m_height(0u), m_maxRects(std::max(maxRects, 1u)), m_full(false), m_stats()
+    {
+    }
+
+    void DirtyRegion::SetBounds(unsigned int width, unsigned int height)
+    {
+        // New bounds mean new contents
+        m_width = width;
+        m_height = height;
+        AddAll();
+    }
+
+    void DirtyRegion::SetMaxRects(unsigned int maxRects)
+    {
+        m_maxRects = std::max(maxRects, 1u);
+        if (m_rects.size() > m_maxRects && !m_full)
+        {
+            std::vector<Rect> rects;
+            rects.swap(m_rects);
+            for (const Rect& rect : rects) Insert(rect);
+        }
+    }
+
+    unsigned int DirtyRegion::GetMaxRects() const
+    {
+        return m_maxRects;
+    }
+
+    void DirtyRegion::Add(unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+    {
+        if (m_full || x >= m_width || y >= m_height) return;
+        Rect rect = { x, y, std::min(m_width, x + std::min(width, m_width - x)),
+            std::min(m_height, y + std::min(height, m_height - y)) };
+        if (rect.right <= rect.left || rect.bottom <= rect.top) return;
+
+        // Most writes land next to the previous one, check it before doing any real work
+        if (!m_rects.empty() && Contains(m_rects.back(), rect)) return;
+        Insert(rect);
+    }
+
+    void DirtyRegion::AddAll()
+    {
+        m_rects.clear();
+        m_full = m_width > 0u && m_height > 0u;
+        if (m_full) m_rects.push_back({ 0u, 0u, m_width, m_height });
+    }
+
+    void DirtyRegion::Clear()
+    {
+        m_rects.clear();
+        m_full = false;
+    }
+
+    bool DirtyRegion::IsEmpty() const
+    {
+        return m_rects.empty();
+    }
+
+    bool DirtyRegion::IsFull() const
+    {
+        return m_full;
+    }
+
+    const std::vector<DirtyRegion::Rect>& DirtyRegion::GetRects() const
+    {
+        return m_rects;
+    }
+
+    unsigned long long DirtyRegion::GetArea() const
+    {
+        unsigned long long area = 0ull;
+        for (const Rect& rect : m_rects) area += rect.Area();
+        return area;
+    }
+
+    void DirtyRegion::RecordUpload(unsigned int bytesPerPixel, bool full)
+    {
+        unsigned long long total = (unsigned long long)m_width * m_height * bytesPerPixel;
+        ++m_stats.uploads;
+        if (full || m_full)
+        {
+            ++m_stats.fullUploads;
+            ++m_stats.rects;
+            m_stats.bytesUploaded += total;
+            return;
+        }
+
+        unsigned long long uploaded = std::min(GetArea() * bytesPerPixel, total);
+        m_stats.rects += m_rects.size();
+        m_stats.bytesUploaded += uploaded;
+        m_stats.bytesSaved += total - uploaded;
+    }
+
+    const DirtyRegion::Stats& DirtyRegion::GetStats() const
+    {
+        return m_stats;
+    }
+
+    void DirtyRegion::ResetStats()
+    {
+        m_stats = Stats();
+    }
+
+    void DirtyRegion::Insert(Rect rect)
+    {
+        // Absorb every rect that touches this one when the union costs no more than both separately
+        for (size_t i = 0u; i < m_rects.size();)
+        {
+            const Rect& other = m_rects[i];
+            if (Contains(other, rect)) return;
+            Rect merged = Union(rect, other);
+            if (Contains(rect, other) || (Touches(rect, other) && merged.Area() <= rect.Area() + other.Area()))
+            {
+                rect = merged;
+                m_rects[i] = m_rects.back();
+                m_rects.pop_back();
+                i = 0u;
+                continue;
+            }
+            ++i;
+        }
+        m_rects.push_back(rect);
+
+        // Over the limit, merge the pair whose union adds the least area
+        if (m_rects.size() > m_maxRects)
+        {
+            size_t bestA = 0u, bestB = 1u;
+            unsigned long long bestCost = ~0ull;
+            for (size_t a = 0u; a < m_rects.size(); ++a)
+            {
+                for (size_t b = a + 1u; b < m_rects.size(); ++b)
+                {
+                    unsigned long long area = Union(m_rects[a], m_rects[b]).Area();
+                    unsigned long long separate = m_rects[a].Area() + m_rects[b].Area();
+                    unsigned long long cost = area > separate ? area - separate : 0ull;
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestA = a;
+                        bestB = b;
+                    }
+                }
+            }
+            Rect merged = Union(m_rects[bestA], m_rects[bestB]);
+            m_rects.erase(m_rects.begin() + bestB);
+            m_rects.erase(m_rects.begin() + bestA);
+            Insert(merged);
+            return;
+        }
+
+        // Mostly dirty anyway, one full upload is cheaper than many small ones
+        if (GetArea() * 4u >= (unsigned long long)m_width * m_height * 3u) AddAll();
+    }
+
+    DirtyRegion::Rect DirtyRegion::Union(const Rect& a, const Rect& b)
+    {
+        return { std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom) };
+    }
+
+    bool DirtyRegion::Contains(const Rect& outer, const Rect& inner)
+    {
+        return outer.left <= inner.left && outer.top <= inner.top &&
+            outer.right >= inner.right && outer.bottom >= inner.bottom;
+    }
+
+    bool DirtyRegion::Touches(const Rect& a, const Rect& b)
+    {
+        return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+    }
+}
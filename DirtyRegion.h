@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace Ice2D
+{
+	class DirtyRegion
+	{
+	public:
+		struct Rect
+		{
+			unsigned int left, top, right, bottom;
+			unsigned long long Area() const;
+		};
+		struct Stats
+		{
+			unsigned long long uploads, fullUploads, rects;
+			unsigned long long bytesUploaded, bytesSaved;
+		};
+		DirtyRegion(unsigned int maxRects = 8u);
+		void SetBounds(unsigned int width, unsigned int height);
+		void SetMaxRects(unsigned int maxRects);
+		unsigned int GetMaxRects() const;
+		void Add(unsigned int x, unsigned int y, unsigned int width, unsigned int height);
+		void AddAll();
+		void Clear();
+		bool IsEmpty() const;
+		bool IsFull() const;
+		const std::vector<Rect>& GetRects() const;
+		unsigned long long GetArea() const;
+		void RecordUpload(unsigned int bytesPerPixel, bool full);
+		const Stats& GetStats() const;
+		void ResetStats();
+	private:
+		std::vector<Rect> m_rects;
+		unsigned int m_width, m_height, m_maxRects;
+		bool m_full;
+		Stats m_stats;
+		void Insert(Rect rect);
+		static Rect Union(const Rect& a, const Rect& b);
+		static bool Contains(const Rect& outer, const Rect& inner);
+		static bool Touches(const Rect& a, const Rect& b);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "pch.h"
+
+#include "FramePacer.h"
+#include <thread>
+
+namespace Ice2D
+{
+    SystemClock::SystemClock() : m_hTimer(nullptr)
+    {
+#ifdef _WIN32
+#ifdef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+        m_hTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+        // Older systems do not support high resolution timers, fall back to a regular one
+        if (!m_hTimer) m_hTimer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+#endif
+    }
+
+    SystemClock::~SystemClock()
+    {
+#ifdef _WIN32
+        if (m_hTimer) CloseHandle(m_hTimer);
+#endif
+    }
+
+    std::chrono::high_resolution_clock::time_point SystemClock::Now()
+    {
+        return std::chrono::high_resolution_clock::now();
+    }
+
+    void SystemClock::Sleep(std::chrono::high_resolution_clock::duration duration)
+    {
+        if (duration.count() <= 0) return;
+#ifdef _WIN32
+        if (m_hTimer)
+        {
+            // Relative due times are negative and in 100 nanosecond units
+            LARGE_INTEGER dueTime = {};
+            dueTime.QuadPart = -(LONGLONG)(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 100);
+            if (dueTime.QuadPart == 0) dueTime.QuadPart = -1;
+            if (SetWaitableTimer(m_hTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+            {
+                WaitForSingleObject(m_hTimer, INFINITE);
+                return;
+            }
+        }
+#endif
+        std::this_thread::sleep_for(duration);
+    }
+
+    void SystemClock::Spin()
+    {
+#ifdef _WIN32
+        YieldProcessor();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    FramePacer::FramePacer() : FramePacer(nullptr)
+    {
+    }
+
+    FramePacer::FramePacer(IBasicClock* pClock) :
+        m_pClock(pClock ? pClock : &m_systemClock), m_targetFPS(0u), m_frameTime(),
+        m_spinThreshold(std::chrono::microseconds(250)), m_oversleep(std::chrono::milliseconds(1)),
+        m_lateness(), m_nextFrame(), m_started(false)
+    {
+    }
+
+    void FramePacer::SetClock(IBasicClock* pClock)
+    {
+        m_pClock = pClock ? pClock : &m_systemClock;
+        Reset();
+    }
+
+    void FramePacer::SetTargetFPS(unsigned int fps)
+    {
+        m_targetFPS = fps;
+        m_frameTime = fps > 0u ? std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+            std::chrono::nanoseconds(1'000'000'000 / fps)) : std::chrono::high_resolution_clock::duration::zero();
+        Reset();
+    }
+
+    unsigned int FramePacer::GetTargetFPS() const
+    {
+        return m_targetFPS;
+    }
+
+    void FramePacer::SetSpinThreshold(std::chrono::high_resolution_clock::duration threshold)
+    {
+        m_spinThreshold = threshold;
+    }
+
+    void FramePacer::Wait()
+    {
+        if (m_targetFPS == 0u) return;
+
+        auto now = m_pClock->Now();
+        if (!m_started || now - m_nextFrame > m_frameTime)
+        {
+            // First frame, or we fell more than a frame behind, so resynchronize instead of bursting
+            m_lateness = m_started ? now - m_nextFrame : std::chrono::high_resolution_clock::duration::zero();
+            m_nextFrame = now + m_frameTime;
+            m_started = true;
+            return;
+        }
+
+        // Sleep while the remaining time is comfortably above the expected oversleep
+        auto remaining = m_nextFrame - now;
+        auto maxOversleep = m_frameTime / 2;
+        bool slept = false;
+        while (remaining > m_oversleep + m_spinThreshold)
+        {
+            auto request = remaining - m_oversleep;
+            m_pClock->Sleep(request);
+            auto after = m_pClock->Now();
+            auto error = (after - now) - request;
+
+            // Rise quickly on late wakeups and decay slowly, so one good sleep doesn't cause a miss.
+            // Preemption spikes are clamped so a single stall doesn't turn the pacer into a spin loop.
+            if (error > maxOversleep) error = maxOversleep;
+            if (error > m_oversleep) m_oversleep += (error - m_oversleep) / 2;
+            else m_oversleep -= (m_oversleep - error) / 16;
+            if (m_oversleep.count() < 0) m_oversleep = std::chrono::high_resolution_clock::duration::zero();
+
+            now = after;
+            remaining = m_nextFrame - now;
+            slept = true;
+        }
+
+        // Without a sleep there is no new measurement, so let the estimate recover on its own
+        if (!slept) m_oversleep -= m_oversleep / 16;
+
+        // Spin off the rest for an accurate wakeup
+        while (now < m_nextFrame)
+        {
+            m_pClock->Spin();
+            now = m_pClock->Now();
+        }
+
+        m_lateness = now - m_nextFrame;
+        m_nextFrame += m_frameTime;
+    }
+
+    void FramePacer::Reset()
+    {
+        m_started = false;
+        m_lateness = std::chrono::high_resolution_clock::duration::zero();
+    }
+
+    std::chrono::high_resolution_clock::duration FramePacer::GetOversleep() const
+    {
+        return m_oversleep;
+    }
+
+    std::chrono::high_resolution_clock::duration FramePacer::GetLastLateness() const
+    {
+        return m_lateness;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+
+namespace Ice2D
+{
+	class IBasicClock
+	{
+	public:
+		virtual ~IBasicClock() {}
+		virtual std::chrono::high_resolution_clock::time_point Now() = 0;
+		virtual void Sleep(std::chrono::high_resolution_clock::duration duration) = 0;
+		virtual void Spin() {}
+	};
+
+	class SystemClock : public IBasicClock
+	{
+	public:
+		SystemClock();
+		SystemClock(const SystemClock& other) = delete;
+		SystemClock& operator=(const SystemClock& other) = delete;
+		~SystemClock();
+		std::chrono::high_resolution_clock::time_point Now() override;
+		void Sleep(std::chrono::high_resolution_clock::duration duration) override;
+		void Spin() override;
+	private:
+		void* m_hTimer;
+	};
+
+	class FramePacer
+	{
+	public:
+		FramePacer();
+		FramePacer(IBasicClock* pClock);
+		FramePacer(const FramePacer& other) = delete;
+		FramePacer& operator=(const FramePacer& other) = delete;
+		void SetClock(IBasicClock* pClock);
+		void SetTargetFPS(unsigned int fps);
+		unsigned int GetTargetFPS() const;
+		void SetSpinThreshold(std::chrono::high_resolution_clock::duration threshold);
+		void Wait();
+		void Reset();
+		std::chrono::high_resolution_clock::duration GetOversleep() const;
+		std::chrono::high_resolution_clock::duration GetLastLateness() const;
+	private:
+		SystemClock m_systemClock;
+		IBasicClock* m_pClock;
+		unsigned int m_targetFPS;
+		std::chrono::high_resolution_clock::duration m_frameTime, m_spinThreshold, m_oversleep, m_lateness;
+		std::chrono::high_resolution_clock::time_point m_nextFrame;
+		bool m_started;
+	};
+}
\ No newline at end of file
@@ -6,6 +6,9 @@
 
 namespace Ice2D
 {
+    // Tessellator triangles go to the sink as they are, so the layouts have to match
+    static_assert(sizeof(Tessellator::Triangle) == sizeof(D2D1_TRIANGLE), "Triangle layout mismatch.");
+
     PathGeometry::PathGeometry() : m_pGeometry(nullptr), m_pSink(nullptr)
     {
     }
@@ -20,12 +23,21 @@ namespace Ice2D
         OnLoad();
     }
 
+    PathGeometry::PathGeometry(ResourceManager* pManager, const ShapeDescription& shape) : IBasicResource(pManager),
+        m_pSink(nullptr)
+    {
+        // Shared with every other geometry of the same shape, and already closed
+        m_pGeometry = pManager->GetGeometryCache().GetGeometry(pManager->GetD2DFactory(), shape);
+
+        OnLoad();
+    }
+
     PathGeometry::PathGeometry(PathGeometry&& other) noexcept : 
         IBasicResource(other), m_pGeometry(other.m_pGeometry), m_pSink(other.m_pSink)
     {
         other.m_pGeometry = nullptr;
         other.m_pSink = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     PathGeometry& PathGeometry::operator=(PathGeometry&& other) noexcept
@@ -38,7 +50,7 @@ namespace Ice2D
         m_pSink = other.m_pSink;
 		other.m_pSink = nullptr;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -118,11 +130,19 @@ namespace Ice2D
         OnLoad();
     }
 
+    Mesh::Mesh(ResourceManager* pManager, const ShapeDescription& shape, float tolerance) :
+        IBasicResource(pManager), m_pSink(nullptr)
+    {
+        m_pMesh = pManager->GetGeometryCache().GetMesh(pManager->GetRenderTarget(), shape, tolerance);
+
+        OnLoad();
+    }
+
     Mesh::Mesh(Mesh&& other) noexcept : IBasicResource(other), m_pMesh(other.m_pMesh), m_pSink(other.m_pSink)
     {
         other.m_pMesh = nullptr;
         other.m_pSink = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     Mesh& Mesh::operator=(Mesh&& other) noexcept
@@ -133,7 +153,7 @@ namespace Ice2D
         m_pMesh = other.Get();
         other.m_pMesh = nullptr;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -168,6 +188,14 @@ namespace Ice2D
         m_pSink->AddTriangles(&tri, 1u);
     }
 
+    void Mesh::AddTriangles(const Tessellator& tessellator)
+    {
+        if (!m_pSink) throw std::runtime_error("Tessellation sink is null. Cannot add triangles.");
+        const std::vector<Tessellator::Triangle>& triangles = tessellator.GetTriangles();
+        if (triangles.empty()) return;
+        m_pSink->AddTriangles(reinterpret_cast<const D2D1_TRIANGLE*>(triangles.data()), (UINT32)triangles.size());
+    }
+
     void Mesh::Close()
     {
         if (!m_pSink) throw std::runtime_error("Tessellation sink is null. Cannot close.");
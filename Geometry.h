@@ -1,5 +1,7 @@
 #pragma once
 #include "ResourceManager.h"
+#include "GeometryCache.h"
+#include "Tessellator.h"
 #include <d2d1.h>
 
 namespace Ice2D
@@ -9,6 +11,7 @@ namespace Ice2D
 	public:
 		PathGeometry();
 		PathGeometry(ResourceManager* pManager);
+		PathGeometry(ResourceManager* pManager, const ShapeDescription& shape);
 		PathGeometry(const PathGeometry& other) = delete;
 		PathGeometry& operator=(const PathGeometry& other) = delete;
 		PathGeometry(PathGeometry&& other) noexcept;
@@ -32,6 +35,8 @@ namespace Ice2D
 	public:
 		Mesh();
 		Mesh(ResourceManager* pManager);
+		Mesh(ResourceManager* pManager, const ShapeDescription& shape,
+			float tolerance = D2D1_DEFAULT_FLATTENING_TOLERANCE);
 		Mesh(const Mesh& other) = delete;
 		Mesh& operator=(const Mesh& other) = delete;
 		Mesh(Mesh&& other) noexcept;
@@ -40,6 +45,7 @@ namespace Ice2D
 		void Release() override;
 		void AddTriangles(D2D1_TRIANGLE* triangles, unsigned int count);
 		void AddTriangle(const D2D_POINT_2F& pt1, const D2D_POINT_2F& pt2, const D2D_POINT_2F& pt3);
+		void AddTriangles(const Tessellator& tessellator);
 		void Close();
 		ID2D1Mesh* Get() const;
 	private:
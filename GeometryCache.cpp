@@ -0,0 +1,509 @@
+#include "pch.h"
+
+#include "GeometryCache.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+#include <cmath>
+#include <cstring>
+
+namespace Ice2D
+{
+    static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static const uint64_t FNV_PRIME = 1099511628211ull;
+
+    // Forwards to the mesh's sink and counts the triangles, for the memory accounting
+    class CountingTessellationSink : public ID2D1TessellationSink
+    {
+    public:
+        CountingTessellationSink(ID2D1TessellationSink* pTarget) : pTarget(pTarget), triangles(0u)
+        {
+        }
+
+        // Lives on the stack for one Tessellate() call
+        ULONG STDMETHODCALLTYPE AddRef() override { return 1u; }
+        ULONG STDMETHODCALLTYPE Release() override { return 1u; }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppObject) override
+        {
+            if (!ppObject) return E_POINTER;
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(ID2D1TessellationSink))
+            {
+                *ppObject = static_cast<ID2D1TessellationSink*>(this);
+                return S_OK;
+            }
+            *ppObject = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        void STDMETHODCALLTYPE AddTriangles(const D2D1_TRIANGLE* pTriangles, UINT32 count) override
+        {
+            triangles += count;
+            pTarget->AddTriangles(pTriangles, count);
+        }
+
+        HRESULT STDMETHODCALLTYPE Close() override
+        {
+            return pTarget->Close();
+        }
+
+        ID2D1TessellationSink* pTarget;
+        size_t triangles;
+    };
+
+    ShapeDescription::ShapeDescription(D2D1_FILL_MODE fillMode) : m_hash(FNV_OFFSET), m_open(false)
+    {
+        SetFillMode(fillMode);
+    }
+
+    void ShapeDescription::Clear()
+    {
+        // Keeps the capacity, a description rebuilt every frame stops allocating. SetFillMode() would swap the
+        // buffer out, so the fill mode words are written here
+        D2D1_FILL_MODE fillMode = m_data.empty() ? D2D1_FILL_MODE_ALTERNATE : (D2D1_FILL_MODE)m_data[1];
+        m_data.clear();
+        m_hash = FNV_OFFSET;
+        m_open = false;
+        Append((uint32_t)Op::FillMode);
+        Append((uint32_t)fillMode);
+    }
+
+    void ShapeDescription::SetFillMode(D2D1_FILL_MODE fillMode)
+    {
+        // The fill mode always comes first, so changing it means starting over
+        if (!m_data.empty() && (D2D1_FILL_MODE)m_data[1] == fillMode) return;
+        std::vector<uint32_t> data;
+        data.swap(m_data);
+        m_hash = FNV_OFFSET;
+        Append((uint32_t)Op::FillMode);
+        Append((uint32_t)fillMode);
+        for (size_t i = 2u; i < data.size(); ++i) Append(data[i]);
+    }
+
+    void ShapeDescription::BeginFigure(const D2D1_POINT_2F& startPoint, D2D1_FIGURE_BEGIN figureBegin)
+    {
+        if (m_open) throw std::runtime_error("Shape figure already begun.");
+        m_open = true;
+        Append((uint32_t)Op::Begin);
+        Append((uint32_t)figureBegin);
+        Append(startPoint);
+    }
+
+    void ShapeDescription::EndFigure(D2D1_FIGURE_END figureEnd)
+    {
+        if (!m_open) throw std::runtime_error("Shape figure not begun.");
+        m_open = false;
+        Append((uint32_t)Op::End);
+        Append((uint32_t)figureEnd);
+    }
+
+    void ShapeDescription::AddLine(const D2D1_POINT_2F& point)
+    {
+        if (!m_open) throw std::runtime_error("Shape figure not begun.");
+        Append((uint32_t)Op::Line);
+        Append(point);
+    }
+
+    void ShapeDescription::AddLines(const D2D1_POINT_2F* points, unsigned int count)
+    {
+        for (unsigned int i = 0u; i < count; ++i) AddLine(points[i]);
+    }
+
+    void ShapeDescription::AddBezier(const D2D1_BEZIER_SEGMENT& bezier)
+    {
+        if (!m_open) throw std::runtime_error("Shape figure not begun.");
+        Append((uint32_t)Op::Bezier);
+        Append(bezier.point1);
+        Append(bezier.point2);
+        Append(bezier.point3);
+    }
+
+    void ShapeDescription::AddQuadraticBezier(const D2D1_QUADRATIC_BEZIER_SEGMENT& bezier)
+    {
+        if (!m_open) throw std::runtime_error("Shape figure not begun.");
+        Append((uint32_t)Op::QuadraticBezier);
+        Append(bezier.point1);
+        Append(bezier.point2);
+    }
+
+    void ShapeDescription::AddArc(const D2D1_ARC_SEGMENT& arc)
+    {
+        if (!m_open) throw std::runtime_error("Shape figure not begun.");
+        Append((uint32_t)Op::Arc);
+        Append(arc.point);
+        Append(arc.size.width);
+        Append(arc.size.height);
+        Append(arc.rotationAngle);
+        Append((uint32_t)arc.sweepDirection);
+        Append((uint32_t)arc.arcSize);
+    }
+
+    void ShapeDescription::AddRectangle(const D2D1_RECT_F& rect)
+    {
+        BeginFigure(D2D1::Point2F(rect.left, rect.top));
+        AddLine(D2D1::Point2F(rect.right, rect.top));
+        AddLine(D2D1::Point2F(rect.right, rect.bottom));
+        AddLine(D2D1::Point2F(rect.left, rect.bottom));
+        EndFigure();
+    }
+
+    void ShapeDescription::AddRoundedRectangle(const D2D1_ROUNDED_RECT& rounded)
+    {
+        // Clockwise from the end of the top left corner, with the radii clamped like Direct2D does
+        const D2D1_RECT_F& r = rounded.rect;
+        float rx = std::fabs(rounded.radiusX), ry = std::fabs(rounded.radiusY);
+        rx = std::fmin(rx, std::fabs(r.right - r.left) * 0.5f);
+        ry = std::fmin(ry, std::fabs(r.bottom - r.top) * 0.5f);
+        if (rx == 0.0f || ry == 0.0f)
+        {
+            AddRectangle(r);
+            return;
+        }
+        const D2D1_SIZE_F size = D2D1::SizeF(rx, ry);
+        BeginFigure(D2D1::Point2F(r.left + rx, r.top));
+        AddLine(D2D1::Point2F(r.right - rx, r.top));
+        AddArc(D2D1::ArcSegment(D2D1::Point2F(r.right, r.top + ry), size, 0.0f, D2D1_SWEEP_DIRECTION_CLOCKWISE,
+            D2D1_ARC_SIZE_SMALL));
+        AddLine(D2D1::Point2F(r.right, r.bottom - ry));
+        AddArc(D2D1::ArcSegment(D2D1::Point2F(r.right - rx, r.bottom), size, 0.0f, D2D1_SWEEP_DIRECTION_CLOCKWISE,
+            D2D1_ARC_SIZE_SMALL));
+        AddLine(D2D1::Point2F(r.left + rx, r.bottom));
+        AddArc(D2D1::ArcSegment(D2D1::Point2F(r.left, r.bottom - ry), size, 0.0f, D2D1_SWEEP_DIRECTION_CLOCKWISE,
+            D2D1_ARC_SIZE_SMALL));
+        AddLine(D2D1::Point2F(r.left, r.top + ry));
+        AddArc(D2D1::ArcSegment(D2D1::Point2F(r.left + rx, r.top), size, 0.0f, D2D1_SWEEP_DIRECTION_CLOCKWISE,
+            D2D1_ARC_SIZE_SMALL));
+        EndFigure();
+    }
+
+    void ShapeDescription::AddEllipse(const D2D1_ELLIPSE& ellipse)
+    {
+        // Two half arcs, a single arc can't end where it starts
+        const D2D1_SIZE_F size = D2D1::SizeF(ellipse.radiusX, ellipse.radiusY);
+        const D2D1_POINT_2F& c = ellipse.point;
+        BeginFigure(D2D1::Point2F(c.x - ellipse.radiusX, c.y));
+        AddArc(D2D1::ArcSegment(D2D1::Point2F(c.x + ellipse.radiusX, c.y), size, 0.0f,
+            D2D1_SWEEP_DIRECTION_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+        AddArc(D2D1::ArcSegment(D2D1::Point2F(c.x - ellipse.radiusX, c.y), size, 0.0f,
+            D2D1_SWEEP_DIRECTION_CLOCKWISE, D2D1_ARC_SIZE_SMALL));
+        EndFigure();
+    }
+
+    uint64_t ShapeDescription::GetHash() const
+    {
+        return m_hash;
+    }
+
+    size_t ShapeDescription::GetSize() const
+    {
+        return m_data.size() * sizeof(uint32_t);
+    }
+
+    bool ShapeDescription::operator==(const ShapeDescription& other) const
+    {
+        return m_hash == other.m_hash && m_data == other.m_data;
+    }
+
+    void ShapeDescription::Replay(ID2D1GeometrySink* pSink) const
+    {
+        if (m_open) throw std::runtime_error("Shape figure was not ended.");
+        size_t i = 0u;
+        while (i < m_data.size())
+        {
+            switch ((Op)m_data[i++])
+            {
+            case Op::FillMode:
+                pSink->SetFillMode((D2D1_FILL_MODE)m_data[i++]);
+                break;
+            case Op::Begin:
+            {
+                D2D1_FIGURE_BEGIN figureBegin = (D2D1_FIGURE_BEGIN)m_data[i++];
+                pSink->BeginFigure(ReadPoint(i), figureBegin);
+                break;
+            }
+            case Op::Line:
+                pSink->AddLine(ReadPoint(i));
+                break;
+            case Op::Bezier:
+            {
+                D2D1_BEZIER_SEGMENT bezier;
+                bezier.point1 = ReadPoint(i);
+                bezier.point2 = ReadPoint(i);
+                bezier.point3 = ReadPoint(i);
+                pSink->AddBezier(bezier);
+                break;
+            }
+            case Op::QuadraticBezier:
+            {
+                D2D1_QUADRATIC_BEZIER_SEGMENT bezier;
+                bezier.point1 = ReadPoint(i);
+                bezier.point2 = ReadPoint(i);
+                pSink->AddQuadraticBezier(bezier);
+                break;
+            }
+            case Op::Arc:
+            {
+                D2D1_ARC_SEGMENT arc;
+                arc.point = ReadPoint(i);
+                arc.size.width = ReadFloat(i);
+                arc.size.height = ReadFloat(i);
+                arc.rotationAngle = ReadFloat(i);
+                arc.sweepDirection = (D2D1_SWEEP_DIRECTION)m_data[i++];
+                arc.arcSize = (D2D1_ARC_SIZE)m_data[i++];
+                pSink->AddArc(arc);
+                break;
+            }
+            case Op::End:
+                pSink->EndFigure((D2D1_FIGURE_END)m_data[i++]);
+                break;
+            default:
+                throw std::runtime_error("Shape description is corrupt.");
+            }
+        }
+    }
+
+    void ShapeDescription::Append(uint32_t word)
+    {
+        // FNV-1a over the words as they come in, so the hash is ready when the shape is
+        m_data.push_back(word);
+        for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+        {
+            m_hash ^= (word >> shift) & 0xFFu;
+            m_hash *= FNV_PRIME;
+        }
+    }
+
+    void ShapeDescription::Append(float value)
+    {
+        // Adding zero turns -0 into +0, so both spellings of a coordinate hash the same
+        value += 0.0f;
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        Append(bits);
+    }
+
+    void ShapeDescription::Append(const D2D1_POINT_2F& point)
+    {
+        Append(point.x);
+        Append(point.y);
+    }
+
+    float ShapeDescription::ReadFloat(size_t& i) const
+    {
+        float value;
+        memcpy(&value, &m_data[i++], sizeof(value));
+        return value;
+    }
+
+    D2D1_POINT_2F ShapeDescription::ReadPoint(size_t& i) const
+    {
+        float x = ReadFloat(i);
+        return D2D1::Point2F(x, ReadFloat(i));
+    }
+
+    GeometryCache::GeometryCache(size_t budget) :
+        m_budget(budget), m_bytes(0u), m_hits(0ull), m_misses(0ull), m_evictions(0ull)
+    {
+    }
+
+    GeometryCache::~GeometryCache()
+    {
+        Clear();
+    }
+
+    void GeometryCache::SetBudget(size_t bytes)
+    {
+        m_budget = bytes;
+        Trim();
+    }
+
+    size_t GeometryCache::GetBudget() const
+    {
+        return m_budget;
+    }
+
+    bool GeometryCache::IsEnabled() const
+    {
+        return m_budget > 0u;
+    }
+
+    ID2D1PathGeometry* GeometryCache::GetGeometry(ID2D1Factory* pFactory, const ShapeDescription& shape)
+    {
+        if (!pFactory) throw std::runtime_error("Direct2D factory is null.");
+        IUnknown* pFound = Find(Kind::Geometry, shape, 0.0f);
+        if (pFound) return static_cast<ID2D1PathGeometry*>(pFound);
+
+        ID2D1PathGeometry* pGeometry = nullptr;
+        ID2D1GeometrySink* pSink = nullptr;
+        HRESULT hr = pFactory->CreatePathGeometry(&pGeometry);
+        if (SUCCEEDED(hr)) hr = pGeometry->Open(&pSink);
+        if (SUCCEEDED(hr))
+        {
+            shape.Replay(pSink);
+            hr = pSink->Close();
+        }
+        SafeRelease(pSink);
+        if (FAILED(hr)) SafeRelease(pGeometry);
+        CheckHR(hr);
+
+        // Direct2D keeps about as much as the description, plus its own bookkeeping
+        UINT32 segments = 0u;
+        pGeometry->GetSegmentCount(&segments);
+        if (IsEnabled())
+        {
+            Entry entry = { Kind::Geometry, MakeKey(Kind::Geometry, shape, 0.0f), 0.0f, shape, pGeometry,
+                shape.GetSize() * 2u + segments * sizeof(D2D1_BEZIER_SEGMENT) };
+            pGeometry->AddRef();
+            Insert(std::move(entry));
+        }
+        return pGeometry;
+    }
+
+    ID2D1Mesh* GeometryCache::GetMesh(ID2D1RenderTarget* pRenderTarget, const ShapeDescription& shape,
+        float tolerance)
+    {
+        if (!pRenderTarget) throw std::runtime_error("Render target is null.");
+        IUnknown* pFound = Find(Kind::Mesh, shape, tolerance);
+        if (pFound) return static_cast<ID2D1Mesh*>(pFound);
+
+        // Tessellated from the shared geometry, so the geometry is cached on the way
+        ID2D1Factory* pFactory = nullptr;
+        pRenderTarget->GetFactory(&pFactory);
+        ID2D1PathGeometry* pGeometry = nullptr;
+        try
+        {
+            pGeometry = GetGeometry(pFactory, shape);
+        }
+        catch (...)
+        {
+            SafeRelease(pFactory);
+            throw;
+        }
+        SafeRelease(pFactory);
+
+        ID2D1Mesh* pMesh = nullptr;
+        ID2D1TessellationSink* pSink = nullptr;
+        HRESULT hr = pRenderTarget->CreateMesh(&pMesh);
+        if (SUCCEEDED(hr)) hr = pMesh->Open(&pSink);
+        CountingTessellationSink counter(pSink);
+        if (SUCCEEDED(hr)) hr = pGeometry->Tessellate(nullptr, tolerance, &counter);
+        if (SUCCEEDED(hr)) hr = pSink->Close();
+        SafeRelease(pSink);
+        SafeRelease(pGeometry);
+        if (FAILED(hr)) SafeRelease(pMesh);
+        CheckHR(hr);
+
+        if (IsEnabled())
+        {
+            Entry entry = { Kind::Mesh, MakeKey(Kind::Mesh, shape, tolerance), tolerance, shape, pMesh,
+                shape.GetSize() + counter.triangles * sizeof(D2D1_TRIANGLE) };
+            pMesh->AddRef();
+            Insert(std::move(entry));
+        }
+        return pMesh;
+    }
+
+    void GeometryCache::Clear()
+    {
+        while (!m_lru.empty()) Remove(m_lru.begin());
+    }
+
+    void GeometryCache::ClearDeviceResources()
+    {
+        // Meshes belong to a render target, geometries only to the factory
+        for (auto it = m_lru.begin(); it != m_lru.end();)
+        {
+            auto next = std::next(it);
+            if (it->kind == Kind::Mesh) Remove(it);
+            it = next;
+        }
+    }
+
+    GeometryCache::Stats GeometryCache::GetStats() const
+    {
+        Stats stats = {};
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.bytes = m_bytes;
+        stats.budget = m_budget;
+        stats.entries = (unsigned int)m_lru.size();
+        return stats;
+    }
+
+    void GeometryCache::ResetStats()
+    {
+        m_hits = m_misses = m_evictions = 0ull;
+    }
+
+    uint64_t GeometryCache::MakeKey(Kind kind, const ShapeDescription& shape, float tolerance)
+    {
+        uint32_t bits;
+        memcpy(&bits, &tolerance, sizeof(bits));
+        uint64_t key = shape.GetHash();
+        key = (key ^ (uint64_t)kind) * FNV_PRIME;
+        return (key ^ bits) * FNV_PRIME;
+    }
+
+    IUnknown* GeometryCache::Find(Kind kind, const ShapeDescription& shape, float tolerance)
+    {
+        if (!IsEnabled()) return nullptr;
+
+        // The key is only a hash, the description itself decides, a collision is just a miss
+        auto found = m_index.find(MakeKey(kind, shape, tolerance));
+        if (found == m_index.end() || found->second->kind != kind || found->second->tolerance != tolerance ||
+            !(found->second->shape == shape))
+        {
+            ++m_misses;
+            return nullptr;
+        }
+
+        ++m_hits;
+        m_lru.splice(m_lru.begin(), m_lru, found->second);
+        m_lru.front().pObject->AddRef();
+        return m_lru.front().pObject;
+    }
+
+    void GeometryCache::Insert(Entry&& entry)
+    {
+        auto found = m_index.find(entry.key);
+        if (found != m_index.end()) Remove(found->second);
+
+        m_bytes += entry.bytes;
+        m_lru.push_front(std::move(entry));
+        m_index[m_lru.front().key] = m_lru.begin();
+        Trim();
+    }
+
+    void GeometryCache::Remove(std::list<Entry>::iterator it)
+    {
+        m_bytes -= it->bytes;
+        SafeRelease(it->pObject);
+        m_index.erase(it->key);
+        m_lru.erase(it);
+    }
+
+    void GeometryCache::Trim()
+    {
+        // Cold entries nobody else holds go first, the same policy as the asset cache
+        for (auto it = m_lru.end(); m_bytes > m_budget && it != m_lru.begin();)
+        {
+            --it;
+            if (InUse(*it)) continue;
+            auto victim = it++;
+            Remove(victim);
+            ++m_evictions;
+        }
+
+        while (m_bytes > m_budget && !m_lru.empty())
+        {
+            Remove(std::prev(m_lru.end()));
+            ++m_evictions;
+        }
+    }
+
+    bool GeometryCache::InUse(const Entry& entry)
+    {
+        entry.pObject->AddRef();
+        return entry.pObject->Release() > 1u;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <d2d1.h>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace Ice2D
+{
+	class ShapeDescription
+	{
+	public:
+		ShapeDescription(D2D1_FILL_MODE fillMode = D2D1_FILL_MODE_ALTERNATE);
+		void Clear();
+		void SetFillMode(D2D1_FILL_MODE fillMode);
+		void BeginFigure(const D2D1_POINT_2F& startPoint, D2D1_FIGURE_BEGIN figureBegin = D2D1_FIGURE_BEGIN_FILLED);
+		void EndFigure(D2D1_FIGURE_END figureEnd = D2D1_FIGURE_END_CLOSED);
+		void AddLine(const D2D1_POINT_2F& point);
+		void AddLines(const D2D1_POINT_2F* points, unsigned int count);
+		void AddBezier(const D2D1_BEZIER_SEGMENT& bezier);
+		void AddQuadraticBezier(const D2D1_QUADRATIC_BEZIER_SEGMENT& bezier);
+		void AddArc(const D2D1_ARC_SEGMENT& arc);
+		void AddRectangle(const D2D1_RECT_F& rect);
+		void AddRoundedRectangle(const D2D1_ROUNDED_RECT& rect);
+		void AddEllipse(const D2D1_ELLIPSE& ellipse);
+		uint64_t GetHash() const;
+		size_t GetSize() const;
+		bool operator==(const ShapeDescription& other) const;
+		void Replay(ID2D1GeometrySink* pSink) const;
+	private:
+		enum class Op : uint32_t { FillMode, Begin, Line, Bezier, QuadraticBezier, Arc, End };
+		std::vector<uint32_t> m_data;
+		uint64_t m_hash;
+		bool m_open;
+		void Append(uint32_t word);
+		void Append(float value);
+		void Append(const D2D1_POINT_2F& point);
+		float ReadFloat(size_t& i) const;
+		D2D1_POINT_2F ReadPoint(size_t& i) const;
+	};
+
+	class GeometryCache
+	{
+	public:
+		struct Stats
+		{
+			unsigned long long hits, misses, evictions;
+			size_t bytes, budget;
+			unsigned int entries;
+		};
+		GeometryCache(size_t budget = 16u * 1024u * 1024u);
+		GeometryCache(const GeometryCache& other) = delete;
+		GeometryCache& operator=(const GeometryCache& other) = delete;
+		~GeometryCache();
+		void SetBudget(size_t bytes);
+		size_t GetBudget() const;
+		bool IsEnabled() const;
+		ID2D1PathGeometry* GetGeometry(ID2D1Factory* pFactory, const ShapeDescription& shape);
+		ID2D1Mesh* GetMesh(ID2D1RenderTarget* pRenderTarget, const ShapeDescription& shape,
+			float tolerance = D2D1_DEFAULT_FLATTENING_TOLERANCE);
+		void Clear();
+		void ClearDeviceResources();
+		Stats GetStats() const;
+		void ResetStats();
+	private:
+		enum class Kind { Geometry, Mesh };
+		struct Entry
+		{
+			Kind kind;
+			uint64_t key;
+			float tolerance;
+			ShapeDescription shape;
+			IUnknown* pObject;
+			size_t bytes;
+		};
+		std::list<Entry> m_lru;
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+		size_t m_budget, m_bytes;
+		unsigned long long m_hits, m_misses, m_evictions;
+		static uint64_t MakeKey(Kind kind, const ShapeDescription& shape, float tolerance);
+		IUnknown* Find(Kind kind, const ShapeDescription& shape, float tolerance);
+		void Insert(Entry&& entry);
+		void Remove(std::list<Entry>::iterator it);
+		void Trim();
+		static bool InUse(const Entry& entry);
+	};
+}
@@ -0,0 +1,489 @@
+#include "pch.h"
+
+#include "GlyphTable.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Ice2D
+{
+    struct FontToken
+    {
+        const char* p;
+        size_t n;
+    };
+
+    struct FontLine
+    {
+        static const size_t MAX_PAIRS = 32u;
+        FontToken tag;
+        FontToken keys[MAX_PAIRS], values[MAX_PAIRS];
+        size_t count;
+    };
+
+    static bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static bool Equals(const FontToken& token, const char* text)
+    {
+        size_t n = std::strlen(text);
+        return token.n == n && std::memcmp(token.p, text, n) == 0;
+    }
+
+    static bool SplitLine(const char* p, size_t n, FontLine& line)
+    {
+        // tag key=value key="quoted value" ...
+        size_t i = 0u;
+        while (i < n && IsSpace(p[i])) ++i;
+        line.tag.p = p + i;
+        while (i < n && !IsSpace(p[i])) ++i;
+        line.tag.n = (size_t)(p + i - line.tag.p);
+        line.count = 0u;
+        while (i < n)
+        {
+            while (i < n && IsSpace(p[i])) ++i;
+            if (i == n) break;
+            FontToken key = { p + i, 0u };
+            while (i < n && !IsSpace(p[i]) && p[i] != '=') ++i;
+            key.n = (size_t)(p + i - key.p);
+            if (i == n || p[i] != '=') continue;
+            ++i;
+
+            FontToken value;
+            if (i < n && p[i] == '"')
+            {
+                value.p = p + ++i;
+                while (i < n && p[i] != '"') ++i;
+                if (i == n) return false;
+                value.n = (size_t)(p + i - value.p);
+                ++i;
+            }
+            else
+            {
+                value.p = p + i;
+                while (i < n && !IsSpace(p[i])) ++i;
+                value.n = (size_t)(p + i - value.p);
+            }
+            if (line.count < FontLine::MAX_PAIRS)
+            {
+                line.keys[line.count] = key;
+                line.values[line.count] = value;
+                ++line.count;
+            }
+        }
+        return true;
+    }
+
+    static const FontToken* FindValue(const FontLine& line, const char* key)
+    {
+        for (size_t i = 0u; i < line.count; ++i)
+        {
+            if (Equals(line.keys[i], key)) return &line.values[i];
+        }
+        return nullptr;
+    }
+
+    static bool GetInt(const FontLine& line, const char* key, long& value)
+    {
+        const FontToken* pToken = FindValue(line, key);
+        if (!pToken || pToken->n == 0u) return false;
+        size_t i = 0u;
+        bool negative = pToken->p[0] == '-';
+        if (negative || pToken->p[0] == '+') ++i;
+        if (i == pToken->n) return false;
+
+        long result = 0;
+        for (; i < pToken->n; ++i)
+        {
+            char c = pToken->p[i];
+            if (c < '0' || c > '9' || result > 0x10000000) return false;
+            result = result * 10 + (c - '0');
+        }
+        value = negative ? -result : result;
+        return true;
+    }
+
+    static bool InRange(long value, long low, long high)
+    {
+        return value >= low && value <= high;
+    }
+
+    static uint32_t Decode(const wchar_t* text, size_t length, size_t& i)
+    {
+        // Surrogate pairs only show up where wchar_t is 16 bits
+        uint32_t c = (uint32_t)text[i++];
+        if (c >= 0xD800u && c < 0xDC00u && i < length)
+        {
+            uint32_t low = (uint32_t)text[i];
+            if (low >= 0xDC00u && low < 0xE000u)
+            {
+                ++i;
+                c = 0x10000u + ((c - 0xD800u) << 10) + (low - 0xDC00u);
+            }
+        }
+        return c;
+    }
+
+    static uint32_t Decode(const char* text, size_t length, size_t& i)
+    {
+        // UTF-8, a broken sequence turns into U+FFFD and decoding resumes at the next byte
+        uint32_t c = (unsigned char)text[i++];
+        if (c < 0x80u) return c;
+        size_t extra = c >= 0xF0u && c < 0xF8u ? 3u : c >= 0xE0u ? 2u : c >= 0xC0u ? 1u : 0u;
+        if (extra == 0u || c >= 0xF8u) return 0xFFFDu;
+        c &= 0x3Fu >> extra;
+        for (size_t k = 0u; k < extra; ++k)
+        {
+            if (i + k >= length || ((unsigned char)text[i + k] & 0xC0u) != 0x80u) return 0xFFFDu;
+            c = (c << 6) | ((unsigned char)text[i + k] & 0x3Fu);
+        }
+        i += extra;
+        return c;
+    }
+
+    GlyphTable::GlyphTable() : m_latin(256u, Slot()), m_lineHeight(0.0f), m_base(0.0f), m_pageWidth(0u),
+        m_pageHeight(0u), m_fallback('?'), m_glyphCount(0u)
+    {
+    }
+
+    void GlyphTable::Clear()
+    {
+        m_latin.assign(256u, Slot());
+        m_extended.clear();
+        m_kerning.clear();
+        m_pages.clear();
+        m_lineHeight = m_base = 0.0f;
+        m_pageWidth = m_pageHeight = 0u;
+        m_glyphCount = 0u;
+    }
+
+    GlyphTable::Result GlyphTable::Parse(const void* pData, size_t size)
+    {
+        Clear();
+        const char* p = static_cast<const char*>(pData);
+        if (!p || size == 0u) return Result::Empty;
+        if (size >= 3u && std::memcmp(p, "\xEF\xBB\xBF", 3u) == 0)
+        {
+            p += 3;
+            size -= 3u;
+        }
+        if (size >= 3u && std::memcmp(p, "BMF", 3u) == 0) return Result::Binary;
+        size_t first = 0u;
+        while (first < size && (IsSpace(p[first]) || p[first] == '\n')) ++first;
+        if (first < size && p[first] == '<') return Result::Xml;
+
+        // The AngelCode BMFont text format, one tag per line
+        bool hasCommon = false;
+        unsigned int maxPage = 0u;
+        FontLine line;
+        size_t start = 0u;
+        Result result = Result::Ok;
+        while (start < size && result == Result::Ok)
+        {
+            const char* pEnd = static_cast<const char*>(std::memchr(p + start, '\n', size - start));
+            size_t end = pEnd ? (size_t)(pEnd - p) : size;
+            bool split = SplitLine(p + start, end - start, line);
+            start = end + 1u;
+            if (!split)
+            {
+                result = Result::BadLine;
+            }
+            else if (Equals(line.tag, "common"))
+            {
+                long lineHeight, base, width, height, pages = 1;
+                if (!GetInt(line, "lineHeight", lineHeight) || !GetInt(line, "base", base) ||
+                    !GetInt(line, "scaleW", width) || !GetInt(line, "scaleH", height) ||
+                    !InRange(width, 1, 65535) || !InRange(height, 1, 65535))
+                {
+                    result = Result::BadLine;
+                    break;
+                }
+                if (FindValue(line, "pages") && (!GetInt(line, "pages", pages) || !InRange(pages, 0, 1024)))
+                {
+                    result = Result::BadLine;
+                    break;
+                }
+                SetMetrics((float)lineHeight, (float)base, (unsigned int)width, (unsigned int)height);
+                m_pages.resize((size_t)pages);
+                hasCommon = true;
+            }
+            else if (Equals(line.tag, "page"))
+            {
+                long id;
+                const FontToken* pFile = FindValue(line, "file");
+                if (!GetInt(line, "id", id) || !InRange(id, 0, 1023) || !pFile || pFile->n == 0u)
+                {
+                    result = Result::BadLine;
+                    break;
+                }
+                if ((size_t)id >= m_pages.size()) m_pages.resize((size_t)id + 1u);
+                m_pages[(size_t)id].assign(pFile->p, pFile->n);
+            }
+            else if (Equals(line.tag, "char"))
+            {
+                long id, x, y, width, height, offsetX, offsetY, advance, page = 0;
+                if (!hasCommon)
+                {
+                    result = Result::MissingCommon;
+                    break;
+                }
+                if (!GetInt(line, "id", id) || !GetInt(line, "x", x) || !GetInt(line, "y", y) ||
+                    !GetInt(line, "width", width) || !GetInt(line, "height", height) ||
+                    !GetInt(line, "xoffset", offsetX) || !GetInt(line, "yoffset", offsetY) ||
+                    !GetInt(line, "xadvance", advance) || (FindValue(line, "page") && !GetInt(line, "page", page)))
+                {
+                    result = Result::BadLine;
+                    break;
+                }
+                // Some exporters write the invalid-character glyph as id -1
+                if (id < 0) continue;
+                if (id > 0x10FFFF || !InRange(x, 0, 65535) || !InRange(y, 0, 65535) || width < 0 || height < 0 ||
+                    x + width > (long)m_pageWidth || y + height > (long)m_pageHeight || !InRange(page, 0, 1023) ||
+                    !InRange(offsetX, -32768, 32767) || !InRange(offsetY, -32768, 32767) ||
+                    !InRange(advance, -32768, 32767))
+                {
+                    result = Result::BadGlyph;
+                    break;
+                }
+                Glyph glyph = { (uint16_t)x, (uint16_t)y, (uint16_t)width, (uint16_t)height,
+                    (int16_t)offsetX, (int16_t)offsetY, (int16_t)advance, (uint16_t)page };
+                AddGlyph((uint32_t)id, glyph);
+                maxPage = std::max(maxPage, (unsigned int)page);
+            }
+            else if (Equals(line.tag, "kerning"))
+            {
+                long firstId, secondId, amount;
+                if (!GetInt(line, "first", firstId) || !GetInt(line, "second", secondId) ||
+                    !GetInt(line, "amount", amount) || !InRange(firstId, 0, 0x10FFFF) || !InRange(secondId, 0, 0x10FFFF))
+                {
+                    result = Result::BadLine;
+                    break;
+                }
+                AddKerning((uint32_t)firstId, (uint32_t)secondId, (int)amount);
+            }
+        }
+
+        if (result == Result::Ok)
+        {
+            if (!hasCommon) result = Result::MissingCommon;
+            else if (m_glyphCount == 0u) result = Result::NoGlyphs;
+            else if (maxPage >= m_pages.size()) result = Result::BadGlyph;
+            else if (std::any_of(m_pages.begin(), m_pages.end(), [](const std::string& page) { return page.empty(); }))
+                result = Result::MissingPage;
+        }
+        if (result != Result::Ok) Clear();
+        return result;
+    }
+
+    const char* GlyphTable::GetResultName(Result result)
+    {
+        switch (result)
+        {
+        case Result::Ok: return "Ok";
+        case Result::Empty: return "Empty file";
+        case Result::Binary: return "Binary BMFont files are not supported";
+        case Result::Xml: return "XML BMFont files are not supported";
+        case Result::BadLine: return "Invalid line";
+        case Result::MissingCommon: return "Missing common line";
+        case Result::MissingPage: return "Missing page file";
+        case Result::BadGlyph: return "Glyph outside its page";
+        case Result::NoGlyphs: return "No glyphs";
+        }
+        return "Unknown";
+    }
+
+    void GlyphTable::SetMetrics(float lineHeight, float base, unsigned int pageWidth, unsigned int pageHeight)
+    {
+        m_lineHeight = lineHeight;
+        m_base = base;
+        m_pageWidth = pageWidth;
+        m_pageHeight = pageHeight;
+    }
+
+    void GlyphTable::AddPage(const std::string& file)
+    {
+        m_pages.push_back(file);
+    }
+
+    void GlyphTable::AddGlyph(uint32_t codepoint, const Glyph& glyph)
+    {
+        Slot& slot = GetSlot(codepoint);
+        if (!slot.present) ++m_glyphCount;
+        slot.glyph = glyph;
+        slot.present = true;
+    }
+
+    void GlyphTable::AddKerning(uint32_t first, uint32_t second, int amount)
+    {
+        // Glyphs remember whether they start a pair, so most characters never touch the map
+        amount = amount < -32768 ? -32768 : amount > 32767 ? 32767 : amount;
+        m_kerning[((uint64_t)first << 32) | second] = (int16_t)amount;
+        GetSlot(first).kerns = true;
+    }
+
+    void GlyphTable::SetFallback(uint32_t codepoint)
+    {
+        m_fallback = codepoint;
+    }
+
+    const GlyphTable::Glyph* GlyphTable::FindGlyph(uint32_t codepoint) const
+    {
+        const Slot* pSlot = FindSlot(codepoint);
+        return pSlot ? &pSlot->glyph : nullptr;
+    }
+
+    int GlyphTable::GetKerning(uint32_t first, uint32_t second) const
+    {
+        if (m_kerning.empty()) return 0;
+        auto found = m_kerning.find(((uint64_t)first << 32) | second);
+        return found != m_kerning.end() ? found->second : 0;
+    }
+
+    size_t GlyphTable::Layout(const wchar_t* text, size_t length, float x, float y, float scale,
+        std::vector<Quad>& quads) const
+    {
+        return LayoutText(text, length, x, y, scale, &quads, nullptr);
+    }
+
+    size_t GlyphTable::Layout(const char* text, size_t length, float x, float y, float scale,
+        std::vector<Quad>& quads) const
+    {
+        return LayoutText(text, length, x, y, scale, &quads, nullptr);
+    }
+
+    GlyphTable::Size GlyphTable::Measure(const wchar_t* text, size_t length, float scale) const
+    {
+        Size size;
+        LayoutText(text, length, 0.0f, 0.0f, scale, nullptr, &size);
+        return size;
+    }
+
+    GlyphTable::Size GlyphTable::Measure(const char* text, size_t length, float scale) const
+    {
+        Size size;
+        LayoutText(text, length, 0.0f, 0.0f, scale, nullptr, &size);
+        return size;
+    }
+
+    float GlyphTable::GetLineHeight() const
+    {
+        return m_lineHeight;
+    }
+
+    float GlyphTable::GetBase() const
+    {
+        return m_base;
+    }
+
+    unsigned int GlyphTable::GetPageWidth() const
+    {
+        return m_pageWidth;
+    }
+
+    unsigned int GlyphTable::GetPageHeight() const
+    {
+        return m_pageHeight;
+    }
+
+    unsigned int GlyphTable::GetPageCount() const
+    {
+        return (unsigned int)m_pages.size();
+    }
+
+    const std::string& GlyphTable::GetPage(unsigned int page) const
+    {
+        return m_pages.at(page);
+    }
+
+    size_t GlyphTable::GetGlyphCount() const
+    {
+        return m_glyphCount;
+    }
+
+    size_t GlyphTable::GetKerningCount() const
+    {
+        return m_kerning.size();
+    }
+
+    const GlyphTable::Slot* GlyphTable::FindSlot(uint32_t codepoint) const
+    {
+        // Latin-1 is a plain array lookup, everything else goes through the map
+        if (codepoint < 256u) return m_latin[codepoint].present ? &m_latin[codepoint] : nullptr;
+        auto found = m_extended.find(codepoint);
+        return found != m_extended.end() && found->second.present ? &found->second : nullptr;
+    }
+
+    GlyphTable::Slot& GlyphTable::GetSlot(uint32_t codepoint)
+    {
+        if (codepoint < 256u) return m_latin[codepoint];
+        return m_extended[codepoint];
+    }
+
+    template <typename Char> size_t GlyphTable::LayoutText(const Char* text, size_t length, float x, float y,
+        float scale, std::vector<Quad>* pQuads, Size* pSize) const
+    {
+        if (!text && length) throw std::runtime_error("Text is null.");
+        if (pQuads) pQuads->reserve(pQuads->size() + length);
+
+        const Slot* pFallback = FindSlot(m_fallback);
+        const Slot* pPrevious = nullptr;
+        uint32_t previous = 0u;
+        float penX = x, lineY = y, width = 0.0f;
+        size_t lines = length ? 1u : 0u, emitted = 0u, i = 0u;
+        while (i < length)
+        {
+            uint32_t codepoint = Decode(text, length, i);
+            if (codepoint == '\n')
+            {
+                width = std::max(width, penX - x);
+                penX = x;
+                lineY += m_lineHeight * scale;
+                ++lines;
+                pPrevious = nullptr;
+                continue;
+            }
+            if (codepoint == '\r') continue;
+
+            const Slot* pSlot = FindSlot(codepoint);
+            if (!pSlot)
+            {
+                pSlot = pFallback;
+                codepoint = m_fallback;
+                if (!pSlot)
+                {
+                    pPrevious = nullptr;
+                    continue;
+                }
+            }
+            if (pPrevious && pPrevious->kerns) penX += (float)GetKerning(previous, codepoint) * scale;
+
+            const Glyph& glyph = pSlot->glyph;
+            if (pQuads && glyph.width && glyph.height)
+            {
+                Quad quad;
+                quad.left = penX + glyph.offsetX * scale;
+                quad.top = lineY + glyph.offsetY * scale;
+                quad.right = quad.left + glyph.width * scale;
+                quad.bottom = quad.top + glyph.height * scale;
+                quad.sourceLeft = glyph.x;
+                quad.sourceTop = glyph.y;
+                quad.sourceRight = (uint32_t)glyph.x + glyph.width;
+                quad.sourceBottom = (uint32_t)glyph.y + glyph.height;
+                quad.page = glyph.page;
+                pQuads->push_back(quad);
+                ++emitted;
+            }
+            penX += glyph.advance * scale;
+            pPrevious = pSlot;
+            previous = codepoint;
+        }
+
+        if (pSize)
+        {
+            pSize->width = std::max(width, penX - x);
+            pSize->height = (float)lines * m_lineHeight * scale;
+        }
+        return emitted;
+    }
+}
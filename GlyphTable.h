@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Ice2D
+{
+	class GlyphTable
+	{
+	public:
+		enum class Result { Ok, Empty, Binary, Xml, BadLine, MissingCommon, MissingPage, BadGlyph, NoGlyphs };
+		struct Glyph
+		{
+			uint16_t x, y, width, height;
+			int16_t offsetX, offsetY, advance;
+			uint16_t page;
+		};
+		struct Quad
+		{
+			float left, top, right, bottom;
+			uint32_t sourceLeft, sourceTop, sourceRight, sourceBottom;
+			uint32_t page;
+		};
+		struct Size
+		{
+			float width, height;
+		};
+		GlyphTable();
+		void Clear();
+		Result Parse(const void* pData, size_t size);
+		static const char* GetResultName(Result result);
+		void SetMetrics(float lineHeight, float base, unsigned int pageWidth, unsigned int pageHeight);
+		void AddPage(const std::string& file);
+		void AddGlyph(uint32_t codepoint, const Glyph& glyph);
+		void AddKerning(uint32_t first, uint32_t second, int amount);
+		void SetFallback(uint32_t codepoint);
+		const Glyph* FindGlyph(uint32_t codepoint) const;
+		int GetKerning(uint32_t first, uint32_t second) const;
+		size_t Layout(const wchar_t* text, size_t length, float x, float y, float scale, std::vector<Quad>& quads) const;
+		size_t Layout(const char* text, size_t length, float x, float y, float scale, std::vector<Quad>& quads) const;
+		Size Measure(const wchar_t* text, size_t length, float scale = 1.0f) const;
+		Size Measure(const char* text, size_t length, float scale = 1.0f) const;
+		float GetLineHeight() const;
+		float GetBase() const;
+		unsigned int GetPageWidth() const;
+		unsigned int GetPageHeight() const;
+		unsigned int GetPageCount() const;
+		const std::string& GetPage(unsigned int page) const;
+		size_t GetGlyphCount() const;
+		size_t GetKerningCount() const;
+	private:
+		struct Slot
+		{
+			Glyph glyph;
+			bool present, kerns;
+		};
+		std::vector<Slot> m_latin;
+		std::unordered_map<uint32_t, Slot> m_extended;
+		std::unordered_map<uint64_t, int16_t> m_kerning;
+		std::vector<std::string> m_pages;
+		float m_lineHeight, m_base;
+		unsigned int m_pageWidth, m_pageHeight;
+		uint32_t m_fallback;
+		size_t m_glyphCount;
+		const Slot* FindSlot(uint32_t codepoint) const;
+		Slot& GetSlot(uint32_t codepoint);
+		template <typename Char> size_t LayoutText(const Char* text, size_t length, float x, float y, float scale,
+			std::vector<Quad>* pQuads, Size* pSize) const;
+	};
+}
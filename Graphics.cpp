@@ -8,27 +8,41 @@ namespace Ice2D
 {
     Graphics::Graphics(HINSTANCE hInstance, const unsigned int clientWidth, const unsigned int clientHeight,
         LPCWSTR title, const DWORD windowStyle, const int nCmdShow) :
-        Window(hInstance, clientWidth, clientHeight, title, windowStyle, nCmdShow)
+        Window(hInstance, clientWidth, clientHeight, title, windowStyle, nCmdShow), m_pD2DFactory(nullptr),
+        m_pRenderTarget(nullptr), m_pWICFactory(nullptr), m_pFrame(nullptr), m_comInitialized(false)
     {
-        // Create d2d factory
-        HRESULT hr;
-        if (!m_pD2DFactory)
-        {
-#ifdef _DEBUG
-            D2D1_FACTORY_OPTIONS options = {};
-            options.debugLevel = D2D1_DEBUG_LEVEL_INFORMATION;
-            hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, options, &m_pD2DFactory);
-#else
-            hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &m_pD2DFactory);
-#endif
-            CheckHR(hr);
-        }
+        CreateFactory();
 
         // Create render target
-        hr = m_pD2DFactory->CreateHwndRenderTarget(
+        ID2D1HwndRenderTarget* pHwndTarget = nullptr;
+        HRESULT hr = m_pD2DFactory->CreateHwndRenderTarget(
             D2D1::RenderTargetProperties(),
             D2D1::HwndRenderTargetProperties(hwnd, D2D1::SizeU(m_clientWidth, m_clientHeight)),
-            &m_pRenderTarget);
+            &pHwndTarget);
+        CheckHR(hr);
+        m_pRenderTarget = pHwndTarget;
+    }
+
+    Graphics::Graphics(const unsigned int width, const unsigned int height) : Window(width, height),
+        m_pD2DFactory(nullptr), m_pRenderTarget(nullptr), m_pWICFactory(nullptr), m_pFrame(nullptr),
+        m_comInitialized(false)
+    {
+        // The resource manager isn't constructed yet, so the WIC factory needs COM here already
+        HRESULT hr = CoInitialize(nullptr);
+        if (hr != RPC_E_CHANGED_MODE) CheckHR(hr);
+        m_comInitialized = SUCCEEDED(hr);
+        CreateFactory();
+
+        // Frames are drawn into a WIC bitmap in system memory, the same way as RawImage::GetRenderTarget()
+        hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&m_pWICFactory));
+        CheckHR(hr);
+        hr = m_pWICFactory->CreateBitmap(width, height, GUID_WICPixelFormat32bppPBGRA, WICBitmapCacheOnLoad, &m_pFrame);
+        CheckHR(hr);
+        hr = m_pD2DFactory->CreateWicBitmapRenderTarget(m_pFrame,
+            D2D1::RenderTargetProperties(
+                D2D1_RENDER_TARGET_TYPE_DEFAULT,
+                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED)
+            ), &m_pRenderTarget);
         CheckHR(hr);
     }
 
@@ -47,7 +61,23 @@ namespace Ice2D
             HRException::ErrorBox(e);
         }
         SafeRelease(m_pRenderTarget);
+        SafeRelease(m_pFrame);
+        SafeRelease(m_pWICFactory);
         SafeRelease(m_pD2DFactory);
+        if (m_comInitialized) CoUninitialize();
+    }
+
+    void Graphics::CreateFactory()
+    {
+        HRESULT hr;
+#ifdef _DEBUG
+        D2D1_FACTORY_OPTIONS options = {};
+        options.debugLevel = D2D1_DEBUG_LEVEL_INFORMATION;
+        hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, options, &m_pD2DFactory);
+#else
+        hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &m_pD2DFactory);
+#endif
+        CheckHR(hr);
     }
 
     void Graphics::OnResize(const unsigned int width, const unsigned int height)
@@ -56,7 +86,7 @@ namespace Ice2D
         GetClientRect(hwnd, &rc);
         m_clientWidth = rc.right - rc.left;
         m_clientHeight = rc.bottom - rc.top;
-        HRESULT hr = m_pRenderTarget->Resize(D2D1::SizeU(m_clientWidth, m_clientHeight));
+        HRESULT hr = GetHwndRT()->Resize(D2D1::SizeU(m_clientWidth, m_clientHeight));
         CheckHR(hr);
     }
 
@@ -80,8 +110,53 @@ namespace Ice2D
         m_pRenderTarget->SetTransform(D2D1::IdentityMatrix());
     }
 
-    ID2D1HwndRenderTarget* Graphics::GetRT() const
+    ID2D1RenderTarget* Graphics::GetRT() const
     {
         return m_pRenderTarget;
     }
+
+    ID2D1HwndRenderTarget* Graphics::GetHwndRT() const
+    {
+        // Headless graphics draw into a WIC bitmap, there is no window target to resize
+        if (IsHeadless()) return nullptr;
+        return static_cast<ID2D1HwndRenderTarget*>(m_pRenderTarget);
+    }
+
+    IWICBitmap* Graphics::GetFrameBitmap() const
+    {
+        return m_pFrame;
+    }
+
+    void Graphics::CopyFrame(void* pPixels, unsigned int stride) const
+    {
+        // Premultiplied BGRA rows of the last frame, only valid outside of BeginDraw()/EndDraw()
+        if (!m_pFrame) throw std::runtime_error("Frame bitmap is null.");
+        if (!pPixels) throw std::runtime_error("Pixels are null.");
+        WICRect rect = { 0, 0, (INT)m_clientWidth, (INT)m_clientHeight };
+        HRESULT hr = m_pFrame->CopyPixels(&rect, stride, stride * m_clientHeight, static_cast<BYTE*>(pPixels));
+        CheckHR(hr);
+    }
+
+    void Graphics::SaveFrame(const wchar_t* filePath) const
+    {
+        if (!m_pFrame) throw std::runtime_error("Frame bitmap is null.");
+
+        // Screenshots are written as PNG, which keeps the pixels exact for comparisons
+        IWICStream* pStream = nullptr;
+        IWICBitmapEncoder* pEncoder = nullptr;
+        IWICBitmapFrameEncode* pFrame = nullptr;
+        HRESULT hr = m_pWICFactory->CreateStream(&pStream);
+        if (SUCCEEDED(hr)) hr = pStream->InitializeFromFilename(filePath, GENERIC_WRITE);
+        if (SUCCEEDED(hr)) hr = m_pWICFactory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &pEncoder);
+        if (SUCCEEDED(hr)) hr = pEncoder->Initialize(pStream, WICBitmapEncoderNoCache);
+        if (SUCCEEDED(hr)) hr = pEncoder->CreateNewFrame(&pFrame, nullptr);
+        if (SUCCEEDED(hr)) hr = pFrame->Initialize(nullptr);
+        if (SUCCEEDED(hr)) hr = pFrame->WriteSource(m_pFrame, nullptr);
+        if (SUCCEEDED(hr)) hr = pFrame->Commit();
+        if (SUCCEEDED(hr)) hr = pEncoder->Commit();
+        SafeRelease(pFrame);
+        SafeRelease(pEncoder);
+        SafeRelease(pStream);
+        CheckHR(hr);
+    }
 }
\ No newline at end of file
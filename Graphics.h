@@ -1,6 +1,7 @@
 #pragma once
 #include "Window.h"
 #include <d2d1.h>
+#include <wincodec.h>
 
 namespace Ice2D
 {
@@ -10,17 +11,26 @@ namespace Ice2D
         Graphics(HINSTANCE hInstance, const unsigned int clientWidth, const unsigned int clientHeight, LPCWSTR title,
             const DWORD windowStyle = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX,
             const int nCmdShow = SW_SHOWNORMAL);
+        Graphics(const unsigned int width, const unsigned int height);
         Graphics(const Graphics& other) = delete;
         void operator=(const Graphics& other) = delete;
         ~Graphics();
-        ID2D1HwndRenderTarget* GetRT() const;
+        ID2D1RenderTarget* GetRT() const;
+        ID2D1HwndRenderTarget* GetHwndRT() const;
         ID2D1Factory* GetFactory() const;
+        IWICBitmap* GetFrameBitmap() const;
+        void CopyFrame(void* pPixels, unsigned int stride) const;
+        void SaveFrame(const wchar_t* filePath) const;
         void SetRotation(float angle, D2D_POINT_2F center = D2D1::Point2F());
         void SetRotation(float angle, float center_x, float center_y);
         void ClearTransform();
     private:
         ID2D1Factory* m_pD2DFactory;
-        ID2D1HwndRenderTarget* m_pRenderTarget;
+        ID2D1RenderTarget* m_pRenderTarget;
+        IWICImagingFactory* m_pWICFactory;
+        IWICBitmap* m_pFrame;
+        bool m_comInitialized;
+        void CreateFactory();
         void OnResize(const unsigned int width, const unsigned int height) override;
     };
-}
\ No newline at end of file
+}
@@ -1,8 +1,23 @@
 #pragma once
 
 #include "Application.h"
+#include "InputQueue.h"
 #include "Brush.h"
+#include "BrushCache.h"
 #include "Geometry.h"
+#include "GeometryCache.h"
+#include "Tessellator.h"
+#include "CommandList.h"
+#include "CachedLayer.h"
 #include "Images.h"
 #include "Sound.h"
-#include "TextFormat.h"
\ No newline at end of file
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "AssetPack.h"
+#include "StreamingSound.h"
+#include "VoicePool.h"
+#include "Mixer.h"
+#include "SoftwareCanvas.h"
+#include "TextFormat.h"
+#include "TextBitmapCache.h"
+#include "BitmapFont.h"
\ No newline at end of file
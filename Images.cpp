@@ -3,9 +3,18 @@
 #include "Images.h"
 #include "SafeRelease.h"
 #include "HRException.h"
+#include "PixelKernels.h"
+#include "AssetPack.h"
 
 namespace Ice2D
 {
+    // Identifies a raw image across moves, so a D2DImage knows whether it holds the last upload of it
+    static unsigned long long NextRawImageId()
+    {
+        static unsigned long long nextId = 0ull;
+        return ++nextId;
+    }
+
     unsigned int IBasicImage::GetWidth() const
     {
         return m_width;
@@ -40,10 +49,15 @@ namespace Ice2D
     }
 
     IWICBitmapSource* IBasicImage::GetSourceFromFile(const wchar_t* path)
+    {
+        return CreateSourceFromFile(m_pManager->GetWICFactory(), path);
+    }
+
+    IWICBitmapSource* IBasicImage::CreateSourceFromFile(IWICImagingFactory* pFactory, const wchar_t* path)
     {
         // Load the image using WIC
         IWICBitmapDecoder* pDecoder = nullptr;
-        HRESULT hr = m_pManager->GetWICFactory()->CreateDecoderFromFilename(path, nullptr,
+        HRESULT hr = pFactory->CreateDecoderFromFilename(path, nullptr,
             GENERIC_READ, WICDecodeOptions::WICDecodeMetadataCacheOnDemand, &pDecoder);
         CheckHR(hr);
 
@@ -54,7 +68,7 @@ namespace Ice2D
 
         // Convert the image to a Direct2D-compatible pixel format
         IWICFormatConverter* pConverter = nullptr;
-        hr = m_pManager->GetWICFactory()->CreateFormatConverter(&pConverter);
+        hr = pFactory->CreateFormatConverter(&pConverter);
         CheckHR(hr);
 
         // Initialize the format converter
@@ -67,12 +81,80 @@ namespace Ice2D
         return pConverter;
     }
 
-    D2DImage::D2DImage() : m_pBitmap(nullptr)
+    bool IBasicImage::DecodeFile(IWICImagingFactory* pFactory, const wchar_t* path,
+        unsigned int& width, unsigned int& height, std::vector<BYTE>& pixels,
+        const std::function<bool(float)>& onProgress)
+    {
+        // Doesn't touch the render target, so it can run on a loader thread
+        auto pSource = CreateSourceFromFile(pFactory, path);
+        HRESULT hr = pSource->GetSize(&width, &height);
+        if (FAILED(hr))
+        {
+            SafeRelease(pSource);
+            CheckHR(hr);
+        }
+
+        // Copy in bands, the converter decodes lazily so this reports real progress
+        const UINT stride = width * 4u;
+        const UINT band = 64u;
+        pixels.resize((size_t)stride * height);
+        for (UINT y = 0u; y < height; y += band)
+        {
+            UINT rows = height - y < band ? height - y : band;
+            WICRect rect = { 0, (INT)y, (INT)width, (INT)rows };
+            hr = pSource->CopyPixels(&rect, stride, stride * rows, pixels.data() + (size_t)stride * y);
+            if (FAILED(hr))
+            {
+                SafeRelease(pSource);
+                CheckHR(hr);
+            }
+            if (onProgress && !onProgress((float)(y + rows) / height))
+            {
+                SafeRelease(pSource);
+                return false;
+            }
+        }
+
+        SafeRelease(pSource);
+        return true;
+    }
+
+    ID2D1Bitmap* IBasicImage::GetBitmapFromFile(const wchar_t* path)
+    {
+        // Identical files are only decoded once while they stay in the manager's cache
+        AssetCache& cache = m_pManager->GetAssetCache();
+        ID2D1Bitmap* pBitmap = cache.FindBitmap(path);
+        if (pBitmap) return pBitmap;
+
+        auto pSource = GetSourceFromFile(path);
+        D2D1_BITMAP_PROPERTIES bitmapProperties = {};
+        bitmapProperties.pixelFormat = { DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED };
+        HRESULT hr = m_pManager->GetRenderTarget()->CreateBitmapFromWicBitmap(pSource, &bitmapProperties, &pBitmap);
+        SafeRelease(pSource);
+        CheckHR(hr);
+
+        cache.InsertBitmap(path, pBitmap);
+        return pBitmap;
+    }
+
+    ID2D1Bitmap* IBasicImage::GetBitmapFromMemory(unsigned int width, unsigned int height,
+        const void* pPixels, unsigned int stride)
+    {
+        // Pixels are premultiplied 32bpp BGRA
+        ID2D1Bitmap* pBitmap = nullptr;
+        D2D1_PIXEL_FORMAT pixelFormat = D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+        HRESULT hr = m_pManager->GetRenderTarget()->CreateBitmap(D2D1::SizeU(width, height), pPixels, stride,
+            D2D1::BitmapProperties(pixelFormat), &pBitmap);
+        CheckHR(hr);
+        return pBitmap;
+    }
+
+    D2DImage::D2DImage() : m_pBitmap(nullptr), m_isShared(false), m_sourceId(0ull), m_sourceVersion(0ull)
     {
     }
 
     D2DImage::D2DImage(ResourceManager* pManager, unsigned int width, unsigned int height) :
-        IBasicImage(pManager, width, height)
+        IBasicImage(pManager, width, height), m_isShared(false), m_sourceId(0ull), m_sourceVersion(0ull)
     {
         D2D1_PIXEL_FORMAT pixelFormat =
             D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
@@ -83,15 +165,11 @@ namespace Ice2D
     }
 
     D2DImage::D2DImage(ResourceManager* pManager, const wchar_t* path) :
-        IBasicImage(pManager)
+        IBasicImage(pManager), m_sourceId(0ull), m_sourceVersion(0ull)
     {
-        // Create Direct2D bitmap from the converted WIC image
-        auto pSource = GetSourceFromFile(path);
-        D2D1_BITMAP_PROPERTIES bitmapProperties = {};
-        bitmapProperties.pixelFormat = { DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED };
-        HRESULT hr = m_pManager->GetRenderTarget()->CreateBitmapFromWicBitmap(pSource, &bitmapProperties, &m_pBitmap);
-        CheckHR(hr);
-        SafeRelease(pSource);
+        // The bitmap may be shared with other images loaded from the same file
+        m_pBitmap = GetBitmapFromFile(path);
+        m_isShared = m_pManager->GetAssetCache().IsEnabled();
 
         // Get size
         auto size = m_pBitmap->GetPixelSize();
@@ -101,8 +179,31 @@ namespace Ice2D
         OnLoad();
     }
 
+    D2DImage::D2DImage(ResourceManager* pManager, unsigned int width, unsigned int height,
+        const void* pPixels, unsigned int stride) :
+        IBasicImage(pManager, width, height), m_isShared(false), m_sourceId(0ull), m_sourceVersion(0ull)
+    {
+        // Pixels are premultiplied 32bpp BGRA, the format DecodeFile produces
+        D2D1_PIXEL_FORMAT pixelFormat = D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+        HRESULT hr = m_pManager->GetRenderTarget()->CreateBitmap(D2D1::SizeU(width, height), pPixels, stride,
+            D2D1::BitmapProperties(pixelFormat), &m_pBitmap);
+        CheckHR(hr);
+        OnLoad();
+    }
+
+    D2DImage::D2DImage(ResourceManager* pManager, const AssetPack& pack, const char* name) :
+        IBasicImage(pManager), m_isShared(false), m_sourceId(0ull), m_sourceVersion(0ull)
+    {
+        // Uploaded straight from the pack's mapping, the pixels were converted when the pack was baked
+        AssetPack::ImageData image = pack.GetImage(name);
+        m_pBitmap = GetBitmapFromMemory(image.width, image.height, image.pPixels, image.stride);
+        m_width = image.width;
+        m_height = image.height;
+        OnLoad();
+    }
+
     D2DImage::D2DImage(const RawImage& other) :
-        IBasicImage(other)
+        IBasicImage(other), m_isShared(false), m_sourceId(0ull), m_sourceVersion(0ull)
     {
         D2D1_BITMAP_PROPERTIES bitmapProperties = {};
         bitmapProperties.pixelFormat = { DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED };
@@ -113,10 +214,12 @@ namespace Ice2D
         OnLoad();
     }
 
-    D2DImage::D2DImage(D2DImage&& other) noexcept : IBasicImage(other), m_pBitmap(other.m_pBitmap)
+    D2DImage::D2DImage(D2DImage&& other) noexcept : IBasicImage(other), m_pBitmap(other.m_pBitmap),
+        m_isShared(other.m_isShared), m_sourceId(other.m_sourceId), m_sourceVersion(other.m_sourceVersion)
     {
         other.m_pBitmap = nullptr;
-        OnLoad();
+        other.m_isShared = false;
+        OnMove(other);
     }
 
     D2DImage& D2DImage::operator=(D2DImage&& other) noexcept
@@ -126,11 +229,15 @@ namespace Ice2D
         Release();
         m_pBitmap = other.m_pBitmap;
         other.m_pBitmap = nullptr;
+        m_isShared = other.m_isShared;
+        other.m_isShared = false;
+        m_sourceId = other.m_sourceId;
+        m_sourceVersion = other.m_sourceVersion;
 
         m_width = other.m_width;
         m_height = other.m_height;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -142,6 +249,7 @@ namespace Ice2D
     void D2DImage::Release()
     {
         SafeRelease(m_pBitmap);
+        m_isShared = false;
         OnUnload();
     }
 
@@ -158,11 +266,49 @@ namespace Ice2D
             throw std::runtime_error("Image dimensions do not match in copy.");
         }
 
+        // Only the dirty rects are needed if this image got the previous upload of the same raw image. Once the
+        // raw image has a render target, a kept pointer can draw at any time without marking anything.
+        bool partial = !m_isShared && m_sourceId == other.m_id && m_sourceVersion == other.m_version &&
+            !other.m_pRT && !other.m_dirty.IsFull();
+
+        // Copy on write, a cached bitmap is shared with every image loaded from the same file
+        if (m_isShared)
+        {
+            ID2D1Bitmap* pBitmap = nullptr;
+            D2D1_PIXEL_FORMAT pixelFormat =
+                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+            HRESULT hr = m_pManager->GetRenderTarget()->CreateBitmap(D2D1::SizeU(m_width, m_height),
+                D2D1::BitmapProperties(pixelFormat), &pBitmap);
+            CheckHR(hr);
+            SafeRelease(m_pBitmap);
+            m_pBitmap = pBitmap;
+            m_isShared = false;
+        }
+
         bool wasLocked = other.IsLocked();
         other.Lock();
-        HRESULT hr = m_pBitmap->CopyFromMemory(nullptr, other.m_pData, other.m_stride);
-        CheckHR(hr);
+        if (partial)
+        {
+            for (const DirtyRegion::Rect& rect : other.m_dirty.GetRects())
+            {
+                D2D1_RECT_U dest = D2D1::RectU(rect.left, rect.top, rect.right, rect.bottom);
+                const BYTE* pSource = reinterpret_cast<const BYTE*>(other.m_pData) + rect.top * other.m_stride +
+                    rect.left * sizeof(RawImage::PixelColor);
+                HRESULT hr = m_pBitmap->CopyFromMemory(&dest, pSource, other.m_stride);
+                CheckHR(hr);
+            }
+        }
+        else
+        {
+            HRESULT hr = m_pBitmap->CopyFromMemory(nullptr, other.m_pData, other.m_stride);
+            CheckHR(hr);
+        }
         if (!wasLocked) other.Unlock();
+
+        other.m_dirty.RecordUpload(sizeof(RawImage::PixelColor), !partial);
+        other.m_dirty.Clear();
+        m_sourceId = other.m_id;
+        m_sourceVersion = ++other.m_version;
     }
 
     ID2D1Bitmap* D2DImage::Get() const
@@ -171,44 +317,78 @@ namespace Ice2D
         return m_pBitmap;
     }
 
+    bool D2DImage::IsShared() const
+    {
+        return m_isShared;
+    }
+
     RawImage::RawImage() : m_pBitmap(nullptr), m_pLock(nullptr), m_pData(nullptr), m_stride(0u), m_bufferSize(0u),
-		m_pRT(nullptr)
+		m_pRT(nullptr), m_id(0ull), m_version(0ull)
     {
     }
 
     RawImage::RawImage(ResourceManager* pManager, unsigned int width, unsigned int height) :
         IBasicImage(pManager, width, height), m_pLock(nullptr), m_pData(nullptr), m_stride(0u), m_bufferSize(0u),
-        m_pRT(nullptr)
+        m_pRT(nullptr), m_id(NextRawImageId()), m_version(0ull)
     {
         HRESULT hr = pManager->GetWICFactory()->CreateBitmap(width, height, GUID_WICPixelFormat32bppPBGRA,
             WICBitmapCacheOnDemand, &m_pBitmap);
         CheckHR(hr);
+        m_dirty.SetBounds(m_width, m_height);
         OnLoad();
     }
 
     RawImage::RawImage(ResourceManager* pManager, const wchar_t* path) :
         IBasicImage(pManager), m_pLock(nullptr), m_pData(nullptr), m_stride(0u), m_bufferSize(0u),
-        m_pRT(nullptr)
+        m_pRT(nullptr), m_id(NextRawImageId()), m_version(0ull)
     {
-        // Copy from source into bitmap
-        auto pSource = GetSourceFromFile(path);
-        HRESULT hr = m_pManager->GetWICFactory()->CreateBitmapFromSource(pSource, WICBitmapCacheOnLoad, &m_pBitmap);
+        // Raw images are writable, so only the decoded pixels are cached and every image gets its own copy
+        AssetCache& cache = m_pManager->GetAssetCache();
+        IWICBitmap* pDecoded = cache.FindWICBitmap(path);
+        if (!pDecoded)
+        {
+            auto pSource = GetSourceFromFile(path);
+            HRESULT hr = m_pManager->GetWICFactory()->CreateBitmapFromSource(pSource, WICBitmapCacheOnLoad, &pDecoded);
+            SafeRelease(pSource);
+            CheckHR(hr);
+            cache.InsertWICBitmap(path, pDecoded);
+        }
+
+        HRESULT hr = m_pManager->GetWICFactory()->CreateBitmapFromSource(pDecoded, WICBitmapCacheOnLoad, &m_pBitmap);
+        SafeRelease(pDecoded);
         CheckHR(hr);
-        SafeRelease(pSource);
 
         // Get size
         hr = m_pBitmap->GetSize(&m_width, &m_height);
         CheckHR(hr);
+        m_dirty.SetBounds(m_width, m_height);
+        OnLoad();
+    }
+
+    RawImage::RawImage(ResourceManager* pManager, const AssetPack& pack, const char* name) :
+        IBasicImage(pManager), m_pLock(nullptr), m_pData(nullptr), m_stride(0u), m_bufferSize(0u),
+        m_pRT(nullptr), m_id(NextRawImageId()), m_version(0ull)
+    {
+        // Raw images are writable, so this is the one copy out of the pack
+        AssetPack::ImageData image = pack.GetImage(name);
+        HRESULT hr = pManager->GetWICFactory()->CreateBitmapFromMemory(image.width, image.height,
+            GUID_WICPixelFormat32bppPBGRA, image.stride, image.stride * image.height,
+            static_cast<BYTE*>(const_cast<void*>(image.pPixels)), &m_pBitmap);
+        CheckHR(hr);
+        m_width = image.width;
+        m_height = image.height;
+        m_dirty.SetBounds(m_width, m_height);
         OnLoad();
     }
 
     RawImage::RawImage(RawImage&& other) noexcept : IBasicImage(other), m_pBitmap(other.m_pBitmap),
-		m_pLock(nullptr), m_pData(nullptr), m_stride(0u), m_bufferSize(0u), m_pRT(other.m_pRT)
+		m_pLock(nullptr), m_pData(nullptr), m_stride(0u), m_bufferSize(0u), m_pRT(other.m_pRT),
+        m_dirty(other.m_dirty), m_id(other.m_id), m_version(other.m_version)
     {
         other.Unlock();
         other.m_pBitmap = nullptr;
         other.m_pRT = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     RawImage& RawImage::operator=(RawImage&& other) noexcept
@@ -221,11 +401,14 @@ namespace Ice2D
         other.m_pRT = nullptr;
         m_pBitmap = other.m_pBitmap;
         other.m_pBitmap = nullptr;
+        m_dirty = other.m_dirty;
+        m_id = other.m_id;
+        m_version = other.m_version;
 
         m_width = other.m_width;
         m_height = other.m_height;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -255,6 +438,7 @@ namespace Ice2D
             throw std::runtime_error("Image dimensions do not match in copy.");
         }
 
+        m_dirty.AddAll();
         bool wasLocked = IsLocked();
         Lock();
         HRESULT hr = other.m_pBitmap->CopyPixels(NULL, m_stride, m_bufferSize, 
@@ -325,6 +509,7 @@ namespace Ice2D
             BYTE* rowStart = reinterpret_cast<BYTE*>(m_pData) + y * m_stride;
 
             reinterpret_cast<PixelColor*>(rowStart)[x] = c;
+            m_dirty.Add(x, y, 1u, 1u);
         }
     }
 
@@ -333,6 +518,7 @@ namespace Ice2D
     {
         if (!m_pBitmap) throw std::runtime_error("WIC bitmap is null.");
         if (!IsLocked()) throw std::runtime_error("Raw image is not locked");
+        m_dirty.AddAll();
 
         for (unsigned int y = 0; y < m_height; ++y)
         {
@@ -349,6 +535,7 @@ namespace Ice2D
     {
         if (!m_pBitmap) throw std::runtime_error("WIC bitmap is null.");
         if (!IsLocked()) throw std::runtime_error("Raw image is not locked");
+        m_dirty.AddAll();
 
         for (unsigned int y = 0; y < m_height; ++y)
         {
@@ -364,6 +551,8 @@ namespace Ice2D
     ID2D1RenderTarget* RawImage::GetRenderTarget()
     {
 		if (!m_pBitmap) throw std::runtime_error("WIC bitmap is null.");
+        // Drawing through the render target can't be tracked
+        m_dirty.AddAll();
         if (!m_pRT)
         {
 			HRESULT hr = m_pManager->GetD2DFactory()->CreateWicBitmapRenderTarget(
@@ -378,19 +567,151 @@ namespace Ice2D
 		return m_pRT;
     }
 
+    SoftwareCanvas RawImage::GetCanvas(ThreadPool* pPool)
+    {
+        // The canvas can draw anywhere, so the whole image is uploaded next time
+        CheckLocked();
+        m_dirty.AddAll();
+        return SoftwareCanvas(reinterpret_cast<UINT32*>(m_pData), m_width, m_height, m_stride, pPool);
+    }
+
     void RawImage::SetAll(const PixelColor& c)
     {
-		if (!m_pBitmap) throw std::runtime_error("WIC bitmap is null.");
-		if (!IsLocked()) throw std::runtime_error("Raw image is not locked");
-        for (unsigned int y = 0; y < m_height; ++y)
-        {
-            BYTE* rowStart = reinterpret_cast<BYTE*>(m_pData) + y * m_stride;
+        CheckLocked();
+        m_dirty.AddAll();
+        PixelKernels::Fill(reinterpret_cast<UINT32*>(m_pData), m_stride, m_width, m_height, c.data);
+    }
 
-            for (unsigned int x = 0; x < m_width; ++x)
-            {
-                reinterpret_cast<PixelColor*>(rowStart)[x] = c;
-            }
-        }
+    void RawImage::FillRect(int x, int y, unsigned int width, unsigned int height, const PixelColor& c)
+    {
+        CheckLocked();
+        int right = x + (int)width, bottom = y + (int)height;
+        x = x < 0 ? 0 : x;
+        y = y < 0 ? 0 : y;
+        right = right > (int)m_width ? (int)m_width : right;
+        bottom = bottom > (int)m_height ? (int)m_height : bottom;
+        if (right <= x || bottom <= y) return;
+
+        m_dirty.Add(x, y, right - x, bottom - y);
+        BYTE* pStart = reinterpret_cast<BYTE*>(m_pData) + y * m_stride + x * sizeof(PixelColor);
+        PixelKernels::Fill(reinterpret_cast<UINT32*>(pStart), m_stride, right - x, bottom - y, c.data);
+    }
+
+    void RawImage::Blit(const RawImage& source, int x, int y)
+    {
+        CheckLocked();
+        source.CheckLocked();
+        unsigned int srcX, srcY, width, height;
+        if (!Clip(source, x, y, srcX, srcY, width, height)) return;
+
+        m_dirty.Add(x, y, width, height);
+        BYTE* pDst = reinterpret_cast<BYTE*>(m_pData) + y * m_stride + x * sizeof(PixelColor);
+        const BYTE* pSrc = reinterpret_cast<const BYTE*>(source.m_pData) + srcY * source.m_stride +
+            srcX * sizeof(PixelColor);
+        PixelKernels::CopyRect(reinterpret_cast<UINT32*>(pDst), m_stride,
+            reinterpret_cast<const UINT32*>(pSrc), source.m_stride, width, height);
+    }
+
+    void RawImage::Blend(const RawImage& source, int x, int y)
+    {
+        CheckLocked();
+        source.CheckLocked();
+        unsigned int srcX, srcY, width, height;
+        if (!Clip(source, x, y, srcX, srcY, width, height)) return;
+
+        m_dirty.Add(x, y, width, height);
+        BYTE* pDst = reinterpret_cast<BYTE*>(m_pData) + y * m_stride + x * sizeof(PixelColor);
+        const BYTE* pSrc = reinterpret_cast<const BYTE*>(source.m_pData) + srcY * source.m_stride +
+            srcX * sizeof(PixelColor);
+        PixelKernels::Blend(reinterpret_cast<UINT32*>(pDst), m_stride,
+            reinterpret_cast<const UINT32*>(pSrc), source.m_stride, width, height);
+    }
+
+    void RawImage::Premultiply()
+    {
+        CheckLocked();
+        m_dirty.AddAll();
+        PixelKernels::Premultiply(reinterpret_cast<UINT32*>(m_pData), m_stride, m_width, m_height);
+    }
+
+    void RawImage::Unpremultiply()
+    {
+        CheckLocked();
+        m_dirty.AddAll();
+        PixelKernels::Unpremultiply(reinterpret_cast<UINT32*>(m_pData), m_stride, m_width, m_height);
+    }
+
+    void RawImage::Tint(const PixelColor& c)
+    {
+        CheckLocked();
+        m_dirty.AddAll();
+        PixelKernels::Tint(reinterpret_cast<UINT32*>(m_pData), m_stride, m_width, m_height, c.data);
+    }
+
+    void RawImage::Grayscale()
+    {
+        CheckLocked();
+        m_dirty.AddAll();
+        PixelKernels::Grayscale(reinterpret_cast<UINT32*>(m_pData), m_stride, m_width, m_height);
+    }
+
+    void RawImage::Swizzle(const unsigned char order[4])
+    {
+        CheckLocked();
+        m_dirty.AddAll();
+        PixelKernels::Swizzle(reinterpret_cast<UINT32*>(m_pData), m_stride, m_width, m_height, order);
+    }
+
+    void RawImage::MarkDirty()
+    {
+        m_dirty.AddAll();
+    }
+
+    void RawImage::MarkDirty(unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+    {
+        m_dirty.Add(x, y, width, height);
+    }
+
+    const DirtyRegion& RawImage::GetDirtyRegion() const
+    {
+        return m_dirty;
+    }
+
+    const DirtyRegion::Stats& RawImage::GetUploadStats() const
+    {
+        return m_dirty.GetStats();
+    }
+
+    void RawImage::SetMaxDirtyRects(unsigned int count)
+    {
+        m_dirty.SetMaxRects(count);
+    }
+
+    void RawImage::CheckLocked() const
+    {
+        if (!m_pBitmap) throw std::runtime_error("WIC bitmap is null.");
+        if (!IsLocked()) throw std::runtime_error("Raw image is not locked");
+    }
+
+    bool RawImage::Clip(const RawImage& source, int& x, int& y, unsigned int& srcX, unsigned int& srcY,
+        unsigned int& width, unsigned int& height) const
+    {
+        // Clip the source rectangle placed at (x, y) against this image
+        int left = x < 0 ? -x : 0;
+        int top = y < 0 ? -y : 0;
+        int right = (int)source.m_width;
+        int bottom = (int)source.m_height;
+        if (x + right > (int)m_width) right = (int)m_width - x;
+        if (y + bottom > (int)m_height) bottom = (int)m_height - y;
+        if (right <= left || bottom <= top) return false;
+
+        srcX = left;
+        srcY = top;
+        width = right - left;
+        height = bottom - top;
+        x += left;
+        y += top;
+        return true;
     }
 
     RawImage::PixelColor::PixelColor() : data(0xFF000000)
@@ -454,12 +775,12 @@ namespace Ice2D
     {
         data = (data & ~(0xFF << 24)) | (a << 24);
     }
-	ImageRenderTarget::ImageRenderTarget() : m_pRT(nullptr)
+	ImageRenderTarget::ImageRenderTarget() : m_pRT(nullptr), m_pBitmap(nullptr)
 	{
 	}
     
     ImageRenderTarget::ImageRenderTarget(ResourceManager* pManager, unsigned int width, unsigned int height) :
-		IBasicImage(pManager, width, height), m_pRT(nullptr)
+		IBasicImage(pManager, width, height), m_pRT(nullptr), m_pBitmap(nullptr)
 	{
 		HRESULT hr = pManager->GetRenderTarget()->CreateCompatibleRenderTarget(D2D1::SizeF(width, height),
 			&m_pRT);
@@ -468,10 +789,12 @@ namespace Ice2D
 		OnLoad();
 	}
 
-	ImageRenderTarget::ImageRenderTarget(ImageRenderTarget&& other) noexcept : IBasicImage(other), m_pRT(other.m_pRT)
+	ImageRenderTarget::ImageRenderTarget(ImageRenderTarget&& other) noexcept : IBasicImage(other), m_pRT(other.m_pRT),
+		m_pBitmap(other.m_pBitmap)
 	{
 		other.m_pRT = nullptr;
-		OnLoad();
+		other.m_pBitmap = nullptr;
+		OnMove(other);
 	}
 
     ImageRenderTarget& ImageRenderTarget::operator=(ImageRenderTarget&& other) noexcept
@@ -480,12 +803,14 @@ namespace Ice2D
 		m_pManager = other.m_pManager;
 		Release();
 		m_pRT = other.m_pRT;
+		m_pBitmap = other.m_pBitmap;
 		other.m_pRT = nullptr;
+		other.m_pBitmap = nullptr;
 
 		m_width = other.m_width;
 		m_height = other.m_height;
 
-		OnLoad();
+		OnMove(other);
 		return *this;
     }
 
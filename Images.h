@@ -1,15 +1,24 @@
 #pragma once
 #include "ResourceManager.h"
+#include "ThreadPool.h"
+#include "DirtyRegion.h"
+#include "SoftwareCanvas.h"
 #include <d2d1.h>
 #include <chrono>
+#include <functional>
+#include <vector>
 
 namespace Ice2D
 {
+	class AssetPack;
 	class IBasicImage : protected IBasicResource
 	{
 	public:
 		unsigned int GetWidth() const;
 		unsigned int GetHeight() const;
+		static bool DecodeFile(IWICImagingFactory* pFactory, const wchar_t* path,
+			unsigned int& width, unsigned int& height, std::vector<BYTE>& pixels,
+			const std::function<bool(float)>& onProgress = nullptr);
 	protected:
 		IBasicImage();
 		IBasicImage(ResourceManager* pManager, unsigned int width, unsigned int height);
@@ -18,6 +27,9 @@ namespace Ice2D
 		IBasicImage& operator=(const IBasicImage& other) = delete;
 		~IBasicImage();
 		IWICBitmapSource* GetSourceFromFile(const wchar_t* path);
+		static IWICBitmapSource* CreateSourceFromFile(IWICImagingFactory* pFactory, const wchar_t* path);
+		ID2D1Bitmap* GetBitmapFromFile(const wchar_t* path);
+		ID2D1Bitmap* GetBitmapFromMemory(unsigned int width, unsigned int height, const void* pPixels, unsigned int stride);
 		unsigned int m_width, m_height;
 	};
 
@@ -28,6 +40,9 @@ namespace Ice2D
 		D2DImage();
 		D2DImage(ResourceManager* pManager, unsigned int width, unsigned int height);
 		D2DImage(ResourceManager* pManager, const wchar_t* path);
+		D2DImage(ResourceManager* pManager, unsigned int width, unsigned int height,
+			const void* pPixels, unsigned int stride);
+		D2DImage(ResourceManager* pManager, const AssetPack& pack, const char* name);
 		D2DImage(const RawImage& other);
 		D2DImage(const D2DImage& other) = delete;
 		D2DImage& operator=(const D2DImage& other) = delete;
@@ -37,8 +52,11 @@ namespace Ice2D
 		void Release() override;
 		void CopyRaw(RawImage& other);
 		ID2D1Bitmap* Get() const;
+		bool IsShared() const;
 	private:
 		ID2D1Bitmap* m_pBitmap;
+		bool m_isShared;
+		unsigned long long m_sourceId, m_sourceVersion;
 	};
 
 	class RawImage : public IBasicImage
@@ -48,6 +66,7 @@ namespace Ice2D
 		RawImage();
 		RawImage(ResourceManager* pManager, unsigned int width, unsigned int height);
 		RawImage(ResourceManager* pManager, const wchar_t* path);
+		RawImage(ResourceManager* pManager, const AssetPack& pack, const char* name);
 		RawImage(const RawImage& other) = delete;
 		RawImage& operator=(const RawImage& other) = delete;
 		RawImage(RawImage&& other) noexcept;
@@ -79,8 +98,26 @@ namespace Ice2D
 		void ForEach(void (*process)(unsigned int x, unsigned int y, PixelColor& c, 
 			void* pExtra, unsigned int extraSize), void* pExtra, unsigned int extraSize);
 		void ForEach(void (*process)(unsigned int x, unsigned int y, PixelColor& c));
+		template <typename F> void ForEach(F&& process);
+		template <typename F> void ForEachRow(F&& process);
+		template <typename F> void ParallelForEach(F&& process, ThreadPool& pool = ThreadPool::GetShared());
+		template <typename F> void ParallelForEachRow(F&& process, ThreadPool& pool = ThreadPool::GetShared());
 		ID2D1RenderTarget* GetRenderTarget();
+		SoftwareCanvas GetCanvas(ThreadPool* pPool = &ThreadPool::GetShared());
 		void SetAll(const PixelColor& c);
+		void FillRect(int x, int y, unsigned int width, unsigned int height, const PixelColor& c);
+		void Blit(const RawImage& source, int x, int y);
+		void Blend(const RawImage& source, int x, int y);
+		void Premultiply();
+		void Unpremultiply();
+		void Tint(const PixelColor& c);
+		void Grayscale();
+		void Swizzle(const unsigned char order[4]);
+		void MarkDirty();
+		void MarkDirty(unsigned int x, unsigned int y, unsigned int width, unsigned int height);
+		const DirtyRegion& GetDirtyRegion() const;
+		const DirtyRegion::Stats& GetUploadStats() const;
+		void SetMaxDirtyRects(unsigned int count);
 	private:
 		IWICBitmap* m_pBitmap;
 		IWICBitmapLock* m_pLock;
@@ -88,8 +125,59 @@ namespace Ice2D
 		unsigned int m_bufferSize;
 		unsigned int m_stride;
 		ID2D1RenderTarget* m_pRT;
+		DirtyRegion m_dirty;
+		unsigned long long m_id, m_version;
+		void CheckLocked() const;
+		PixelColor* Row(unsigned int y) const;
+		bool Clip(const RawImage& source, int& x, int& y, unsigned int& srcX, unsigned int& srcY,
+			unsigned int& width, unsigned int& height) const;
 	};
 
+	inline RawImage::PixelColor* RawImage::Row(unsigned int y) const
+	{
+		return reinterpret_cast<PixelColor*>(reinterpret_cast<BYTE*>(m_pData) + y * m_stride);
+	}
+
+	// process(x, y, PixelColor& c), any callable, so the body can be inlined
+	template <typename F>
+	void RawImage::ForEach(F&& process)
+	{
+		ForEachRow([&process](unsigned int y, PixelColor* pRow, unsigned int width)
+		{
+			for (unsigned int x = 0; x < width; ++x) process(x, y, pRow[x]);
+		});
+	}
+
+	// process(y, PixelColor* pRow, width)
+	template <typename F>
+	void RawImage::ForEachRow(F&& process)
+	{
+		CheckLocked();
+		m_dirty.AddAll();
+		for (unsigned int y = 0; y < m_height; ++y) process(y, Row(y), m_width);
+	}
+
+	// Rows are split into fixed bands, process must only write the pixel or row it is given
+	template <typename F>
+	void RawImage::ParallelForEach(F&& process, ThreadPool& pool)
+	{
+		ParallelForEachRow([&process](unsigned int y, PixelColor* pRow, unsigned int width)
+		{
+			for (unsigned int x = 0; x < width; ++x) process(x, y, pRow[x]);
+		}, pool);
+	}
+
+	template <typename F>
+	void RawImage::ParallelForEachRow(F&& process, ThreadPool& pool)
+	{
+		CheckLocked();
+		m_dirty.AddAll();
+		pool.ParallelFor(0u, m_height, [this, &process](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int y = begin; y < end; ++y) process(y, Row(y), m_width);
+		}, 16u);
+	}
+
 	class IBasicAnimation : public IBasicImage
 	{
 	public:
@@ -103,6 +191,8 @@ namespace Ice2D
 		bool IsPlaying();
 		void PlayOnce();
 		void SetFrameRate(unsigned int frameRate);
+		unsigned int GetFrameCount() const;
+		unsigned int GetCurrentFrame() const;
 		virtual ID2D1Bitmap* Get() = 0;
 	protected:
 		unsigned int m_frameCount, m_currentFrame;
@@ -128,6 +218,7 @@ namespace Ice2D
 		~ImageSequence();
 		void Release() override;
 		ID2D1Bitmap* Get() override;
+		ID2D1Bitmap* GetFrame(unsigned int index) const;
 	private:
 		ID2D1Bitmap** m_pFrames;
 	};
@@ -140,6 +231,7 @@ namespace Ice2D
 			unsigned int rows, unsigned int cols, unsigned int frameCount, unsigned int frameRate);
 		AnimationSheet(ResourceManager* pManager, const wchar_t* path,
 			unsigned int rows, unsigned int cols, unsigned int frameCount, unsigned int frameRate);
+		AnimationSheet(ResourceManager* pManager, const AssetPack& pack, const char* name);
 		AnimationSheet(const AnimationSheet& other) = delete;
 		AnimationSheet& operator=(const AnimationSheet& other) = delete;
 		AnimationSheet(AnimationSheet&& other) noexcept;
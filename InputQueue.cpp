@@ -0,0 +1,325 @@
+#include "pch.h"
+
+#include "InputQueue.h"
+
+namespace Ice2D
+{
+    // One notch of a standard wheel, WHEEL_DELTA on Windows
+    static const float WHEEL_NOTCH = 120.0f;
+
+    static int16_t Clamp16(int value)
+    {
+        return (int16_t)(value < -32768 ? -32768 : value > 32767 ? 32767 : value);
+    }
+
+    InputQueue::InputQueue(unsigned int capacity) : m_head(0u), m_count(0u), m_stats()
+    {
+        // Power of two, so the ring index is a mask
+        size_t size = 16u;
+        while (size < capacity) size *= 2u;
+        m_ring.resize(size);
+    }
+
+    void InputQueue::PushKey(uint8_t key, bool down, bool repeat, uint32_t time)
+    {
+        EventType type = !down ? EventType::KeyUp : repeat ? EventType::KeyRepeat : EventType::KeyDown;
+        Push({ time, type, key, 0, 0, 0 });
+    }
+
+    void InputQueue::PushButton(MouseButton button, bool down, int x, int y, uint32_t time)
+    {
+        Push({ time, down ? EventType::ButtonDown : EventType::ButtonUp, button, 0, Clamp16(x), Clamp16(y) });
+    }
+
+    void InputQueue::PushMove(int x, int y, uint32_t time)
+    {
+        Push({ time, EventType::MouseMove, 0u, 0, Clamp16(x), Clamp16(y) });
+    }
+
+    void InputQueue::PushWheel(int delta, bool horizontal, uint32_t time)
+    {
+        Push({ time, horizontal ? EventType::WheelX : EventType::Wheel, 0u, Clamp16(delta), 0, 0 });
+    }
+
+    void InputQueue::PushFocusLost(uint32_t time)
+    {
+        Push({ time, EventType::FocusLost, 0u, 0, 0, 0 });
+    }
+
+    void InputQueue::Push(const Event& e)
+    {
+        ++m_stats.pushed;
+
+        // A burst of moves only needs its last position, and wheel steps in a row add up
+        if (m_count > 0u)
+        {
+            Event& last = Back();
+            bool merge = e.type == last.type && (e.type == EventType::MouseMove ||
+                ((e.type == EventType::Wheel || e.type == EventType::WheelX) &&
+                    (int)last.delta + e.delta >= -32768 && (int)last.delta + e.delta <= 32767));
+            if (merge)
+            {
+                int16_t delta = (int16_t)(last.delta + e.delta);
+                last = e;
+                last.delta = delta;
+                ++m_stats.coalesced;
+                return;
+            }
+        }
+
+        // Key and button transitions are never dropped, a full ring doubles instead
+        if (m_count == m_ring.size()) Grow();
+        m_ring[(m_head + m_count) & (m_ring.size() - 1u)] = e;
+        ++m_count;
+    }
+
+    bool InputQueue::Pop(Event& e)
+    {
+        if (m_count == 0u) return false;
+        e = m_ring[m_head];
+        m_head = (m_head + 1u) & (m_ring.size() - 1u);
+        --m_count;
+        return true;
+    }
+
+    size_t InputQueue::Size() const
+    {
+        return m_count;
+    }
+
+    size_t InputQueue::GetCapacity() const
+    {
+        return m_ring.size();
+    }
+
+    void InputQueue::Clear()
+    {
+        m_head = 0u;
+        m_count = 0u;
+    }
+
+    const InputQueue::Stats& InputQueue::GetStats() const
+    {
+        return m_stats;
+    }
+
+    InputQueue::Event& InputQueue::Back()
+    {
+        return m_ring[(m_head + m_count - 1u) & (m_ring.size() - 1u)];
+    }
+
+    void InputQueue::Grow()
+    {
+        std::vector<Event> ring(m_ring.size() * 2u);
+        for (size_t i = 0u; i < m_count; ++i) ring[i] = m_ring[(m_head + i) & (m_ring.size() - 1u)];
+        m_ring.swap(ring);
+        m_head = 0u;
+        ++m_stats.grown;
+    }
+
+    InputState::InputState() : m_buttons(0u), m_buttonsPressed(0u), m_buttonsReleased(0u), m_mouseX(0), m_mouseY(0),
+        m_deltaX(0), m_deltaY(0), m_wheel(0), m_wheelX(0)
+    {
+        Reset();
+    }
+
+    void InputState::Update(InputQueue& queue)
+    {
+        // The edges describe what happened since the last update, so a tap between two frames still shows up
+        ClearEdges();
+        m_events.clear();
+        InputQueue::Event e;
+        while (queue.Pop(e))
+        {
+            Apply(e);
+            m_events.push_back(e);
+        }
+    }
+
+    void InputState::ClearEdges()
+    {
+        for (unsigned int i = 0u; i < WORDS; ++i)
+        {
+            m_pressed[i] = 0u;
+            m_released[i] = 0u;
+            m_repeated[i] = 0u;
+        }
+        m_buttonsPressed = 0u;
+        m_buttonsReleased = 0u;
+        m_deltaX = 0;
+        m_deltaY = 0;
+        m_wheel = 0;
+        m_wheelX = 0;
+    }
+
+    void InputState::Reset()
+    {
+        ClearEdges();
+        for (uint64_t& word : m_down) word = 0u;
+        m_buttons = 0u;
+        m_events.clear();
+    }
+
+    bool InputState::IsKeyDown(uint8_t key) const
+    {
+        return Test(m_down, key);
+    }
+
+    bool InputState::WasKeyPressed(uint8_t key) const
+    {
+        return Test(m_pressed, key);
+    }
+
+    bool InputState::WasKeyReleased(uint8_t key) const
+    {
+        return Test(m_released, key);
+    }
+
+    bool InputState::WasKeyRepeated(uint8_t key) const
+    {
+        return Test(m_repeated, key);
+    }
+
+    bool InputState::AnyKeyPressed() const
+    {
+        return (m_pressed[0] | m_pressed[1] | m_pressed[2] | m_pressed[3]) != 0u;
+    }
+
+    unsigned int InputState::GetPressedKeys(uint8_t* pKeys, unsigned int maxKeys) const
+    {
+        // Walks the set bits only, most frames have none
+        unsigned int count = 0u;
+        for (unsigned int i = 0u; i < WORDS; ++i)
+        {
+            for (uint64_t bits = m_pressed[i]; bits != 0u && count < maxKeys; bits &= bits - 1u)
+            {
+                unsigned int bit = 0u;
+                while (!((bits >> bit) & 1u)) ++bit;
+                pKeys[count++] = (uint8_t)(i * 64u + bit);
+            }
+        }
+        return count;
+    }
+
+    bool InputState::IsButtonDown(InputQueue::MouseButton button) const
+    {
+        return (m_buttons >> button) & 1u;
+    }
+
+    bool InputState::WasButtonPressed(InputQueue::MouseButton button) const
+    {
+        return (m_buttonsPressed >> button) & 1u;
+    }
+
+    bool InputState::WasButtonReleased(InputQueue::MouseButton button) const
+    {
+        return (m_buttonsReleased >> button) & 1u;
+    }
+
+    int InputState::GetMouseX() const
+    {
+        return m_mouseX;
+    }
+
+    int InputState::GetMouseY() const
+    {
+        return m_mouseY;
+    }
+
+    int InputState::GetMouseDeltaX() const
+    {
+        return m_deltaX;
+    }
+
+    int InputState::GetMouseDeltaY() const
+    {
+        return m_deltaY;
+    }
+
+    float InputState::GetWheel() const
+    {
+        return m_wheel / WHEEL_NOTCH;
+    }
+
+    float InputState::GetWheelX() const
+    {
+        return m_wheelX / WHEEL_NOTCH;
+    }
+
+    const std::vector<InputQueue::Event>& InputState::GetEvents() const
+    {
+        return m_events;
+    }
+
+    void InputState::Apply(const InputQueue::Event& e)
+    {
+        const uint64_t bit = 1ull << (e.code & 63u);
+        const unsigned int word = e.code >> 6;
+        switch (e.type)
+        {
+        case InputQueue::EventType::KeyDown:
+        case InputQueue::EventType::KeyRepeat:
+            // A repeat of a key that was never seen going down still counts as a press
+            if (m_down[word] & bit)
+            {
+                m_repeated[word] |= bit;
+                break;
+            }
+            m_down[word] |= bit;
+            m_pressed[word] |= bit;
+            break;
+        case InputQueue::EventType::KeyUp:
+            if (!(m_down[word] & bit)) break;
+            m_down[word] &= ~bit;
+            m_released[word] |= bit;
+            break;
+        case InputQueue::EventType::ButtonDown:
+        case InputQueue::EventType::ButtonUp:
+        {
+            const uint8_t mask = (uint8_t)(1u << (e.code & 7u));
+            bool down = e.type == InputQueue::EventType::ButtonDown;
+            if (((m_buttons & mask) != 0u) != down)
+            {
+                m_buttons ^= mask;
+                (down ? m_buttonsPressed : m_buttonsReleased) |= mask;
+            }
+
+            // Clicks carry the cursor position too
+            MoveTo(e.x, e.y);
+            break;
+        }
+        case InputQueue::EventType::MouseMove:
+            MoveTo(e.x, e.y);
+            break;
+        case InputQueue::EventType::Wheel:
+            m_wheel += e.delta;
+            break;
+        case InputQueue::EventType::WheelX:
+            m_wheelX += e.delta;
+            break;
+        case InputQueue::EventType::FocusLost:
+            // Key ups go to the window that has focus, so everything still held is released here
+            for (unsigned int i = 0u; i < WORDS; ++i)
+            {
+                m_released[i] |= m_down[i];
+                m_down[i] = 0u;
+            }
+            m_buttonsReleased |= m_buttons;
+            m_buttons = 0u;
+            break;
+        }
+    }
+
+    void InputState::MoveTo(int x, int y)
+    {
+        m_deltaX += x - m_mouseX;
+        m_deltaY += y - m_mouseY;
+        m_mouseX = x;
+        m_mouseY = y;
+    }
+
+    bool InputState::Test(const uint64_t* pBits, uint8_t key)
+    {
+        return (pBits[key >> 6] >> (key & 63u)) & 1u;
+    }
+}
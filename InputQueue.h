@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Ice2D
+{
+	class InputQueue
+	{
+	public:
+		enum class EventType : uint8_t
+		{
+			KeyDown, KeyUp, KeyRepeat, ButtonDown, ButtonUp, MouseMove, Wheel, WheelX, FocusLost
+		};
+		enum MouseButton : uint8_t { Left, Middle, Right, X1, X2 };
+		struct Event
+		{
+			uint32_t time;
+			EventType type;
+			uint8_t code;
+			int16_t delta;
+			int16_t x, y;
+		};
+		struct Stats
+		{
+			unsigned long long pushed, coalesced, grown;
+		};
+		InputQueue(unsigned int capacity = 256u);
+		void PushKey(uint8_t key, bool down, bool repeat, uint32_t time);
+		void PushButton(MouseButton button, bool down, int x, int y, uint32_t time);
+		void PushMove(int x, int y, uint32_t time);
+		void PushWheel(int delta, bool horizontal, uint32_t time);
+		void PushFocusLost(uint32_t time);
+		void Push(const Event& e);
+		bool Pop(Event& e);
+		size_t Size() const;
+		size_t GetCapacity() const;
+		void Clear();
+		const Stats& GetStats() const;
+	private:
+		std::vector<Event> m_ring;
+		size_t m_head, m_count;
+		Stats m_stats;
+		Event& Back();
+		void Grow();
+	};
+
+	class InputState
+	{
+	public:
+		InputState();
+		void Update(InputQueue& queue);
+		void ClearEdges();
+		void Reset();
+		bool IsKeyDown(uint8_t key) const;
+		bool WasKeyPressed(uint8_t key) const;
+		bool WasKeyReleased(uint8_t key) const;
+		bool WasKeyRepeated(uint8_t key) const;
+		bool AnyKeyPressed() const;
+		unsigned int GetPressedKeys(uint8_t* pKeys, unsigned int maxKeys) const;
+		bool IsButtonDown(InputQueue::MouseButton button) const;
+		bool WasButtonPressed(InputQueue::MouseButton button) const;
+		bool WasButtonReleased(InputQueue::MouseButton button) const;
+		int GetMouseX() const;
+		int GetMouseY() const;
+		int GetMouseDeltaX() const;
+		int GetMouseDeltaY() const;
+		float GetWheel() const;
+		float GetWheelX() const;
+		const std::vector<InputQueue::Event>& GetEvents() const;
+	private:
+		static const unsigned int WORDS = 4u;
+		uint64_t m_down[WORDS], m_pressed[WORDS], m_released[WORDS], m_repeated[WORDS];
+		uint8_t m_buttons, m_buttonsPressed, m_buttonsReleased;
+		int m_mouseX, m_mouseY, m_deltaX, m_deltaY, m_wheel, m_wheelX;
+		std::vector<InputQueue::Event> m_events;
+		void Apply(const InputQueue::Event& e);
+		void MoveTo(int x, int y);
+		static bool Test(const uint64_t* pBits, uint8_t key);
+	};
+}
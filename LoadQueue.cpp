@@ -0,0 +1,309 @@
+#include "pch.h"
+
+#include "LoadQueue.h"
+#include <algorithm>
+
+namespace Ice2D
+{
+    LoadTicket::LoadTicket() : m_status((int)Status::Queued), m_progress(0.0f), m_cancelled(false)
+    {
+    }
+
+    LoadTicket::Status LoadTicket::GetStatus() const
+    {
+        return (Status)m_status.load(std::memory_order_acquire);
+    }
+
+    float LoadTicket::GetProgress() const
+    {
+        return m_progress.load(std::memory_order_relaxed);
+    }
+
+    void LoadTicket::SetProgress(float progress)
+    {
+        m_progress.store(std::min(std::max(progress, 0.0f), 1.0f), std::memory_order_relaxed);
+    }
+
+    bool LoadTicket::IsDone() const
+    {
+        Status status = GetStatus();
+        return status == Status::Completed || status == Status::Cancelled || status == Status::Failed;
+    }
+
+    bool LoadTicket::IsCancelled() const
+    {
+        return m_cancelled.load(std::memory_order_relaxed);
+    }
+
+    void LoadTicket::Cancel()
+    {
+        m_cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    const std::string& LoadTicket::GetError() const
+    {
+        // Only written before the status becomes Failed
+        return m_error;
+    }
+
+    void LoadTicket::SetStatus(Status status)
+    {
+        m_status.store((int)status, std::memory_order_release);
+    }
+
+    void LoadTicket::Fail(const char* message)
+    {
+        m_error = message;
+        SetStatus(Status::Failed);
+    }
+
+    LoadQueue::LoadQueue() : LoadQueue(DefaultThreadCount())
+    {
+    }
+
+    LoadQueue::LoadQueue(unsigned int threadCount) : m_threadCount(threadCount), m_stopping(false)
+    {
+    }
+
+    LoadQueue::~LoadQueue()
+    {
+        Shutdown();
+    }
+
+    void LoadQueue::SetThreadCount(unsigned int count)
+    {
+        // Running jobs finish first, queued jobs are picked up by the new workers
+        StopWorkers();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threadCount = count;
+        if (!m_pending.empty()) StartWorkers();
+    }
+
+    unsigned int LoadQueue::GetThreadCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_threadCount;
+    }
+
+    void LoadQueue::SetThreadHooks(std::function<void()> onStart, std::function<void()> onExit)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_onThreadStart = std::move(onStart);
+        m_onThreadExit = std::move(onExit);
+    }
+
+    LoadHandle LoadQueue::Enqueue(Work work, Finish finish)
+    {
+        auto ticket = std::make_shared<LoadTicket>();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back({ ticket, std::move(work), std::move(finish) });
+            StartWorkers();
+        }
+        m_wake.notify_one();
+        return ticket;
+    }
+
+    unsigned int LoadQueue::Pump(std::chrono::microseconds budget)
+    {
+        return Drain(true, budget);
+    }
+
+    unsigned int LoadQueue::Pump()
+    {
+        return Drain(false, std::chrono::microseconds::zero());
+    }
+
+    size_t LoadQueue::GetPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pending.size() + m_running.size() + m_staged.size();
+    }
+
+    void LoadQueue::CancelAll()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Job& job : m_pending) job.ticket->Cancel();
+        for (Job& job : m_staged) job.ticket->Cancel();
+        for (LoadHandle& ticket : m_running) ticket->Cancel();
+    }
+
+    void LoadQueue::Shutdown()
+    {
+        CancelAll();
+        StopWorkers();
+
+        // Destroy the jobs outside the lock, their staging buffers can be large
+        std::deque<Job> pending, staged;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            pending.swap(m_pending);
+            staged.swap(m_staged);
+        }
+        for (Job& job : pending) job.ticket->SetStatus(LoadTicket::Status::Cancelled);
+        for (Job& job : staged) job.ticket->SetStatus(LoadTicket::Status::Cancelled);
+    }
+
+    unsigned int LoadQueue::DefaultThreadCount()
+    {
+        // Leave a core for the main thread, decoding is rarely worth more than a few threads
+        unsigned int cores = std::thread::hardware_concurrency();
+        if (cores <= 2u) return 1u;
+        return std::min(cores - 1u, 4u);
+    }
+
+    unsigned int LoadQueue::Drain(bool limited, std::chrono::microseconds budget)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        unsigned int completed = 0u;
+        while (true)
+        {
+            Job job;
+            bool staged;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_staged.empty())
+                {
+                    job = std::move(m_staged.front());
+                    m_staged.pop_front();
+                    staged = true;
+                }
+                else if (m_threadCount == 0u && !m_pending.empty())
+                {
+                    // Without workers the whole job runs here, which keeps tests deterministic
+                    job = std::move(m_pending.front());
+                    m_pending.pop_front();
+                    staged = false;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            if (!staged && !RunWork(job)) continue;
+            if (RunFinish(job)) ++completed;
+            if (limited && std::chrono::high_resolution_clock::now() - start >= budget) break;
+        }
+        return completed;
+    }
+
+    void LoadQueue::StartWorkers()
+    {
+        // Called with the mutex held
+        while (m_workers.size() < m_threadCount)
+        {
+            m_workers.emplace_back(&LoadQueue::WorkerLoop, this);
+        }
+    }
+
+    void LoadQueue::StopWorkers()
+    {
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            workers.swap(m_workers);
+        }
+        m_wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+    }
+
+    void LoadQueue::WorkerLoop()
+    {
+        std::function<void()> onStart, onExit;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            onStart = m_onThreadStart;
+            onExit = m_onThreadExit;
+        }
+        if (onStart) onStart();
+
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stopping || !m_pending.empty(); });
+                if (m_stopping) break;
+                job = std::move(m_pending.front());
+                m_pending.pop_front();
+                m_running.push_back(job.ticket);
+            }
+
+            bool staged = RunWork(job);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running.erase(std::find(m_running.begin(), m_running.end(), job.ticket));
+            if (staged) m_staged.push_back(std::move(job));
+        }
+
+        if (onExit) onExit();
+    }
+
+    bool LoadQueue::RunWork(Job& job)
+    {
+        LoadTicket& ticket = *job.ticket;
+        if (ticket.IsCancelled())
+        {
+            ticket.SetStatus(LoadTicket::Status::Cancelled);
+            return false;
+        }
+
+        ticket.SetStatus(LoadTicket::Status::Loading);
+        try
+        {
+            if (job.work) job.work(ticket);
+        }
+        catch (const std::exception& e)
+        {
+            ticket.Fail(e.what());
+            return false;
+        }
+        catch (...)
+        {
+            ticket.Fail("Unknown error.");
+            return false;
+        }
+
+        if (ticket.IsCancelled())
+        {
+            ticket.SetStatus(LoadTicket::Status::Cancelled);
+            return false;
+        }
+        ticket.SetStatus(LoadTicket::Status::Staged);
+        return true;
+    }
+
+    bool LoadQueue::RunFinish(Job& job)
+    {
+        LoadTicket& ticket = *job.ticket;
+        if (ticket.IsCancelled())
+        {
+            ticket.SetStatus(LoadTicket::Status::Cancelled);
+            return false;
+        }
+
+        try
+        {
+            if (job.finish) job.finish();
+        }
+        catch (const std::exception& e)
+        {
+            ticket.Fail(e.what());
+            return false;
+        }
+        catch (...)
+        {
+            ticket.Fail("Unknown error.");
+            return false;
+        }
+
+        ticket.SetProgress(1.0f);
+        ticket.SetStatus(LoadTicket::Status::Completed);
+        return true;
+    }
+}
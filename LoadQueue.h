@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Ice2D
+{
+	class LoadTicket
+	{
+		friend class LoadQueue;
+	public:
+		enum class Status { Queued, Loading, Staged, Completed, Cancelled, Failed };
+		LoadTicket();
+		LoadTicket(const LoadTicket& other) = delete;
+		LoadTicket& operator=(const LoadTicket& other) = delete;
+		Status GetStatus() const;
+		float GetProgress() const;
+		void SetProgress(float progress);
+		bool IsDone() const;
+		bool IsCancelled() const;
+		void Cancel();
+		const std::string& GetError() const;
+	private:
+		std::atomic<int> m_status;
+		std::atomic<float> m_progress;
+		std::atomic<bool> m_cancelled;
+		std::string m_error;
+		void SetStatus(Status status);
+		void Fail(const char* message);
+	};
+	typedef std::shared_ptr<LoadTicket> LoadHandle;
+
+	class LoadQueue
+	{
+	public:
+		typedef std::function<void(LoadTicket&)> Work;
+		typedef std::function<void()> Finish;
+		LoadQueue();
+		LoadQueue(unsigned int threadCount);
+		LoadQueue(const LoadQueue& other) = delete;
+		LoadQueue& operator=(const LoadQueue& other) = delete;
+		~LoadQueue();
+		void SetThreadCount(unsigned int count);
+		unsigned int GetThreadCount() const;
+		void SetThreadHooks(std::function<void()> onStart, std::function<void()> onExit);
+		LoadHandle Enqueue(Work work, Finish finish);
+		unsigned int Pump(std::chrono::microseconds budget);
+		unsigned int Pump();
+		size_t GetPendingCount() const;
+		void CancelAll();
+		void Shutdown();
+		static unsigned int DefaultThreadCount();
+	private:
+		struct Job
+		{
+			LoadHandle ticket;
+			Work work;
+			Finish finish;
+		};
+		mutable std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::deque<Job> m_pending, m_staged;
+		std::vector<std::thread> m_workers;
+		std::function<void()> m_onThreadStart, m_onThreadExit;
+		unsigned int m_threadCount;
+		std::vector<LoadHandle> m_running;
+		bool m_stopping;
+		unsigned int Drain(bool limited, std::chrono::microseconds budget);
+		void StartWorkers();
+		void StopWorkers();
+		void WorkerLoop();
+		static bool RunWork(Job& job);
+		static bool RunFinish(Job& job);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "pch.h"
+
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Ice2D
+{
+    MappedFile::MappedFile() : m_pData(nullptr), m_size(0u), m_hFile(nullptr), m_hMapping(nullptr)
+    {
+    }
+
+    MappedFile::MappedFile(const char* path) : MappedFile()
+    {
+        if (!path) throw std::runtime_error("File path is null.");
+        Map(nullptr, path);
+    }
+
+    MappedFile::MappedFile(const wchar_t* path) : MappedFile()
+    {
+        if (!path) throw std::runtime_error("File path is null.");
+        Map(path, nullptr);
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept : m_pData(other.m_pData), m_size(other.m_size),
+        m_hFile(other.m_hFile), m_hMapping(other.m_hMapping)
+    {
+        other.m_pData = nullptr;
+        other.m_size = 0u;
+        other.m_hFile = nullptr;
+        other.m_hMapping = nullptr;
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this == &other) return *this;
+        Close();
+        m_pData = other.m_pData;
+        m_size = other.m_size;
+        m_hFile = other.m_hFile;
+        m_hMapping = other.m_hMapping;
+        other.m_pData = nullptr;
+        other.m_size = 0u;
+        other.m_hFile = nullptr;
+        other.m_hMapping = nullptr;
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+#ifdef _WIN32
+    void MappedFile::Close()
+    {
+        if (m_pData) UnmapViewOfFile(m_pData);
+        if (m_hMapping) CloseHandle(m_hMapping);
+        if (m_hFile) CloseHandle(m_hFile);
+        m_pData = nullptr;
+        m_size = 0u;
+        m_hFile = nullptr;
+        m_hMapping = nullptr;
+    }
+
+    void MappedFile::Map(const wchar_t* widePath, const char* path)
+    {
+        std::wstring converted;
+        if (!widePath)
+        {
+            // Narrow paths are UTF-8
+            int length = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+            if (length <= 0) throw std::runtime_error("Invalid file path.");
+            std::vector<wchar_t> buffer((size_t)length);
+            MultiByteToWideChar(CP_UTF8, 0, path, -1, buffer.data(), length);
+            converted = buffer.data();
+            widePath = converted.c_str();
+        }
+
+        HANDLE hFile = CreateFileW(widePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open file for mapping.");
+        m_hFile = hFile;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(hFile, &size))
+        {
+            Close();
+            throw std::runtime_error("Failed to get file size.");
+        }
+        if (size.QuadPart == 0) return;
+        if ((unsigned long long)size.QuadPart > (size_t)-1)
+        {
+            Close();
+            throw std::runtime_error("File is too large to map.");
+        }
+
+        m_hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_hMapping)
+        {
+            Close();
+            throw std::runtime_error("Failed to create file mapping.");
+        }
+        m_pData = static_cast<const unsigned char*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_pData)
+        {
+            Close();
+            throw std::runtime_error("Failed to map file.");
+        }
+        m_size = (size_t)size.QuadPart;
+    }
+#else
+    void MappedFile::Close()
+    {
+        if (m_pData) munmap(const_cast<unsigned char*>(m_pData), m_size);
+        m_pData = nullptr;
+        m_size = 0u;
+        m_hFile = nullptr;
+        m_hMapping = nullptr;
+    }
+
+    void MappedFile::Map(const wchar_t* widePath, const char* path)
+    {
+        std::string converted;
+        if (!path)
+        {
+            size_t length = std::wcstombs(nullptr, widePath, 0);
+            if (length == (size_t)-1) throw std::runtime_error("Invalid file path.");
+            converted.resize(length);
+            std::wcstombs(&converted[0], widePath, length);
+            path = converted.c_str();
+        }
+
+        // The descriptor can be closed straight away, the mapping keeps the file alive
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Failed to open file for mapping.");
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("Failed to get file size.");
+        }
+        if (info.st_size > 0)
+        {
+            void* pData = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pData == MAP_FAILED)
+            {
+                close(fd);
+                throw std::runtime_error("Failed to map file.");
+            }
+            m_pData = static_cast<const unsigned char*>(pData);
+            m_size = (size_t)info.st_size;
+        }
+        close(fd);
+    }
+#endif
+
+    bool MappedFile::IsOpen() const
+    {
+        return m_pData != nullptr;
+    }
+
+    const unsigned char* MappedFile::GetData() const
+    {
+        return m_pData;
+    }
+
+    size_t MappedFile::GetSize() const
+    {
+        return m_size;
+    }
+}
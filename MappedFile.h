@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+
+namespace Ice2D
+{
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		MappedFile(const char* path);
+		MappedFile(const wchar_t* path);
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile();
+		void Close();
+		bool IsOpen() const;
+		const unsigned char* GetData() const;
+		size_t GetSize() const;
+	private:
+		const unsigned char* m_pData;
+		size_t m_size;
+		void* m_hFile;
+		void* m_hMapping;
+		void Map(const wchar_t* widePath, const char* path);
+	};
+}
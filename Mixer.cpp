@@ -0,0 +1,454 @@
+#include "pch.h"
+
+#include "Mixer.h"
+#include "WavParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ICE2D_MIXER_SSE 1
+#include <emmintrin.h>
+#else
+#define ICE2D_MIXER_SSE 0
+#endif
+
+namespace Ice2D
+{
+    static const uint64_t ONE = 1ull << 32;
+    static const uint64_t MAX_STEP = 16ull << 32;
+
+    // Adds a stereo block scaled by gains that ramp linearly across it, so gain and pan changes don't click
+    static void MixAdd(float* pDst, const float* pSrc, uint32_t frames, float left0, float right0,
+        float left1, float right1)
+    {
+        const float dl = (left1 - left0) / (float)frames, dr = (right1 - right0) / (float)frames;
+        uint32_t i = 0u;
+#if ICE2D_MIXER_SSE
+        __m128 gain0 = _mm_setr_ps(left0, right0, left0 + dl, right0 + dr);
+        __m128 gain1 = _mm_setr_ps(left0 + 2.0f * dl, right0 + 2.0f * dr, left0 + 3.0f * dl, right0 + 3.0f * dr);
+        const __m128 delta = _mm_setr_ps(4.0f * dl, 4.0f * dr, 4.0f * dl, 4.0f * dr);
+        for (; i + 4u <= frames; i += 4u)
+        {
+            float* pOut = pDst + i * 2u;
+            __m128 a = _mm_add_ps(_mm_loadu_ps(pOut), _mm_mul_ps(_mm_loadu_ps(pSrc + i * 2u), gain0));
+            __m128 b = _mm_add_ps(_mm_loadu_ps(pOut + 4), _mm_mul_ps(_mm_loadu_ps(pSrc + i * 2u + 4u), gain1));
+            _mm_storeu_ps(pOut, a);
+            _mm_storeu_ps(pOut + 4, b);
+            gain0 = _mm_add_ps(gain0, delta);
+            gain1 = _mm_add_ps(gain1, delta);
+        }
+#endif
+        for (; i < frames; ++i)
+        {
+            pDst[i * 2u] += pSrc[i * 2u] * (left0 + dl * (float)i);
+            pDst[i * 2u + 1u] += pSrc[i * 2u + 1u] * (right0 + dr * (float)i);
+        }
+    }
+
+    struct LoadU8
+    {
+        float operator()(const unsigned char* p) const { return ((int)p[0] - 128) * (1.0f / 128.0f); }
+    };
+
+    struct LoadS16
+    {
+        float operator()(const unsigned char* p) const
+        {
+            return (int16_t)(uint16_t)(p[0] | p[1] << 8) * (1.0f / 32768.0f);
+        }
+    };
+
+    struct LoadS24
+    {
+        float operator()(const unsigned char* p) const
+        {
+            int32_t value = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+            return value * (1.0f / 8388608.0f);
+        }
+    };
+
+    struct LoadS32
+    {
+        float operator()(const unsigned char* p) const
+        {
+            int32_t value;
+            memcpy(&value, p, sizeof(value));
+            return (float)value * (1.0f / 2147483648.0f);
+        }
+    };
+
+    struct LoadF32
+    {
+        float operator()(const unsigned char* p) const
+        {
+            float value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+    };
+
+    // Mono is copied to both sides, channels past the first two are dropped
+    template <typename Load>
+    static void ConvertFrames(const unsigned char* p, uint32_t stride, uint16_t channels, uint32_t count, float* pOut)
+    {
+        Load load;
+        const uint32_t second = channels > 1u ? stride / channels : 0u;
+        for (uint32_t i = 0u; i < count; ++i, p += stride)
+        {
+            pOut[i * 2u] = load(p);
+            pOut[i * 2u + 1u] = load(p + second);
+        }
+    }
+
+    bool Mixer::Clip::FromWav(const void* pData, size_t size, Clip& clip)
+    {
+        WavParser::Info info;
+        if (WavParser::Parse(pData, size, info) != WavParser::Result::Ok) return false;
+        bool isFloat = info.sampleType == WavParser::SampleType::Float;
+        if (isFloat ? info.bitsPerSample != 32u : info.bitsPerSample % 8u != 0u || info.bitsPerSample > 32u) return false;
+        clip = { info.pSamples, info.frameCount, info.sampleRate, info.channels, info.bitsPerSample, isFloat };
+        return true;
+    }
+
+    Mixer::Mixer(MixerOutput* pOutput, uint32_t sampleRate, uint32_t blockFrames, unsigned int maxVoices,
+        unsigned int queueSize) : m_pOutput(pOutput), m_sampleRate(sampleRate), m_blockFrames(blockFrames),
+        m_nextVoice(1u), m_maxVoices(maxVoices), m_queueHead(0u), m_queueTail(0u), m_active(0u), m_blocks(0u),
+        m_voicesMixed(0u), m_commands(0u), m_dropped(0u), m_mixNanoseconds(0u), m_running(false)
+    {
+        if (!pOutput) throw std::runtime_error("Mixer output is null.");
+        if (sampleRate == 0u || blockFrames == 0u) throw std::runtime_error("Mixer format is invalid.");
+
+        // The queue indices wrap with a mask, so its size is rounded up to a power of two
+        size_t size = 2u;
+        while (size < queueSize) size <<= 1;
+        m_queue.resize(size);
+        m_voices.reserve(maxVoices);
+        m_mix.resize((size_t)blockFrames * 2u);
+        m_scratch.resize((size_t)blockFrames * 2u);
+        m_source.resize(((size_t)blockFrames * (size_t)(MAX_STEP >> 32) + 2u) * 2u);
+    }
+
+    Mixer::~Mixer()
+    {
+        Shutdown();
+    }
+
+    uint32_t Mixer::Play(const Clip& clip, float gain, float pan, float pitch, bool looping)
+    {
+        if (!clip.pData) throw std::runtime_error("Clip data is null.");
+        if (clip.channels == 0u || clip.sampleRate == 0u || (clip.isFloat ? clip.bitsPerSample != 32u :
+            clip.bitsPerSample % 8u != 0u || clip.bitsPerSample == 0u || clip.bitsPerSample > 32u))
+        {
+            throw std::runtime_error("Clip format is not supported.");
+        }
+
+        // Ids are handed out here, so the game thread can refer to a voice before the mixer has seen it
+        uint32_t voice = m_nextVoice++;
+        if (m_nextVoice == 0u) m_nextVoice = 1u;
+        Command command = { CommandType::Play, voice, clip, gain, pan, pitch, looping };
+        return Push(command) ? voice : 0u;
+    }
+
+    bool Mixer::Stop(uint32_t voice)
+    {
+        return Push({ CommandType::Stop, voice, {}, 0.0f, 0.0f, 0.0f, false });
+    }
+
+    bool Mixer::StopAll()
+    {
+        return Push({ CommandType::StopAll, 0u, {}, 0.0f, 0.0f, 0.0f, false });
+    }
+
+    bool Mixer::SetGain(uint32_t voice, float gain)
+    {
+        return Push({ CommandType::Gain, voice, {}, gain, 0.0f, 0.0f, false });
+    }
+
+    bool Mixer::SetPan(uint32_t voice, float pan)
+    {
+        return Push({ CommandType::Pan, voice, {}, 0.0f, pan, 0.0f, false });
+    }
+
+    bool Mixer::SetPitch(uint32_t voice, float pitch)
+    {
+        return Push({ CommandType::Pitch, voice, {}, 0.0f, 0.0f, pitch, false });
+    }
+
+    void Mixer::Start(bool paced)
+    {
+        if (m_running) return;
+        m_running = true;
+        m_thread = std::thread([this, paced]()
+        {
+            // Paced mixing keeps to the wall clock like a sound card would, unpaced runs as fast as it can
+            const auto blockTime = std::chrono::nanoseconds(1000000000ull * m_blockFrames / m_sampleRate);
+            auto next = std::chrono::steady_clock::now();
+            while (m_running)
+            {
+                MixBlock();
+                if (!paced) continue;
+                next += blockTime;
+                auto now = std::chrono::steady_clock::now();
+                if (next < now - blockTime) next = now;
+                std::this_thread::sleep_until(next);
+            }
+        });
+    }
+
+    void Mixer::Shutdown()
+    {
+        m_running = false;
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    bool Mixer::IsRunning() const
+    {
+        return m_running;
+    }
+
+    void Mixer::Render(unsigned int blockCount)
+    {
+        if (m_running) throw std::runtime_error("Mixer thread is running.");
+        for (unsigned int i = 0u; i < blockCount; ++i) MixBlock();
+    }
+
+    uint32_t Mixer::GetSampleRate() const
+    {
+        return m_sampleRate;
+    }
+
+    uint32_t Mixer::GetBlockFrames() const
+    {
+        return m_blockFrames;
+    }
+
+    unsigned int Mixer::GetActiveCount() const
+    {
+        return m_active.load(std::memory_order_relaxed);
+    }
+
+    Mixer::Stats Mixer::GetStats() const
+    {
+        Stats stats;
+        stats.blocks = m_blocks.load(std::memory_order_relaxed);
+        stats.frames = stats.blocks * m_blockFrames;
+        stats.voicesMixed = m_voicesMixed.load(std::memory_order_relaxed);
+        stats.commands = m_commands.load(std::memory_order_relaxed);
+        stats.dropped = m_dropped.load(std::memory_order_relaxed);
+        stats.mixSeconds = m_mixNanoseconds.load(std::memory_order_relaxed) * 1e-9;
+        return stats;
+    }
+
+    bool Mixer::Push(const Command& command)
+    {
+        // Single producer, single consumer: the game thread owns the tail and the mix thread the head
+        const size_t tail = m_queueTail.load(std::memory_order_relaxed);
+        if (tail - m_queueHead.load(std::memory_order_acquire) >= m_queue.size())
+        {
+            m_dropped.fetch_add(1u, std::memory_order_relaxed);
+            return false;
+        }
+        m_queue[tail & (m_queue.size() - 1u)] = command;
+        m_queueTail.store(tail + 1u, std::memory_order_release);
+        return true;
+    }
+
+    void Mixer::Execute(const Command& command)
+    {
+        if (command.type == CommandType::Play)
+        {
+            if (m_voices.size() >= m_maxVoices)
+            {
+                m_dropped.fetch_add(1u, std::memory_order_relaxed);
+                return;
+            }
+            Voice voice = { command.clip, command.voice, 0u, 0u, command.gain,
+                command.pan < -1.0f ? -1.0f : command.pan > 1.0f ? 1.0f : command.pan, command.pitch,
+                0.0f, 0.0f, command.looping, false };
+            voice.step = GetStep(voice.clip, voice.pitch, m_sampleRate);
+            m_voices.push_back(voice);
+            return;
+        }
+        if (command.type == CommandType::StopAll)
+        {
+            m_voices.clear();
+            return;
+        }
+
+        for (size_t i = 0u; i < m_voices.size(); ++i)
+        {
+            Voice& voice = m_voices[i];
+            if (voice.id != command.voice) continue;
+            switch (command.type)
+            {
+            case CommandType::Stop:
+                m_voices[i] = m_voices.back();
+                m_voices.pop_back();
+                break;
+            case CommandType::Gain:
+                voice.gain = command.gain;
+                break;
+            case CommandType::Pan:
+                voice.pan = command.pan < -1.0f ? -1.0f : command.pan > 1.0f ? 1.0f : command.pan;
+                break;
+            case CommandType::Pitch:
+                voice.pitch = command.pitch;
+                voice.step = GetStep(voice.clip, voice.pitch, m_sampleRate);
+                break;
+            default:
+                break;
+            }
+            return;
+        }
+    }
+
+    void Mixer::MixBlock()
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        size_t head = m_queueHead.load(std::memory_order_relaxed);
+        const size_t tail = m_queueTail.load(std::memory_order_acquire);
+        for (; head != tail; ++head)
+        {
+            Execute(m_queue[head & (m_queue.size() - 1u)]);
+            m_commands.fetch_add(1u, std::memory_order_relaxed);
+        }
+        m_queueHead.store(head, std::memory_order_release);
+
+        std::fill(m_mix.begin(), m_mix.end(), 0.0f);
+        const size_t mixed = m_voices.size();
+        for (size_t i = 0u; i < m_voices.size();)
+        {
+            if (RenderVoice(m_voices[i]))
+            {
+                ++i;
+                continue;
+            }
+            m_voices[i] = m_voices.back();
+            m_voices.pop_back();
+        }
+        m_active.store((unsigned int)m_voices.size(), std::memory_order_relaxed);
+
+        auto end = std::chrono::steady_clock::now();
+        m_pOutput->Write(m_mix.data(), m_blockFrames, 2u, m_sampleRate);
+        m_blocks.fetch_add(1u, std::memory_order_relaxed);
+        m_voicesMixed.fetch_add(mixed, std::memory_order_relaxed);
+        m_mixNanoseconds.fetch_add((unsigned long long)
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), std::memory_order_relaxed);
+    }
+
+    bool Mixer::RenderVoice(Voice& voice)
+    {
+        const uint32_t frames = m_blockFrames;
+        float* pOut = m_scratch.data();
+        if (voice.step == ONE && (uint32_t)voice.position == 0u)
+        {
+            ReadFrames(voice, voice.position >> 32, frames, pOut);
+        }
+        else
+        {
+            // Linear interpolation over the source span this block covers, plus one frame for the last pair
+            const uint64_t first = voice.position >> 32;
+            const uint32_t span = (uint32_t)(((voice.position + voice.step * (frames - 1u)) >> 32) - first) + 2u;
+            const float* pSource = m_source.data();
+            ReadFrames(voice, first, span, m_source.data());
+            uint64_t position = (uint32_t)voice.position;
+            for (uint32_t i = 0u; i < frames; ++i, position += voice.step)
+            {
+                const float* pFrame = pSource + (position >> 32) * 2u;
+                const float t = (float)(uint32_t)position * (1.0f / 4294967296.0f);
+                pOut[i * 2u] = pFrame[0] + (pFrame[2] - pFrame[0]) * t;
+                pOut[i * 2u + 1u] = pFrame[1] + (pFrame[3] - pFrame[1]) * t;
+            }
+        }
+
+        float left, right;
+        GetGains(voice, left, right);
+        if (!voice.started)
+        {
+            voice.left = left;
+            voice.right = right;
+            voice.started = true;
+        }
+        MixAdd(m_mix.data(), pOut, frames, voice.left, voice.right, left, right);
+        voice.left = left;
+        voice.right = right;
+
+        voice.position += voice.step * frames;
+        const uint64_t length = (uint64_t)voice.clip.frameCount << 32;
+        if (voice.looping && length > 0u)
+        {
+            voice.position %= length;
+            return true;
+        }
+        return voice.position < length;
+    }
+
+    void Mixer::ReadFrames(const Voice& voice, uint64_t first, uint32_t count, float* pOut) const
+    {
+        const Clip& clip = voice.clip;
+        const uint32_t stride = clip.channels * (clip.bitsPerSample / 8u);
+        uint64_t frame = first;
+        if (voice.looping && clip.frameCount > 0u) frame %= clip.frameCount;
+        while (count > 0u)
+        {
+            if (frame >= clip.frameCount)
+            {
+                // Looping clips wrap around, anything past the end of a one-shot is silence
+                if (!voice.looping || clip.frameCount == 0u)
+                {
+                    std::fill(pOut, pOut + (size_t)count * 2u, 0.0f);
+                    return;
+                }
+                frame = 0u;
+            }
+
+            const uint32_t run = (uint32_t)std::min<uint64_t>(count, clip.frameCount - frame);
+            const unsigned char* p = static_cast<const unsigned char*>(clip.pData) + frame * stride;
+            if (clip.isFloat)
+            {
+                ConvertFrames<LoadF32>(p, stride, clip.channels, run, pOut);
+            }
+            else
+            {
+                switch (clip.bitsPerSample)
+                {
+                case 8u: ConvertFrames<LoadU8>(p, stride, clip.channels, run, pOut); break;
+                case 16u: ConvertFrames<LoadS16>(p, stride, clip.channels, run, pOut); break;
+                case 24u: ConvertFrames<LoadS24>(p, stride, clip.channels, run, pOut); break;
+                default: ConvertFrames<LoadS32>(p, stride, clip.channels, run, pOut); break;
+                }
+            }
+            pOut += (size_t)run * 2u;
+            count -= run;
+            frame += run;
+        }
+    }
+
+    uint64_t Mixer::GetStep(const Clip& clip, float pitch, uint32_t sampleRate)
+    {
+        // 32.32 fixed point source frames per output frame, covering both the rate conversion and the pitch
+        double step = (double)clip.sampleRate / sampleRate * (pitch > 0.0f ? pitch : 0.0f) * 4294967296.0;
+        if (step < 1.0) return 1u;
+        return step >= (double)MAX_STEP ? MAX_STEP : (uint64_t)step;
+    }
+
+    void Mixer::GetGains(const Voice& voice, float& left, float& right)
+    {
+        if (voice.clip.channels == 1u)
+        {
+            // Constant power pan for mono, a centered sound is 3 dB down on each side
+            const float angle = (voice.pan + 1.0f) * 0.785398163f;
+            left = voice.gain * std::cos(angle);
+            right = voice.gain * std::sin(angle);
+        }
+        else
+        {
+            // Stereo clips already have their own image, pan only turns one side down
+            left = voice.gain * (voice.pan > 0.0f ? 1.0f - voice.pan : 1.0f);
+            right = voice.gain * (voice.pan < 0.0f ? 1.0f + voice.pan : 1.0f);
+        }
+    }
+}
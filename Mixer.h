@@ -0,0 +1,83 @@
+#pragma once
+#include "MixerOutput.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace Ice2D
+{
+	class Mixer
+	{
+	public:
+		struct Clip
+		{
+			const void* pData;
+			uint32_t frameCount, sampleRate;
+			uint16_t channels, bitsPerSample;
+			bool isFloat;
+			static bool FromWav(const void* pData, size_t size, Clip& clip);
+		};
+		struct Stats
+		{
+			unsigned long long blocks, frames, voicesMixed, commands, dropped;
+			double mixSeconds;
+		};
+		Mixer(MixerOutput* pOutput, uint32_t sampleRate = 48000u, uint32_t blockFrames = 512u,
+			unsigned int maxVoices = 256u, unsigned int queueSize = 1024u);
+		Mixer(const Mixer& other) = delete;
+		Mixer& operator=(const Mixer& other) = delete;
+		~Mixer();
+		uint32_t Play(const Clip& clip, float gain = 1.0f, float pan = 0.0f, float pitch = 1.0f, bool looping = false);
+		bool Stop(uint32_t voice);
+		bool StopAll();
+		bool SetGain(uint32_t voice, float gain);
+		bool SetPan(uint32_t voice, float pan);
+		bool SetPitch(uint32_t voice, float pitch);
+		void Start(bool paced = true);
+		void Shutdown();
+		bool IsRunning() const;
+		void Render(unsigned int blockCount = 1u);
+		uint32_t GetSampleRate() const;
+		uint32_t GetBlockFrames() const;
+		unsigned int GetActiveCount() const;
+		Stats GetStats() const;
+	private:
+		enum class CommandType { Play, Stop, StopAll, Gain, Pan, Pitch };
+		struct Command
+		{
+			CommandType type;
+			uint32_t voice;
+			Clip clip;
+			float gain, pan, pitch;
+			bool looping;
+		};
+		struct Voice
+		{
+			Clip clip;
+			uint32_t id;
+			uint64_t position, step;
+			float gain, pan, pitch, left, right;
+			bool looping, started;
+		};
+		MixerOutput* m_pOutput;
+		uint32_t m_sampleRate, m_blockFrames, m_nextVoice;
+		unsigned int m_maxVoices;
+		std::vector<Command> m_queue;
+		std::atomic<size_t> m_queueHead, m_queueTail;
+		std::vector<Voice> m_voices;
+		std::vector<float> m_mix, m_scratch, m_source;
+		std::atomic<unsigned int> m_active;
+		std::atomic<unsigned long long> m_blocks, m_voicesMixed, m_commands, m_dropped, m_mixNanoseconds;
+		std::atomic<bool> m_running;
+		std::thread m_thread;
+		bool Push(const Command& command);
+		void Execute(const Command& command);
+		void MixBlock();
+		bool RenderVoice(Voice& voice);
+		void ReadFrames(const Voice& voice, uint64_t first, uint32_t count, float* pOut) const;
+		static uint64_t GetStep(const Clip& clip, float pitch, uint32_t sampleRate);
+		static void GetGains(const Voice& voice, float& left, float& right);
+	};
+}
@@ -0,0 +1,147 @@
+#include "pch.h"
+
+#include "MixerOutput.h"
+#include <cmath>
+#include <cstring>
+
+namespace Ice2D
+{
+    static void Put16(unsigned char* p, uint32_t value)
+    {
+        p[0] = (unsigned char)value;
+        p[1] = (unsigned char)(value >> 8);
+    }
+
+    static void Put32(unsigned char* p, uint32_t value)
+    {
+        Put16(p, value);
+        Put16(p + 2, value >> 16);
+    }
+
+    NullOutput::NullOutput() : m_frames(0u), m_peak(0.0f)
+    {
+    }
+
+    void NullOutput::Write(const float* pSamples, uint32_t frameCount, uint16_t channels, uint32_t)
+    {
+        // Only the peak is kept, enough to tell silence from sound in a test
+        float peak = m_peak.load(std::memory_order_relaxed);
+        const size_t count = (size_t)frameCount * channels;
+        for (size_t i = 0u; i < count; ++i)
+        {
+            float value = std::fabs(pSamples[i]);
+            if (value > peak) peak = value;
+        }
+        m_peak.store(peak, std::memory_order_relaxed);
+        m_frames.fetch_add(frameCount, std::memory_order_relaxed);
+    }
+
+    uint64_t NullOutput::GetFrameCount() const
+    {
+        return m_frames.load(std::memory_order_relaxed);
+    }
+
+    float NullOutput::GetPeak() const
+    {
+        return m_peak.load(std::memory_order_relaxed);
+    }
+
+    void NullOutput::Reset()
+    {
+        m_frames.store(0u, std::memory_order_relaxed);
+        m_peak.store(0.0f, std::memory_order_relaxed);
+    }
+
+    WavFileOutput::WavFileOutput(const char* filePath, uint16_t bitsPerSample) :
+        m_file(filePath, std::ios::binary | std::ios::trunc), m_bits(bitsPerSample), m_channels(0u),
+        m_sampleRate(0u), m_frames(0u)
+    {
+        if (!m_file) throw std::runtime_error("Failed to open WAV output.");
+        if (m_bits != 16u && m_bits != 32u) throw std::runtime_error("WAV output must be 16-bit or 32-bit float.");
+    }
+
+    WavFileOutput::~WavFileOutput()
+    {
+        Close();
+    }
+
+    void WavFileOutput::Write(const float* pSamples, uint32_t frameCount, uint16_t channels, uint32_t sampleRate)
+    {
+        if (!m_file.is_open()) return;
+        if (m_channels == 0u)
+        {
+            // The header is written once the format is known and patched with the sizes on Close()
+            m_channels = channels;
+            m_sampleRate = sampleRate;
+            WriteHeader();
+        }
+
+        const size_t count = (size_t)frameCount * channels;
+        m_buffer.resize(count * (m_bits / 8u));
+        unsigned char* p = m_buffer.data();
+        for (size_t i = 0u; i < count; ++i)
+        {
+            float value = pSamples[i];
+            if (m_bits == 16u)
+            {
+                value = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+                Put16(p + i * 2u, (uint32_t)(int32_t)std::lrintf(value * 32767.0f));
+            }
+            else
+            {
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                Put32(p + i * 4u, bits);
+            }
+        }
+        m_file.write(reinterpret_cast<const char*>(p), (std::streamsize)m_buffer.size());
+        m_frames.fetch_add(frameCount, std::memory_order_relaxed);
+    }
+
+    void WavFileOutput::Close()
+    {
+        if (!m_file.is_open()) return;
+        if (m_channels == 0u)
+        {
+            m_channels = 2u;
+            m_sampleRate = 48000u;
+        }
+        WriteHeader();
+        m_file.close();
+    }
+
+    bool WavFileOutput::IsOpen() const
+    {
+        return m_file.is_open();
+    }
+
+    uint64_t WavFileOutput::GetFrameCount() const
+    {
+        return m_frames.load(std::memory_order_relaxed);
+    }
+
+    void WavFileOutput::WriteHeader()
+    {
+        const uint32_t blockAlign = m_channels * (m_bits / 8u);
+        const uint64_t dataSize = m_frames.load(std::memory_order_relaxed) * blockAlign;
+        const uint32_t size = dataSize > 0xFFFFFFFFull - 36u ? 0xFFFFFFFFu - 36u : (uint32_t)dataSize;
+        unsigned char header[44];
+        memcpy(header, "RIFF", 4);
+        Put32(header + 4, 36u + size);
+        memcpy(header + 8, "WAVEfmt ", 8);
+        Put32(header + 16, 16u);
+        Put16(header + 20, m_bits == 32u ? 3u : 1u);
+        Put16(header + 22, m_channels);
+        Put32(header + 24, m_sampleRate);
+        Put32(header + 28, m_sampleRate * blockAlign);
+        Put16(header + 32, blockAlign);
+        Put16(header + 34, m_bits);
+        memcpy(header + 36, "data", 4);
+        Put32(header + 40, size);
+
+        std::streampos position = m_file.tellp();
+        m_file.seekp(0);
+        m_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        if (position > (std::streampos)sizeof(header)) m_file.seekp(position);
+    }
+}
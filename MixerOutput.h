@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+namespace Ice2D
+{
+	class MixerOutput
+	{
+	public:
+		virtual ~MixerOutput() {}
+		virtual void Write(const float* pSamples, uint32_t frameCount, uint16_t channels, uint32_t sampleRate) = 0;
+	};
+
+	class NullOutput : public MixerOutput
+	{
+	public:
+		NullOutput();
+		void Write(const float* pSamples, uint32_t frameCount, uint16_t channels, uint32_t sampleRate) override;
+		uint64_t GetFrameCount() const;
+		float GetPeak() const;
+		void Reset();
+	private:
+		std::atomic<uint64_t> m_frames;
+		std::atomic<float> m_peak;
+	};
+
+	class WavFileOutput : public MixerOutput
+	{
+	public:
+		WavFileOutput(const char* filePath, uint16_t bitsPerSample = 16u);
+		WavFileOutput(const WavFileOutput& other) = delete;
+		WavFileOutput& operator=(const WavFileOutput& other) = delete;
+		~WavFileOutput();
+		void Write(const float* pSamples, uint32_t frameCount, uint16_t channels, uint32_t sampleRate) override;
+		void Close();
+		bool IsOpen() const;
+		uint64_t GetFrameCount() const;
+	private:
+		std::ofstream m_file;
+		std::vector<unsigned char> m_buffer;
+		uint16_t m_bits, m_channels;
+		uint32_t m_sampleRate;
+		std::atomic<uint64_t> m_frames;
+		void WriteHeader();
+	};
+}
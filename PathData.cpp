@@ -0,0 +1,411 @@
+#include "pch.h"
+
+#include "PathData.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Ice2D
+{
+    static const float PI = 3.14159265358979f;
+    static const unsigned int MAX_SEGMENTS = 256u;
+
+    Matrix2D Matrix2D::Identity()
+    {
+        return { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    }
+
+    Matrix2D Matrix2D::Translation(float x, float y)
+    {
+        return { 1.0f, 0.0f, 0.0f, 1.0f, x, y };
+    }
+
+    Matrix2D Matrix2D::Scale(float x, float y, float centerX, float centerY)
+    {
+        return { x, 0.0f, 0.0f, y, centerX - x * centerX, centerY - y * centerY };
+    }
+
+    Matrix2D Matrix2D::Rotation(float degrees, float centerX, float centerY)
+    {
+        // Same convention as D2D1::Matrix3x2F::Rotation, positive angles turn clockwise on screen
+        float radians = degrees * (PI / 180.0f);
+        float c = std::cos(radians), s = std::sin(radians);
+        return { c, s, -s, c, centerX - c * centerX + s * centerY, centerY - s * centerX - c * centerY };
+    }
+
+    Matrix2D Matrix2D::operator*(const Matrix2D& other) const
+    {
+        // Row vectors like Direct2D, a * b applies a first
+        return {
+            m11 * other.m11 + m12 * other.m21, m11 * other.m12 + m12 * other.m22,
+            m21 * other.m11 + m22 * other.m21, m21 * other.m12 + m22 * other.m22,
+            dx * other.m11 + dy * other.m21 + other.dx, dx * other.m12 + dy * other.m22 + other.dy };
+    }
+
+    bool Matrix2D::Invert(Matrix2D& inverse) const
+    {
+        float det = m11 * m22 - m12 * m21;
+        if (det == 0.0f || !std::isfinite(det)) return false;
+        float inv = 1.0f / det;
+        inverse = { m22 * inv, -m12 * inv, -m21 * inv, m11 * inv,
+            (m21 * dy - m22 * dx) * inv, (m12 * dx - m11 * dy) * inv };
+        return true;
+    }
+
+    bool Matrix2D::IsIdentity() const
+    {
+        return m11 == 1.0f && m12 == 0.0f && m21 == 0.0f && m22 == 1.0f && dx == 0.0f && dy == 0.0f;
+    }
+
+    void Matrix2D::Transform(float& x, float& y) const
+    {
+        float tx = x * m11 + y * m21 + dx;
+        y = x * m12 + y * m22 + dy;
+        x = tx;
+    }
+
+    PathData::PathData(float tolerance) : m_mode(FillMode::Alternate), m_tolerance(tolerance), m_open(false)
+    {
+    }
+
+    void PathData::Clear()
+    {
+        m_points.clear();
+        m_figures.clear();
+        m_open = false;
+    }
+
+    void PathData::SetFillMode(FillMode mode)
+    {
+        m_mode = mode;
+    }
+
+    PathData::FillMode PathData::GetFillMode() const
+    {
+        return m_mode;
+    }
+
+    void PathData::SetTolerance(float tolerance)
+    {
+        // Curves are flattened as they are added, so this only affects the ones that follow
+        m_tolerance = tolerance > 0.001f ? tolerance : 0.001f;
+    }
+
+    float PathData::GetTolerance() const
+    {
+        return m_tolerance;
+    }
+
+    void PathData::MoveTo(float x, float y)
+    {
+        m_figures.push_back({ (unsigned int)m_points.size(), 1u, false });
+        m_points.push_back({ x, y });
+        m_open = true;
+    }
+
+    void PathData::LineTo(float x, float y)
+    {
+        if (!m_open)
+        {
+            MoveTo(x, y);
+            return;
+        }
+        m_points.push_back({ x, y });
+        ++m_figures.back().count;
+    }
+
+    void PathData::QuadraticTo(float cx, float cy, float x, float y)
+    {
+        // A parabola's chord error is |p0 - 2p1 + p2| / (4n^2)
+        Point p0 = Last();
+        float ddx = p0.x - 2.0f * cx + x, ddy = p0.y - 2.0f * cy + y;
+        unsigned int n = (unsigned int)std::ceil(std::sqrt(std::sqrt(ddx * ddx + ddy * ddy) / (4.0f * m_tolerance)));
+        n = std::max(1u, std::min(n, MAX_SEGMENTS));
+        for (unsigned int i = 1u; i <= n; ++i)
+        {
+            float t = (float)i / n, u = 1.0f - t;
+            LineTo(u * u * p0.x + 2.0f * u * t * cx + t * t * x, u * u * p0.y + 2.0f * u * t * cy + t * t * y);
+        }
+    }
+
+    void PathData::BezierTo(float c1x, float c1y, float c2x, float c2y, float x, float y)
+    {
+        // The second difference bounds the curvature, 3/4 of it over n^2 bounds the chord error
+        Point p0 = Last();
+        float ax = p0.x - 2.0f * c1x + c2x, ay = p0.y - 2.0f * c1y + c2y;
+        float bx = c1x - 2.0f * c2x + x, by = c1y - 2.0f * c2y + y;
+        float dd = std::sqrt(std::max(ax * ax + ay * ay, bx * bx + by * by));
+        unsigned int n = (unsigned int)std::ceil(std::sqrt(0.75f * dd / m_tolerance));
+        n = std::max(1u, std::min(n, MAX_SEGMENTS));
+        for (unsigned int i = 1u; i <= n; ++i)
+        {
+            float t = (float)i / n, u = 1.0f - t;
+            float a = u * u * u, b = 3.0f * u * u * t, c = 3.0f * u * t * t, d = t * t * t;
+            LineTo(a * p0.x + b * c1x + c * c2x + d * x, a * p0.y + b * c1y + c * c2y + d * y);
+        }
+    }
+
+    void PathData::ArcTo(float x, float y, float radiusX, float radiusY, float rotation, bool largeArc, bool clockwise)
+    {
+        // Endpoint to center conversion, the same arc D2D1_ARC_SEGMENT and SVG describe
+        Point p0 = Last();
+        float rx = std::fabs(radiusX), ry = std::fabs(radiusY);
+        if (rx == 0.0f || ry == 0.0f || (p0.x == x && p0.y == y))
+        {
+            LineTo(x, y);
+            return;
+        }
+        float phi = rotation * (PI / 180.0f), c = std::cos(phi), s = std::sin(phi);
+        float hx = (p0.x - x) * 0.5f, hy = (p0.y - y) * 0.5f;
+        float x1 = c * hx + s * hy, y1 = -s * hx + c * hy;
+
+        // Radii that are too small to reach the end point are scaled up
+        float lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+        if (lambda > 1.0f)
+        {
+            float scale = std::sqrt(lambda);
+            rx *= scale;
+            ry *= scale;
+        }
+        float num = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+        float den = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+        float k = den > 0.0f ? std::sqrt(std::max(num, 0.0f) / den) : 0.0f;
+        if (largeArc == clockwise) k = -k;
+        float cx1 = k * rx * y1 / ry, cy1 = -k * ry * x1 / rx;
+        float cx = c * cx1 - s * cy1 + (p0.x + x) * 0.5f, cy = s * cx1 + c * cy1 + (p0.y + y) * 0.5f;
+
+        float start = std::atan2((y1 - cy1) / ry, (x1 - cx1) / rx);
+        float end = std::atan2((-y1 - cy1) / ry, (-x1 - cx1) / rx);
+        float sweep = end - start;
+        if (clockwise && sweep < 0.0f) sweep += 2.0f * PI;
+        if (!clockwise && sweep > 0.0f) sweep -= 2.0f * PI;
+        AddArc(cx, cy, rx, ry, rotation, start, sweep);
+
+        // Lands exactly on the end point, whatever the rounding in the conversion
+        m_points.back() = { x, y };
+    }
+
+    void PathData::Close()
+    {
+        if (!m_open) return;
+        m_figures.back().closed = true;
+        m_open = false;
+    }
+
+    void PathData::AddRect(float left, float top, float right, float bottom)
+    {
+        MoveTo(left, top);
+        LineTo(right, top);
+        LineTo(right, bottom);
+        LineTo(left, bottom);
+        Close();
+    }
+
+    void PathData::AddRoundedRect(float left, float top, float right, float bottom, float radiusX, float radiusY)
+    {
+        float rx = std::min(std::fabs(radiusX), std::fabs(right - left) * 0.5f);
+        float ry = std::min(std::fabs(radiusY), std::fabs(bottom - top) * 0.5f);
+        if (rx <= 0.0f || ry <= 0.0f)
+        {
+            AddRect(left, top, right, bottom);
+            return;
+        }
+        MoveTo(left + rx, top);
+        LineTo(right - rx, top);
+        AddArc(right - rx, top + ry, rx, ry, 0.0f, -0.5f * PI, 0.5f * PI);
+        LineTo(right, bottom - ry);
+        AddArc(right - rx, bottom - ry, rx, ry, 0.0f, 0.0f, 0.5f * PI);
+        LineTo(left + rx, bottom);
+        AddArc(left + rx, bottom - ry, rx, ry, 0.0f, 0.5f * PI, 0.5f * PI);
+        LineTo(left, top + ry);
+        AddArc(left + rx, top + ry, rx, ry, 0.0f, PI, 0.5f * PI);
+        Close();
+    }
+
+    void PathData::AddEllipse(float centerX, float centerY, float radiusX, float radiusY)
+    {
+        MoveTo(centerX + radiusX, centerY);
+        AddArc(centerX, centerY, radiusX, radiusY, 0.0f, 0.0f, 2.0f * PI);
+        m_points.pop_back();
+        --m_figures.back().count;
+        Close();
+    }
+
+    void PathData::AddPolygon(const Point* pPoints, unsigned int count, bool closed)
+    {
+        if (!pPoints || count == 0u) return;
+        MoveTo(pPoints[0].x, pPoints[0].y);
+        for (unsigned int i = 1u; i < count; ++i) LineTo(pPoints[i].x, pPoints[i].y);
+        if (closed) Close();
+        else m_open = false;
+    }
+
+    void PathData::Transform(const Matrix2D& matrix)
+    {
+        for (Point& point : m_points) matrix.Transform(point.x, point.y);
+    }
+
+    bool PathData::GetBounds(float& left, float& top, float& right, float& bottom) const
+    {
+        if (m_points.empty()) return false;
+        left = right = m_points[0].x;
+        top = bottom = m_points[0].y;
+        for (const Point& point : m_points)
+        {
+            left = std::min(left, point.x);
+            right = std::max(right, point.x);
+            top = std::min(top, point.y);
+            bottom = std::max(bottom, point.y);
+        }
+        return true;
+    }
+
+    PathData PathData::Widen(float strokeWidth) const
+    {
+        // Every segment becomes a quad and every joint a wedge on the outer side, all wound the same way,
+        // so the winding rule fills their union without gaps or holes
+        PathData outline(m_tolerance);
+        outline.SetFillMode(FillMode::Winding);
+        const float half = std::fabs(strokeWidth) * 0.5f;
+        if (half == 0.0f) return outline;
+
+        std::vector<Point> directions;
+        std::vector<unsigned int> starts;
+        for (const Figure& figure : m_figures)
+        {
+            const Point* p = m_points.data() + figure.first;
+            unsigned int segments = figure.closed ? figure.count : figure.count - 1u;
+            directions.clear();
+            starts.clear();
+            for (unsigned int i = 0u; i < segments; ++i)
+            {
+                const Point& a = p[i];
+                const Point& b = p[(i + 1u) % figure.count];
+                float dx = b.x - a.x, dy = b.y - a.y;
+                float length = std::sqrt(dx * dx + dy * dy);
+                if (length == 0.0f) continue;
+                dx /= length;
+                dy /= length;
+                outline.AddQuad({ a.x - dy * half, a.y + dx * half }, { b.x - dy * half, b.y + dx * half },
+                    { b.x + dy * half, b.y - dx * half }, { a.x + dy * half, a.y - dx * half });
+                directions.push_back({ dx, dy });
+                starts.push_back(i);
+            }
+            if (directions.empty())
+            {
+                outline.AddCircle(p[0].x, p[0].y, half);
+                continue;
+            }
+
+            // Round joins only cover the turn, so flattened curves get thin slivers instead of whole discs
+            const size_t count = directions.size();
+            for (size_t i = figure.closed ? 0u : 1u; i < count; ++i)
+            {
+                const Point& d0 = directions[(i + count - 1u) % count];
+                const Point& d1 = directions[i];
+                float cross = d0.x * d1.y - d0.y * d1.x, dot = d0.x * d1.x + d0.y * d1.y;
+                if (cross == 0.0f && dot > 0.0f) continue;
+                float nx = -d0.y, ny = d0.x;
+                if (cross > 0.0f)
+                {
+                    nx = -nx;
+                    ny = -ny;
+                }
+                const Point& pivot = p[starts[i]];
+                outline.AddWedge(pivot.x, pivot.y, half, std::atan2(ny, nx), std::atan2(cross, dot));
+            }
+
+            // Round caps on open figures, half discs facing away from the line
+            if (!figure.closed)
+            {
+                const Point& first = directions.front();
+                const Point& last = directions.back();
+                const Point& end = p[(starts.back() + 1u) % figure.count];
+                outline.AddWedge(p[starts.front()].x, p[starts.front()].y, half, std::atan2(first.x, -first.y), PI);
+                outline.AddWedge(end.x, end.y, half, std::atan2(last.x, -last.y), -PI);
+            }
+        }
+        return outline;
+    }
+
+    const std::vector<PathData::Point>& PathData::GetPoints() const
+    {
+        return m_points;
+    }
+
+    const std::vector<PathData::Figure>& PathData::GetFigures() const
+    {
+        return m_figures;
+    }
+
+    PathData::Point PathData::Last() const
+    {
+        return m_open ? m_points.back() : Point{ 0.0f, 0.0f };
+    }
+
+    void PathData::AddArc(float centerX, float centerY, float radiusX, float radiusY, float rotation,
+        float startAngle, float sweep)
+    {
+        float phi = rotation * (PI / 180.0f), c = std::cos(phi), s = std::sin(phi);
+        unsigned int n = ArcSegments(std::max(std::fabs(radiusX), std::fabs(radiusY)), sweep);
+        for (unsigned int i = 1u; i <= n; ++i)
+        {
+            float angle = startAngle + sweep * i / n;
+            float ex = radiusX * std::cos(angle), ey = radiusY * std::sin(angle);
+            LineTo(centerX + c * ex - s * ey, centerY + s * ex + c * ey);
+        }
+    }
+
+    unsigned int PathData::ArcSegments(float radius, float sweep) const
+    {
+        // A chord over angle a is off by r(1 - cos(a/2)), keep that under the tolerance
+        if (radius <= m_tolerance) return std::max(1u, (unsigned int)std::ceil(std::fabs(sweep) / (0.5f * PI)));
+        float step = 2.0f * std::acos(1.0f - m_tolerance / radius);
+        unsigned int n = (unsigned int)std::ceil(std::fabs(sweep) / step);
+        return std::max(1u, std::min(n, MAX_SEGMENTS));
+    }
+
+    void PathData::AddCircle(float x, float y, float radius)
+    {
+        // Clockwise on screen, the same way AddQuad orders its corners
+        MoveTo(x + radius, y);
+        AddArc(x, y, radius, radius, 0.0f, 0.0f, 2.0f * PI);
+        m_points.pop_back();
+        --m_figures.back().count;
+        Close();
+    }
+
+    void PathData::AddWedge(float x, float y, float radius, float startAngle, float sweep)
+    {
+        // Always swept in the positive direction, so the wedge is wound like AddQuad's quads
+        if (sweep < 0.0f)
+        {
+            startAngle += sweep;
+            sweep = -sweep;
+        }
+        MoveTo(x, y);
+        LineTo(x + radius * std::cos(startAngle), y + radius * std::sin(startAngle));
+        AddArc(x, y, radius, radius, 0.0f, startAngle, sweep);
+        Close();
+    }
+
+    void PathData::AddQuad(const Point& a, const Point& b, const Point& c, const Point& d)
+    {
+        // Flips the corner order when needed, so every quad has a positive area
+        float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y) +
+            (c.x - a.x) * (d.y - a.y) - (d.x - a.x) * (c.y - a.y);
+        MoveTo(a.x, a.y);
+        if (area >= 0.0f)
+        {
+            LineTo(b.x, b.y);
+            LineTo(c.x, c.y);
+            LineTo(d.x, d.y);
+        }
+        else
+        {
+            LineTo(d.x, d.y);
+            LineTo(c.x, c.y);
+            LineTo(b.x, b.y);
+        }
+        Close();
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+
+namespace Ice2D
+{
+	struct Matrix2D
+	{
+		float m11, m12, m21, m22, dx, dy;
+		static Matrix2D Identity();
+		static Matrix2D Translation(float x, float y);
+		static Matrix2D Scale(float x, float y, float centerX = 0.0f, float centerY = 0.0f);
+		static Matrix2D Rotation(float degrees, float centerX = 0.0f, float centerY = 0.0f);
+		Matrix2D operator*(const Matrix2D& other) const;
+		bool Invert(Matrix2D& inverse) const;
+		bool IsIdentity() const;
+		void Transform(float& x, float& y) const;
+	};
+
+	class PathData
+	{
+	public:
+		enum class FillMode { Alternate, Winding };
+		struct Point
+		{
+			float x, y;
+		};
+		struct Figure
+		{
+			unsigned int first, count;
+			bool closed;
+		};
+		PathData(float tolerance = 0.25f);
+		void Clear();
+		void SetFillMode(FillMode mode);
+		FillMode GetFillMode() const;
+		void SetTolerance(float tolerance);
+		float GetTolerance() const;
+		void MoveTo(float x, float y);
+		void LineTo(float x, float y);
+		void QuadraticTo(float cx, float cy, float x, float y);
+		void BezierTo(float c1x, float c1y, float c2x, float c2y, float x, float y);
+		void ArcTo(float x, float y, float radiusX, float radiusY, float rotation, bool largeArc, bool clockwise);
+		void Close();
+		void AddRect(float left, float top, float right, float bottom);
+		void AddRoundedRect(float left, float top, float right, float bottom, float radiusX, float radiusY);
+		void AddEllipse(float centerX, float centerY, float radiusX, float radiusY);
+		void AddPolygon(const Point* pPoints, unsigned int count, bool closed = true);
+		void Transform(const Matrix2D& matrix);
+		bool GetBounds(float& left, float& top, float& right, float& bottom) const;
+		PathData Widen(float strokeWidth) const;
+		const std::vector<Point>& GetPoints() const;
+		const std::vector<Figure>& GetFigures() const;
+	private:
+		std::vector<Point> m_points;
+		std::vector<Figure> m_figures;
+		FillMode m_mode;
+		float m_tolerance;
+		bool m_open;
+		Point Last() const;
+		void AddArc(float centerX, float centerY, float radiusX, float radiusY, float rotation,
+			float startAngle, float sweep);
+		unsigned int ArcSegments(float radius, float sweep) const;
+		void AddCircle(float x, float y, float radius);
+		void AddWedge(float x, float y, float radius, float startAngle, float sweep);
+		void AddQuad(const Point& a, const Point& b, const Point& c, const Point& d);
+	};
+}
@@ -0,0 +1,565 @@
+#include "pch.h"
+
+#include "PixelKernels.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ICE2D_PIXEL_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define ICE2D_TARGET_AVX2
+#else
+#define ICE2D_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define ICE2D_PIXEL_X86 0
+#endif
+
+namespace Ice2D
+{
+    namespace PixelKernels
+    {
+        // Every path rounds the same way, so the result doesn't depend on the instruction set
+        static inline uint32_t Div255(uint32_t x)
+        {
+            x += 128u;
+            return (x + (x >> 8)) >> 8;
+        }
+
+        static inline uint32_t* Row(uint32_t* p, size_t stride, unsigned int y)
+        {
+            return reinterpret_cast<uint32_t*>(reinterpret_cast<unsigned char*>(p) + stride * y);
+        }
+
+        static inline const uint32_t* Row(const uint32_t* p, size_t stride, unsigned int y)
+        {
+            return reinterpret_cast<const uint32_t*>(reinterpret_cast<const unsigned char*>(p) + stride * y);
+        }
+
+        struct UnpremultiplyTable
+        {
+            unsigned char values[256][256];
+            UnpremultiplyTable()
+            {
+                for (unsigned int a = 0u; a < 256u; ++a)
+                {
+                    for (unsigned int c = 0u; c < 256u; ++c)
+                    {
+                        values[a][c] = a == 0u ? 0u : (unsigned char)std::min((c * 255u + a / 2u) / a, 255u);
+                    }
+                }
+            }
+        };
+
+        static const UnpremultiplyTable& GetUnpremultiplyTable()
+        {
+            static const UnpremultiplyTable table;
+            return table;
+        }
+
+        static void ScalarFillRow(uint32_t* p, unsigned int width, uint32_t color)
+        {
+            std::fill(p, p + width, color);
+        }
+
+        static void ScalarPremultiplyRow(uint32_t* p, unsigned int width)
+        {
+            for (unsigned int x = 0u; x < width; ++x)
+            {
+                uint32_t c = p[x];
+                uint32_t a = c >> 24;
+                if (a == 255u) continue;
+                p[x] = (a << 24) | (Div255(((c >> 16) & 0xFFu) * a) << 16) |
+                    (Div255(((c >> 8) & 0xFFu) * a) << 8) | Div255((c & 0xFFu) * a);
+            }
+        }
+
+        static void ScalarUnpremultiplyRow(uint32_t* p, unsigned int width)
+        {
+            const UnpremultiplyTable& table = GetUnpremultiplyTable();
+            for (unsigned int x = 0u; x < width; ++x)
+            {
+                uint32_t c = p[x];
+                uint32_t a = c >> 24;
+                if (a == 255u || a == 0u) continue;
+                const unsigned char* lut = table.values[a];
+                p[x] = (a << 24) | ((uint32_t)lut[(c >> 16) & 0xFFu] << 16) |
+                    ((uint32_t)lut[(c >> 8) & 0xFFu] << 8) | lut[c & 0xFFu];
+            }
+        }
+
+        static void ScalarBlendRow(uint32_t* d, const uint32_t* s, unsigned int width)
+        {
+            // Source over with premultiplied colors
+            for (unsigned int x = 0u; x < width; ++x)
+            {
+                uint32_t src = s[x];
+                uint32_t inv = 255u - (src >> 24);
+                if (inv == 0u)
+                {
+                    d[x] = src;
+                    continue;
+                }
+                uint32_t dst = d[x], out = 0u;
+                for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+                {
+                    uint32_t c = ((src >> shift) & 0xFFu) + Div255(((dst >> shift) & 0xFFu) * inv);
+                    out |= std::min(c, 255u) << shift;
+                }
+                d[x] = out;
+            }
+        }
+
+        static void ScalarTintRow(uint32_t* p, unsigned int width, uint32_t color)
+        {
+            for (unsigned int x = 0u; x < width; ++x)
+            {
+                uint32_t c = p[x], out = 0u;
+                for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+                {
+                    out |= Div255(((c >> shift) & 0xFFu) * ((color >> shift) & 0xFFu)) << shift;
+                }
+                p[x] = out;
+            }
+        }
+
+        static void ScalarGrayscaleRow(uint32_t* p, unsigned int width)
+        {
+            // Rec. 601 weights out of 256, gray never exceeds alpha so the result stays premultiplied
+            for (unsigned int x = 0u; x < width; ++x)
+            {
+                uint32_t c = p[x];
+                uint32_t y = (((c >> 16) & 0xFFu) * 77u + ((c >> 8) & 0xFFu) * 150u + (c & 0xFFu) * 29u + 128u) >> 8;
+                p[x] = (c & 0xFF000000u) | (y << 16) | (y << 8) | y;
+            }
+        }
+
+        static void ScalarSwizzleRow(uint32_t* p, unsigned int width, const unsigned char* order)
+        {
+            for (unsigned int x = 0u; x < width; ++x)
+            {
+                uint32_t c = p[x];
+                p[x] = ((c >> (order[0] * 8u)) & 0xFFu) | (((c >> (order[1] * 8u)) & 0xFFu) << 8) |
+                    (((c >> (order[2] * 8u)) & 0xFFu) << 16) | (((c >> (order[3] * 8u)) & 0xFFu) << 24);
+            }
+        }
+
+#if ICE2D_PIXEL_X86
+        static inline __m128i Sse2MulDiv255(__m128i a, __m128i b)
+        {
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+
+        static inline __m128i Sse2BroadcastAlpha(__m128i v)
+        {
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+            return _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+
+        static void Sse2FillRow(uint32_t* p, unsigned int width, uint32_t color)
+        {
+            __m128i c = _mm_set1_epi32((int)color);
+            unsigned int x = 0u;
+            for (; x + 4u <= width; x += 4u) _mm_storeu_si128(reinterpret_cast<__m128i*>(p + x), c);
+            ScalarFillRow(p + x, width - x, color);
+        }
+
+        static void Sse2PremultiplyRow(uint32_t* p, unsigned int width)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+            const __m128i alpha255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+            const __m128i opaque = _mm_set1_epi32((int)0xFF000000u);
+            unsigned int x = 0u;
+            for (; x + 4u <= width; x += 4u)
+            {
+                __m128i* pPixels = reinterpret_cast<__m128i*>(p + x);
+                __m128i px = _mm_loadu_si128(pPixels);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(px, opaque), opaque)) == 0xFFFF) continue;
+
+                // Multiply color by alpha and alpha by 255, which leaves it unchanged
+                __m128i lo = _mm_unpacklo_epi8(px, zero);
+                __m128i hi = _mm_unpackhi_epi8(px, zero);
+                __m128i loMul = _mm_or_si128(_mm_andnot_si128(alphaLanes, Sse2BroadcastAlpha(lo)), alpha255);
+                __m128i hiMul = _mm_or_si128(_mm_andnot_si128(alphaLanes, Sse2BroadcastAlpha(hi)), alpha255);
+                _mm_storeu_si128(pPixels, _mm_packus_epi16(Sse2MulDiv255(lo, loMul), Sse2MulDiv255(hi, hiMul)));
+            }
+            ScalarPremultiplyRow(p + x, width - x);
+        }
+
+        static void Sse2UnpremultiplyRow(uint32_t* p, unsigned int width)
+        {
+            // A divide per channel has no SSE2 form, skip runs of opaque or empty pixels and use the table for the rest
+            const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000u);
+            const __m128i zero = _mm_setzero_si128();
+            unsigned int x = 0u;
+            for (; x + 4u <= width; x += 4u)
+            {
+                __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + x)), alphaMask);
+                int opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(a, alphaMask));
+                int empty = _mm_movemask_epi8(_mm_cmpeq_epi32(a, zero));
+                if ((opaque | empty) != 0xFFFF) ScalarUnpremultiplyRow(p + x, 4u);
+            }
+            ScalarUnpremultiplyRow(p + x, width - x);
+        }
+
+        static void Sse2BlendRow(uint32_t* d, const uint32_t* s, unsigned int width)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i full = _mm_set1_epi16(255);
+            unsigned int x = 0u;
+            for (; x + 4u <= width; x += 4u)
+            {
+                __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x));
+                __m128i* pDst = reinterpret_cast<__m128i*>(d + x);
+                __m128i dst = _mm_loadu_si128(pDst);
+                __m128i loInv = _mm_sub_epi16(full, Sse2BroadcastAlpha(_mm_unpacklo_epi8(src, zero)));
+                __m128i hiInv = _mm_sub_epi16(full, Sse2BroadcastAlpha(_mm_unpackhi_epi8(src, zero)));
+                __m128i lo = Sse2MulDiv255(_mm_unpacklo_epi8(dst, zero), loInv);
+                __m128i hi = Sse2MulDiv255(_mm_unpackhi_epi8(dst, zero), hiInv);
+                _mm_storeu_si128(pDst, _mm_adds_epu8(_mm_packus_epi16(lo, hi), src));
+            }
+            ScalarBlendRow(d + x, s + x, width - x);
+        }
+
+        static void Sse2TintRow(uint32_t* p, unsigned int width, uint32_t color)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i tint = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+            unsigned int x = 0u;
+            for (; x + 4u <= width; x += 4u)
+            {
+                __m128i* pPixels = reinterpret_cast<__m128i*>(p + x);
+                __m128i px = _mm_loadu_si128(pPixels);
+                __m128i lo = Sse2MulDiv255(_mm_unpacklo_epi8(px, zero), tint);
+                __m128i hi = Sse2MulDiv255(_mm_unpackhi_epi8(px, zero), tint);
+                _mm_storeu_si128(pPixels, _mm_packus_epi16(lo, hi));
+            }
+            ScalarTintRow(p + x, width - x, color);
+        }
+
+        static void Sse2GrayscaleRow(uint32_t* p, unsigned int width)
+        {
+            // Channels sit in the low word of each lane, so 16-bit multiplies can't overflow into the next one
+            const __m128i mask = _mm_set1_epi32(0xFF);
+            const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000u);
+            unsigned int x = 0u;
+            for (; x + 4u <= width; x += 4u)
+            {
+                __m128i* pPixels = reinterpret_cast<__m128i*>(p + x);
+                __m128i px = _mm_loadu_si128(pPixels);
+                __m128i b = _mm_and_si128(px, mask);
+                __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+                __m128i r = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+                __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi32(77)), _mm_mullo_epi16(g, _mm_set1_epi32(150)));
+                sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi32(29)), _mm_set1_epi32(128)));
+                __m128i y = _mm_srli_epi32(sum, 8);
+                __m128i gray = _mm_or_si128(_mm_or_si128(y, _mm_slli_epi32(y, 8)), _mm_slli_epi32(y, 16));
+                _mm_storeu_si128(pPixels, _mm_or_si128(gray, _mm_and_si128(px, alphaMask)));
+            }
+            ScalarGrayscaleRow(p + x, width - x);
+        }
+
+        static void Sse2SwizzleRow(uint32_t* p, unsigned int width, const unsigned char* order)
+        {
+            // No byte shuffle before SSSE3, move each channel with a shift pair instead
+            const __m128i mask = _mm_set1_epi32(0xFF);
+            __m128i right[4], left[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                right[i] = _mm_cvtsi32_si128(order[i] * 8);
+                left[i] = _mm_cvtsi32_si128(i * 8);
+            }
+            unsigned int x = 0u;
+            for (; x + 4u <= width; x += 4u)
+            {
+                __m128i* pPixels = reinterpret_cast<__m128i*>(p + x);
+                __m128i px = _mm_loadu_si128(pPixels);
+                __m128i out = _mm_setzero_si128();
+                for (int i = 0; i < 4; ++i)
+                {
+                    out = _mm_or_si128(out, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(px, right[i]), mask), left[i]));
+                }
+                _mm_storeu_si128(pPixels, out);
+            }
+            ScalarSwizzleRow(p + x, width - x, order);
+        }
+
+        ICE2D_TARGET_AVX2 static inline __m256i Avx2MulDiv255(__m256i a, __m256i b)
+        {
+            __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+            return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+        }
+
+        ICE2D_TARGET_AVX2 static inline __m256i Avx2BroadcastAlpha(__m256i v)
+        {
+            v = _mm256_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+            return _mm256_shufflehi_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+
+        ICE2D_TARGET_AVX2 static void Avx2FillRow(uint32_t* p, unsigned int width, uint32_t color)
+        {
+            __m256i c = _mm256_set1_epi32((int)color);
+            unsigned int x = 0u;
+            for (; x + 8u <= width; x += 8u) _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + x), c);
+            ScalarFillRow(p + x, width - x, color);
+        }
+
+        ICE2D_TARGET_AVX2 static void Avx2PremultiplyRow(uint32_t* p, unsigned int width)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i alphaLanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+            const __m256i alpha255 = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+            const __m256i opaque = _mm256_set1_epi32((int)0xFF000000u);
+            unsigned int x = 0u;
+            for (; x + 8u <= width; x += 8u)
+            {
+                __m256i* pPixels = reinterpret_cast<__m256i*>(p + x);
+                __m256i px = _mm256_loadu_si256(pPixels);
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(px, opaque), opaque)) == -1) continue;
+
+                __m256i lo = _mm256_unpacklo_epi8(px, zero);
+                __m256i hi = _mm256_unpackhi_epi8(px, zero);
+                __m256i loMul = _mm256_or_si256(_mm256_andnot_si256(alphaLanes, Avx2BroadcastAlpha(lo)), alpha255);
+                __m256i hiMul = _mm256_or_si256(_mm256_andnot_si256(alphaLanes, Avx2BroadcastAlpha(hi)), alpha255);
+                _mm256_storeu_si256(pPixels, _mm256_packus_epi16(Avx2MulDiv255(lo, loMul), Avx2MulDiv255(hi, hiMul)));
+            }
+            ScalarPremultiplyRow(p + x, width - x);
+        }
+
+        ICE2D_TARGET_AVX2 static void Avx2UnpremultiplyRow(uint32_t* p, unsigned int width)
+        {
+            const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000u);
+            const __m256i zero = _mm256_setzero_si256();
+            unsigned int x = 0u;
+            for (; x + 8u <= width; x += 8u)
+            {
+                __m256i a = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + x)), alphaMask);
+                int opaque = _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, alphaMask));
+                int empty = _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, zero));
+                if ((opaque | empty) != -1) ScalarUnpremultiplyRow(p + x, 8u);
+            }
+            ScalarUnpremultiplyRow(p + x, width - x);
+        }
+
+        ICE2D_TARGET_AVX2 static void Avx2BlendRow(uint32_t* d, const uint32_t* s, unsigned int width)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i full = _mm256_set1_epi16(255);
+            unsigned int x = 0u;
+            for (; x + 8u <= width; x += 8u)
+            {
+                __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + x));
+                __m256i* pDst = reinterpret_cast<__m256i*>(d + x);
+                __m256i dst = _mm256_loadu_si256(pDst);
+                __m256i loInv = _mm256_sub_epi16(full, Avx2BroadcastAlpha(_mm256_unpacklo_epi8(src, zero)));
+                __m256i hiInv = _mm256_sub_epi16(full, Avx2BroadcastAlpha(_mm256_unpackhi_epi8(src, zero)));
+                __m256i lo = Avx2MulDiv255(_mm256_unpacklo_epi8(dst, zero), loInv);
+                __m256i hi = Avx2MulDiv255(_mm256_unpackhi_epi8(dst, zero), hiInv);
+                _mm256_storeu_si256(pDst, _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), src));
+            }
+            ScalarBlendRow(d + x, s + x, width - x);
+        }
+
+        ICE2D_TARGET_AVX2 static void Avx2TintRow(uint32_t* p, unsigned int width, uint32_t color)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i tint = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+            unsigned int x = 0u;
+            for (; x + 8u <= width; x += 8u)
+            {
+                __m256i* pPixels = reinterpret_cast<__m256i*>(p + x);
+                __m256i px = _mm256_loadu_si256(pPixels);
+                __m256i lo = Avx2MulDiv255(_mm256_unpacklo_epi8(px, zero), tint);
+                __m256i hi = Avx2MulDiv255(_mm256_unpackhi_epi8(px, zero), tint);
+                _mm256_storeu_si256(pPixels, _mm256_packus_epi16(lo, hi));
+            }
+            ScalarTintRow(p + x, width - x, color);
+        }
+
+        ICE2D_TARGET_AVX2 static void Avx2GrayscaleRow(uint32_t* p, unsigned int width)
+        {
+            const __m256i mask = _mm256_set1_epi32(0xFF);
+            const __m256i alphaMask = _mm256_set1_epi32((int)0xFF000000u);
+            unsigned int x = 0u;
+            for (; x + 8u <= width; x += 8u)
+            {
+                __m256i* pPixels = reinterpret_cast<__m256i*>(p + x);
+                __m256i px = _mm256_loadu_si256(pPixels);
+                __m256i b = _mm256_and_si256(px, mask);
+                __m256i g = _mm256_and_si256(_mm256_srli_epi32(px, 8), mask);
+                __m256i r = _mm256_and_si256(_mm256_srli_epi32(px, 16), mask);
+                __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi32(77)),
+                    _mm256_mullo_epi16(g, _mm256_set1_epi32(150)));
+                sum = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi32(29)),
+                    _mm256_set1_epi32(128)));
+                __m256i y = _mm256_srli_epi32(sum, 8);
+                __m256i gray = _mm256_or_si256(_mm256_or_si256(y, _mm256_slli_epi32(y, 8)), _mm256_slli_epi32(y, 16));
+                _mm256_storeu_si256(pPixels, _mm256_or_si256(gray, _mm256_and_si256(px, alphaMask)));
+            }
+            ScalarGrayscaleRow(p + x, width - x);
+        }
+
+        ICE2D_TARGET_AVX2 static void Avx2SwizzleRow(uint32_t* p, unsigned int width, const unsigned char* order)
+        {
+            char shuffle[32];
+            for (int i = 0; i < 32; ++i) shuffle[i] = (char)((i & ~3) + order[i & 3]);
+            const __m256i control = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shuffle));
+            unsigned int x = 0u;
+            for (; x + 8u <= width; x += 8u)
+            {
+                __m256i* pPixels = reinterpret_cast<__m256i*>(p + x);
+                _mm256_storeu_si256(pPixels, _mm256_shuffle_epi8(_mm256_loadu_si256(pPixels), control));
+            }
+            ScalarSwizzleRow(p + x, width - x, order);
+        }
+
+        static bool CpuHasSse2()
+        {
+#if defined(_M_X64) || defined(__x86_64__)
+            return true;
+#elif defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            return (info[3] & (1 << 26)) != 0;
+#else
+            return __builtin_cpu_supports("sse2");
+#endif
+        }
+
+        static bool CpuHasAvx2()
+        {
+#ifdef _MSC_VER
+            // The OS also has to save the YMM registers on context switches
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            const int osxsave = 1 << 27, avx = 1 << 28;
+            if ((info[2] & osxsave) == 0 || (info[2] & avx) == 0) return false;
+            if ((_xgetbv(0) & 6u) != 6u) return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        static Level& CurrentLevel()
+        {
+            static Level level = GetSupportedLevel();
+            return level;
+        }
+
+        template <typename F>
+        static F Pick(F scalar, F sse2, F avx2)
+        {
+            switch (CurrentLevel())
+            {
+            case Level::AVX2: return avx2;
+            case Level::SSE2: return sse2;
+            default: return scalar;
+            }
+        }
+
+#if ICE2D_PIXEL_X86
+#define ICE2D_PICK_ROW(name) Pick(&Scalar##name##Row, &Sse2##name##Row, &Avx2##name##Row)
+#else
+#define ICE2D_PICK_ROW(name) (&Scalar##name##Row)
+#endif
+
+        Level GetLevel()
+        {
+            return CurrentLevel();
+        }
+
+        Level GetSupportedLevel()
+        {
+#if ICE2D_PIXEL_X86
+            static const Level supported = CpuHasAvx2() ? Level::AVX2 : CpuHasSse2() ? Level::SSE2 : Level::Scalar;
+            return supported;
+#else
+            return Level::Scalar;
+#endif
+        }
+
+        void SetLevel(Level level)
+        {
+            // Mainly for comparing the paths, a level the CPU lacks falls back to the best one it has
+            Level supported = GetSupportedLevel();
+            CurrentLevel() = (int)level > (int)supported ? supported : level;
+        }
+
+        const char* GetLevelName(Level level)
+        {
+            switch (level)
+            {
+            case Level::AVX2: return "AVX2";
+            case Level::SSE2: return "SSE2";
+            default: return "Scalar";
+            }
+        }
+
+        void Fill(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height, uint32_t color)
+        {
+            auto row = ICE2D_PICK_ROW(Fill);
+            for (unsigned int y = 0u; y < height; ++y) row(Row(pDst, dstStride, y), width, color);
+        }
+
+        void CopyRect(uint32_t* pDst, size_t dstStride, const uint32_t* pSrc, size_t srcStride,
+            unsigned int width, unsigned int height)
+        {
+            // memmove is already vectorized by the CRT and handles copies within one buffer
+            for (unsigned int y = 0u; y < height; ++y)
+            {
+                std::memmove(Row(pDst, dstStride, y), Row(pSrc, srcStride, y), width * sizeof(uint32_t));
+            }
+        }
+
+        void Premultiply(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height)
+        {
+            auto row = ICE2D_PICK_ROW(Premultiply);
+            for (unsigned int y = 0u; y < height; ++y) row(Row(pDst, dstStride, y), width);
+        }
+
+        void Unpremultiply(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height)
+        {
+            auto row = ICE2D_PICK_ROW(Unpremultiply);
+            for (unsigned int y = 0u; y < height; ++y) row(Row(pDst, dstStride, y), width);
+        }
+
+        void Blend(uint32_t* pDst, size_t dstStride, const uint32_t* pSrc, size_t srcStride,
+            unsigned int width, unsigned int height)
+        {
+            auto row = ICE2D_PICK_ROW(Blend);
+            for (unsigned int y = 0u; y < height; ++y) row(Row(pDst, dstStride, y), Row(pSrc, srcStride, y), width);
+        }
+
+        void Tint(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height, uint32_t color)
+        {
+            auto row = ICE2D_PICK_ROW(Tint);
+            for (unsigned int y = 0u; y < height; ++y) row(Row(pDst, dstStride, y), width, color);
+        }
+
+        void Grayscale(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height)
+        {
+            auto row = ICE2D_PICK_ROW(Grayscale);
+            for (unsigned int y = 0u; y < height; ++y) row(Row(pDst, dstStride, y), width);
+        }
+
+        void Swizzle(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height,
+            const unsigned char order[4])
+        {
+            if (order[0] > 3u || order[1] > 3u || order[2] > 3u || order[3] > 3u)
+            {
+                throw std::runtime_error("Swizzle channel index out of range.");
+            }
+            auto row = ICE2D_PICK_ROW(Swizzle);
+            for (unsigned int y = 0u; y < height; ++y) row(Row(pDst, dstStride, y), width, order);
+        }
+    }
+}
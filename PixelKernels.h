@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Bulk operations on 32bpp premultiplied BGRA rows, strides are in bytes
+namespace Ice2D
+{
+	namespace PixelKernels
+	{
+		enum class Level { Scalar, SSE2, AVX2 };
+		Level GetLevel();
+		Level GetSupportedLevel();
+		void SetLevel(Level level);
+		const char* GetLevelName(Level level);
+
+		void Fill(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height, uint32_t color);
+		void CopyRect(uint32_t* pDst, size_t dstStride, const uint32_t* pSrc, size_t srcStride,
+			unsigned int width, unsigned int height);
+		void Premultiply(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height);
+		void Unpremultiply(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height);
+		void Blend(uint32_t* pDst, size_t dstStride, const uint32_t* pSrc, size_t srcStride,
+			unsigned int width, unsigned int height);
+		void Tint(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height, uint32_t color);
+		void Grayscale(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height);
+		void Swizzle(uint32_t* pDst, size_t dstStride, unsigned int width, unsigned int height,
+			const unsigned char order[4]);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "pch.h"
+
+#include "Profiler.h"
+
+#ifdef ICE2D_PROFILE
+#include <algorithm>
+#include <iomanip>
+
+namespace Ice2D
+{
+    double Profiler::Frame::Milliseconds() const
+    {
+        return (end - start) / 1'000'000.0;
+    }
+
+    Profiler& Profiler::Get()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Profiler::Profiler() : m_head(0u), m_count(0u), m_frameNumber(0ull), m_inFrame(false),
+        m_epoch(std::chrono::high_resolution_clock::now())
+    {
+        SetHistorySize(240u);
+    }
+
+    void Profiler::SetHistorySize(unsigned int frameCount)
+    {
+        if (frameCount == 0u) throw std::invalid_argument("Profiler history must hold at least one frame.");
+
+        // One extra slot holds the frame currently being recorded
+        m_frames.resize(frameCount + 1u);
+        Clear();
+    }
+
+    unsigned int Profiler::GetHistorySize() const
+    {
+        return (unsigned int)m_frames.size() - 1u;
+    }
+
+    void Profiler::NextFrame()
+    {
+        unsigned long long now = Now();
+        if (m_inFrame)
+        {
+            Frame& frame = m_frames[m_head];
+            for (int index : m_stack) frame.zones[index].end = now;
+            frame.end = now;
+
+            m_head = (m_head + 1u) % (unsigned int)m_frames.size();
+            if (m_count < GetHistorySize()) ++m_count;
+        }
+        else
+        {
+            // Zones are only recorded on the thread that drives the frames
+            m_thread = std::this_thread::get_id();
+        }
+
+        // Clearing keeps the zone capacity, so steady state recording doesn't allocate
+        Frame& frame = m_frames[m_head];
+        frame.number = ++m_frameNumber;
+        frame.start = now;
+        frame.end = now;
+        frame.zones.clear();
+        m_stack.clear();
+        m_inFrame = true;
+    }
+
+    Profiler::ZoneToken Profiler::BeginZone(const char* name)
+    {
+        if (!m_inFrame || std::this_thread::get_id() != m_thread) return { 0ull, -1 };
+
+        Frame& frame = m_frames[m_head];
+        Zone zone = {};
+        zone.name = name;
+        zone.start = Now();
+        zone.end = zone.start;
+        zone.parent = m_stack.empty() ? -1 : m_stack.back();
+        zone.depth = (unsigned int)m_stack.size();
+
+        int index = (int)frame.zones.size();
+        frame.zones.push_back(zone);
+        m_stack.push_back(index);
+        return { frame.number, index };
+    }
+
+    void Profiler::EndZone(const ZoneToken& token)
+    {
+        // Zones still open when the frame ended were already closed by NextFrame()
+        if (token.index < 0 || token.frame != m_frameNumber || !m_inFrame) return;
+
+        Frame& frame = m_frames[m_head];
+        unsigned long long now = Now();
+        while (!m_stack.empty())
+        {
+            int index = m_stack.back();
+            m_stack.pop_back();
+            frame.zones[index].end = now;
+            if (index == token.index) break;
+        }
+    }
+
+    unsigned int Profiler::GetFrameCount() const
+    {
+        return m_count;
+    }
+
+    const Profiler::Frame& Profiler::GetFrame(unsigned int age) const
+    {
+        if (age >= m_count) throw std::out_of_range("Profiler frame is not in the history.");
+        unsigned int size = (unsigned int)m_frames.size();
+        return m_frames[(m_head + size - 1u - age) % size];
+    }
+
+    Profiler::FrameStats Profiler::GetStats() const
+    {
+        FrameStats stats = {};
+        stats.frameCount = m_count;
+        if (m_count == 0u) return stats;
+
+        std::vector<double> times(m_count);
+        double total = 0.0;
+        for (unsigned int i = 0; i < m_count; ++i)
+        {
+            times[i] = GetFrame(i).Milliseconds();
+            total += times[i];
+        }
+        std::sort(times.begin(), times.end());
+
+        // Nearest rank percentiles
+        auto percentile = [&times](double p)
+        {
+            size_t rank = (size_t)(p * times.size() + 0.5);
+            if (rank < 1) rank = 1;
+            if (rank > times.size()) rank = times.size();
+            return times[rank - 1];
+        };
+
+        stats.average = total / m_count;
+        stats.min = times.front();
+        stats.max = times.back();
+        stats.p50 = percentile(0.50);
+        stats.p95 = percentile(0.95);
+        stats.p99 = percentile(0.99);
+        return stats;
+    }
+
+    std::vector<unsigned int> Profiler::GetHistogram(double bucketMs, unsigned int bucketCount) const
+    {
+        if (bucketMs <= 0.0 || bucketCount == 0u) throw std::invalid_argument("Invalid histogram buckets.");
+
+        // The last bucket also collects every frame that is slower than the range
+        std::vector<unsigned int> buckets(bucketCount, 0u);
+        for (unsigned int i = 0; i < m_count; ++i)
+        {
+            size_t bucket = (size_t)(GetFrame(i).Milliseconds() / bucketMs);
+            if (bucket >= bucketCount) bucket = bucketCount - 1u;
+            ++buckets[bucket];
+        }
+        return buckets;
+    }
+
+    static void WriteJsonString(std::ostream& out, const char* str)
+    {
+        out << '"';
+        for (const char* c = str ? str : ""; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\') out << '\\' << *c;
+            else if ((unsigned char)*c < 0x20) out << ' ';
+            else out << *c;
+        }
+        out << '"';
+    }
+
+    static void WriteTraceEvent(std::ostream& out, const char* name, unsigned long long start, unsigned long long end,
+        bool& first)
+    {
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"name\":";
+        WriteJsonString(out, name);
+        out << ",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << start / 1000.0 << ",\"dur\":" << (end - start) / 1000.0
+            << "}";
+    }
+
+    void Profiler::ExportChromeTrace(std::ostream& out) const
+    {
+        // Complete ("X") events in microseconds, nesting is inferred by the viewer from the time ranges
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(3);
+
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        for (unsigned int age = m_count; age-- > 0u;)
+        {
+            const Frame& frame = GetFrame(age);
+            WriteTraceEvent(out, "Frame", frame.start, frame.end, first);
+            for (const Zone& zone : frame.zones)
+            {
+                WriteTraceEvent(out, zone.name, zone.start, zone.end, first);
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    void Profiler::Clear()
+    {
+        for (Frame& frame : m_frames)
+        {
+            frame.number = 0ull;
+            frame.start = frame.end = 0ull;
+            frame.zones.clear();
+        }
+        m_stack.clear();
+        m_head = 0u;
+        m_count = 0u;
+        m_inFrame = false;
+    }
+
+    unsigned long long Profiler::Now() const
+    {
+        return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::high_resolution_clock::now() - m_epoch).count();
+    }
+
+    ProfileZone::ProfileZone(const char* name) : m_token(Profiler::Get().BeginZone(name))
+    {
+    }
+
+    ProfileZone::~ProfileZone()
+    {
+        Profiler::Get().EndZone(m_token);
+    }
+}
+#endif
\ No newline at end of file
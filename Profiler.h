@@ -0,0 +1,86 @@
+#pragma once
+
+// Define ICE2D_PROFILE in the project settings to enable the profiler, otherwise the macros compile to nothing
+#ifdef ICE2D_PROFILE
+#define ICE2D_PROFILE_CONCAT_INNER(a, b) a##b
+#define ICE2D_PROFILE_CONCAT(a, b) ICE2D_PROFILE_CONCAT_INNER(a, b)
+#define ICE2D_PROFILE_SCOPE(name) Ice2D::ProfileZone ICE2D_PROFILE_CONCAT(iceProfileZone, __LINE__)(name)
+#define ICE2D_PROFILE_FRAME() Ice2D::Profiler::Get().NextFrame()
+#else
+#define ICE2D_PROFILE_SCOPE(name)
+#define ICE2D_PROFILE_FRAME()
+#endif
+
+#ifdef ICE2D_PROFILE
+#include <chrono>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace Ice2D
+{
+	class Profiler
+	{
+	public:
+		struct Zone
+		{
+			const char* name;
+			unsigned long long start, end;
+			int parent;
+			unsigned int depth;
+		};
+		struct Frame
+		{
+			unsigned long long number;
+			unsigned long long start, end;
+			std::vector<Zone> zones;
+			double Milliseconds() const;
+		};
+		struct FrameStats
+		{
+			unsigned int frameCount;
+			double average, min, max, p50, p95, p99;
+		};
+		struct ZoneToken
+		{
+			unsigned long long frame;
+			int index;
+		};
+		static Profiler& Get();
+		Profiler(const Profiler& other) = delete;
+		Profiler& operator=(const Profiler& other) = delete;
+		void SetHistorySize(unsigned int frameCount);
+		unsigned int GetHistorySize() const;
+		void NextFrame();
+		ZoneToken BeginZone(const char* name);
+		void EndZone(const ZoneToken& token);
+		unsigned int GetFrameCount() const;
+		const Frame& GetFrame(unsigned int age) const;
+		FrameStats GetStats() const;
+		std::vector<unsigned int> GetHistogram(double bucketMs, unsigned int bucketCount) const;
+		void ExportChromeTrace(std::ostream& out) const;
+		void Clear();
+	private:
+		Profiler();
+		unsigned long long Now() const;
+		std::vector<Frame> m_frames;
+		std::vector<int> m_stack;
+		unsigned int m_head, m_count;
+		unsigned long long m_frameNumber;
+		bool m_inFrame;
+		std::thread::id m_thread;
+		std::chrono::high_resolution_clock::time_point m_epoch;
+	};
+
+	class ProfileZone
+	{
+	public:
+		ProfileZone(const char* name);
+		ProfileZone(const ProfileZone& other) = delete;
+		ProfileZone& operator=(const ProfileZone& other) = delete;
+		~ProfileZone();
+	private:
+		Profiler::ZoneToken m_token;
+	};
+}
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "pch.h"
 
 #include "ResourceManager.h"
+#include "Images.h"
+#include "Sound.h"
 #include "SafeRelease.h"
 #include "HRException.h"
 
@@ -15,6 +17,10 @@ namespace Ice2D
 
 	ResourceManager::ResourceManager() : m_pRenderTarget(nullptr)
     {
+        m_registry.Reserve(256);
+        m_loadQueue.SetThreadHooks(
+            [] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },
+            [] { CoUninitialize(); });
         if (instances < 1)
         {
             HRESULT hr = CoInitialize(nullptr);
@@ -34,6 +40,8 @@ namespace Ice2D
 
     ResourceManager::~ResourceManager()
     {
+        // Loader threads use the shared factories, stop them before those go away
+        m_loadQueue.Shutdown();
         --instances;
         FreeAll();
 		SafeRelease(m_pRenderTarget);
@@ -54,12 +62,27 @@ namespace Ice2D
 
     void ResourceManager::FreeAll()
     {
-        for (IBasicResource* resource : m_trackers)
+        for (IBasicResource* resource : m_registry)
         {
             resource->Release();
             resource->m_isFree = true;
+            resource->m_pTracker = nullptr;
         }
-        m_trackers.clear();
+        m_registry.Clear();
+        m_assetCache.Clear();
+        m_brushCache.Clear();
+        m_geometryCache.Clear();
+        m_textLayoutCache.Clear();
+    }
+
+    size_t ResourceManager::GetResourceCount() const
+    {
+        return m_registry.Size();
+    }
+
+    void ResourceManager::ReserveResources(size_t count)
+    {
+        m_registry.Reserve(count);
     }
 
     ID2D1RenderTarget* ResourceManager::GetRenderTarget() const
@@ -117,8 +140,107 @@ namespace Ice2D
         return m_pMasterVoice;
     }
 
+    AssetCache& ResourceManager::GetAssetCache()
+    {
+        return m_assetCache;
+    }
+
+    BrushCache& ResourceManager::GetBrushCache()
+    {
+        return m_brushCache;
+    }
+
+    GeometryCache& ResourceManager::GetGeometryCache()
+    {
+        return m_geometryCache;
+    }
+
+    TextLayoutCache& ResourceManager::GetTextLayoutCache()
+    {
+        return m_textLayoutCache;
+    }
+
+    LoadQueue& ResourceManager::GetLoadQueue()
+    {
+        return m_loadQueue;
+    }
+
+    LoadHandle ResourceManager::LoadImageAsync(const wchar_t* path, std::function<void(D2DImage&&)> onLoaded)
+    {
+        std::wstring file(path);
+        if (m_assetCache.ContainsBitmap(path))
+        {
+            // Already decoded, only the main thread part is left
+            return m_loadQueue.Enqueue(nullptr, [this, file, onLoaded] {
+                D2DImage image(this, file.c_str());
+                if (onLoaded) onLoaded(std::move(image));
+            });
+        }
+
+        // The worker decodes into memory, the main thread only creates the bitmap
+        struct Staging
+        {
+            unsigned int width, height;
+            std::vector<BYTE> pixels;
+        };
+        auto pStaging = std::make_shared<Staging>();
+        IWICImagingFactory* pFactory = GetWICFactory();
+        return m_loadQueue.Enqueue(
+            [pFactory, file, pStaging](LoadTicket& ticket) {
+                IBasicImage::DecodeFile(pFactory, file.c_str(), pStaging->width, pStaging->height, pStaging->pixels,
+                    [&ticket](float progress) {
+                        ticket.SetProgress(progress * 0.9f);
+                        return !ticket.IsCancelled();
+                    });
+            },
+            [this, file, pStaging, onLoaded] {
+                D2DImage image(this, pStaging->width, pStaging->height, pStaging->pixels.data(), pStaging->width * 4u);
+                pStaging->pixels = std::vector<BYTE>();
+
+                // Shared through the cache like a synchronous load, so loading the file again doesn't decode it
+                m_assetCache.InsertBitmap(file.c_str(), image.Get());
+                if (m_assetCache.ContainsBitmap(file.c_str())) image = D2DImage(this, file.c_str());
+                if (onLoaded) onLoaded(std::move(image));
+            });
+    }
+
+    LoadHandle ResourceManager::LoadSoundAsync(const wchar_t* path, std::function<void(Sound&&)> onLoaded)
+    {
+        std::wstring file(path);
+        if (m_assetCache.ContainsSound(path))
+        {
+            return m_loadQueue.Enqueue(nullptr, [this, file, onLoaded] {
+                Sound sound(this, file.c_str());
+                if (onLoaded) onLoaded(std::move(sound));
+            });
+        }
+
+        auto pStaging = std::make_shared<AssetCache::SoundData>();
+        return m_loadQueue.Enqueue(
+            [file, pStaging](LoadTicket& ticket) {
+                HRESULT hr = Sound::ReadWav(file.c_str(), pStaging->format, pStaging->pData, pStaging->size);
+                CheckHR(hr);
+                ticket.SetProgress(0.9f);
+            },
+            [this, file, pStaging, onLoaded] {
+                // Sample buffers are read-only, so they can go straight into the cache
+                m_assetCache.InsertSound(file.c_str(), *pStaging);
+                Sound sound(this, pStaging->format, pStaging->pData, pStaging->size);
+                if (onLoaded) onLoaded(std::move(sound));
+            });
+    }
+
+    unsigned int ResourceManager::PumpLoads(std::chrono::microseconds budget)
+    {
+        return m_loadQueue.Pump(budget);
+    }
+
     void ResourceManager::SetRenderTarget(ID2D1RenderTarget* pRenderTarget)
     {
+        // Cached bitmaps, brushes and meshes were created by the old render target
+        m_assetCache.ClearDeviceResources();
+        m_brushCache.ClearDeviceResources();
+        m_geometryCache.ClearDeviceResources();
 		SafeRelease(m_pRenderTarget);
 		HRESULT hr = pRenderTarget->QueryInterface(&m_pRenderTarget);
         CheckHR(hr);
@@ -139,12 +261,13 @@ namespace Ice2D
         }
     }
 
-    IBasicResource::IBasicResource() : m_isFree(true), m_isLoaded(false), m_pManager(nullptr)
+    IBasicResource::IBasicResource() : m_isFree(true), m_isLoaded(false), m_trackerHandle(), m_pTracker(nullptr),
+        m_pManager(nullptr)
     {
     }
 
     IBasicResource::IBasicResource(ResourceManager* pManager) :
-        m_pManager(pManager), m_isFree(true), m_isLoaded(false)
+        m_pManager(pManager), m_isFree(true), m_isLoaded(false), m_trackerHandle(), m_pTracker(nullptr)
     {
     }
 
@@ -170,14 +293,17 @@ namespace Ice2D
     void IBasicResource::RegisterTracker()
     {
         if (!m_isFree) return;
-        m_trackerRef = m_pManager->m_trackers.insert(m_pManager->m_trackers.end(), this);
+        m_trackerHandle = m_pManager->m_registry.Add(this);
+        m_pTracker = m_pManager;
         m_isFree = false;
     }
 
     void IBasicResource::UnregisterTracker()
     {
         if (m_isFree) return;
-        m_pManager->m_trackers.erase(m_trackerRef);
+        // Unregister from the manager that tracked us, m_pManager may have been reassigned since
+        m_pTracker->m_registry.Remove(m_trackerHandle);
+        m_pTracker = nullptr;
         m_isFree = true;
     }
 
@@ -191,4 +317,22 @@ namespace Ice2D
     {
         m_isLoaded = false;
     }
+
+    void IBasicResource::OnMove(IBasicResource& other)
+    {
+        // Take over the other resource's tracker slot, the moved-from object ends up free and unloaded
+        UnregisterTracker();
+        if (!other.m_isFree)
+        {
+            m_pTracker = other.m_pTracker;
+            m_trackerHandle = other.m_trackerHandle;
+            m_pTracker->m_registry.Relocate(m_trackerHandle, this);
+            m_isFree = false;
+
+            other.m_pTracker = nullptr;
+            other.m_isFree = true;
+        }
+        m_isLoaded = other.m_isLoaded;
+        other.m_isLoaded = false;
+    }
 }
@@ -1,15 +1,22 @@
 #pragma once
 
 #include "Graphics.h"
+#include "ResourceRegistry.h"
+#include "AssetCache.h"
+#include "BrushCache.h"
+#include "GeometryCache.h"
+#include "TextLayoutCache.h"
+#include "LoadQueue.h"
 #include <d2d1.h>
 #include <dwrite.h>
 #include <wincodec.h>
 #include <xaudio2.h>
-#include <list>
 
 namespace Ice2D
 {
 	class IBasicResource;
+	class D2DImage;
+	class Sound;
 	class ResourceManager
 	{
 		friend class IBasicResource;
@@ -22,15 +29,30 @@ namespace Ice2D
 		~ResourceManager();
 	public:
 		void FreeAll();
+		size_t GetResourceCount() const;
+		void ReserveResources(size_t count);
 		ID2D1Factory* GetD2DFactory() const;
 		ID2D1RenderTarget* GetRenderTarget() const;
 		IWICImagingFactory* GetWICFactory();
 		IDWriteFactory* GetWriteFactory();
 		IXAudio2* GetXAudio();
 		IXAudio2MasteringVoice* GetMasterVoice();
+		AssetCache& GetAssetCache();
+		BrushCache& GetBrushCache();
+		GeometryCache& GetGeometryCache();
+		TextLayoutCache& GetTextLayoutCache();
+		LoadQueue& GetLoadQueue();
+		LoadHandle LoadImageAsync(const wchar_t* path, std::function<void(D2DImage&&)> onLoaded);
+		LoadHandle LoadSoundAsync(const wchar_t* path, std::function<void(Sound&&)> onLoaded);
+		unsigned int PumpLoads(std::chrono::microseconds budget);
 		void SetRenderTarget(ID2D1RenderTarget* pRenderTarget);
 	private:
-		std::list<IBasicResource*> m_trackers;
+		ResourceRegistry m_registry;
+		AssetCache m_assetCache;
+		BrushCache m_brushCache;
+		GeometryCache m_geometryCache;
+		TextLayoutCache m_textLayoutCache;
+		LoadQueue m_loadQueue;
 		ID2D1RenderTarget* m_pRenderTarget;
 		static ID2D1Factory* m_pD2DFactory;
 		static unsigned int instances;
@@ -54,12 +76,14 @@ namespace Ice2D
 		bool IsLoaded() const;
 	private:
 		bool m_isFree, m_isLoaded;
-		std::list<IBasicResource*>::iterator m_trackerRef;
+		ResourceRegistry::Handle m_trackerHandle;
+		ResourceManager* m_pTracker;
 		void RegisterTracker();
 		void UnregisterTracker();
 	protected:
 		void OnLoad();
 		void OnUnload();
+		void OnMove(IBasicResource& other);
 		ResourceManager* m_pManager;
 	};
 }
\ No newline at end of file
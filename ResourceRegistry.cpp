@@ -0,0 +1,110 @@
+#include "pch.h"
+
+#include "ResourceRegistry.h"
+
+namespace Ice2D
+{
+    // Slots are in use while their generation is odd, so a zeroed handle is never valid
+    ResourceRegistry::ResourceRegistry() : m_freeHead(NO_SLOT)
+    {
+    }
+
+    ResourceRegistry::Handle ResourceRegistry::Add(IBasicResource* pResource)
+    {
+        unsigned int index;
+        if (m_freeHead != NO_SLOT)
+        {
+            index = m_freeHead;
+            m_freeHead = m_slots[index].dense;
+        }
+        else
+        {
+            index = (unsigned int)m_slots.size();
+            m_slots.push_back({ 0u, NO_SLOT });
+        }
+
+        Slot& slot = m_slots[index];
+        ++slot.generation;
+        slot.dense = (unsigned int)m_dense.size();
+        m_dense.push_back(pResource);
+        m_denseToSlot.push_back(index);
+
+        return { index, slot.generation };
+    }
+
+    bool ResourceRegistry::Remove(const Handle& handle)
+    {
+        if (!Contains(handle)) return false;
+
+        // Swap the last dense entry into the hole to keep iteration contiguous
+        Slot& slot = m_slots[handle.index];
+        unsigned int last = (unsigned int)m_dense.size() - 1u;
+        if (slot.dense != last)
+        {
+            m_dense[slot.dense] = m_dense[last];
+            m_denseToSlot[slot.dense] = m_denseToSlot[last];
+            m_slots[m_denseToSlot[last]].dense = slot.dense;
+        }
+        m_dense.pop_back();
+        m_denseToSlot.pop_back();
+
+        ++slot.generation;
+        slot.dense = m_freeHead;
+        m_freeHead = handle.index;
+        return true;
+    }
+
+    bool ResourceRegistry::Relocate(const Handle& handle, IBasicResource* pResource)
+    {
+        if (!Contains(handle)) return false;
+        m_dense[m_slots[handle.index].dense] = pResource;
+        return true;
+    }
+
+    bool ResourceRegistry::Contains(const Handle& handle) const
+    {
+        return handle.index < m_slots.size() && (handle.generation & 1u) &&
+            m_slots[handle.index].generation == handle.generation;
+    }
+
+    IBasicResource* ResourceRegistry::Get(const Handle& handle) const
+    {
+        if (!Contains(handle)) return nullptr;
+        return m_dense[m_slots[handle.index].dense];
+    }
+
+    void ResourceRegistry::Reserve(size_t count)
+    {
+        m_slots.reserve(count);
+        m_dense.reserve(count);
+        m_denseToSlot.reserve(count);
+    }
+
+    void ResourceRegistry::Clear()
+    {
+        for (unsigned int index : m_denseToSlot)
+        {
+            Slot& slot = m_slots[index];
+            ++slot.generation;
+            slot.dense = m_freeHead;
+            m_freeHead = index;
+        }
+        m_dense.clear();
+        m_denseToSlot.clear();
+    }
+
+    size_t ResourceRegistry::Size() const
+    {
+        return m_dense.size();
+    }
+
+    IBasicResource* const* ResourceRegistry::begin() const
+    {
+        return m_dense.data();
+    }
+
+    IBasicResource* const* ResourceRegistry::end() const
+    {
+        return m_dense.data() + m_dense.size();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace Ice2D
+{
+	class IBasicResource;
+	class ResourceRegistry
+	{
+	public:
+		struct Handle
+		{
+			unsigned int index;
+			unsigned int generation;
+		};
+		ResourceRegistry();
+		ResourceRegistry(const ResourceRegistry& other) = delete;
+		ResourceRegistry& operator=(const ResourceRegistry& other) = delete;
+		Handle Add(IBasicResource* pResource);
+		bool Remove(const Handle& handle);
+		bool Relocate(const Handle& handle, IBasicResource* pResource);
+		bool Contains(const Handle& handle) const;
+		IBasicResource* Get(const Handle& handle) const;
+		void Reserve(size_t count);
+		void Clear();
+		size_t Size() const;
+		IBasicResource* const* begin() const;
+		IBasicResource* const* end() const;
+	private:
+		struct Slot
+		{
+			unsigned int generation;
+			unsigned int dense;
+		};
+		static constexpr unsigned int NO_SLOT = 0xFFFFFFFFu;
+		std::vector<Slot> m_slots;
+		std::vector<IBasicResource*> m_dense;
+		std::vector<unsigned int> m_denseToSlot;
+		unsigned int m_freeHead;
+	};
+}
\ No newline at end of file
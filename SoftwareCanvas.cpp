@@ -0,0 +1,747 @@
+#include "pch.h"
+
+#include "SoftwareCanvas.h"
+#include "PixelKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace Ice2D
+{
+    static const int SAMPLES = 16;
+    static const unsigned int PARALLEL_ROWS = 64u;
+
+    // Both halves of a packed 0x00XX00XX pair divided by 255 with rounding
+    static inline uint32_t Div255Pair(uint32_t x)
+    {
+        x += 0x00800080u;
+        return ((x + ((x >> 8) & 0x00FF00FFu)) >> 8) & 0x00FF00FFu;
+    }
+
+    // Premultiplied color times a 0-255 factor
+    static inline uint32_t Scale(uint32_t color, uint32_t factor)
+    {
+        return Div255Pair((color & 0x00FF00FFu) * factor) | Div255Pair(((color >> 8) & 0x00FF00FFu) * factor) << 8;
+    }
+
+    static inline uint32_t Over(uint32_t src, uint32_t dst)
+    {
+        return src + Scale(dst, 255u - (src >> 24));
+    }
+
+    static inline uint32_t Lerp(uint32_t a, uint32_t b, uint32_t weight)
+    {
+        // weight is 0-256
+        uint32_t rb = ((a & 0x00FF00FFu) * (256u - weight) + (b & 0x00FF00FFu) * weight) >> 8;
+        uint32_t ag = (((a >> 8) & 0x00FF00FFu) * (256u - weight) + ((b >> 8) & 0x00FF00FFu) * weight) >> 8;
+        return (rb & 0x00FF00FFu) | (ag & 0x00FF00FFu) << 8;
+    }
+
+    static inline uint32_t ToByte(float value)
+    {
+        return value <= 0.0f ? 0u : value >= 1.0f ? 255u : (uint32_t)(value * 255.0f + 0.5f);
+    }
+
+    // Crossings arrive almost in order, where this beats a general sort
+    template <typename T>
+    static void InsertionSort(std::vector<T>& items)
+    {
+        for (size_t i = 1u; i < items.size(); ++i)
+        {
+            T item = items[i];
+            size_t j = i;
+            for (; j > 0u && item.x < items[j - 1u].x; --j) items[j] = items[j - 1u];
+            items[j] = item;
+        }
+    }
+
+    // Joins the span to the previous one when they touch and have the same coverage
+    template <typename T>
+    static inline void AddSpan(std::vector<T>& spans, int x, int count, uint32_t coverage)
+    {
+        if (!spans.empty() && spans.back().coverage == coverage && spans.back().x + spans.back().count == x)
+        {
+            spans.back().count += count;
+            return;
+        }
+        spans.push_back({ x, count, coverage });
+    }
+
+    SoftwareCanvas::Paint::Paint() : m_type(Type::Solid), m_color(0u), m_x0(0.0f), m_y0(0.0f), m_x1(0.0f),
+        m_y1(0.0f), m_radiusX(0.0f), m_radiusY(0.0f), m_pPixels(nullptr), m_width(0u), m_height(0u), m_stride(0u),
+        m_transform(Matrix2D::Identity()), m_opacity(1.0f), m_bilinear(true)
+    {
+    }
+
+    SoftwareCanvas::Paint SoftwareCanvas::Paint::Solid(const Color& color)
+    {
+        Paint paint;
+        paint.m_color = Premultiply(color);
+        return paint;
+    }
+
+    SoftwareCanvas::Paint SoftwareCanvas::Paint::Linear(float startX, float startY, float endX, float endY,
+        const GradientStop* pStops, unsigned int count)
+    {
+        Paint paint;
+        paint.m_type = Type::Linear;
+        paint.m_x0 = startX;
+        paint.m_y0 = startY;
+        paint.m_x1 = endX;
+        paint.m_y1 = endY;
+        paint.BuildRamp(pStops, count);
+        return paint;
+    }
+
+    SoftwareCanvas::Paint SoftwareCanvas::Paint::Radial(float centerX, float centerY, float radiusX, float radiusY,
+        const GradientStop* pStops, unsigned int count, float offsetX, float offsetY)
+    {
+        // Same parameters as a Direct2D radial gradient, the offset moves the origin away from the center
+        Paint paint;
+        paint.m_type = Type::Radial;
+        paint.m_x0 = centerX;
+        paint.m_y0 = centerY;
+        paint.m_x1 = offsetX;
+        paint.m_y1 = offsetY;
+        paint.m_radiusX = radiusX;
+        paint.m_radiusY = radiusY;
+        paint.BuildRamp(pStops, count);
+        return paint;
+    }
+
+    SoftwareCanvas::Paint SoftwareCanvas::Paint::Bitmap(const uint32_t* pPixels, unsigned int width,
+        unsigned int height, size_t stride, const Matrix2D& transform, bool bilinear)
+    {
+        if (!pPixels || width == 0u || height == 0u) throw std::runtime_error("Paint bitmap is null.");
+        Paint paint;
+        paint.m_type = Type::Bitmap;
+        paint.m_pPixels = pPixels;
+        paint.m_width = width;
+        paint.m_height = height;
+        paint.m_stride = stride;
+        paint.m_transform = transform;
+        paint.m_bilinear = bilinear;
+        return paint;
+    }
+
+    SoftwareCanvas::Paint::Type SoftwareCanvas::Paint::GetType() const
+    {
+        return m_type;
+    }
+
+    void SoftwareCanvas::Paint::SetOpacity(float opacity)
+    {
+        m_opacity = opacity;
+    }
+
+    float SoftwareCanvas::Paint::GetOpacity() const
+    {
+        return m_opacity;
+    }
+
+    void SoftwareCanvas::Paint::BuildRamp(const GradientStop* pStops, unsigned int count)
+    {
+        // 256 premultiplied entries, interpolated between stops in straight alpha and clamped at the ends
+        if (!pStops || count == 0u) throw std::runtime_error("Gradient stops are null.");
+        std::vector<GradientStop> stops(pStops, pStops + count);
+        std::stable_sort(stops.begin(), stops.end(),
+            [](const GradientStop& a, const GradientStop& b) { return a.position < b.position; });
+        m_ramp.resize(256u);
+        size_t next = 0u;
+        for (unsigned int i = 0u; i < 256u; ++i)
+        {
+            float t = i / 255.0f;
+            while (next < stops.size() && stops[next].position <= t) ++next;
+            Color color;
+            if (next == 0u)
+            {
+                color = stops.front().color;
+            }
+            else if (next == stops.size())
+            {
+                color = stops.back().color;
+            }
+            else
+            {
+                const GradientStop& a = stops[next - 1u];
+                const GradientStop& b = stops[next];
+                float span = b.position - a.position;
+                float w = span > 0.0f ? (t - a.position) / span : 1.0f;
+                color = { a.color.r + (b.color.r - a.color.r) * w, a.color.g + (b.color.g - a.color.g) * w,
+                    a.color.b + (b.color.b - a.color.b) * w, a.color.a + (b.color.a - a.color.a) * w };
+            }
+            m_ramp[i] = Premultiply(color);
+        }
+    }
+
+    SoftwareCanvas::SoftwareCanvas(uint32_t* pPixels, unsigned int width, unsigned int height, size_t stride,
+        ThreadPool* pPool) : m_pPixels(pPixels), m_width(width), m_height(height), m_stride(stride), m_pPool(pPool),
+        m_transform(Matrix2D::Identity()), m_antialias(true), m_stats()
+    {
+        if (!pPixels) throw std::runtime_error("Canvas pixels are null.");
+        if (stride < (size_t)width * 4u) throw std::runtime_error("Canvas stride is too small.");
+        ResetClip();
+    }
+
+    unsigned int SoftwareCanvas::GetWidth() const
+    {
+        return m_width;
+    }
+
+    unsigned int SoftwareCanvas::GetHeight() const
+    {
+        return m_height;
+    }
+
+    void SoftwareCanvas::SetTransform(const Matrix2D& transform)
+    {
+        m_transform = transform;
+    }
+
+    const Matrix2D& SoftwareCanvas::GetTransform() const
+    {
+        return m_transform;
+    }
+
+    void SoftwareCanvas::SetAntialias(bool antialias)
+    {
+        m_antialias = antialias;
+    }
+
+    bool SoftwareCanvas::GetAntialias() const
+    {
+        return m_antialias;
+    }
+
+    void SoftwareCanvas::SetClip(int left, int top, int right, int bottom)
+    {
+        // Device pixels, unaffected by the transform
+        m_clipLeft = std::max(left, 0);
+        m_clipTop = std::max(top, 0);
+        m_clipRight = std::max(m_clipLeft, std::min(right, (int)m_width));
+        m_clipBottom = std::max(m_clipTop, std::min(bottom, (int)m_height));
+    }
+
+    void SoftwareCanvas::ResetClip()
+    {
+        SetClip(0, 0, (int)m_width, (int)m_height);
+    }
+
+    void SoftwareCanvas::Clear(const Color& color)
+    {
+        if (m_clipRight <= m_clipLeft || m_clipBottom <= m_clipTop) return;
+        uint32_t* pStart = reinterpret_cast<uint32_t*>(reinterpret_cast<unsigned char*>(m_pPixels) +
+            m_stride * m_clipTop) + m_clipLeft;
+        PixelKernels::Fill(pStart, m_stride, m_clipRight - m_clipLeft, m_clipBottom - m_clipTop, Premultiply(color));
+    }
+
+    void SoftwareCanvas::FillRect(float left, float top, float right, float bottom, const Paint& paint)
+    {
+        m_path.Clear();
+        m_path.AddRect(left, top, right, bottom);
+        Fill(m_path, paint);
+    }
+
+    void SoftwareCanvas::FillRoundedRect(float left, float top, float right, float bottom, float radiusX,
+        float radiusY, const Paint& paint)
+    {
+        m_path.Clear();
+        m_path.AddRoundedRect(left, top, right, bottom, radiusX, radiusY);
+        Fill(m_path, paint);
+    }
+
+    void SoftwareCanvas::FillEllipse(float centerX, float centerY, float radiusX, float radiusY, const Paint& paint)
+    {
+        m_path.Clear();
+        m_path.AddEllipse(centerX, centerY, radiusX, radiusY);
+        Fill(m_path, paint);
+    }
+
+    void SoftwareCanvas::FillPath(const PathData& path, const Paint& paint)
+    {
+        Fill(path, paint);
+    }
+
+    void SoftwareCanvas::DrawLine(float x0, float y0, float x1, float y1, const Paint& paint, float strokeWidth)
+    {
+        PathData::Point points[2] = { { x0, y0 }, { x1, y1 } };
+        DrawPolyline(points, 2u, false, paint, strokeWidth);
+    }
+
+    void SoftwareCanvas::DrawRect(float left, float top, float right, float bottom, const Paint& paint,
+        float strokeWidth)
+    {
+        PathData::Point points[4] = { { left, top }, { right, top }, { right, bottom }, { left, bottom } };
+        DrawPolyline(points, 4u, true, paint, strokeWidth);
+    }
+
+    void SoftwareCanvas::DrawEllipse(float centerX, float centerY, float radiusX, float radiusY, const Paint& paint,
+        float strokeWidth)
+    {
+        m_path.Clear();
+        m_path.AddEllipse(centerX, centerY, radiusX, radiusY);
+        StrokePath(m_path, paint, strokeWidth);
+    }
+
+    void SoftwareCanvas::DrawPolyline(const PathData::Point* pPoints, unsigned int count, bool closed,
+        const Paint& paint, float strokeWidth)
+    {
+        m_path.Clear();
+        m_path.AddPolygon(pPoints, count, closed);
+        StrokePath(m_path, paint, strokeWidth);
+    }
+
+    void SoftwareCanvas::StrokePath(const PathData& path, const Paint& paint, float strokeWidth)
+    {
+        // The width is in user space like Direct2D's, so it scales with the transform
+        Fill(path.Widen(strokeWidth), paint);
+    }
+
+    void SoftwareCanvas::DrawBitmap(const uint32_t* pPixels, unsigned int width, unsigned int height, size_t stride,
+        float left, float top, float right, float bottom, float opacity, bool bilinear)
+    {
+        Matrix2D place = Matrix2D::Scale((right - left) / width, (bottom - top) / height) *
+            Matrix2D::Translation(left, top);
+        Paint paint = Paint::Bitmap(pPixels, width, height, stride, place, bilinear);
+        paint.SetOpacity(opacity);
+        FillRect(left, top, right, bottom, paint);
+    }
+
+    const SoftwareCanvas::Stats& SoftwareCanvas::GetStats() const
+    {
+        return m_stats;
+    }
+
+    void SoftwareCanvas::ResetStats()
+    {
+        m_stats = {};
+    }
+
+    uint32_t SoftwareCanvas::Premultiply(const Color& color)
+    {
+        float a = color.a <= 0.0f ? 0.0f : color.a >= 1.0f ? 1.0f : color.a;
+        return ToByte(a) << 24 | ToByte(color.r * a) << 16 | ToByte(color.g * a) << 8 | ToByte(color.b * a);
+    }
+
+    void SoftwareCanvas::Fill(const PathData& path, const Paint& paint)
+    {
+        // Edges in device space, every figure is closed for filling like Direct2D does
+        m_edges.clear();
+        float minY = 0.0f, maxY = 0.0f;
+        const std::vector<PathData::Point>& points = path.GetPoints();
+        for (const PathData::Figure& figure : path.GetFigures())
+        {
+            if (figure.count < 2u) continue;
+            for (unsigned int i = 0u; i < figure.count; ++i)
+            {
+                PathData::Point a = points[figure.first + i];
+                PathData::Point b = points[figure.first + (i + 1u) % figure.count];
+                m_transform.Transform(a.x, a.y);
+                m_transform.Transform(b.x, b.y);
+                if (a.y == b.y || !std::isfinite(a.x + a.y + b.x + b.y)) continue;
+                int winding = 1;
+                if (a.y > b.y)
+                {
+                    std::swap(a, b);
+                    winding = -1;
+                }
+                if (m_edges.empty())
+                {
+                    minY = a.y;
+                    maxY = b.y;
+                }
+                minY = std::min(minY, a.y);
+                maxY = std::max(maxY, b.y);
+                m_edges.push_back({ a.x, a.y, b.y, (b.x - a.x) / (b.y - a.y), winding });
+            }
+        }
+        if (m_edges.empty()) return;
+        std::sort(m_edges.begin(), m_edges.end(), [](const Edge& a, const Edge& b) { return a.y0 < b.y0; });
+
+        const int top = std::max(m_clipTop, (int)std::floor(std::max(minY, -1.0f)));
+        const int bottom = std::min(m_clipBottom, (int)std::ceil(std::min(maxY, (float)m_height + 1.0f)));
+        if (bottom <= top || m_clipRight <= m_clipLeft) return;
+
+        // Gradients and bitmaps are sampled by mapping device pixels back into paint space
+        Matrix2D inverse = Matrix2D::Identity();
+        uint32_t color = 0u;
+        if (paint.m_type == Paint::Type::Solid)
+        {
+            color = Scale(paint.m_color, ToByte(paint.m_opacity));
+            if (color == 0u) return;
+        }
+        else
+        {
+            Matrix2D toDevice = paint.m_type == Paint::Type::Bitmap ? paint.m_transform * m_transform : m_transform;
+            if (!toDevice.Invert(inverse)) return;
+        }
+
+        ++m_stats.fills;
+        const PathData::FillMode mode = path.GetFillMode();
+        if (!m_pPool || m_pPool->GetThreadCount() < 2u || (unsigned int)(bottom - top) < PARALLEL_ROWS)
+        {
+            m_stats.pixels += RasterizeRows(top, bottom, mode, paint, color, inverse, m_scratch);
+            return;
+        }
+
+        // Each chunk owns a run of rows, so the result doesn't depend on the thread count
+        std::atomic<unsigned long long> pixels(0u);
+        m_pPool->ParallelFor((unsigned int)top, (unsigned int)bottom, [&](unsigned int begin, unsigned int end)
+        {
+            Scratch scratch;
+            pixels += RasterizeRows((int)begin, (int)end, mode, paint, color, inverse, scratch);
+        }, PARALLEL_ROWS / 2u);
+        m_stats.pixels += pixels;
+    }
+
+    unsigned long long SoftwareCanvas::RasterizeRows(int begin, int end, PathData::FillMode mode, const Paint& paint,
+        uint32_t color, const Matrix2D& inverse, Scratch& scratch) const
+    {
+        scratch.cover.resize(m_width + 2u, 0.0f);
+        scratch.area.resize(m_width + 2u, 0.0f);
+        if (paint.m_type != Paint::Type::Solid) scratch.shade.resize(m_width);
+        scratch.active.clear();
+
+        unsigned long long pixels = 0u;
+        size_t next = 0u;
+        for (int y = begin; y < end; ++y)
+        {
+            // Edges become active once they reach the row and drop out below their end
+            const float rowTop = (float)y, rowBottom = (float)(y + 1);
+            while (next < m_edges.size() && m_edges[next].y0 < rowBottom)
+            {
+                if (m_edges[next].y1 > rowTop) scratch.active.push_back(&m_edges[next]);
+                ++next;
+            }
+            scratch.active.erase(std::remove_if(scratch.active.begin(), scratch.active.end(),
+                [rowTop](const Edge* pEdge) { return pEdge->y1 <= rowTop; }), scratch.active.end());
+            if (scratch.active.empty())
+            {
+                if (next == m_edges.size()) break;
+                continue;
+            }
+
+            // Kept in x order at the row's center, so the crossings of each sub-scanline are nearly sorted
+            const float rowCenter = rowTop + 0.5f;
+            for (size_t i = 1u; i < scratch.active.size(); ++i)
+            {
+                const Edge* pEdge = scratch.active[i];
+                float x = pEdge->x0 + (rowCenter - pEdge->y0) * pEdge->dxdy;
+                size_t j = i;
+                for (; j > 0u; --j)
+                {
+                    const Edge* pPrevious = scratch.active[j - 1u];
+                    if (pPrevious->x0 + (rowCenter - pPrevious->y0) * pPrevious->dxdy <= x) break;
+                    scratch.active[j] = pPrevious;
+                }
+                scratch.active[j] = pEdge;
+            }
+
+            scratch.spans.clear();
+            if (!m_antialias || !AccumulateRow(rowTop, mode, scratch)) SampleRow(rowTop, mode, scratch);
+
+            uint32_t* pRow = reinterpret_cast<uint32_t*>(reinterpret_cast<unsigned char*>(m_pPixels) + m_stride * y);
+            for (const Span& span : scratch.spans)
+            {
+                pixels += Composite(pRow, y, span, paint, color, inverse, scratch);
+            }
+        }
+        return pixels;
+    }
+
+    bool SoftwareCanvas::AccumulateRow(float rowTop, PathData::FillMode mode, Scratch& scratch) const
+    {
+        // Without vertices inside the row and with edges that don't cross in it, the row is a set of trapezoids
+        // and each boundary edge adds its exact area, one pass instead of a pass per sub-scanline
+        const float rowBottom = rowTop + 1.0f;
+        const float clipLeft = (float)m_clipLeft, clipRight = (float)m_clipRight;
+        scratch.boundaries.clear();
+        int winding = 0;
+        float lastTop = -1e30f, lastBottom = -1e30f;
+        for (const Edge* pEdge : scratch.active)
+        {
+            if (pEdge->y0 > rowTop || pEdge->y1 < rowBottom) return false;
+            float top = pEdge->x0 + (rowTop - pEdge->y0) * pEdge->dxdy;
+            float bottom = top + pEdge->dxdy;
+            if (top < lastTop || bottom < lastBottom) return false;
+            lastTop = top;
+            lastBottom = bottom;
+
+            // Only edges where the inside changes are boundaries, +1 entering and -1 leaving
+            bool before = mode == PathData::FillMode::Winding ? winding != 0 : (winding & 1) != 0;
+            winding += pEdge->winding;
+            bool after = mode == PathData::FillMode::Winding ? winding != 0 : (winding & 1) != 0;
+            if (before == after) continue;
+            if (std::min(top, bottom) < clipLeft || std::max(top, bottom) > clipRight) return false;
+            scratch.boundaries.push_back({ top, bottom, after ? 1.0f : -1.0f });
+        }
+        if (winding != 0 && mode == PathData::FillMode::Winding) return false;
+
+        // Each boundary touches the cells under it, left of them the coverage is whatever it was and right
+        // of them it has moved by the boundary's sign
+        float* pArea = scratch.area.data();
+        for (const Boundary& boundary : scratch.boundaries)
+        {
+            const float x0 = std::min(boundary.top, boundary.bottom), x1 = std::max(boundary.top, boundary.bottom);
+            const float sign = boundary.sign;
+            const float x0Floor = std::floor(x0), x1Ceil = std::ceil(x1);
+            const int i0 = (int)x0Floor, i1 = (int)x1Ceil;
+            if (i1 <= i0 + 1)
+            {
+                float middle = 0.5f * (x0 + x1) - x0Floor;
+                pArea[i0] += sign * (1.0f - middle);
+                pArea[i0 + 1] += sign * middle;
+                continue;
+            }
+            const float slope = 1.0f / (x1 - x0);
+            const float f0 = x0 - x0Floor, f1 = x1 - x1Ceil + 1.0f;
+            const float a0 = 0.5f * slope * (1.0f - f0) * (1.0f - f0);
+            const float am = 0.5f * slope * f1 * f1;
+            pArea[i0] += sign * a0;
+            if (i1 == i0 + 2)
+            {
+                pArea[i0 + 1] += sign * (1.0f - a0 - am);
+            }
+            else
+            {
+                const float a1 = slope * (1.5f - f0);
+                pArea[i0 + 1] += sign * (a1 - a0);
+                for (int i = i0 + 2; i < i1 - 1; ++i) pArea[i] += sign * slope;
+                const float a2 = a1 + (i1 - i0 - 3) * slope;
+                pArea[i1 - 1] += sign * (1.0f - a2 - am);
+            }
+            pArea[i1] += sign * am;
+        }
+
+        // Walks the touched cells of each boundary, the gaps between boundaries have constant coverage
+        float running = 0.0f;
+        int x = -1;
+        for (size_t i = 0u; i < scratch.boundaries.size(); ++i)
+        {
+            const Boundary& boundary = scratch.boundaries[i];
+            const int first = std::max((int)std::floor(std::min(boundary.top, boundary.bottom)), x + 1);
+            const int last = (int)std::ceil(std::max(boundary.top, boundary.bottom));
+            for (x = first; x <= last; ++x)
+            {
+                running += pArea[x];
+                pArea[x] = 0.0f;
+                uint32_t cell = ToByte(std::fabs(running));
+                if (cell != 0u && x < m_clipRight) AddSpan(scratch.spans, x, 1, cell);
+            }
+            x = std::max(x - 1, first - 1);
+            if (i + 1u < scratch.boundaries.size())
+            {
+                const Boundary& nextBoundary = scratch.boundaries[i + 1u];
+                const int gapEnd = std::min((int)std::floor(std::min(nextBoundary.top, nextBoundary.bottom)),
+                    m_clipRight);
+                uint32_t run = ToByte(std::fabs(running));
+                if (run != 0u && gapEnd > x + 1) AddSpan(scratch.spans, x + 1, gapEnd - x - 1, run);
+            }
+        }
+        return true;
+    }
+
+    void SoftwareCanvas::SampleRow(float rowTop, PathData::FillMode mode, Scratch& scratch) const
+    {
+        // Exact horizontal coverage on each sub-scanline, as partial cells plus a running delta. Only the
+        // cells where something changes are remembered, the coverage between them is constant
+        const int samples = m_antialias ? SAMPLES : 1;
+        const float sampleStep = 1.0f / samples;
+        const float clipLeft = (float)m_clipLeft, clipRight = (float)m_clipRight;
+        float* pCover = scratch.cover.data();
+        float* pArea = scratch.area.data();
+        scratch.cells.clear();
+        for (int s = 0; s < samples; ++s)
+        {
+            const float sy = rowTop + (s + 0.5f) * sampleStep;
+            scratch.crossings.clear();
+            for (const Edge* pEdge : scratch.active)
+            {
+                if (pEdge->y0 <= sy && sy < pEdge->y1)
+                {
+                    scratch.crossings.push_back({ pEdge->x0 + (sy - pEdge->y0) * pEdge->dxdy, pEdge->winding });
+                }
+            }
+            InsertionSort(scratch.crossings);
+
+            int winding = 0;
+            for (size_t i = 0u; i + 1u < scratch.crossings.size(); ++i)
+            {
+                winding += scratch.crossings[i].winding;
+                bool inside = mode == PathData::FillMode::Winding ? winding != 0 : (winding & 1) != 0;
+                if (!inside) continue;
+                float xa = std::max(scratch.crossings[i].x, clipLeft);
+                float xb = std::min(scratch.crossings[i + 1u].x, clipRight);
+                if (xb <= xa) continue;
+                if (!m_antialias)
+                {
+                    // Pixels whose centers are inside the span
+                    int ia = (int)std::ceil(xa - 0.5f), ib = (int)std::ceil(xb - 0.5f);
+                    if (ib <= ia) continue;
+                    pCover[ia] += 1.0f;
+                    pCover[ib] -= 1.0f;
+                    scratch.cells.push_back(ia);
+                    scratch.cells.push_back(ib);
+                    continue;
+                }
+                int ia = (int)xa, ib = (int)xb;
+                scratch.cells.push_back(ia);
+                if (ia == ib)
+                {
+                    pArea[ia] += xb - xa;
+                    continue;
+                }
+                pArea[ia] += (float)(ia + 1) - xa;
+                pCover[ia + 1] += 1.0f;
+                pCover[ib] -= 1.0f;
+                pArea[ib] += xb - (float)ib;
+                scratch.cells.push_back(ia + 1);
+                scratch.cells.push_back(ib);
+            }
+        }
+        if (scratch.cells.empty()) return;
+
+        const auto bounds = std::minmax_element(scratch.cells.begin(), scratch.cells.end());
+        const int firstCell = *bounds.first, lastCell = *bounds.second;
+        float running = 0.0f;
+        if (lastCell - firstCell < (int)scratch.cells.size() * 4 + 16)
+        {
+            // Narrow rows like thin strokes are cheaper to walk than to sort
+            for (int x = firstCell; x <= lastCell; ++x)
+            {
+                running += pCover[x];
+                uint32_t cell = ToByte((running + pArea[x]) * sampleStep);
+                pCover[x] = 0.0f;
+                pArea[x] = 0.0f;
+                if (cell != 0u && x < m_clipRight) AddSpan(scratch.spans, x, 1, cell);
+            }
+            return;
+        }
+
+        // Each remembered cell is one pixel, followed by a run of constant coverage up to the next cell
+        std::sort(scratch.cells.begin(), scratch.cells.end());
+        scratch.cells.erase(std::unique(scratch.cells.begin(), scratch.cells.end()), scratch.cells.end());
+        for (size_t i = 0u; i < scratch.cells.size(); ++i)
+        {
+            const int x = scratch.cells[i];
+            running += pCover[x];
+            uint32_t cell = ToByte((running + pArea[x]) * sampleStep);
+            uint32_t run = ToByte(running * sampleStep);
+            pCover[x] = 0.0f;
+            pArea[x] = 0.0f;
+            if (x >= m_clipRight) continue;
+            if (cell != 0u) AddSpan(scratch.spans, x, 1, cell);
+            const int runEnd = std::min(i + 1u < scratch.cells.size() ? scratch.cells[i + 1u] : x + 1, m_clipRight);
+            if (run != 0u && runEnd > x + 1) AddSpan(scratch.spans, x + 1, runEnd - x - 1, run);
+        }
+    }
+
+    unsigned long long SoftwareCanvas::Composite(uint32_t* pRow, int y, const Span& span, const Paint& paint,
+        uint32_t color, const Matrix2D& inverse, Scratch& scratch) const
+    {
+        uint32_t* pDst = pRow + span.x;
+        if (paint.m_type == Paint::Type::Solid)
+        {
+            // Fully covered runs of an opaque color are plain fills
+            if (span.coverage == 255u && color >> 24 == 255u)
+            {
+                PixelKernels::Fill(pDst, m_stride, span.count, 1u, color);
+                return span.count;
+            }
+            const uint32_t src = span.coverage == 255u ? color : Scale(color, span.coverage);
+            const uint32_t inverseAlpha = 255u - (src >> 24);
+            for (int i = 0; i < span.count; ++i) pDst[i] = src + Scale(pDst[i], inverseAlpha);
+            return span.count;
+        }
+
+        uint32_t coverage = span.coverage;
+        const uint32_t opacity = ToByte(paint.m_opacity);
+        if (opacity != 255u) coverage = Div255Pair(coverage * opacity) & 0xFFu;
+        if (coverage == 0u) return 0u;
+        uint32_t* pShade = scratch.shade.data();
+        Shade(paint, inverse, span.x, y, span.count, pShade);
+        if (coverage == 255u)
+        {
+            for (int i = 0; i < span.count; ++i) pDst[i] = Over(pShade[i], pDst[i]);
+        }
+        else
+        {
+            for (int i = 0; i < span.count; ++i) pDst[i] = Over(Scale(pShade[i], coverage), pDst[i]);
+        }
+        return span.count;
+    }
+
+    void SoftwareCanvas::Shade(const Paint& paint, const Matrix2D& inverse, int x, int y, int count,
+        uint32_t* pOut) const
+    {
+        // Paint space position of the first pixel center, stepping one device pixel to the right each time
+        float px = x + 0.5f, py = y + 0.5f;
+        inverse.Transform(px, py);
+        const float stepX = inverse.m11, stepY = inverse.m12;
+
+        if (paint.m_type == Paint::Type::Linear)
+        {
+            const float dx = paint.m_x1 - paint.m_x0, dy = paint.m_y1 - paint.m_y0;
+            const float length = dx * dx + dy * dy;
+            const float scale = length > 0.0f ? 255.0f / length : 0.0f;
+            float t = ((px - paint.m_x0) * dx + (py - paint.m_y0) * dy) * scale;
+            const float dt = (stepX * dx + stepY * dy) * scale;
+            for (int i = 0; i < count; ++i, t += dt)
+            {
+                int index = (int)(t + 0.5f);
+                pOut[i] = paint.m_ramp[index < 0 ? 0 : index > 255 ? 255 : index];
+            }
+        }
+        else if (paint.m_type == Paint::Type::Radial)
+        {
+            // Circles of radius t around (1 - t) * origin in unit space, solved for the one through the pixel
+            const float rx = paint.m_radiusX != 0.0f ? paint.m_radiusX : 1e-6f;
+            const float ry = paint.m_radiusY != 0.0f ? paint.m_radiusY : 1e-6f;
+            float fx = paint.m_x1 / rx, fy = paint.m_y1 / ry;
+            float f2 = fx * fx + fy * fy;
+            if (f2 > 0.998f)
+            {
+                float scale = std::sqrt(0.998f / f2);
+                fx *= scale;
+                fy *= scale;
+                f2 = 0.998f;
+            }
+            const float a = 1.0f - f2;
+            for (int i = 0; i < count; ++i, px += stepX, py += stepY)
+            {
+                float dx = (px - paint.m_x0) / rx - fx, dy = (py - paint.m_y0) / ry - fy;
+                float b = dx * fx + dy * fy;
+                float t = (b + std::sqrt(b * b + a * (dx * dx + dy * dy))) / a;
+                int index = (int)(t * 255.0f + 0.5f);
+                pOut[i] = paint.m_ramp[index < 0 ? 0 : index > 255 ? 255 : index];
+            }
+        }
+        else
+        {
+            // Clamped at the edges like Direct2D's default extend mode
+            const unsigned char* pBase = reinterpret_cast<const unsigned char*>(paint.m_pPixels);
+            const int maxX = (int)paint.m_width - 1, maxY = (int)paint.m_height - 1;
+            auto texel = [&](int tx, int ty)
+            {
+                tx = tx < 0 ? 0 : tx > maxX ? maxX : tx;
+                ty = ty < 0 ? 0 : ty > maxY ? maxY : ty;
+                return reinterpret_cast<const uint32_t*>(pBase + paint.m_stride * ty)[tx];
+            };
+            for (int i = 0; i < count; ++i, px += stepX, py += stepY)
+            {
+                if (!paint.m_bilinear)
+                {
+                    pOut[i] = texel((int)std::floor(px), (int)std::floor(py));
+                    continue;
+                }
+                float sx = px - 0.5f, sy = py - 0.5f;
+                float fx = std::floor(sx), fy = std::floor(sy);
+                int tx = (int)fx, ty = (int)fy;
+                uint32_t wx = (uint32_t)((sx - fx) * 256.0f), wy = (uint32_t)((sy - fy) * 256.0f);
+                uint32_t top = Lerp(texel(tx, ty), texel(tx + 1, ty), wx);
+                uint32_t bottom = Lerp(texel(tx, ty + 1), texel(tx + 1, ty + 1), wx);
+                pOut[i] = Lerp(top, bottom, wy);
+            }
+        }
+    }
+}
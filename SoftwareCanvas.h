@@ -0,0 +1,133 @@
+#pragma once
+#include "PathData.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Ice2D
+{
+	class SoftwareCanvas
+	{
+	public:
+		struct Color
+		{
+			float r, g, b, a;
+		};
+		struct GradientStop
+		{
+			float position;
+			Color color;
+		};
+		class Paint
+		{
+			friend class SoftwareCanvas;
+		public:
+			enum class Type { Solid, Linear, Radial, Bitmap };
+			Paint();
+			static Paint Solid(const Color& color);
+			static Paint Linear(float startX, float startY, float endX, float endY,
+				const GradientStop* pStops, unsigned int count);
+			static Paint Radial(float centerX, float centerY, float radiusX, float radiusY,
+				const GradientStop* pStops, unsigned int count, float offsetX = 0.0f, float offsetY = 0.0f);
+			static Paint Bitmap(const uint32_t* pPixels, unsigned int width, unsigned int height, size_t stride,
+				const Matrix2D& transform = Matrix2D::Identity(), bool bilinear = true);
+			Type GetType() const;
+			void SetOpacity(float opacity);
+			float GetOpacity() const;
+		private:
+			Type m_type;
+			uint32_t m_color;
+			std::vector<uint32_t> m_ramp;
+			float m_x0, m_y0, m_x1, m_y1, m_radiusX, m_radiusY;
+			const uint32_t* m_pPixels;
+			unsigned int m_width, m_height;
+			size_t m_stride;
+			Matrix2D m_transform;
+			float m_opacity;
+			bool m_bilinear;
+			void BuildRamp(const GradientStop* pStops, unsigned int count);
+		};
+		struct Stats
+		{
+			unsigned long long fills, pixels;
+		};
+		SoftwareCanvas(uint32_t* pPixels, unsigned int width, unsigned int height, size_t stride,
+			ThreadPool* pPool = nullptr);
+		unsigned int GetWidth() const;
+		unsigned int GetHeight() const;
+		void SetTransform(const Matrix2D& transform);
+		const Matrix2D& GetTransform() const;
+		void SetAntialias(bool antialias);
+		bool GetAntialias() const;
+		void SetClip(int left, int top, int right, int bottom);
+		void ResetClip();
+		void Clear(const Color& color);
+		void FillRect(float left, float top, float right, float bottom, const Paint& paint);
+		void FillRoundedRect(float left, float top, float right, float bottom, float radiusX, float radiusY,
+			const Paint& paint);
+		void FillEllipse(float centerX, float centerY, float radiusX, float radiusY, const Paint& paint);
+		void FillPath(const PathData& path, const Paint& paint);
+		void DrawLine(float x0, float y0, float x1, float y1, const Paint& paint, float strokeWidth = 1.0f);
+		void DrawRect(float left, float top, float right, float bottom, const Paint& paint, float strokeWidth = 1.0f);
+		void DrawEllipse(float centerX, float centerY, float radiusX, float radiusY, const Paint& paint,
+			float strokeWidth = 1.0f);
+		void DrawPolyline(const PathData::Point* pPoints, unsigned int count, bool closed, const Paint& paint,
+			float strokeWidth = 1.0f);
+		void StrokePath(const PathData& path, const Paint& paint, float strokeWidth = 1.0f);
+		void DrawBitmap(const uint32_t* pPixels, unsigned int width, unsigned int height, size_t stride,
+			float left, float top, float right, float bottom, float opacity = 1.0f, bool bilinear = true);
+		const Stats& GetStats() const;
+		void ResetStats();
+		static uint32_t Premultiply(const Color& color);
+	private:
+		struct Edge
+		{
+			float x0, y0, y1, dxdy;
+			int winding;
+		};
+		struct Crossing
+		{
+			float x;
+			int winding;
+		};
+		struct Boundary
+		{
+			float top, bottom, sign;
+		};
+		struct Span
+		{
+			int x, count;
+			uint32_t coverage;
+		};
+		struct Scratch
+		{
+			std::vector<float> cover, area;
+			std::vector<int> cells;
+			std::vector<Span> spans;
+			std::vector<uint32_t> shade;
+			std::vector<const Edge*> active;
+			std::vector<Crossing> crossings;
+			std::vector<Boundary> boundaries;
+		};
+		uint32_t* m_pPixels;
+		unsigned int m_width, m_height;
+		size_t m_stride;
+		ThreadPool* m_pPool;
+		Matrix2D m_transform;
+		int m_clipLeft, m_clipTop, m_clipRight, m_clipBottom;
+		bool m_antialias;
+		Stats m_stats;
+		PathData m_path;
+		std::vector<Edge> m_edges;
+		Scratch m_scratch;
+		void Fill(const PathData& path, const Paint& paint);
+		unsigned long long RasterizeRows(int begin, int end, PathData::FillMode mode, const Paint& paint,
+			uint32_t color, const Matrix2D& inverse, Scratch& scratch) const;
+		bool AccumulateRow(float rowTop, PathData::FillMode mode, Scratch& scratch) const;
+		void SampleRow(float rowTop, PathData::FillMode mode, Scratch& scratch) const;
+		unsigned long long Composite(uint32_t* pRow, int y, const Span& span, const Paint& paint, uint32_t color,
+			const Matrix2D& inverse, Scratch& scratch) const;
+		void Shade(const Paint& paint, const Matrix2D& inverse, int x, int y, int count, uint32_t* pOut) const;
+	};
+}
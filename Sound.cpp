@@ -3,6 +3,10 @@
 #include "Sound.h"
 #include "SafeRelease.h"
 #include "HRException.h"
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include "WavParser.h"
+#include <cstring>
 
 namespace Ice2D
 {
@@ -12,17 +16,45 @@ namespace Ice2D
 
     Sound::Sound(ResourceManager* pManager, const wchar_t* filePath) : IBasicResource(pManager)
     {
-        HRESULT hr = LoadWav(filePath);
-        CheckHR(hr);
+        // Sounds loaded from the same file share one read-only sample buffer
+        AssetCache& cache = m_pManager->GetAssetCache();
+        AssetCache::SoundData data = {};
+        if (!cache.FindSound(filePath, data))
+        {
+            HRESULT hr = ReadWav(filePath, data.format, data.pData, data.size);
+            CheckHR(hr);
+            cache.InsertSound(filePath, data);
+        }
+        SetData(data.format, data.pData, data.size);
         OnLoad();
     }
 
-    Sound::Sound(Sound&& other) noexcept : IBasicResource(other), m_buffer(other.m_buffer), m_wfx(other.m_wfx)
+    Sound::Sound(ResourceManager* pManager, const WAVEFORMATEXTENSIBLE& format, std::shared_ptr<BYTE> pData,
+        UINT32 size) : IBasicResource(pManager)
     {
-        other.m_buffer.pAudioData = nullptr;
+        if (!pData) throw std::runtime_error("Sound data is null.");
+        SetData(format, std::move(pData), size);
+        OnLoad();
+    }
+
+    Sound::Sound(ResourceManager* pManager, const AssetPack& pack, const char* name) : IBasicResource(pManager)
+    {
+        // The samples aren't copied, the buffer points into the pack and keeps its mapping alive
+        AssetPack::SoundData sound = pack.GetSound(name);
+        WAVEFORMATEXTENSIBLE format = {};
+        std::memcpy(&format, sound.pFormat, sound.formatSize < sizeof(format) ? sound.formatSize : sizeof(format));
+        std::shared_ptr<BYTE> pData(pack.GetFile(), static_cast<BYTE*>(const_cast<void*>(sound.pSamples)));
+        SetData(format, std::move(pData), sound.size);
         OnLoad();
     }
 
+    Sound::Sound(Sound&& other) noexcept : IBasicResource(other), m_buffer(other.m_buffer), m_wfx(other.m_wfx),
+        m_pData(std::move(other.m_pData))
+    {
+        other.m_buffer.pAudioData = nullptr;
+        OnMove(other);
+    }
+
     Sound& Sound::operator=(Sound&& other) noexcept
     {
         if (this == &other) return *this;
@@ -30,9 +62,10 @@ namespace Ice2D
         Release();
         m_buffer = other.m_buffer;
         m_wfx = other.m_wfx;
+        m_pData = std::move(other.m_pData);
         other.m_buffer.pAudioData = nullptr;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -43,11 +76,9 @@ namespace Ice2D
 
     void Sound::Release()
     {
-        if (m_buffer.pAudioData)
-        {
-            delete[] m_buffer.pAudioData;
-            m_buffer.pAudioData = nullptr;
-        }
+        // The samples are freed once the asset cache and every other sound let go of them
+        m_pData.reset();
+        m_buffer.pAudioData = nullptr;
 
         OnUnload();
     }
@@ -63,128 +94,70 @@ namespace Ice2D
         return (WAVEFORMATEX*)&m_wfx;
     }
 
-#ifdef _XBOX //Big-Endian
-#define fourccRIFF 'RIFF'
-#define fourccDATA 'data'
-#define fourccFMT 'fmt '
-#define fourccWAVE 'WAVE'
-#define fourccXWMA 'XWMA'
-#define fourccDPDS 'dpds'
-#endif
-#ifndef _XBOX //Little-Endian
-#define fourccRIFF 'FFIR'
-#define fourccDATA 'atad'
-#define fourccFMT ' tmf'
-#define fourccWAVE 'EVAW'
-#define fourccXWMA 'AMWX'
-#define fourccDPDS 'sdpd'
-#endif
-    HRESULT FindChunk(HANDLE hFile, DWORD fourcc, DWORD& dwChunkSize, DWORD& dwChunkDataPosition)
+    void Sound::SetData(const WAVEFORMATEXTENSIBLE& format, std::shared_ptr<BYTE> pData, UINT32 size)
+    {
+        m_buffer = { 0 };
+        m_wfx = format;
+        m_pData = std::move(pData);
+        m_buffer.AudioBytes = size;  // size of the audio buffer in bytes
+        m_buffer.pAudioData = m_pData.get();  // buffer containing audio data
+        m_buffer.Flags = XAUDIO2_END_OF_STREAM; // tell the source voice not to expect any data after this buffer
+    }
+
+    // Maps the file and finds the format and samples, nothing is copied
+    static HRESULT MapWav(const wchar_t* filePath, std::shared_ptr<MappedFile>& pFile, WavParser::Info& info)
     {
-        HRESULT hr = S_OK;
-        if (INVALID_SET_FILE_POINTER == SetFilePointer(hFile, 0, NULL, FILE_BEGIN))
-            return HRESULT_FROM_WIN32(GetLastError());
-
-        DWORD dwChunkType;
-        DWORD dwChunkDataSize;
-        DWORD dwRIFFDataSize = 0;
-        DWORD dwFileType;
-        DWORD bytesRead = 0;
-        DWORD dwOffset = 0;
-
-        while (hr == S_OK)
+        try
         {
-            DWORD dwRead;
-            if (0 == ReadFile(hFile, &dwChunkType, sizeof(DWORD), &dwRead, NULL))
-                hr = HRESULT_FROM_WIN32(GetLastError());
-
-            if (0 == ReadFile(hFile, &dwChunkDataSize, sizeof(DWORD), &dwRead, NULL))
-                hr = HRESULT_FROM_WIN32(GetLastError());
-
-            switch (dwChunkType)
-            {
-            case fourccRIFF:
-                dwRIFFDataSize = dwChunkDataSize;
-                dwChunkDataSize = 4;
-                if (0 == ReadFile(hFile, &dwFileType, sizeof(DWORD), &dwRead, NULL))
-                    hr = HRESULT_FROM_WIN32(GetLastError());
-                break;
-
-            default:
-                if (INVALID_SET_FILE_POINTER == SetFilePointer(hFile, dwChunkDataSize, NULL, FILE_CURRENT))
-                    return HRESULT_FROM_WIN32(GetLastError());
-            }
-
-            dwOffset += sizeof(DWORD) * 2;
-
-            if (dwChunkType == fourcc)
-            {
-                dwChunkSize = dwChunkDataSize;
-                dwChunkDataPosition = dwOffset;
-                return S_OK;
-            }
-
-            dwOffset += dwChunkDataSize;
-
-            if (bytesRead >= dwRIFFDataSize) return S_FALSE;
+            pFile = std::make_shared<MappedFile>(filePath);
         }
-
-        return hr;
+        catch (const std::exception&)
+        {
+            return HRESULT_FROM_WIN32(ERROR_OPEN_FAILED);
+        }
+        if (WavParser::Parse(pFile->GetData(), pFile->GetSize(), info) != WavParser::Result::Ok)
+        {
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+        return S_OK;
     }
 
-    HRESULT ReadChunkData(HANDLE hFile, void* buffer, DWORD buffersize, DWORD bufferoffset)
+    HRESULT Sound::ReadWav(const wchar_t* filePath, WAVEFORMATEXTENSIBLE& format,
+        std::shared_ptr<BYTE>& pData, UINT32& size)
     {
-        HRESULT hr = S_OK;
-        if (INVALID_SET_FILE_POINTER == SetFilePointer(hFile, bufferoffset, NULL, FILE_BEGIN))
-            return HRESULT_FROM_WIN32(GetLastError());
-        DWORD dwRead;
-        if (0 == ReadFile(hFile, buffer, buffersize, &dwRead, NULL))
-            hr = HRESULT_FROM_WIN32(GetLastError());
-        return hr;
+        // Only touches its arguments, so loader threads can call it
+        format = { 0 };
+        pData.reset();
+        size = 0;
+
+        std::shared_ptr<MappedFile> pFile;
+        WavParser::Info info;
+        HRESULT hr = MapWav(filePath, pFile, info);
+        if (FAILED(hr)) return hr;
+
+        // The samples stay in the mapping, which lives as long as anything points into it
+        std::memcpy(&format, info.pFormat, info.formatSize < sizeof(format) ? info.formatSize : sizeof(format));
+        pData = std::shared_ptr<BYTE>(pFile, const_cast<BYTE*>(info.pSamples));
+        size = info.size;
+        return S_OK;
     }
 
-    HRESULT Sound::LoadWav(const wchar_t* filePath)
+    HRESULT Sound::FindWavData(const wchar_t* filePath, WAVEFORMATEXTENSIBLE& format,
+        UINT32& dataOffset, UINT32& size)
     {
-        m_buffer = { 0 };
-        m_wfx = { 0 };
-
-        // Open the file
-        HANDLE hFile = CreateFile(
-            filePath,
-            GENERIC_READ,
-            FILE_SHARE_READ,
-            NULL,
-            OPEN_EXISTING,
-            0,
-            NULL);
-
-        if (INVALID_HANDLE_VALUE == hFile)
-            return HRESULT_FROM_WIN32(GetLastError());
-
-        if (INVALID_SET_FILE_POINTER == SetFilePointer(hFile, 0, NULL, FILE_BEGIN))
-            return HRESULT_FROM_WIN32(GetLastError());
-
-        DWORD dwChunkSize;
-        DWORD dwChunkPosition;
-        // check the file type, should be fourccWAVE or 'XWMA'
-        FindChunk(hFile, fourccRIFF, dwChunkSize, dwChunkPosition);
-        DWORD filetype;
-        ReadChunkData(hFile, &filetype, sizeof(DWORD), dwChunkPosition);
-        if (filetype != fourccWAVE)
-            return S_FALSE;
-
-        FindChunk(hFile, fourccFMT, dwChunkSize, dwChunkPosition);
-        ReadChunkData(hFile, &m_wfx, dwChunkSize, dwChunkPosition);
-
-        // fill out the audio data buffer with the contents of the fourccDATA chunk
-        FindChunk(hFile, fourccDATA, dwChunkSize, dwChunkPosition);
-        BYTE* pDataBuffer = new BYTE[dwChunkSize];
-        ReadChunkData(hFile, pDataBuffer, dwChunkSize, dwChunkPosition);
-
-        m_buffer.AudioBytes = dwChunkSize;  // size of the audio buffer in bytes
-        m_buffer.pAudioData = pDataBuffer;  // buffer containing audio data
-        m_buffer.Flags = XAUDIO2_END_OF_STREAM; // tell the source voice not to expect any data after this buffer
+        // Reads the format only, so the samples can be streamed from the returned offset
+        format = { 0 };
+        dataOffset = 0;
+        size = 0;
+
+        std::shared_ptr<MappedFile> pFile;
+        WavParser::Info info;
+        HRESULT hr = MapWav(filePath, pFile, info);
+        if (FAILED(hr)) return hr;
 
+        std::memcpy(&format, info.pFormat, info.formatSize < sizeof(format) ? info.formatSize : sizeof(format));
+        dataOffset = (UINT32)(info.pSamples - pFile->GetData());
+        size = info.size;
         return S_OK;
     }
 
@@ -199,10 +172,19 @@ namespace Ice2D
         OnLoad();
     }
 
+    Voice::Voice(ResourceManager* pManager, const WAVEFORMATEX* pFormat, IXAudio2VoiceCallback* pCallback) :
+        IBasicResource(pManager)
+    {
+        HRESULT hr = pManager->GetXAudio()->CreateSourceVoice(&m_pVoice, pFormat, 0, XAUDIO2_DEFAULT_FREQ_RATIO,
+            pCallback);
+        CheckHR(hr);
+        OnLoad();
+    }
+
     Voice::Voice(Voice&& other) noexcept : IBasicResource(other), m_pVoice(other.m_pVoice)
     {
         other.m_pVoice = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     Voice& Voice::operator=(Voice&& other) noexcept
@@ -213,7 +195,7 @@ namespace Ice2D
         m_pVoice = other.m_pVoice;
         other.m_pVoice = nullptr;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -3,14 +3,18 @@
 #include <xaudio2.h>
 #include <vector>
 #include <fstream>
+#include <memory>
 
 namespace Ice2D
 {
+	class AssetPack;
 	class Sound : private IBasicResource
 	{
 	public:
 		Sound();
 		Sound(ResourceManager* pManager, const wchar_t* filePath);
+		Sound(ResourceManager* pManager, const WAVEFORMATEXTENSIBLE& format, std::shared_ptr<BYTE> pData, UINT32 size);
+		Sound(ResourceManager* pManager, const AssetPack& pack, const char* name);
 		Sound(const Sound& other) = delete;
 		Sound& operator=(const Sound& other) = delete;
 		Sound(Sound&& other) noexcept;
@@ -19,10 +23,15 @@ namespace Ice2D
 		void Release() override;
 		XAUDIO2_BUFFER* GetBuffer();
 		WAVEFORMATEX* GetFormat();
+		static HRESULT ReadWav(const wchar_t* filePath, WAVEFORMATEXTENSIBLE& format,
+			std::shared_ptr<BYTE>& pData, UINT32& size);
+		static HRESULT FindWavData(const wchar_t* filePath, WAVEFORMATEXTENSIBLE& format,
+			UINT32& dataOffset, UINT32& size);
 	private:
 		XAUDIO2_BUFFER m_buffer;
 		WAVEFORMATEXTENSIBLE m_wfx;
-		HRESULT LoadWav(const wchar_t* filePath);
+		std::shared_ptr<BYTE> m_pData;
+		void SetData(const WAVEFORMATEXTENSIBLE& format, std::shared_ptr<BYTE> pData, UINT32 size);
 	};
 
 	class Voice : private IBasicResource
@@ -30,6 +39,7 @@ namespace Ice2D
 	public:
 		Voice();
 		Voice(ResourceManager* pManager, const WAVEFORMATEX* pFormat);
+		Voice(ResourceManager* pManager, const WAVEFORMATEX* pFormat, IXAudio2VoiceCallback* pCallback);
 		Voice(const Voice& other) = delete;
 		Voice& operator=(const Voice& other) = delete;
 		Voice(Voice&& other) noexcept;
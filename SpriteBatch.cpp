@@ -0,0 +1,276 @@
+#include "pch.h"
+
+#include "SpriteBatch.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+
+namespace Ice2D
+{
+    // The queue's sprites are handed to Direct2D as strided arrays, so the layouts have to match
+    static_assert(sizeof(SpriteQueue::Rect) == sizeof(D2D1_RECT_F), "Rect layout mismatch.");
+    static_assert(sizeof(SpriteQueue::RectU) == sizeof(D2D1_RECT_U), "RectU layout mismatch.");
+    static_assert(sizeof(SpriteQueue::Color) == sizeof(D2D1_COLOR_F), "Color layout mismatch.");
+    static_assert(sizeof(SpriteQueue::Transform) == sizeof(D2D1_MATRIX_3X2_F), "Transform layout mismatch.");
+
+    static D2D1_RECT_U ToRectU(const D2D1_RECT_F& rect)
+    {
+        return D2D1::RectU((UINT32)(rect.left + 0.5f), (UINT32)(rect.top + 0.5f),
+            (UINT32)(rect.right + 0.5f), (UINT32)(rect.bottom + 0.5f));
+    }
+
+    static bool IsIdentity(const SpriteQueue::Transform& t)
+    {
+        return t.m11 == 1.0f && t.m12 == 0.0f && t.m21 == 0.0f && t.m22 == 1.0f && t.dx == 0.0f && t.dy == 0.0f;
+    }
+
+    SpriteBatch::SpriteBatch() : m_mode(SpriteQueue::SortMode::LayerTexture), m_pTarget(nullptr), m_pContext(nullptr),
+        m_pSpriteBatch(nullptr), m_drawCalls(0u), m_spriteCount(0u), m_inBatch(false)
+    {
+    }
+
+    SpriteBatch::SpriteBatch(ResourceManager* pManager, unsigned int capacity) : IBasicResource(pManager),
+        m_mode(SpriteQueue::SortMode::LayerTexture), m_pTarget(nullptr), m_pContext(nullptr),
+        m_pSpriteBatch(nullptr), m_drawCalls(0u), m_spriteCount(0u), m_inBatch(false)
+    {
+        m_queue.Reserve(capacity);
+        OnLoad();
+    }
+
+    SpriteBatch::SpriteBatch(SpriteBatch&& other) noexcept : IBasicResource(other), m_queue(std::move(other.m_queue)),
+        m_mode(other.m_mode), m_pTarget(other.m_pTarget), m_pContext(other.m_pContext),
+        m_pSpriteBatch(other.m_pSpriteBatch), m_drawCalls(other.m_drawCalls), m_spriteCount(other.m_spriteCount),
+        m_inBatch(other.m_inBatch)
+    {
+        other.m_pTarget = nullptr;
+        other.m_pContext = nullptr;
+        other.m_pSpriteBatch = nullptr;
+        other.m_inBatch = false;
+        OnMove(other);
+    }
+
+    SpriteBatch& SpriteBatch::operator=(SpriteBatch&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_pManager = other.m_pManager;
+        Release();
+        m_queue = std::move(other.m_queue);
+        m_mode = other.m_mode;
+        m_pTarget = other.m_pTarget;
+        m_pContext = other.m_pContext;
+        m_pSpriteBatch = other.m_pSpriteBatch;
+        m_drawCalls = other.m_drawCalls;
+        m_spriteCount = other.m_spriteCount;
+        m_inBatch = other.m_inBatch;
+        other.m_pTarget = nullptr;
+        other.m_pContext = nullptr;
+        other.m_pSpriteBatch = nullptr;
+        other.m_inBatch = false;
+
+        OnMove(other);
+        return *this;
+    }
+
+    SpriteBatch::~SpriteBatch()
+    {
+        Release();
+    }
+
+    void SpriteBatch::Release()
+    {
+        SafeRelease(m_pSpriteBatch);
+        SafeRelease(m_pContext);
+        SafeRelease(m_pTarget);
+        m_queue.Clear();
+        m_inBatch = false;
+        OnUnload();
+    }
+
+    void SpriteBatch::Begin(SpriteQueue::SortMode mode)
+    {
+        if (m_inBatch) throw std::runtime_error("Sprite batch already begun.");
+        m_queue.Clear();
+        m_mode = mode;
+        m_inBatch = true;
+    }
+
+    void SpriteBatch::Draw(ID2D1Bitmap* pBitmap, const D2D1_RECT_F& dest, const D2D1_RECT_U* pSource,
+        float opacity, int layer, const D2D1_MATRIX_3X2_F* pTransform)
+    {
+        if (!m_inBatch) throw std::runtime_error("Sprite batch not begun.");
+        if (!pBitmap) throw std::runtime_error("Sprite bitmap is null.");
+
+        SpriteQueue::Sprite sprite;
+        sprite.dest = { dest.left, dest.top, dest.right, dest.bottom };
+        if (pSource)
+        {
+            sprite.source = { pSource->left, pSource->top, pSource->right, pSource->bottom };
+        }
+        else
+        {
+            auto size = pBitmap->GetPixelSize();
+            sprite.source = { 0u, 0u, size.width, size.height };
+        }
+
+        // Bitmaps are premultiplied, so opacity scales every channel
+        sprite.color = { opacity, opacity, opacity, opacity };
+        sprite.transform = pTransform ?
+            SpriteQueue::Transform{ pTransform->_11, pTransform->_12, pTransform->_21, pTransform->_22,
+                pTransform->_31, pTransform->_32 } : SpriteQueue::IDENTITY;
+        sprite.pTexture = pBitmap;
+        sprite.layer = layer;
+        m_queue.Add(sprite);
+    }
+
+    void SpriteBatch::Draw(const D2DImage& image, const D2D1_RECT_F& dest,
+        float opacity, int layer, const D2D1_MATRIX_3X2_F* pTransform)
+    {
+        Draw(image.Get(), dest, nullptr, opacity, layer, pTransform);
+    }
+
+    void SpriteBatch::Draw(AnimationSheet& sheet, const D2D1_RECT_F& dest,
+        float opacity, int layer, const D2D1_MATRIX_3X2_F* pTransform)
+    {
+        D2D1_RECT_U source = ToRectU(sheet.GetSourceRect());
+        Draw(sheet.Get(), dest, &source, opacity, layer, pTransform);
+    }
+
+    void SpriteBatch::Draw(IBasicAnimation& animation, const D2D1_RECT_F& dest,
+        float opacity, int layer, const D2D1_MATRIX_3X2_F* pTransform)
+    {
+        Draw(animation.Get(), dest, nullptr, opacity, layer, pTransform);
+    }
+
+    void SpriteBatch::Draw(const AtlasRegion& region, const D2D1_RECT_F& dest,
+        float opacity, int layer, const D2D1_MATRIX_3X2_F* pTransform)
+    {
+        // Regions of one atlas page share a texture, so they end up in the same batch
+        D2D1_RECT_U source = ToRectU(region.GetSourceRect());
+        Draw(region.Get(), dest, &source, opacity, layer, pTransform);
+    }
+
+    void SpriteBatch::End()
+    {
+        if (!m_inBatch) throw std::runtime_error("Sprite batch not begun.");
+        m_inBatch = false;
+        m_drawCalls = 0u;
+        m_spriteCount = (unsigned int)m_queue.Size();
+
+        ID2D1RenderTarget* pRT = m_pManager->GetRenderTarget();
+        Prepare(pRT);
+        m_queue.Sort(m_mode);
+        if (m_pSpriteBatch)
+        {
+            SubmitBatched(m_queue.GetSprites());
+        }
+        else
+        {
+            SubmitFallback(pRT, m_queue.GetSprites());
+        }
+        m_queue.Clear();
+    }
+
+    bool SpriteBatch::IsHardwareBatching() const
+    {
+        return m_pSpriteBatch != nullptr;
+    }
+
+    unsigned int SpriteBatch::GetDrawCallCount() const
+    {
+        return m_drawCalls;
+    }
+
+    unsigned int SpriteBatch::GetSpriteCount() const
+    {
+        return m_spriteCount;
+    }
+
+    SpriteQueue& SpriteBatch::GetQueue()
+    {
+        return m_queue;
+    }
+
+    void SpriteBatch::Prepare(ID2D1RenderTarget* pRT)
+    {
+        if (pRT == m_pTarget) return;
+
+        // Sprite batches need a Windows 10 device context, older systems draw one bitmap at a time
+        SafeRelease(m_pSpriteBatch);
+        SafeRelease(m_pContext);
+        SafeRelease(m_pTarget);
+        m_pTarget = pRT;
+        m_pTarget->AddRef();
+        if (SUCCEEDED(pRT->QueryInterface(&m_pContext)))
+        {
+            if (FAILED(m_pContext->CreateSpriteBatch(&m_pSpriteBatch)))
+            {
+                SafeRelease(m_pContext);
+            }
+        }
+    }
+
+    void SpriteBatch::SubmitBatched(const std::vector<SpriteQueue::Sprite>& sprites)
+    {
+        // DrawSpriteBatch only works with aliased rendering
+        D2D1_ANTIALIAS_MODE antialiasMode = m_pContext->GetAntialiasMode();
+        m_pContext->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+
+        for (const SpriteQueue::Batch& batch : m_queue.GetBatches())
+        {
+            const SpriteQueue::Sprite& first = sprites[batch.first];
+            m_pSpriteBatch->Clear();
+            HRESULT hr = m_pSpriteBatch->AddSprites(batch.count,
+                reinterpret_cast<const D2D1_RECT_F*>(&first.dest),
+                reinterpret_cast<const D2D1_RECT_U*>(&first.source),
+                reinterpret_cast<const D2D1_COLOR_F*>(&first.color),
+                reinterpret_cast<const D2D1_MATRIX_3X2_F*>(&first.transform),
+                sizeof(SpriteQueue::Sprite), sizeof(SpriteQueue::Sprite),
+                sizeof(SpriteQueue::Sprite), sizeof(SpriteQueue::Sprite));
+            if (FAILED(hr))
+            {
+                m_pContext->SetAntialiasMode(antialiasMode);
+                CheckHR(hr);
+            }
+
+            m_pContext->DrawSpriteBatch(m_pSpriteBatch,
+                static_cast<ID2D1Bitmap*>(const_cast<void*>(batch.pTexture)),
+                D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, D2D1_SPRITE_OPTIONS_NONE);
+            ++m_drawCalls;
+        }
+
+        m_pSpriteBatch->Clear();
+        m_pContext->SetAntialiasMode(antialiasMode);
+    }
+
+    void SpriteBatch::SubmitFallback(ID2D1RenderTarget* pRT, const std::vector<SpriteQueue::Sprite>& sprites)
+    {
+        // Sprite transforms apply on top of whatever transform the render target already has
+        D2D1_MATRIX_3X2_F base;
+        pRT->GetTransform(&base);
+        bool transformed = false;
+
+        for (const SpriteQueue::Sprite& sprite : sprites)
+        {
+            if (!IsIdentity(sprite.transform))
+            {
+                const D2D1_MATRIX_3X2_F& local = reinterpret_cast<const D2D1_MATRIX_3X2_F&>(sprite.transform);
+                pRT->SetTransform(*D2D1::Matrix3x2F::ReinterpretBaseType(&local) *
+                    *D2D1::Matrix3x2F::ReinterpretBaseType(&base));
+                transformed = true;
+            }
+            else if (transformed)
+            {
+                pRT->SetTransform(base);
+                transformed = false;
+            }
+
+            D2D1_RECT_F dest = D2D1::RectF(sprite.dest.left, sprite.dest.top, sprite.dest.right, sprite.dest.bottom);
+            D2D1_RECT_F source = D2D1::RectF((float)sprite.source.left, (float)sprite.source.top,
+                (float)sprite.source.right, (float)sprite.source.bottom);
+            pRT->DrawBitmap(static_cast<ID2D1Bitmap*>(const_cast<void*>(sprite.pTexture)), dest, sprite.color.a,
+                D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, &source);
+            ++m_drawCalls;
+        }
+
+        if (transformed) pRT->SetTransform(base);
+    }
+}
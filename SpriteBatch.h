@@ -0,0 +1,49 @@
+#pragma once
+#include "ResourceManager.h"
+#include "SpriteQueue.h"
+#include "Images.h"
+#include "TextureAtlas.h"
+#include <d2d1_3.h>
+
+namespace Ice2D
+{
+	class SpriteBatch : private IBasicResource
+	{
+	public:
+		SpriteBatch();
+		SpriteBatch(ResourceManager* pManager, unsigned int capacity = 1024u);
+		SpriteBatch(const SpriteBatch& other) = delete;
+		SpriteBatch& operator=(const SpriteBatch& other) = delete;
+		SpriteBatch(SpriteBatch&& other) noexcept;
+		SpriteBatch& operator=(SpriteBatch&& other) noexcept;
+		~SpriteBatch();
+		void Release() override;
+		void Begin(SpriteQueue::SortMode mode = SpriteQueue::SortMode::LayerTexture);
+		void Draw(ID2D1Bitmap* pBitmap, const D2D1_RECT_F& dest, const D2D1_RECT_U* pSource = nullptr,
+			float opacity = 1.0f, int layer = 0, const D2D1_MATRIX_3X2_F* pTransform = nullptr);
+		void Draw(const D2DImage& image, const D2D1_RECT_F& dest,
+			float opacity = 1.0f, int layer = 0, const D2D1_MATRIX_3X2_F* pTransform = nullptr);
+		void Draw(AnimationSheet& sheet, const D2D1_RECT_F& dest,
+			float opacity = 1.0f, int layer = 0, const D2D1_MATRIX_3X2_F* pTransform = nullptr);
+		void Draw(IBasicAnimation& animation, const D2D1_RECT_F& dest,
+			float opacity = 1.0f, int layer = 0, const D2D1_MATRIX_3X2_F* pTransform = nullptr);
+		void Draw(const AtlasRegion& region, const D2D1_RECT_F& dest,
+			float opacity = 1.0f, int layer = 0, const D2D1_MATRIX_3X2_F* pTransform = nullptr);
+		void End();
+		bool IsHardwareBatching() const;
+		unsigned int GetDrawCallCount() const;
+		unsigned int GetSpriteCount() const;
+		SpriteQueue& GetQueue();
+	private:
+		SpriteQueue m_queue;
+		SpriteQueue::SortMode m_mode;
+		ID2D1RenderTarget* m_pTarget;
+		ID2D1DeviceContext3* m_pContext;
+		ID2D1SpriteBatch* m_pSpriteBatch;
+		unsigned int m_drawCalls, m_spriteCount;
+		bool m_inBatch;
+		void Prepare(ID2D1RenderTarget* pRT);
+		void SubmitBatched(const std::vector<SpriteQueue::Sprite>& sprites);
+		void SubmitFallback(ID2D1RenderTarget* pRT, const std::vector<SpriteQueue::Sprite>& sprites);
+	};
+}
\ No newline at end of file
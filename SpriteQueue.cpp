@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include "SpriteQueue.h"
+
+namespace Ice2D
+{
+    const SpriteQueue::Transform SpriteQueue::IDENTITY = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+
+    static inline size_t HashTexture(const void* pTexture)
+    {
+        // Fibonacci hashing, textures are aligned so the low bits of the pointer alone are poor
+        return (size_t)(((uint64_t)(uintptr_t)pTexture * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    SpriteQueue::SpriteQueue() : m_textureCount(0u), m_stamp(1u), m_isSorted(false)
+    {
+    }
+
+    void SpriteQueue::Reserve(size_t count)
+    {
+        m_sprites.reserve(count);
+        m_sorted.reserve(count);
+        m_keys.reserve(count);
+        m_keyScratch.reserve(count);
+        m_order.reserve(count);
+        m_orderScratch.reserve(count);
+    }
+
+    void SpriteQueue::Clear()
+    {
+        // Keeps the capacity, so a steady sprite count stops allocating after the first frames
+        m_sprites.clear();
+        m_sorted.clear();
+        m_batches.clear();
+        m_isSorted = false;
+    }
+
+    void SpriteQueue::Add(const Sprite& sprite)
+    {
+        m_sprites.push_back(sprite);
+        m_isSorted = false;
+    }
+
+    size_t SpriteQueue::Size() const
+    {
+        return m_sprites.size();
+    }
+
+    void SpriteQueue::Sort(SortMode mode)
+    {
+        const size_t count = m_sprites.size();
+        m_isSorted = mode != SortMode::Deferred;
+        if (m_isSorted)
+        {
+            // Layer in the high half and texture in the low half, insertion order breaks ties
+            m_textureCount = 0u;
+            if (++m_stamp == 0u)
+            {
+                for (TextureSlot& slot : m_textureSlots) slot.stamp = 0u;
+                m_stamp = 1u;
+            }
+            m_keys.resize(count);
+            const void* pLastTexture = nullptr;
+            uint32_t lastTexture = 0u;
+            for (size_t i = 0u; i < count; ++i)
+            {
+                const Sprite& sprite = m_sprites[i];
+                int layer = sprite.layer < -32768 ? -32768 : sprite.layer > 32767 ? 32767 : sprite.layer;
+                uint32_t key = (uint32_t)(layer + 32768) << 16;
+                if (mode == SortMode::LayerTexture)
+                {
+                    // Texture ids follow first use, so the order doesn't depend on pointer values
+                    if (i == 0u || sprite.pTexture != pLastTexture)
+                    {
+                        uint32_t id = GetTextureId(sprite.pTexture);
+                        pLastTexture = sprite.pTexture;
+                        lastTexture = id < 0xFFFFu ? id : 0xFFFFu;
+                    }
+                    key |= lastTexture;
+                }
+                m_keys[i] = key;
+            }
+            RadixSort();
+
+            m_sorted.resize(count);
+            for (size_t i = 0u; i < count; ++i) m_sorted[i] = m_sprites[m_order[i]];
+        }
+
+        // Consecutive sprites with the same texture can be submitted together
+        const std::vector<Sprite>& sprites = GetSprites();
+        m_batches.clear();
+        for (unsigned int i = 0u; i < (unsigned int)count; ++i)
+        {
+            if (m_batches.empty() || m_batches.back().pTexture != sprites[i].pTexture)
+            {
+                m_batches.push_back({ sprites[i].pTexture, i, 0u });
+            }
+            ++m_batches.back().count;
+        }
+    }
+
+    const std::vector<SpriteQueue::Sprite>& SpriteQueue::GetSprites() const
+    {
+        return m_isSorted ? m_sorted : m_sprites;
+    }
+
+    const std::vector<SpriteQueue::Batch>& SpriteQueue::GetBatches() const
+    {
+        return m_batches;
+    }
+
+    uint32_t SpriteQueue::GetTextureId(const void* pTexture)
+    {
+        // Open addressing in a flat table, slots from an earlier sort have an old stamp and count as empty
+        if ((m_textureCount + 1u) * 2u > m_textureSlots.size()) GrowTextureSlots();
+        const size_t mask = m_textureSlots.size() - 1u;
+        size_t i = HashTexture(pTexture) & mask;
+        while (true)
+        {
+            TextureSlot& slot = m_textureSlots[i];
+            if (slot.stamp != m_stamp)
+            {
+                slot = { pTexture, m_textureCount++, m_stamp };
+                return slot.id;
+            }
+            if (slot.pTexture == pTexture) return slot.id;
+            i = (i + 1u) & mask;
+        }
+    }
+
+    void SpriteQueue::GrowTextureSlots()
+    {
+        // Only grows past the most textures seen in one sort, so a steady scene stops allocating
+        std::vector<TextureSlot> slots(m_textureSlots.empty() ? 64u : m_textureSlots.size() * 2u, TextureSlot());
+        const size_t mask = slots.size() - 1u;
+        for (const TextureSlot& slot : m_textureSlots)
+        {
+            if (slot.stamp != m_stamp) continue;
+            size_t i = HashTexture(slot.pTexture) & mask;
+            while (slots[i].stamp == m_stamp) i = (i + 1u) & mask;
+            slots[i] = slot;
+        }
+        m_textureSlots.swap(slots);
+    }
+
+    void SpriteQueue::RadixSort()
+    {
+        // Stable LSD radix sort over the key bytes, bytes that are the same for every sprite are skipped
+        const size_t count = m_keys.size();
+        m_order.resize(count);
+        m_orderScratch.resize(count);
+        m_keyScratch.resize(count);
+        for (size_t i = 0u; i < count; ++i) m_order[i] = (unsigned int)i;
+
+        for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+        {
+            size_t histogram[256] = {};
+            for (uint32_t key : m_keys) ++histogram[(key >> shift) & 0xFFu];
+            if (histogram[(m_keys.empty() ? 0u : (m_keys[0] >> shift) & 0xFFu)] == count) continue;
+
+            size_t offset = 0u;
+            for (size_t& bucket : histogram)
+            {
+                size_t size = bucket;
+                bucket = offset;
+                offset += size;
+            }
+            for (size_t i = 0u; i < count; ++i)
+            {
+                size_t slot = histogram[(m_keys[i] >> shift) & 0xFFu]++;
+                m_keyScratch[slot] = m_keys[i];
+                m_orderScratch[slot] = m_order[i];
+            }
+            m_keys.swap(m_keyScratch);
+            m_order.swap(m_orderScratch);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Ice2D
+{
+	class SpriteQueue
+	{
+	public:
+		enum class SortMode { Deferred, Layer, LayerTexture };
+		struct Rect
+		{
+			float left, top, right, bottom;
+		};
+		struct RectU
+		{
+			uint32_t left, top, right, bottom;
+		};
+		struct Color
+		{
+			float r, g, b, a;
+		};
+		struct Transform
+		{
+			float m11, m12, m21, m22, dx, dy;
+		};
+		struct Sprite
+		{
+			Rect dest;
+			RectU source;
+			Color color;
+			Transform transform;
+			const void* pTexture;
+			int layer;
+		};
+		struct Batch
+		{
+			const void* pTexture;
+			unsigned int first, count;
+		};
+		SpriteQueue();
+		void Reserve(size_t count);
+		void Clear();
+		void Add(const Sprite& sprite);
+		size_t Size() const;
+		void Sort(SortMode mode);
+		const std::vector<Sprite>& GetSprites() const;
+		const std::vector<Batch>& GetBatches() const;
+		static const Transform IDENTITY;
+	private:
+		std::vector<Sprite> m_sprites, m_sorted;
+		std::vector<uint32_t> m_keys, m_keyScratch;
+		std::vector<unsigned int> m_order, m_orderScratch;
+		std::vector<Batch> m_batches;
+		struct TextureSlot
+		{
+			const void* pTexture;
+			uint32_t id, stamp;
+		};
+		std::vector<TextureSlot> m_textureSlots;
+		uint32_t m_textureCount, m_stamp;
+		bool m_isSorted;
+		uint32_t GetTextureId(const void* pTexture);
+		void GrowTextureSlots();
+		void RadixSort();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "pch.h"
+
+#include "StreamingSound.h"
+#include "HRException.h"
+#include <atomic>
+#include <fstream>
+
+namespace Ice2D
+{
+    // Submits stream blocks to the voice and hands them back once XAudio2 is done with them
+    class StreamingSound::Sink : public AudioStreamSink, public IXAudio2VoiceCallback
+    {
+    public:
+        Sink() : pVoice(nullptr), pStream(nullptr), playing(false)
+        {
+        }
+
+        void Submit(const unsigned char* pData, uint32_t size, unsigned int block, bool endOfStream) override
+        {
+            XAUDIO2_BUFFER buffer = { 0 };
+            buffer.AudioBytes = size;
+            buffer.pAudioData = pData;
+            buffer.pContext = reinterpret_cast<void*>((uintptr_t)block);
+            buffer.Flags = endOfStream ? XAUDIO2_END_OF_STREAM : 0;
+            if (FAILED(pVoice->SubmitSourceBuffer(&buffer))) pStream->Recycle(block);
+        }
+
+        void Flush() override
+        {
+            // A started voice keeps playing its current buffer through a flush, so stop it briefly
+            bool wasPlaying = playing;
+            if (wasPlaying) pVoice->Stop();
+            pVoice->FlushSourceBuffers();
+            if (wasPlaying) pVoice->Start();
+        }
+
+        void STDMETHODCALLTYPE OnBufferEnd(void* pContext) override
+        {
+            pStream->Recycle((unsigned int)reinterpret_cast<uintptr_t>(pContext));
+        }
+
+        void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32) override {}
+        void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+        void STDMETHODCALLTYPE OnStreamEnd() override {}
+        void STDMETHODCALLTYPE OnBufferStart(void*) override {}
+        void STDMETHODCALLTYPE OnLoopEnd(void*) override {}
+        void STDMETHODCALLTYPE OnVoiceError(void*, HRESULT) override {}
+
+        IXAudio2SourceVoice* pVoice;
+        AudioStream* pStream;
+        std::atomic<bool> playing;
+    };
+
+    StreamingSound::StreamingSound() : m_wfx({})
+    {
+    }
+
+    StreamingSound::StreamingSound(ResourceManager* pManager, const wchar_t* filePath, UINT32 blockSize,
+        unsigned int blockCount) : IBasicResource(pManager), m_wfx({})
+    {
+        UINT32 dataOffset = 0u, dataSize = 0u;
+        HRESULT hr = Sound::FindWavData(filePath, m_wfx, dataOffset, dataSize);
+        CheckHR(hr);
+        if (hr != S_OK) throw std::runtime_error("Streaming sound is not a WAV file.");
+
+        // Only the stream's reader thread touches the file after this
+        auto pFile = std::make_shared<std::ifstream>(filePath, std::ios::binary);
+        if (!*pFile) throw std::runtime_error("Failed to open streaming sound.");
+        AudioStream::Reader reader = [pFile, dataOffset](uint64_t offset, void* pBuffer, size_t size) -> size_t
+        {
+            pFile->clear();
+            pFile->seekg((std::streamoff)(dataOffset + offset));
+            pFile->read(static_cast<char*>(pBuffer), (std::streamsize)size);
+            return (size_t)pFile->gcount();
+        };
+
+        m_pSink.reset(new Sink());
+        m_pStream.reset(new AudioStream(reader, dataSize, m_pSink.get(), blockSize, blockCount,
+            m_wfx.Format.nBlockAlign));
+        m_pSink->pStream = m_pStream.get();
+        m_voice = Voice(pManager, &m_wfx.Format, m_pSink.get());
+        m_pSink->pVoice = m_voice.Get();
+
+        // Starts filling the ring right away, so Play() doesn't wait on the disk
+        m_pStream->Start();
+        OnLoad();
+    }
+
+    StreamingSound::StreamingSound(StreamingSound&& other) noexcept : IBasicResource(other), m_wfx(other.m_wfx),
+        m_pSink(std::move(other.m_pSink)), m_pStream(std::move(other.m_pStream)), m_voice(std::move(other.m_voice))
+    {
+        OnMove(other);
+    }
+
+    StreamingSound& StreamingSound::operator=(StreamingSound&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_pManager = other.m_pManager;
+        Release();
+        m_wfx = other.m_wfx;
+        m_pSink = std::move(other.m_pSink);
+        m_pStream = std::move(other.m_pStream);
+        m_voice = std::move(other.m_voice);
+
+        OnMove(other);
+        return *this;
+    }
+
+    StreamingSound::~StreamingSound()
+    {
+        Release();
+    }
+
+    void StreamingSound::Release()
+    {
+        // The reader thread goes first, then the voice, which waits for its callbacks to finish
+        if (m_pStream) m_pStream->Stop();
+        m_voice.Release();
+        m_pStream.reset();
+        m_pSink.reset();
+        OnUnload();
+    }
+
+    void StreamingSound::Play()
+    {
+        // Playing a finished sound starts it over
+        if (GetStream().IsFinished()) m_pStream->Seek(0u);
+        m_pSink->playing = true;
+        m_voice.Play();
+    }
+
+    void StreamingSound::Stop()
+    {
+        m_pSink->playing = false;
+        m_voice.Stop();
+    }
+
+    void StreamingSound::SetLooping(bool looping)
+    {
+        GetStream().SetLooping(looping);
+    }
+
+    bool StreamingSound::IsLooping() const
+    {
+        return GetStream().IsLooping();
+    }
+
+    void StreamingSound::Seek(float seconds)
+    {
+        GetStream().Seek(seconds > 0.0f ? (uint64_t)(seconds * m_wfx.Format.nAvgBytesPerSec) : 0u);
+    }
+
+    float StreamingSound::GetPosition() const
+    {
+        return (float)GetStream().GetPlayPosition() / m_wfx.Format.nAvgBytesPerSec;
+    }
+
+    float StreamingSound::GetDuration() const
+    {
+        return (float)GetStream().GetSize() / m_wfx.Format.nAvgBytesPerSec;
+    }
+
+    bool StreamingSound::IsPlaying() const
+    {
+        return m_pSink && m_pSink->playing && !GetStream().IsFinished();
+    }
+
+    bool StreamingSound::IsFinished() const
+    {
+        return GetStream().IsFinished();
+    }
+
+    WAVEFORMATEX* StreamingSound::GetFormat()
+    {
+        return (WAVEFORMATEX*)&m_wfx;
+    }
+
+    Voice& StreamingSound::GetVoice()
+    {
+        return m_voice;
+    }
+
+    AudioStream::Stats StreamingSound::GetStats() const
+    {
+        return GetStream().GetStats();
+    }
+
+    AudioStream& StreamingSound::GetStream() const
+    {
+        if (!m_pStream) throw std::runtime_error("Streaming sound is null.");
+        return *m_pStream;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "ResourceManager.h"
+#include "AudioStream.h"
+#include "Sound.h"
+#include <xaudio2.h>
+#include <memory>
+
+namespace Ice2D
+{
+	class StreamingSound : private IBasicResource
+	{
+	public:
+		StreamingSound();
+		StreamingSound(ResourceManager* pManager, const wchar_t* filePath, UINT32 blockSize = 65536u,
+			unsigned int blockCount = 3u);
+		StreamingSound(const StreamingSound& other) = delete;
+		StreamingSound& operator=(const StreamingSound& other) = delete;
+		StreamingSound(StreamingSound&& other) noexcept;
+		StreamingSound& operator=(StreamingSound&& other) noexcept;
+		~StreamingSound();
+		void Release() override;
+		void Play();
+		void Stop();
+		void SetLooping(bool looping);
+		bool IsLooping() const;
+		void Seek(float seconds);
+		float GetPosition() const;
+		float GetDuration() const;
+		bool IsPlaying() const;
+		bool IsFinished() const;
+		WAVEFORMATEX* GetFormat();
+		Voice& GetVoice();
+		AudioStream::Stats GetStats() const;
+	private:
+		class Sink;
+		WAVEFORMATEXTENSIBLE m_wfx;
+		std::unique_ptr<Sink> m_pSink;
+		std::unique_ptr<AudioStream> m_pStream;
+		Voice m_voice;
+		AudioStream& GetStream() const;
+	};
+}
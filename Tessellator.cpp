@@ -0,0 +1,352 @@
+#include "pch.h"
+
+#include "Tessellator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Ice2D
+{
+    template <typename E>
+    static inline float XAt(const E& edge, float y)
+    {
+        // The end points come back exactly, so neighbouring bands agree on where an edge is
+        if (y <= edge.y0) return edge.x0;
+        if (y >= edge.y1) return edge.x1;
+        return edge.x0 + (y - edge.y0) * edge.dxdy;
+    }
+
+    template <typename V>
+    static inline float Cross(const V& a, const V& b, const V& c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    Tessellator::Tessellator() : m_stats()
+    {
+    }
+
+    void Tessellator::Tessellate(const PathData& path)
+    {
+        Tessellate(path, path.GetFillMode());
+    }
+
+    void Tessellator::Tessellate(const PathData& path, PathData::FillMode mode)
+    {
+        // Everything is cleared, not freed, so the same tessellator stops allocating once it has seen a large path
+        m_edges.clear();
+        m_ys.clear();
+        m_active.clear();
+        m_spans.clear();
+        m_previous.clear();
+        m_triangles.clear();
+        m_stats = Stats();
+
+        // Filled figures are closed whether the path closed them or not
+        const std::vector<PathData::Point>& points = path.GetPoints();
+        for (const PathData::Figure& figure : path.GetFigures())
+        {
+            if (figure.count < 3u) continue;
+            for (unsigned int i = 0u; i < figure.count; ++i)
+            {
+                AddEdge(points[figure.first + i], points[figure.first + (i + 1u) % figure.count]);
+            }
+        }
+        m_stats.edges = (unsigned int)m_edges.size();
+        if (!m_edges.empty()) Sweep(mode);
+        m_stats.triangles = (unsigned int)m_triangles.size();
+    }
+
+    const std::vector<Tessellator::Triangle>& Tessellator::GetTriangles() const
+    {
+        return m_triangles;
+    }
+
+    const Tessellator::Stats& Tessellator::GetStats() const
+    {
+        return m_stats;
+    }
+
+    void Tessellator::Reserve(size_t edges)
+    {
+        m_edges.reserve(edges);
+        m_ys.reserve(edges * 2u);
+        m_triangles.reserve(edges);
+    }
+
+    void Tessellator::AddEdge(const PathData::Point& a, const PathData::Point& b)
+    {
+        // Horizontal edges don't change the winding of anything below them
+        if (a.y == b.y || !std::isfinite(a.x) || !std::isfinite(a.y) || !std::isfinite(b.x) || !std::isfinite(b.y))
+        {
+            return;
+        }
+        if (a.y < b.y)
+        {
+            m_edges.push_back({ a.x, a.y, b.x, b.y, (b.x - a.x) / (b.y - a.y), 1 });
+        }
+        else
+        {
+            m_edges.push_back({ b.x, b.y, a.x, a.y, (a.x - b.x) / (a.y - b.y), -1 });
+        }
+    }
+
+    void Tessellator::Sweep(PathData::FillMode mode)
+    {
+        std::sort(m_edges.begin(), m_edges.end(), [](const Edge& a, const Edge& b)
+        {
+            if (a.y0 != b.y0) return a.y0 < b.y0;
+            if (a.x0 != b.x0) return a.x0 < b.x0;
+            if (a.dxdy != b.dxdy) return a.dxdy < b.dxdy;
+            if (a.y1 != b.y1) return a.y1 < b.y1;
+            return a.winding < b.winding;
+        });
+        for (const Edge& edge : m_edges)
+        {
+            m_ys.push_back(edge.y0);
+            m_ys.push_back(edge.y1);
+        }
+        std::sort(m_ys.begin(), m_ys.end());
+        m_ys.erase(std::unique(m_ys.begin(), m_ys.end()), m_ys.end());
+
+        // Bands run between consecutive end points, and are cut short where two edges cross
+        size_t nextEdge = 0u, nextY = 0u;
+        float y = m_ys.front();
+        for (;;)
+        {
+            // Active edges carry a copy of the edge, the passes below only walk this one array
+            m_active.erase(std::remove_if(m_active.begin(), m_active.end(),
+                [y](const Active& active) { return active.edge.y1 <= y; }), m_active.end());
+            for (; nextEdge < m_edges.size() && m_edges[nextEdge].y0 <= y; ++nextEdge)
+            {
+                m_active.push_back({ m_edges[nextEdge], 0.0f, 0.0f, (unsigned int)nextEdge, false });
+            }
+            while (nextY < m_ys.size() && m_ys[nextY] <= y) ++nextY;
+            if (nextY == m_ys.size())
+            {
+                for (const Span& span : m_previous) Close(span, y);
+                m_previous.clear();
+                break;
+            }
+
+            // The order barely changes from one band to the next, so an insertion sort is close to linear
+            for (Active& active : m_active)
+            {
+                active.top = XAt(active.edge, y);
+                active.pinned = false;
+            }
+            for (size_t i = 1u; i < m_active.size(); ++i)
+            {
+                Active item = m_active[i];
+                size_t j = i;
+                for (; j > 0u && (item.top < m_active[j - 1u].top ||
+                    (item.top == m_active[j - 1u].top && item.edge.dxdy < m_active[j - 1u].edge.dxdy)); --j)
+                {
+                    m_active[j] = m_active[j - 1u];
+                }
+                m_active[j] = item;
+            }
+
+            float bottom = m_ys[nextY];
+            SetBottoms(bottom);
+
+            // Edges that cross right at a band boundary can come out of the sort the wrong way round by rounding
+            for (size_t i = 1u; i < m_active.size();)
+            {
+                const Active& a = m_active[i - 1u];
+                const Active& b = m_active[i];
+                if (a.bottom > b.bottom && a.edge.dxdy > b.edge.dxdy &&
+                    !(y + (b.top - a.top) / (a.edge.dxdy - b.edge.dxdy) > y))
+                {
+                    std::swap(m_active[i - 1u], m_active[i]);
+                    if (i > 1u) --i;
+                    continue;
+                }
+                ++i;
+            }
+
+            // Edges that swap places cross somewhere in the band, the first crossing is between neighbours
+            float cut = bottom;
+            for (size_t i = 1u; i < m_active.size(); ++i)
+            {
+                const Active& a = m_active[i - 1u];
+                const Active& b = m_active[i];
+                if (a.bottom <= b.bottom || a.edge.dxdy <= b.edge.dxdy) continue;
+                float crossing = y + (b.top - a.top) / (a.edge.dxdy - b.edge.dxdy);
+                if (crossing > y && crossing < cut) cut = crossing;
+            }
+            if (cut < bottom)
+            {
+                bottom = cut;
+                SetBottoms(bottom);
+            }
+
+            // A crossing in a band too thin to cut, or one a rounding error away from the cut, would twist a span.
+            // Pinning the ends in order moves them by no more than the rounding error or the height of the band
+            for (size_t i = 1u; i < m_active.size(); ++i)
+            {
+                Active& active = m_active[i];
+                const Active& previous = m_active[i - 1u];
+                active.pinned = active.top < previous.top || active.bottom < previous.bottom;
+                if (!active.pinned) continue;
+                active.top = std::max(active.top, previous.top);
+                active.bottom = std::max(active.bottom, previous.bottom);
+            }
+
+            BuildSpans(mode);
+            Join(y);
+            m_previous.swap(m_spans);
+            ++m_stats.bands;
+            y = bottom;
+        }
+    }
+
+    void Tessellator::SetBottoms(float bottom)
+    {
+        for (Active& active : m_active) active.bottom = XAt(active.edge, bottom);
+    }
+
+    void Tessellator::BuildSpans(PathData::FillMode mode)
+    {
+        m_spans.clear();
+        int winding = 0;
+        size_t left = 0u;
+        bool inside = false;
+        for (size_t i = 0u; i < m_active.size(); ++i)
+        {
+            winding += m_active[i].edge.winding;
+            bool now = mode == PathData::FillMode::Winding ? winding != 0 : (winding & 1) != 0;
+            if (now == inside) continue;
+            inside = now;
+            if (inside)
+            {
+                left = i;
+                continue;
+            }
+
+            // Coincident edges enclose nothing
+            const Active& l = m_active[left];
+            const Active& r = m_active[i];
+            if (r.top > l.top || r.bottom > l.bottom)
+            {
+                m_spans.push_back({ l.top, r.top, l.bottom, r.bottom, l.index, r.index, 0u, l.pinned, r.pinned });
+            }
+        }
+    }
+
+    void Tessellator::Join(float y)
+    {
+        // A span that starts exactly where one of the last band ended keeps growing the same region,
+        // everything else ends a region or starts a new one
+        size_t p = 0u;
+        for (Span& span : m_spans)
+        {
+            while (p < m_previous.size() && (m_previous[p].leftBottom < span.leftTop ||
+                (m_previous[p].leftBottom == span.leftTop && m_previous[p].rightBottom < span.rightTop)))
+            {
+                Close(m_previous[p++], y);
+            }
+            if (p < m_previous.size() && m_previous[p].leftBottom == span.leftTop &&
+                m_previous[p].rightBottom == span.rightTop && span.rightTop > span.leftTop)
+            {
+                const Span& previous = m_previous[p++];
+                span.region = previous.region;
+                std::vector<Vertex>& chain = m_chains[span.region];
+                // A side only runs straight on when it's the same edge and neither band had to pin it
+                if (span.leftEdge != previous.leftEdge || span.leftPinned || previous.leftPinned)
+                {
+                    chain.push_back({ span.leftTop, y, false });
+                }
+                if (span.rightEdge != previous.rightEdge || span.rightPinned || previous.rightPinned)
+                {
+                    chain.push_back({ span.rightTop, y, true });
+                }
+            }
+            else
+            {
+                Open(span, y);
+            }
+        }
+        while (p < m_previous.size()) Close(m_previous[p++], y);
+    }
+
+    void Tessellator::Open(Span& span, float y)
+    {
+        if (m_freeChains.empty())
+        {
+            m_freeChains.push_back((unsigned int)m_chains.size());
+            m_chains.emplace_back();
+        }
+        span.region = m_freeChains.back();
+        m_freeChains.pop_back();
+
+        std::vector<Vertex>& chain = m_chains[span.region];
+        chain.clear();
+        chain.push_back({ span.leftTop, y, false });
+        if (span.rightTop > span.leftTop) chain.push_back({ span.rightTop, y, true });
+        ++m_stats.regions;
+    }
+
+    void Tessellator::Close(const Span& span, float y)
+    {
+        std::vector<Vertex>& chain = m_chains[span.region];
+        chain.push_back({ span.leftBottom, y, false });
+        if (span.rightBottom > span.leftBottom) chain.push_back({ span.rightBottom, y, true });
+        Triangulate(chain);
+        m_freeChains.push_back(span.region);
+    }
+
+    void Tessellator::Triangulate(const std::vector<Vertex>& chain)
+    {
+        // The region is monotone in y, with ties going left to right. The usual stack walk: a vertex on the
+        // other chain sees the whole stack, a vertex on the same chain cuts off ears while the corner is convex
+        const size_t count = chain.size();
+        if (count < 3u) return;
+        m_stack.clear();
+        m_stack.push_back(0u);
+        m_stack.push_back(1u);
+        for (unsigned int j = 2u; j + 1u < count; ++j)
+        {
+            const Vertex& v = chain[j];
+            if (v.right != chain[m_stack.back()].right)
+            {
+                for (size_t k = 1u; k < m_stack.size(); ++k) Emit(v, chain[m_stack[k - 1u]], chain[m_stack[k]]);
+                unsigned int last = m_stack.back();
+                m_stack.clear();
+                m_stack.push_back(last);
+            }
+            else
+            {
+                unsigned int last = m_stack.back();
+                m_stack.pop_back();
+                while (!m_stack.empty())
+                {
+                    float turn = Cross(chain[m_stack.back()], chain[last], v);
+                    if (v.right ? turn <= 0.0f : turn >= 0.0f) break;
+                    Emit(v, chain[last], chain[m_stack.back()]);
+                    last = m_stack.back();
+                    m_stack.pop_back();
+                }
+                m_stack.push_back(last);
+            }
+            m_stack.push_back(j);
+        }
+
+        const Vertex& bottom = chain[count - 1u];
+        for (size_t k = 1u; k < m_stack.size(); ++k) Emit(bottom, chain[m_stack[k - 1u]], chain[m_stack[k]]);
+    }
+
+    void Tessellator::Emit(const Vertex& a, const Vertex& b, const Vertex& c)
+    {
+        // Every triangle winds the same way, so shared edges cancel when the mesh is filled as a path
+        float area = Cross(a, b, c);
+        if (area == 0.0f) return;
+        if (area > 0.0f)
+        {
+            m_triangles.push_back({ { a.x, a.y }, { b.x, b.y }, { c.x, c.y } });
+        }
+        else
+        {
+            m_triangles.push_back({ { a.x, a.y }, { c.x, c.y }, { b.x, b.y } });
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "PathData.h"
+#include <cstddef>
+#include <vector>
+
+namespace Ice2D
+{
+	class Tessellator
+	{
+	public:
+		struct Triangle
+		{
+			PathData::Point a, b, c;
+		};
+		struct Stats
+		{
+			unsigned int edges, bands, regions, triangles;
+		};
+		Tessellator();
+		void Tessellate(const PathData& path);
+		void Tessellate(const PathData& path, PathData::FillMode mode);
+		const std::vector<Triangle>& GetTriangles() const;
+		const Stats& GetStats() const;
+		void Reserve(size_t edges);
+	private:
+		struct Edge
+		{
+			float x0, y0, x1, y1, dxdy;
+			int winding;
+		};
+		struct Active
+		{
+			Edge edge;
+			float top, bottom;
+			unsigned int index;
+			bool pinned;
+		};
+		struct Span
+		{
+			float leftTop, rightTop, leftBottom, rightBottom;
+			unsigned int leftEdge, rightEdge, region;
+			bool leftPinned, rightPinned;
+		};
+		struct Vertex
+		{
+			float x, y;
+			bool right;
+		};
+		std::vector<Edge> m_edges;
+		std::vector<float> m_ys;
+		std::vector<Active> m_active;
+		std::vector<Span> m_spans, m_previous;
+		std::vector<std::vector<Vertex>> m_chains;
+		std::vector<unsigned int> m_freeChains, m_stack;
+		std::vector<Triangle> m_triangles;
+		Stats m_stats;
+		void AddEdge(const PathData::Point& a, const PathData::Point& b);
+		void Sweep(PathData::FillMode mode);
+		void SetBottoms(float bottom);
+		void BuildSpans(PathData::FillMode mode);
+		void Join(float y);
+		void Open(Span& span, float y);
+		void Close(const Span& span, float y);
+		void Triangulate(const std::vector<Vertex>& chain);
+		void Emit(const Vertex& a, const Vertex& b, const Vertex& c);
+	};
+}
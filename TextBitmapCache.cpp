@@ -0,0 +1,259 @@
+#include "pch.h"
+
+#include "TextBitmapCache.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Ice2D
+{
+    static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static const uint64_t FNV_PRIME = 1099511628211ull;
+
+    static uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+    {
+        const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+        for (size_t i = 0u; i < size; ++i)
+        {
+            hash ^= pBytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    bool TextBitmapCache::Key::operator==(const Key& other) const
+    {
+        return pFormat == other.pFormat && color.r == other.color.r && color.g == other.color.g &&
+            color.b == other.color.b && color.a == other.color.a && maxWidth == other.maxWidth &&
+            maxHeight == other.maxHeight && text == other.text;
+    }
+
+    size_t TextBitmapCache::KeyHash::operator()(const Key& key) const
+    {
+        uint64_t hash = HashBytes(FNV_OFFSET, key.text.data(), key.text.size() * sizeof(wchar_t));
+        hash = HashBytes(hash, &key.pFormat, sizeof(key.pFormat));
+        hash = HashBytes(hash, &key.color, sizeof(key.color));
+        hash = HashBytes(hash, &key.maxWidth, sizeof(key.maxWidth));
+        return (size_t)HashBytes(hash, &key.maxHeight, sizeof(key.maxHeight));
+    }
+
+    TextBitmapCache::TextBitmapCache() : m_pBrush(nullptr), m_pTarget(nullptr), m_lookup(),
+        m_pageSize(512u), m_maxPageSize(2048u), m_hits(0ull), m_misses(0ull), m_resets(0ull)
+    {
+    }
+
+    TextBitmapCache::TextBitmapCache(ResourceManager* pManager, unsigned int pageSize, unsigned int maxPageSize) :
+        IBasicResource(pManager), m_atlas(pManager, pageSize, maxPageSize), m_pBrush(nullptr), m_pTarget(nullptr),
+        m_lookup(), m_pageSize(pageSize), m_maxPageSize(maxPageSize), m_hits(0ull), m_misses(0ull), m_resets(0ull)
+    {
+        OnLoad();
+    }
+
+    TextBitmapCache::TextBitmapCache(TextBitmapCache&& other) noexcept : IBasicResource(other),
+        m_atlas(std::move(other.m_atlas)), m_scratch(std::move(other.m_scratch)), m_pBrush(other.m_pBrush),
+        m_pTarget(other.m_pTarget), m_labels(std::move(other.m_labels)), m_formats(std::move(other.m_formats)),
+        m_lookup(), m_pageSize(other.m_pageSize), m_maxPageSize(other.m_maxPageSize), m_hits(other.m_hits),
+        m_misses(other.m_misses), m_resets(other.m_resets)
+    {
+        other.m_pBrush = nullptr;
+        other.m_pTarget = nullptr;
+        other.m_labels.clear();
+        other.m_formats.clear();
+        OnMove(other);
+    }
+
+    TextBitmapCache& TextBitmapCache::operator=(TextBitmapCache&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_pManager = other.m_pManager;
+        Release();
+        m_atlas = std::move(other.m_atlas);
+        m_scratch = std::move(other.m_scratch);
+        m_pBrush = other.m_pBrush;
+        m_pTarget = other.m_pTarget;
+        m_labels = std::move(other.m_labels);
+        m_formats = std::move(other.m_formats);
+        m_pageSize = other.m_pageSize;
+        m_maxPageSize = other.m_maxPageSize;
+        m_hits = other.m_hits;
+        m_misses = other.m_misses;
+        m_resets = other.m_resets;
+        other.m_pBrush = nullptr;
+        other.m_pTarget = nullptr;
+        other.m_labels.clear();
+        other.m_formats.clear();
+
+        OnMove(other);
+        return *this;
+    }
+
+    TextBitmapCache::~TextBitmapCache()
+    {
+        Release();
+    }
+
+    void TextBitmapCache::Release()
+    {
+        m_labels.clear();
+        for (IDWriteTextFormat*& pFormat : m_formats) SafeRelease(pFormat);
+        m_formats.clear();
+        m_atlas.Release();
+        m_scratch.Release();
+        SafeRelease(m_pBrush);
+        SafeRelease(m_pTarget);
+        OnUnload();
+    }
+
+    const TextBitmapCache::Label& TextBitmapCache::GetLabel(const wchar_t* text, unsigned int length,
+        const TextFormat& format, const D2D1_COLOR_F& color, float maxWidth, float maxHeight)
+    {
+        if (!text && length) throw std::runtime_error("Text is null.");
+        Prepare();
+
+        // The lookup key keeps its capacity, so a hit doesn't allocate
+        m_lookup.text.assign(text, length);
+        m_lookup.pFormat = format.Get();
+        m_lookup.color = color;
+        m_lookup.maxWidth = maxWidth;
+        m_lookup.maxHeight = maxHeight;
+        auto found = m_labels.find(m_lookup);
+        if (found != m_labels.end())
+        {
+            ++m_hits;
+            return found->second;
+        }
+        ++m_misses;
+
+        IDWriteTextLayout* pLayout = format.GetLayout(text, length, maxWidth, maxHeight);
+        Label label;
+        try
+        {
+            label = Rasterize(pLayout);
+        }
+        catch (...)
+        {
+            SafeRelease(pLayout);
+            throw;
+        }
+        SafeRelease(pLayout);
+
+        if (std::find(m_formats.begin(), m_formats.end(), m_lookup.pFormat) == m_formats.end())
+        {
+            // Labels are keyed by the format's address, holding it keeps the address from being reused
+            m_lookup.pFormat->AddRef();
+            m_formats.push_back(m_lookup.pFormat);
+        }
+        return m_labels.emplace(m_lookup, label).first->second;
+    }
+
+    void TextBitmapCache::Draw(const wchar_t* text, unsigned int length, const TextFormat& format,
+        const D2D1_COLOR_F& color, float x, float y, float opacity)
+    {
+        const Label& label = GetLabel(text, length, format, color);
+        D2D1_RECT_F source = label.region.GetSourceRect();
+        D2D1_RECT_F dest = D2D1::RectF(x + label.offset.x, y + label.offset.y,
+            x + label.offset.x + (source.right - source.left), y + label.offset.y + (source.bottom - source.top));
+        m_pTarget->DrawBitmap(label.region.Get(), dest, opacity, D2D1_BITMAP_INTERPOLATION_MODE_LINEAR, &source);
+    }
+
+    void TextBitmapCache::Clear()
+    {
+        m_labels.clear();
+        for (IDWriteTextFormat*& pFormat : m_formats) SafeRelease(pFormat);
+        m_formats.clear();
+        m_atlas = TextureAtlas(m_pManager, m_pageSize, m_maxPageSize);
+    }
+
+    const TextureAtlas& TextBitmapCache::GetAtlas() const
+    {
+        return m_atlas;
+    }
+
+    TextBitmapCache::Stats TextBitmapCache::GetStats() const
+    {
+        Stats stats = {};
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.resets = m_resets;
+        stats.labels = (unsigned int)m_labels.size();
+        stats.pages = m_atlas.GetPageCount();
+        return stats;
+    }
+
+    void TextBitmapCache::ResetStats()
+    {
+        m_hits = m_misses = m_resets = 0ull;
+    }
+
+    void TextBitmapCache::Prepare()
+    {
+        if (!m_pManager) throw std::runtime_error("Resource manager is null.");
+
+        // Atlas pages and the scratch image belong to the render target they were made with
+        ID2D1RenderTarget* pRT = m_pManager->GetRenderTarget();
+        if (pRT == m_pTarget) return;
+        Clear();
+        m_scratch = ImageRenderTarget();
+        SafeRelease(m_pBrush);
+        SafeRelease(m_pTarget);
+        HRESULT hr = pRT->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_pBrush);
+        CheckHR(hr);
+        m_pTarget = pRT;
+        m_pTarget->AddRef();
+    }
+
+    TextBitmapCache::Label TextBitmapCache::Rasterize(IDWriteTextLayout* pLayout)
+    {
+        // Ink bounds relative to the layout origin, with a pixel of room for antialiasing
+        DWRITE_OVERHANG_METRICS overhang;
+        HRESULT hr = pLayout->GetOverhangMetrics(&overhang);
+        CheckHR(hr);
+        float left = std::floor(-overhang.left) - 1.0f;
+        float top = std::floor(-overhang.top) - 1.0f;
+        float right = std::ceil(pLayout->GetMaxWidth() + overhang.right) + 1.0f;
+        float bottom = std::ceil(pLayout->GetMaxHeight() + overhang.bottom) + 1.0f;
+        unsigned int width = right > left ? (unsigned int)(right - left) : 1u;
+        unsigned int height = bottom > top ? (unsigned int)(bottom - top) : 1u;
+        if (width > m_maxPageSize || height > m_maxPageSize) throw std::runtime_error("Label does not fit in the atlas.");
+
+        // One scratch image is reused for every label, it grows in powers of two
+        if (m_scratch.GetWidth() < width || m_scratch.GetHeight() < height)
+        {
+            unsigned int scratchWidth = m_scratch.GetWidth() > 256u ? m_scratch.GetWidth() : 256u;
+            unsigned int scratchHeight = m_scratch.GetHeight() > 64u ? m_scratch.GetHeight() : 64u;
+            while (scratchWidth < width) scratchWidth *= 2u;
+            while (scratchHeight < height) scratchHeight *= 2u;
+            m_scratch = ImageRenderTarget(m_pManager, scratchWidth, scratchHeight);
+        }
+
+        // Cleartype needs an opaque background, labels are drawn onto anything so they use grayscale
+        ID2D1RenderTarget* pScratch = m_scratch.GetRT();
+        m_pBrush->SetColor(m_lookup.color);
+        pScratch->BeginDraw();
+        pScratch->SetTransform(D2D1::Matrix3x2F::Identity());
+        pScratch->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+        pScratch->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+        pScratch->DrawTextLayout(D2D1::Point2F(-left, -top), pLayout, m_pBrush);
+        hr = pScratch->EndDraw();
+        CheckHR(hr);
+
+        D2D1_RECT_U source = D2D1::RectU(0u, 0u, width, height);
+        Label label;
+        try
+        {
+            label.region = m_atlas.Add(m_scratch.GetBitmap(), &source);
+        }
+        catch (const std::runtime_error&)
+        {
+            // Atlas pages can't free single labels, a full atlas starts over
+            if (m_labels.empty()) throw;
+            Clear();
+            ++m_resets;
+            label.region = m_atlas.Add(m_scratch.GetBitmap(), &source);
+        }
+        label.offset = D2D1::Point2F(left, top);
+        return label;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "ResourceManager.h"
+#include "TextureAtlas.h"
+#include "TextFormat.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Ice2D
+{
+	class TextBitmapCache : private IBasicResource
+	{
+	public:
+		struct Label
+		{
+			AtlasRegion region;
+			D2D1_POINT_2F offset;
+		};
+		struct Stats
+		{
+			unsigned long long hits, misses, resets;
+			unsigned int labels, pages;
+		};
+		TextBitmapCache();
+		TextBitmapCache(ResourceManager* pManager, unsigned int pageSize = 512u, unsigned int maxPageSize = 2048u);
+		TextBitmapCache(const TextBitmapCache& other) = delete;
+		TextBitmapCache& operator=(const TextBitmapCache& other) = delete;
+		TextBitmapCache(TextBitmapCache&& other) noexcept;
+		TextBitmapCache& operator=(TextBitmapCache&& other) noexcept;
+		~TextBitmapCache();
+		void Release() override;
+		const Label& GetLabel(const wchar_t* text, unsigned int length, const TextFormat& format,
+			const D2D1_COLOR_F& color, float maxWidth = 4096.0f, float maxHeight = 4096.0f);
+		void Draw(const wchar_t* text, unsigned int length, const TextFormat& format, const D2D1_COLOR_F& color,
+			float x, float y, float opacity = 1.0f);
+		void Clear();
+		const TextureAtlas& GetAtlas() const;
+		Stats GetStats() const;
+		void ResetStats();
+	private:
+		struct Key
+		{
+			std::wstring text;
+			IDWriteTextFormat* pFormat;
+			D2D1_COLOR_F color;
+			float maxWidth, maxHeight;
+			bool operator==(const Key& other) const;
+		};
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+		TextureAtlas m_atlas;
+		ImageRenderTarget m_scratch;
+		ID2D1SolidColorBrush* m_pBrush;
+		ID2D1RenderTarget* m_pTarget;
+		std::unordered_map<Key, Label, KeyHash> m_labels;
+		std::vector<IDWriteTextFormat*> m_formats;
+		Key m_lookup;
+		unsigned int m_pageSize, m_maxPageSize;
+		unsigned long long m_hits, m_misses, m_resets;
+		void Prepare();
+		Label Rasterize(IDWriteTextLayout* pLayout);
+	};
+}
@@ -25,7 +25,7 @@ namespace Ice2D
         IBasicResource(other), m_pFormat(other.m_pFormat)
     {
         other.m_pFormat = nullptr;
-        OnLoad();
+        OnMove(other);
     }
 
     TextFormat& TextFormat::operator=(TextFormat&& other) noexcept
@@ -36,7 +36,7 @@ namespace Ice2D
         m_pFormat = other.m_pFormat;
         other.m_pFormat = nullptr;
 
-        OnLoad();
+        OnMove(other);
         return *this;
     }
 
@@ -47,6 +47,8 @@ namespace Ice2D
 
     void TextFormat::Release()
     {
+        // Cached layouts keep the format alive, a format that is still tracked has a live manager
+        if (m_pFormat && !IsFree()) m_pManager->GetTextLayoutCache().Evict(m_pFormat);
         SafeRelease(m_pFormat);
         OnUnload();
     }
@@ -56,4 +58,21 @@ namespace Ice2D
         if (!m_pFormat) throw std::runtime_error("Text format is null.");
         return m_pFormat;
     }
+
+    IDWriteTextLayout* TextFormat::GetLayout(const wchar_t* text, unsigned int length, float maxWidth,
+        float maxHeight) const
+    {
+        IDWriteTextFormat* pFormat = Get();
+        return m_pManager->GetTextLayoutCache().GetLayout(m_pManager->GetWriteFactory(), text, length, pFormat,
+            maxWidth, maxHeight);
+    }
+
+    void TextFormat::Draw(const wchar_t* text, unsigned int length, const D2D1_RECT_F& rect, ID2D1Brush* pBrush,
+        D2D1_DRAW_TEXT_OPTIONS options) const
+    {
+        // Same result as DrawText, but the layout is reused while the string and box stay the same
+        IDWriteTextLayout* pLayout = GetLayout(text, length, rect.right - rect.left, rect.bottom - rect.top);
+        m_pManager->GetRenderTarget()->DrawTextLayout(D2D1::Point2F(rect.left, rect.top), pLayout, pBrush, options);
+        SafeRelease(pLayout);
+    }
 }
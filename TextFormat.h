@@ -19,6 +19,9 @@ namespace Ice2D
 		~TextFormat();
 		void Release() override;
 		IDWriteTextFormat* Get() const;
+		IDWriteTextLayout* GetLayout(const wchar_t* text, unsigned int length, float maxWidth, float maxHeight) const;
+		void Draw(const wchar_t* text, unsigned int length, const D2D1_RECT_F& rect, ID2D1Brush* pBrush,
+			D2D1_DRAW_TEXT_OPTIONS options = D2D1_DRAW_TEXT_OPTIONS_NONE) const;
 	private:
 		IDWriteTextFormat* m_pFormat;
 	};
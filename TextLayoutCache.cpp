@@ -0,0 +1,183 @@
+#include "pch.h"
+
+#include "TextLayoutCache.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+#include <cstring>
+#include <cwchar>
+
+namespace Ice2D
+{
+    static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static const uint64_t FNV_PRIME = 1099511628211ull;
+
+    static uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+    {
+        const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+        for (size_t i = 0u; i < size; ++i)
+        {
+            hash ^= pBytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    TextLayoutCache::TextLayoutCache(size_t budget) :
+        m_budget(budget), m_bytes(0u), m_hits(0ull), m_misses(0ull), m_evictions(0ull)
+    {
+    }
+
+    TextLayoutCache::~TextLayoutCache()
+    {
+        Clear();
+    }
+
+    void TextLayoutCache::SetBudget(size_t bytes)
+    {
+        m_budget = bytes;
+        Trim();
+    }
+
+    size_t TextLayoutCache::GetBudget() const
+    {
+        return m_budget;
+    }
+
+    bool TextLayoutCache::IsEnabled() const
+    {
+        return m_budget > 0u;
+    }
+
+    IDWriteTextLayout* TextLayoutCache::GetLayout(IDWriteFactory* pFactory, const wchar_t* text, unsigned int length,
+        IDWriteTextFormat* pFormat, float maxWidth, float maxHeight)
+    {
+        if (!pFactory) throw std::runtime_error("DirectWrite factory is null.");
+        if (!pFormat) throw std::runtime_error("Text format is null.");
+        if (!text && length) throw std::runtime_error("Text is null.");
+
+        // Hits only hash and compare the caller's string, nothing is allocated
+        uint64_t key = 0ull;
+        if (IsEnabled())
+        {
+            key = MakeKey(text, length, pFormat, maxWidth, maxHeight);
+            auto found = m_index.find(key);
+            if (found != m_index.end())
+            {
+                const Entry& entry = *found->second;
+                if (entry.pFormat == pFormat && entry.maxWidth == maxWidth && entry.maxHeight == maxHeight &&
+                    entry.text.size() == length && std::wmemcmp(entry.text.data(), text, length) == 0)
+                {
+                    ++m_hits;
+                    m_lru.splice(m_lru.begin(), m_lru, found->second);
+                    m_lru.front().pLayout->AddRef();
+                    return m_lru.front().pLayout;
+                }
+            }
+            ++m_misses;
+        }
+
+        IDWriteTextLayout* pLayout = nullptr;
+        HRESULT hr = pFactory->CreateTextLayout(text, length, pFormat, maxWidth, maxHeight, &pLayout);
+        CheckHR(hr);
+
+        if (IsEnabled())
+        {
+            // DirectWrite keeps glyph runs and line data per character, roughly a hundred bytes each
+            Entry entry = { key, std::wstring(text, length), pFormat, maxWidth, maxHeight, pLayout,
+                sizeof(Entry) + 512u + (size_t)length * (sizeof(wchar_t) + 96u) };
+            pFormat->AddRef();
+            pLayout->AddRef();
+            Insert(std::move(entry));
+        }
+        return pLayout;
+    }
+
+    void TextLayoutCache::Evict(IDWriteTextFormat* pFormat)
+    {
+        for (auto it = m_lru.begin(); it != m_lru.end();)
+        {
+            auto next = std::next(it);
+            if (it->pFormat == pFormat) Remove(it);
+            it = next;
+        }
+    }
+
+    void TextLayoutCache::Clear()
+    {
+        while (!m_lru.empty()) Remove(m_lru.begin());
+    }
+
+    TextLayoutCache::Stats TextLayoutCache::GetStats() const
+    {
+        Stats stats = {};
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.bytes = m_bytes;
+        stats.budget = m_budget;
+        stats.entries = (unsigned int)m_lru.size();
+        return stats;
+    }
+
+    void TextLayoutCache::ResetStats()
+    {
+        m_hits = m_misses = m_evictions = 0ull;
+    }
+
+    uint64_t TextLayoutCache::MakeKey(const wchar_t* text, unsigned int length, IDWriteTextFormat* pFormat,
+        float maxWidth, float maxHeight)
+    {
+        // Entries hold a reference to their format, so its address can't be reused while it is a key
+        maxWidth += 0.0f;
+        maxHeight += 0.0f;
+        uint64_t key = HashBytes(FNV_OFFSET, text, (size_t)length * sizeof(wchar_t));
+        key = HashBytes(key, &pFormat, sizeof(pFormat));
+        key = HashBytes(key, &maxWidth, sizeof(maxWidth));
+        return HashBytes(key, &maxHeight, sizeof(maxHeight));
+    }
+
+    void TextLayoutCache::Insert(Entry&& entry)
+    {
+        auto found = m_index.find(entry.key);
+        if (found != m_index.end()) Remove(found->second);
+
+        m_bytes += entry.bytes;
+        m_lru.push_front(std::move(entry));
+        m_index[m_lru.front().key] = m_lru.begin();
+        Trim();
+    }
+
+    void TextLayoutCache::Remove(std::list<Entry>::iterator it)
+    {
+        m_bytes -= it->bytes;
+        SafeRelease(it->pLayout);
+        SafeRelease(it->pFormat);
+        m_index.erase(it->key);
+        m_lru.erase(it);
+    }
+
+    void TextLayoutCache::Trim()
+    {
+        // Cold entries nobody else holds go first, the same policy as the other caches
+        for (auto it = m_lru.end(); m_bytes > m_budget && it != m_lru.begin();)
+        {
+            --it;
+            if (InUse(*it)) continue;
+            auto victim = it++;
+            Remove(victim);
+            ++m_evictions;
+        }
+
+        while (m_bytes > m_budget && !m_lru.empty())
+        {
+            Remove(std::prev(m_lru.end()));
+            ++m_evictions;
+        }
+    }
+
+    bool TextLayoutCache::InUse(const Entry& entry)
+    {
+        entry.pLayout->AddRef();
+        return entry.pLayout->Release() > 1u;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <d2d1.h>
+#include <dwrite.h>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace Ice2D
+{
+	class TextLayoutCache
+	{
+	public:
+		struct Stats
+		{
+			unsigned long long hits, misses, evictions;
+			size_t bytes, budget;
+			unsigned int entries;
+		};
+		TextLayoutCache(size_t budget = 4u * 1024u * 1024u);
+		TextLayoutCache(const TextLayoutCache& other) = delete;
+		TextLayoutCache& operator=(const TextLayoutCache& other) = delete;
+		~TextLayoutCache();
+		void SetBudget(size_t bytes);
+		size_t GetBudget() const;
+		bool IsEnabled() const;
+		IDWriteTextLayout* GetLayout(IDWriteFactory* pFactory, const wchar_t* text, unsigned int length,
+			IDWriteTextFormat* pFormat, float maxWidth, float maxHeight);
+		void Evict(IDWriteTextFormat* pFormat);
+		void Clear();
+		Stats GetStats() const;
+		void ResetStats();
+	private:
+		struct Entry
+		{
+			uint64_t key;
+			std::wstring text;
+			IDWriteTextFormat* pFormat;
+			float maxWidth, maxHeight;
+			IDWriteTextLayout* pLayout;
+			size_t bytes;
+		};
+		std::list<Entry> m_lru;
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+		size_t m_budget, m_bytes;
+		unsigned long long m_hits, m_misses, m_evictions;
+		static uint64_t MakeKey(const wchar_t* text, unsigned int length, IDWriteTextFormat* pFormat,
+			float maxWidth, float maxHeight);
+		void Insert(Entry&& entry);
+		void Remove(std::list<Entry>::iterator it);
+		void Trim();
+		static bool InUse(const Entry& entry);
+	};
+}
@@ -0,0 +1,263 @@
+#include "pch.h"
+
+#include "TextureAtlas.h"
+#include "SafeRelease.h"
+#include "HRException.h"
+#include <cstring>
+
+namespace Ice2D
+{
+    ID2D1Bitmap* AtlasRegion::Get() const
+    {
+        // Looked up on every call, pages are replaced when the atlas grows
+        if (!pPages) throw std::runtime_error("Atlas region is null.");
+        return (*pPages)[page];
+    }
+
+    D2D_RECT_F AtlasRegion::GetSourceRect() const
+    {
+        return source;
+    }
+
+    unsigned int AtlasRegion::GetWidth() const
+    {
+        return (unsigned int)(source.right - source.left);
+    }
+
+    unsigned int AtlasRegion::GetHeight() const
+    {
+        return (unsigned int)(source.bottom - source.top);
+    }
+
+    TextureAtlas::TextureAtlas() : m_pPages(new std::vector<ID2D1Bitmap*>())
+    {
+    }
+
+    TextureAtlas::TextureAtlas(ResourceManager* pManager, unsigned int pageSize, unsigned int maxPageSize,
+        unsigned int padding) : IBasicResource(pManager), m_packer(pageSize, pageSize, maxPageSize, maxPageSize, padding),
+        m_pPages(new std::vector<ID2D1Bitmap*>())
+    {
+        OnLoad();
+    }
+
+    TextureAtlas::TextureAtlas(TextureAtlas&& other) noexcept : IBasicResource(other),
+        m_packer(std::move(other.m_packer)), m_pPages(std::move(other.m_pPages))
+    {
+        OnMove(other);
+    }
+
+    TextureAtlas& TextureAtlas::operator=(TextureAtlas&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_pManager = other.m_pManager;
+        Release();
+        m_packer = std::move(other.m_packer);
+        m_pPages = std::move(other.m_pPages);
+
+        OnMove(other);
+        return *this;
+    }
+
+    TextureAtlas::~TextureAtlas()
+    {
+        Release();
+    }
+
+    void TextureAtlas::Release()
+    {
+        if (m_pPages)
+        {
+            for (ID2D1Bitmap*& pPage : *m_pPages)
+            {
+                SafeRelease(pPage);
+            }
+            m_pPages->clear();
+        }
+        m_packer.Clear();
+        OnUnload();
+    }
+
+    AtlasRegion TextureAtlas::Add(const D2DImage& image)
+    {
+        return Add(image.Get());
+    }
+
+    AtlasRegion TextureAtlas::Add(ID2D1Bitmap* pBitmap, const D2D1_RECT_U* pSource)
+    {
+        if (!pBitmap) throw std::runtime_error("Atlas bitmap is null.");
+        D2D1_RECT_U source;
+        if (pSource)
+        {
+            source = *pSource;
+        }
+        else
+        {
+            auto size = pBitmap->GetPixelSize();
+            source = D2D1::RectU(0u, 0u, size.width, size.height);
+        }
+        const unsigned int width = source.right - source.left;
+        const unsigned int height = source.bottom - source.top;
+
+        AtlasPacker::Region region = Allocate(width, height);
+        ID2D1Bitmap* pPage = (*m_pPages)[region.page];
+        D2D1_POINT_2U point = D2D1::Point2U(region.x, region.y);
+        HRESULT hr = pPage->CopyFromBitmap(&point, pBitmap, &source);
+        CheckHR(hr);
+
+        // Repeat the edge pixels into the padding so filtering never samples a neighbour
+        const unsigned int padding = m_packer.GetPadding();
+        for (unsigned int i = 1u; i <= padding; ++i)
+        {
+            D2D1_RECT_U top = D2D1::RectU(source.left, source.top, source.right, source.top + 1u);
+            D2D1_RECT_U bottom = D2D1::RectU(source.left, source.bottom - 1u, source.right, source.bottom);
+            D2D1_RECT_U left = D2D1::RectU(source.left, source.top, source.left + 1u, source.bottom);
+            D2D1_RECT_U right = D2D1::RectU(source.right - 1u, source.top, source.right, source.bottom);
+            point = D2D1::Point2U(region.x, region.y - i);
+            hr = pPage->CopyFromBitmap(&point, pBitmap, &top);
+            CheckHR(hr);
+            point = D2D1::Point2U(region.x, region.y + height - 1u + i);
+            hr = pPage->CopyFromBitmap(&point, pBitmap, &bottom);
+            CheckHR(hr);
+            point = D2D1::Point2U(region.x - i, region.y);
+            hr = pPage->CopyFromBitmap(&point, pBitmap, &left);
+            CheckHR(hr);
+            point = D2D1::Point2U(region.x + width - 1u + i, region.y);
+            hr = pPage->CopyFromBitmap(&point, pBitmap, &right);
+            CheckHR(hr);
+
+            for (unsigned int j = 1u; j <= padding; ++j)
+            {
+                D2D1_RECT_U corners[4] = {
+                    D2D1::RectU(source.left, source.top, source.left + 1u, source.top + 1u),
+                    D2D1::RectU(source.right - 1u, source.top, source.right, source.top + 1u),
+                    D2D1::RectU(source.left, source.bottom - 1u, source.left + 1u, source.bottom),
+                    D2D1::RectU(source.right - 1u, source.bottom - 1u, source.right, source.bottom) };
+                D2D1_POINT_2U points[4] = {
+                    D2D1::Point2U(region.x - i, region.y - j),
+                    D2D1::Point2U(region.x + width - 1u + i, region.y - j),
+                    D2D1::Point2U(region.x - i, region.y + height - 1u + j),
+                    D2D1::Point2U(region.x + width - 1u + i, region.y + height - 1u + j) };
+                for (unsigned int k = 0u; k < 4u; ++k)
+                {
+                    hr = pPage->CopyFromBitmap(&points[k], pBitmap, &corners[k]);
+                    CheckHR(hr);
+                }
+            }
+        }
+
+        return MakeRegion(region);
+    }
+
+    AtlasRegion TextureAtlas::Add(unsigned int width, unsigned int height, const void* pPixels, unsigned int stride)
+    {
+        if (!pPixels) throw std::runtime_error("Atlas pixels are null.");
+        AtlasPacker::Region region = Allocate(width, height);
+
+        // Pixels are premultiplied 32bpp BGRA, extruded on the CPU so the upload is a single copy
+        const unsigned int padding = m_packer.GetPadding();
+        const unsigned int paddedWidth = width + 2u * padding;
+        const unsigned int paddedHeight = height + 2u * padding;
+        std::vector<UINT32> padded((size_t)paddedWidth * paddedHeight);
+        for (unsigned int y = 0u; y < paddedHeight; ++y)
+        {
+            unsigned int srcY = y < padding ? 0u : y - padding < height ? y - padding : height - 1u;
+            const UINT32* pSrc = reinterpret_cast<const UINT32*>(static_cast<const BYTE*>(pPixels) + (size_t)srcY * stride);
+            UINT32* pDst = &padded[(size_t)y * paddedWidth];
+            for (unsigned int x = 0u; x < padding; ++x)
+            {
+                pDst[x] = pSrc[0];
+                pDst[padding + width + x] = pSrc[width - 1u];
+            }
+            std::memcpy(pDst + padding, pSrc, (size_t)width * sizeof(UINT32));
+        }
+
+        D2D1_RECT_U dest = D2D1::RectU(region.x - padding, region.y - padding,
+            region.x + width + padding, region.y + height + padding);
+        HRESULT hr = (*m_pPages)[region.page]->CopyFromMemory(&dest, padded.data(), paddedWidth * sizeof(UINT32));
+        CheckHR(hr);
+        return MakeRegion(region);
+    }
+
+    std::vector<AtlasRegion> TextureAtlas::Add(const ImageSequence& sequence)
+    {
+        std::vector<AtlasRegion> regions;
+        regions.reserve(sequence.GetFrameCount());
+        for (unsigned int i = 0u; i < sequence.GetFrameCount(); ++i)
+        {
+            regions.push_back(Add(sequence.GetFrame(i)));
+        }
+        return regions;
+    }
+
+    unsigned int TextureAtlas::GetPageCount() const
+    {
+        return (unsigned int)m_pPages->size();
+    }
+
+    ID2D1Bitmap* TextureAtlas::GetPage(unsigned int page) const
+    {
+        return m_pPages->at(page);
+    }
+
+    const AtlasPacker& TextureAtlas::GetPacker() const
+    {
+        return m_packer;
+    }
+
+    AtlasPacker::Region TextureAtlas::Allocate(unsigned int width, unsigned int height)
+    {
+        AtlasPacker::Region region;
+        if (!m_packer.Insert(width, height, region)) throw std::runtime_error("Image does not fit in the atlas.");
+
+        // The packer may have grown the page it used
+        SyncPage(region.page);
+        return region;
+    }
+
+    void TextureAtlas::SyncPage(unsigned int page)
+    {
+        const unsigned int width = m_packer.GetPageWidth(page);
+        const unsigned int height = m_packer.GetPageHeight(page);
+        ID2D1Bitmap* pOld = page < m_pPages->size() ? (*m_pPages)[page] : nullptr;
+        if (pOld)
+        {
+            auto size = pOld->GetPixelSize();
+            if (size.width == width && size.height == height) return;
+        }
+
+        ID2D1Bitmap* pBitmap = nullptr;
+        D2D1_PIXEL_FORMAT pixelFormat = D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+        HRESULT hr = m_pManager->GetRenderTarget()->CreateBitmap(D2D1::SizeU(width, height),
+            D2D1::BitmapProperties(pixelFormat), &pBitmap);
+        CheckHR(hr);
+
+        if (pOld)
+        {
+            auto size = pOld->GetPixelSize();
+            D2D1_POINT_2U point = D2D1::Point2U();
+            D2D1_RECT_U rect = D2D1::RectU(0u, 0u, size.width, size.height);
+            hr = pBitmap->CopyFromBitmap(&point, pOld, &rect);
+            if (FAILED(hr))
+            {
+                SafeRelease(pBitmap);
+                CheckHR(hr);
+            }
+            SafeRelease(pOld);
+            (*m_pPages)[page] = pBitmap;
+        }
+        else
+        {
+            m_pPages->push_back(pBitmap);
+        }
+    }
+
+    AtlasRegion TextureAtlas::MakeRegion(const AtlasPacker::Region& region) const
+    {
+        AtlasRegion result;
+        result.pPages = m_pPages.get();
+        result.page = region.page;
+        result.source = D2D1::RectF((float)region.x, (float)region.y,
+            (float)(region.x + region.width), (float)(region.y + region.height));
+        return result;
+    }
+}
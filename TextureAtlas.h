@@ -0,0 +1,47 @@
+#pragma once
+#include "ResourceManager.h"
+#include "AtlasPacker.h"
+#include "Images.h"
+#include <memory>
+#include <vector>
+
+namespace Ice2D
+{
+	struct AtlasRegion
+	{
+		const std::vector<ID2D1Bitmap*>* pPages;
+		unsigned int page;
+		D2D1_RECT_F source;
+		ID2D1Bitmap* Get() const;
+		D2D_RECT_F GetSourceRect() const;
+		unsigned int GetWidth() const;
+		unsigned int GetHeight() const;
+	};
+
+	class TextureAtlas : private IBasicResource
+	{
+	public:
+		TextureAtlas();
+		TextureAtlas(ResourceManager* pManager, unsigned int pageSize = 512u, unsigned int maxPageSize = 2048u,
+			unsigned int padding = 1u);
+		TextureAtlas(const TextureAtlas& other) = delete;
+		TextureAtlas& operator=(const TextureAtlas& other) = delete;
+		TextureAtlas(TextureAtlas&& other) noexcept;
+		TextureAtlas& operator=(TextureAtlas&& other) noexcept;
+		~TextureAtlas();
+		void Release() override;
+		AtlasRegion Add(const D2DImage& image);
+		AtlasRegion Add(ID2D1Bitmap* pBitmap, const D2D1_RECT_U* pSource = nullptr);
+		AtlasRegion Add(unsigned int width, unsigned int height, const void* pPixels, unsigned int stride);
+		std::vector<AtlasRegion> Add(const ImageSequence& sequence);
+		unsigned int GetPageCount() const;
+		ID2D1Bitmap* GetPage(unsigned int page) const;
+		const AtlasPacker& GetPacker() const;
+	private:
+		AtlasPacker m_packer;
+		std::unique_ptr<std::vector<ID2D1Bitmap*>> m_pPages;
+		AtlasPacker::Region Allocate(unsigned int width, unsigned int height);
+		void SyncPage(unsigned int page);
+		AtlasRegion MakeRegion(const AtlasPacker::Region& region) const;
+	};
+}
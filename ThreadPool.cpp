@@ -0,0 +1,131 @@
+#include "pch.h"
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace Ice2D
+{
+    // Set on pool threads, a ParallelFor from inside a chunk runs inline instead of waiting on itself
+    static thread_local bool t_inPool = false;
+
+    ThreadPool::ThreadPool() : ThreadPool(DefaultThreadCount())
+    {
+    }
+
+    ThreadPool::ThreadPool(unsigned int threadCount) :
+        m_pBody(nullptr), m_begin(0u), m_end(0u), m_chunkSize(0u), m_chunkCount(0u), m_remaining(0u),
+        m_generation(0ull), m_stopping(false)
+    {
+        // The calling thread takes the first chunk, so it counts as one of the threads
+        for (unsigned int i = 1u; i < threadCount; ++i)
+        {
+            m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& worker : m_workers) worker.join();
+    }
+
+    unsigned int ThreadPool::GetThreadCount() const
+    {
+        return (unsigned int)m_workers.size() + 1u;
+    }
+
+    void ThreadPool::ParallelFor(unsigned int begin, unsigned int end, const RangeFunction& body, unsigned int minChunk)
+    {
+        if (end <= begin) return;
+        unsigned int count = end - begin;
+        unsigned int chunks = std::min(GetThreadCount(), std::max(count / std::max(minChunk, 1u), 1u));
+
+        // Too small to split, nested, or another thread is already using the pool
+        if (chunks < 2u || t_inPool || !m_dispatch.try_lock())
+        {
+            body(begin, end);
+            return;
+        }
+        std::lock_guard<std::mutex> dispatch(m_dispatch, std::adopt_lock);
+
+        // Fixed contiguous ranges, the same index always lands in the same chunk
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pBody = &body;
+            m_begin = begin;
+            m_end = end;
+            m_chunkSize = (count + chunks - 1u) / chunks;
+            m_chunkCount = (count + m_chunkSize - 1u) / m_chunkSize;
+            m_remaining = m_chunkCount - 1u;
+            m_error = nullptr;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        t_inPool = true;
+        RunChunk(0u);
+        t_inPool = false;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_remaining == 0u; });
+        m_pBody = nullptr;
+        if (m_error)
+        {
+            std::exception_ptr error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    ThreadPool& ThreadPool::GetShared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    unsigned int ThreadPool::DefaultThreadCount()
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        return cores > 0u ? cores : 1u;
+    }
+
+    void ThreadPool::WorkerLoop(unsigned int index)
+    {
+        t_inPool = true;
+        unsigned long long seen = 0ull;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+                if (m_stopping) return;
+                seen = m_generation;
+                if (index >= m_chunkCount) continue;
+            }
+
+            RunChunk(index);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_remaining == 0u) m_done.notify_one();
+        }
+    }
+
+    void ThreadPool::RunChunk(unsigned int chunk)
+    {
+        unsigned int first = m_begin + chunk * m_chunkSize;
+        unsigned int last = std::min(first + m_chunkSize, m_end);
+        try
+        {
+            (*m_pBody)(first, last);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error) m_error = std::current_exception();
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Ice2D
+{
+	class ThreadPool
+	{
+	public:
+		typedef std::function<void(unsigned int begin, unsigned int end)> RangeFunction;
+		ThreadPool();
+		ThreadPool(unsigned int threadCount);
+		ThreadPool(const ThreadPool& other) = delete;
+		ThreadPool& operator=(const ThreadPool& other) = delete;
+		~ThreadPool();
+		unsigned int GetThreadCount() const;
+		void ParallelFor(unsigned int begin, unsigned int end, const RangeFunction& body, unsigned int minChunk = 1u);
+		static ThreadPool& GetShared();
+		static unsigned int DefaultThreadCount();
+	private:
+		std::vector<std::thread> m_workers;
+		std::mutex m_mutex, m_dispatch;
+		std::condition_variable m_wake, m_done;
+		const RangeFunction* m_pBody;
+		unsigned int m_begin, m_end, m_chunkSize, m_chunkCount, m_remaining;
+		unsigned long long m_generation;
+		std::exception_ptr m_error;
+		bool m_stopping;
+		void WorkerLoop(unsigned int index);
+		void RunChunk(unsigned int chunk);
+	};
+}
\ No newline at end of file
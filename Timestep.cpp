@@ -0,0 +1,87 @@
+#include "pch.h"
+
+#include "Timestep.h"
+
+namespace Ice2D
+{
+    FixedTimestep::FixedTimestep() : FixedTimestep(60u)
+    {
+    }
+
+    FixedTimestep::FixedTimestep(unsigned int tickRate, unsigned int maxSteps) :
+        m_step(), m_accumulator(), m_tickRate(0u), m_maxSteps(maxSteps), m_ticks(0ull), m_droppedTicks(0ull)
+    {
+        SetTickRate(tickRate);
+    }
+
+    void FixedTimestep::SetTickRate(unsigned int tickRate)
+    {
+        if (tickRate == 0u) throw std::invalid_argument("Tick rate must be greater than zero.");
+        m_tickRate = tickRate;
+        m_step = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+            std::chrono::nanoseconds(1'000'000'000 / tickRate));
+        if (m_step.count() <= 0) m_step = std::chrono::high_resolution_clock::duration(1);
+        m_accumulator = std::chrono::high_resolution_clock::duration::zero();
+    }
+
+    void FixedTimestep::SetMaxSteps(unsigned int maxSteps)
+    {
+        m_maxSteps = maxSteps;
+    }
+
+    unsigned int FixedTimestep::GetTickRate() const
+    {
+        return m_tickRate;
+    }
+
+    unsigned int FixedTimestep::GetMaxSteps() const
+    {
+        return m_maxSteps;
+    }
+
+    std::chrono::high_resolution_clock::duration FixedTimestep::GetStep() const
+    {
+        return m_step;
+    }
+
+    unsigned int FixedTimestep::Advance(std::chrono::high_resolution_clock::duration elapsed)
+    {
+        if (elapsed.count() > 0) m_accumulator += elapsed;
+
+        auto pending = m_accumulator / m_step;
+        unsigned int steps = (unsigned int)pending;
+
+        // Drop whole ticks beyond the catch-up limit, keeping the phase of the remainder
+        if (m_maxSteps > 0u && pending > m_maxSteps)
+        {
+            steps = m_maxSteps;
+            m_droppedTicks += pending - m_maxSteps;
+        }
+        m_accumulator -= pending * m_step;
+        m_ticks += steps;
+
+        return steps;
+    }
+
+    float FixedTimestep::GetAlpha() const
+    {
+        return (float)m_accumulator.count() / (float)m_step.count();
+    }
+
+    unsigned long long FixedTimestep::GetTickCount() const
+    {
+        return m_ticks;
+    }
+
+    unsigned long long FixedTimestep::GetDroppedTicks() const
+    {
+        return m_droppedTicks;
+    }
+
+    void FixedTimestep::Reset()
+    {
+        m_accumulator = std::chrono::high_resolution_clock::duration::zero();
+        m_ticks = 0ull;
+        m_droppedTicks = 0ull;
+    }
+}
\ No newline at end of file
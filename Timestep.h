@@ -0,0 +1,26 @@
+#pragma once
+#include <chrono>
+
+namespace Ice2D
+{
+	class FixedTimestep
+	{
+	public:
+		FixedTimestep();
+		FixedTimestep(unsigned int tickRate, unsigned int maxSteps = 5u);
+		void SetTickRate(unsigned int tickRate);
+		void SetMaxSteps(unsigned int maxSteps);
+		unsigned int GetTickRate() const;
+		unsigned int GetMaxSteps() const;
+		std::chrono::high_resolution_clock::duration GetStep() const;
+		unsigned int Advance(std::chrono::high_resolution_clock::duration elapsed);
+		float GetAlpha() const;
+		unsigned long long GetTickCount() const;
+		unsigned long long GetDroppedTicks() const;
+		void Reset();
+	private:
+		std::chrono::high_resolution_clock::duration m_step, m_accumulator;
+		unsigned int m_tickRate, m_maxSteps;
+		unsigned long long m_ticks, m_droppedTicks;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "pch.h"
+
+#include "VoiceAllocator.h"
+
+namespace Ice2D
+{
+    VoiceAllocator::VoiceAllocator(unsigned int maxVoices, StealMode mode) : m_maxVoices(maxVoices),
+        m_defaultSoundLimit(0u), m_active(0u), m_mode(mode), m_clock(0ull), m_stats()
+    {
+    }
+
+    unsigned int VoiceAllocator::AddSlot(unsigned int format)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_slots.push_back({ format, 0u, nullptr, 0.0f, 0ull, false });
+        return (unsigned int)m_slots.size() - 1u;
+    }
+
+    void VoiceAllocator::SetMaxVoices(unsigned int maxVoices)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxVoices = maxVoices;
+    }
+
+    void VoiceAllocator::SetStealMode(StealMode mode)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_mode = mode;
+    }
+
+    void VoiceAllocator::SetDefaultSoundLimit(unsigned int limit)
+    {
+        // 0 means no limit
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_defaultSoundLimit = limit;
+    }
+
+    void VoiceAllocator::SetSoundLimit(const void* pSound, unsigned int limit)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_soundLimits[pSound] = limit;
+    }
+
+    void VoiceAllocator::ClearSoundLimit(const void* pSound)
+    {
+        // Limits are kept until cleared, a sound freed with its limit set would pass it on to the next sample
+        // buffer allocated at the same address
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_soundLimits.erase(pSound);
+    }
+
+    bool VoiceAllocator::Acquire(unsigned int format, const void* pSound, float volume, Allocation& allocation)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        allocation = { 0u, 0u, -1, false };
+
+        // A sound over its own limit replaces one of its own voices, otherwise the global cap applies
+        auto limit = m_soundLimits.find(pSound);
+        unsigned int soundLimit = limit != m_soundLimits.end() ? limit->second : m_defaultSoundLimit;
+        auto count = m_soundCounts.find(pSound);
+        unsigned int soundCount = count != m_soundCounts.end() ? count->second : 0u;
+
+        int victim = -1;
+        if (soundLimit > 0u && soundCount >= soundLimit)
+        {
+            victim = PickVictim(pSound, -1);
+        }
+        else if (m_active >= m_maxVoices)
+        {
+            // A voice of the same format can be reused as is, any other one just makes room
+            victim = PickVictim(nullptr, (int)format);
+            if (victim < 0) victim = PickVictim(nullptr, -1);
+        }
+        else
+        {
+            victim = -2;
+        }
+        if (victim == -1)
+        {
+            ++m_stats.rejects;
+            return false;
+        }
+
+        int slot = -1;
+        if (victim >= 0)
+        {
+            Stop(m_slots[victim]);
+            allocation.stopped = victim;
+            ++m_stats.steals;
+            if (m_slots[victim].format == format) slot = victim;
+        }
+        if (slot < 0)
+        {
+            for (size_t i = 0u; i < m_slots.size(); ++i)
+            {
+                if (!m_slots[i].active && m_slots[i].format == format)
+                {
+                    slot = (int)i;
+                    break;
+                }
+            }
+        }
+        if (slot < 0)
+        {
+            // Nothing free in this format, the caller has to create the voice
+            m_slots.push_back({ format, 0u, nullptr, 0.0f, 0ull, false });
+            slot = (int)m_slots.size() - 1;
+            allocation.created = true;
+            ++m_stats.created;
+        }
+
+        Slot& s = m_slots[slot];
+        ++s.generation;
+        s.pSound = pSound;
+        s.volume = volume;
+        s.started = ++m_clock;
+        s.active = true;
+        ++m_active;
+        ++m_soundCounts[pSound];
+        ++m_stats.plays;
+        allocation.slot = (unsigned int)slot;
+        allocation.generation = s.generation;
+        return true;
+    }
+
+    bool VoiceAllocator::Release(unsigned int slot, unsigned int generation)
+    {
+        // Buffers of a stolen voice end after it was handed out again, their generation no longer matches
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (slot >= m_slots.size()) return false;
+        Slot& s = m_slots[slot];
+        if (!s.active || s.generation != generation) return false;
+        Stop(s);
+        return true;
+    }
+
+    void VoiceAllocator::SetVolume(unsigned int slot, float volume)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (slot < m_slots.size()) m_slots[slot].volume = volume;
+    }
+
+    void VoiceAllocator::ReleaseAll()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Slot& slot : m_slots)
+        {
+            if (slot.active) Stop(slot);
+        }
+    }
+
+    unsigned int VoiceAllocator::GetSlotCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return (unsigned int)m_slots.size();
+    }
+
+    unsigned int VoiceAllocator::GetSlotFormat(unsigned int slot) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_slots.at(slot).format;
+    }
+
+    unsigned int VoiceAllocator::GetActiveCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_active;
+    }
+
+    unsigned int VoiceAllocator::GetActiveCount(const void* pSound) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto count = m_soundCounts.find(pSound);
+        return count != m_soundCounts.end() ? count->second : 0u;
+    }
+
+    VoiceAllocator::Stats VoiceAllocator::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    int VoiceAllocator::PickVictim(const void* pSound, int format) const
+    {
+        // Oldest start first, or lowest volume with age breaking ties
+        if (m_mode == StealMode::None) return -1;
+        int victim = -1;
+        for (size_t i = 0u; i < m_slots.size(); ++i)
+        {
+            const Slot& slot = m_slots[i];
+            if (!slot.active || (pSound && slot.pSound != pSound) || (format >= 0 && slot.format != (unsigned int)format))
+            {
+                continue;
+            }
+            if (victim < 0)
+            {
+                victim = (int)i;
+                continue;
+            }
+            const Slot& best = m_slots[victim];
+            bool better = m_mode == StealMode::Quietest ?
+                slot.volume < best.volume || (slot.volume == best.volume && slot.started < best.started) :
+                slot.started < best.started;
+            if (better) victim = (int)i;
+        }
+        return victim;
+    }
+
+    void VoiceAllocator::Stop(Slot& slot)
+    {
+        slot.active = false;
+        --m_active;
+        auto count = m_soundCounts.find(slot.pSound);
+        if (count != m_soundCounts.end() && --count->second == 0u) m_soundCounts.erase(count);
+        slot.pSound = nullptr;
+    }
+}
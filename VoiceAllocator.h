@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Ice2D
+{
+	class VoiceAllocator
+	{
+	public:
+		enum class StealMode { None, Oldest, Quietest };
+		struct Allocation
+		{
+			unsigned int slot, generation;
+			int stopped;
+			bool created;
+		};
+		struct Stats
+		{
+			unsigned long long plays, steals, rejects, created;
+		};
+		VoiceAllocator(unsigned int maxVoices = 32u, StealMode mode = StealMode::Oldest);
+		unsigned int AddSlot(unsigned int format);
+		void SetMaxVoices(unsigned int maxVoices);
+		void SetStealMode(StealMode mode);
+		void SetDefaultSoundLimit(unsigned int limit);
+		void SetSoundLimit(const void* pSound, unsigned int limit);
+		void ClearSoundLimit(const void* pSound);
+		bool Acquire(unsigned int format, const void* pSound, float volume, Allocation& allocation);
+		bool Release(unsigned int slot, unsigned int generation);
+		void SetVolume(unsigned int slot, float volume);
+		void ReleaseAll();
+		unsigned int GetSlotCount() const;
+		unsigned int GetSlotFormat(unsigned int slot) const;
+		unsigned int GetActiveCount() const;
+		unsigned int GetActiveCount(const void* pSound) const;
+		Stats GetStats() const;
+	private:
+		struct Slot
+		{
+			unsigned int format, generation;
+			const void* pSound;
+			float volume;
+			unsigned long long started;
+			bool active;
+		};
+		std::vector<Slot> m_slots;
+		std::unordered_map<const void*, unsigned int> m_soundLimits, m_soundCounts;
+		unsigned int m_maxVoices, m_defaultSoundLimit, m_active;
+		StealMode m_mode;
+		unsigned long long m_clock;
+		Stats m_stats;
+		mutable std::mutex m_mutex;
+		int PickVictim(const void* pSound, int format) const;
+		void Stop(Slot& slot);
+	};
+}
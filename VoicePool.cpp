@@ -0,0 +1,230 @@
+#include "pch.h"
+
+#include "VoicePool.h"
+#include "HRException.h"
+#include <cstring>
+
+namespace Ice2D
+{
+    // One source voice of the pool, buffer ends hand the voice back to the allocator
+    class VoicePool::Slot : public IXAudio2VoiceCallback
+    {
+    public:
+        Slot(VoiceAllocator* pAllocator, unsigned int index) : pAllocator(pAllocator), index(index), pVoice(nullptr)
+        {
+        }
+
+        ~Slot()
+        {
+            if (pVoice) pVoice->DestroyVoice();
+        }
+
+        void STDMETHODCALLTYPE OnBufferEnd(void* pContext) override
+        {
+            pAllocator->Release(index, (unsigned int)reinterpret_cast<uintptr_t>(pContext));
+        }
+
+        void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32) override {}
+        void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+        void STDMETHODCALLTYPE OnStreamEnd() override {}
+        void STDMETHODCALLTYPE OnBufferStart(void*) override {}
+        void STDMETHODCALLTYPE OnLoopEnd(void*) override {}
+        void STDMETHODCALLTYPE OnVoiceError(void*, HRESULT) override {}
+
+        VoiceAllocator* pAllocator;
+        unsigned int index;
+        IXAudio2SourceVoice* pVoice;
+    };
+
+    VoicePool::VoicePool()
+    {
+    }
+
+    VoicePool::VoicePool(ResourceManager* pManager, unsigned int maxVoices, VoiceAllocator::StealMode mode) :
+        IBasicResource(pManager), m_pAllocator(new VoiceAllocator(maxVoices, mode))
+    {
+        OnLoad();
+    }
+
+    VoicePool::VoicePool(VoicePool&& other) noexcept : IBasicResource(other),
+        m_pAllocator(std::move(other.m_pAllocator)), m_slots(std::move(other.m_slots)),
+        m_formats(std::move(other.m_formats))
+    {
+        OnMove(other);
+    }
+
+    VoicePool& VoicePool::operator=(VoicePool&& other) noexcept
+    {
+        if (this == &other) return *this;
+        m_pManager = other.m_pManager;
+        Release();
+        m_pAllocator = std::move(other.m_pAllocator);
+        m_slots = std::move(other.m_slots);
+        m_formats = std::move(other.m_formats);
+
+        OnMove(other);
+        return *this;
+    }
+
+    VoicePool::~VoicePool()
+    {
+        Release();
+    }
+
+    void VoicePool::Release()
+    {
+        // Destroying a voice waits for its callbacks, so the allocator goes last
+        m_slots.clear();
+        m_formats.clear();
+        m_pAllocator.reset();
+        OnUnload();
+    }
+
+    void VoicePool::Reserve(const WAVEFORMATEX* pFormat, unsigned int count)
+    {
+        if (!pFormat) throw std::runtime_error("Format is null.");
+        VoiceAllocator& allocator = GetAllocator();
+        unsigned int format = FindFormat(pFormat);
+        unsigned int existing = 0u;
+        for (unsigned int i = 0u; i < allocator.GetSlotCount(); ++i)
+        {
+            if (allocator.GetSlotFormat(i) == format) ++existing;
+        }
+        for (; existing < count; ++existing)
+        {
+            HRESULT hr = GetVoice(allocator.AddSlot(format), format);
+            CheckHR(hr);
+        }
+    }
+
+    void VoicePool::Reserve(Sound& sound, unsigned int count)
+    {
+        Reserve(sound.GetFormat(), count);
+    }
+
+    bool VoicePool::Play(Sound& sound, float volume)
+    {
+        VoiceAllocator& allocator = GetAllocator();
+        const XAUDIO2_BUFFER* pBuffer = sound.GetBuffer();
+        unsigned int format = FindFormat(sound.GetFormat());
+
+        // Sounds are told apart by their samples, so moved or cached copies share one limit
+        VoiceAllocator::Allocation allocation;
+        if (!allocator.Acquire(format, pBuffer->pAudioData, volume, allocation)) return false;
+
+        // A stolen voice is cut off, its flushed buffer ends with a stale generation
+        if (allocation.stopped >= 0)
+        {
+            IXAudio2SourceVoice* pStopped = m_slots[allocation.stopped]->pVoice;
+            pStopped->Stop();
+            pStopped->FlushSourceBuffers();
+        }
+
+        XAUDIO2_BUFFER buffer = *pBuffer;
+        buffer.pContext = reinterpret_cast<void*>((uintptr_t)allocation.generation);
+        IXAudio2SourceVoice* pVoice = nullptr;
+        HRESULT hr = GetVoice(allocation.slot, format, &pVoice);
+        if (SUCCEEDED(hr)) hr = pVoice->SetVolume(volume);
+        if (SUCCEEDED(hr)) hr = pVoice->SubmitSourceBuffer(&buffer);
+        if (SUCCEEDED(hr)) hr = pVoice->Start();
+        if (FAILED(hr))
+        {
+            allocator.Release(allocation.slot, allocation.generation);
+            CheckHR(hr);
+        }
+        return true;
+    }
+
+    void VoicePool::StopAll()
+    {
+        for (auto& pSlot : m_slots)
+        {
+            if (!pSlot->pVoice) continue;
+            pSlot->pVoice->Stop();
+            pSlot->pVoice->FlushSourceBuffers();
+        }
+        GetAllocator().ReleaseAll();
+    }
+
+    void VoicePool::SetMaxVoices(unsigned int maxVoices)
+    {
+        GetAllocator().SetMaxVoices(maxVoices);
+    }
+
+    void VoicePool::SetStealMode(VoiceAllocator::StealMode mode)
+    {
+        GetAllocator().SetStealMode(mode);
+    }
+
+    void VoicePool::SetDefaultSoundLimit(unsigned int limit)
+    {
+        GetAllocator().SetDefaultSoundLimit(limit);
+    }
+
+    void VoicePool::SetSoundLimit(Sound& sound, unsigned int limit)
+    {
+        GetAllocator().SetSoundLimit(sound.GetBuffer()->pAudioData, limit);
+    }
+
+    void VoicePool::ClearSoundLimit(Sound& sound)
+    {
+        GetAllocator().ClearSoundLimit(sound.GetBuffer()->pAudioData);
+    }
+
+    unsigned int VoicePool::GetVoiceCount() const
+    {
+        return (unsigned int)m_slots.size();
+    }
+
+    unsigned int VoicePool::GetActiveCount() const
+    {
+        return GetAllocator().GetActiveCount();
+    }
+
+    unsigned int VoicePool::GetActiveCount(Sound& sound) const
+    {
+        return GetAllocator().GetActiveCount(sound.GetBuffer()->pAudioData);
+    }
+
+    VoiceAllocator::Stats VoicePool::GetStats() const
+    {
+        return GetAllocator().GetStats();
+    }
+
+    unsigned int VoicePool::FindFormat(const WAVEFORMATEX* pFormat)
+    {
+        // Source voices only take buffers of the format they were created with, so formats compare bytewise
+        size_t size = sizeof(WAVEFORMATEX) + (pFormat->wFormatTag == WAVE_FORMAT_PCM ? 0u : pFormat->cbSize);
+        const BYTE* pBytes = reinterpret_cast<const BYTE*>(pFormat);
+        for (size_t i = 0u; i < m_formats.size(); ++i)
+        {
+            if (m_formats[i].size() == size && memcmp(m_formats[i].data(), pBytes, size) == 0) return (unsigned int)i;
+        }
+        m_formats.emplace_back(pBytes, pBytes + size);
+        return (unsigned int)m_formats.size() - 1u;
+    }
+
+    HRESULT VoicePool::GetVoice(unsigned int slot, unsigned int format, IXAudio2SourceVoice** ppVoice)
+    {
+        // Slots follow the allocator's indices, a voice that failed to create is retried on the next use
+        while (m_slots.size() <= slot)
+        {
+            m_slots.emplace_back(new Slot(m_pAllocator.get(), (unsigned int)m_slots.size()));
+        }
+        Slot& entry = *m_slots[slot];
+        HRESULT hr = S_OK;
+        if (!entry.pVoice)
+        {
+            hr = m_pManager->GetXAudio()->CreateSourceVoice(&entry.pVoice,
+                reinterpret_cast<const WAVEFORMATEX*>(m_formats[format].data()), 0, XAUDIO2_DEFAULT_FREQ_RATIO, &entry);
+        }
+        if (ppVoice) *ppVoice = entry.pVoice;
+        return hr;
+    }
+
+    VoiceAllocator& VoicePool::GetAllocator() const
+    {
+        if (!m_pAllocator) throw std::runtime_error("Voice pool is null.");
+        return *m_pAllocator;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "ResourceManager.h"
+#include "VoiceAllocator.h"
+#include "Sound.h"
+#include <xaudio2.h>
+#include <memory>
+#include <vector>
+
+namespace Ice2D
+{
+	class VoicePool : private IBasicResource
+	{
+	public:
+		VoicePool();
+		VoicePool(ResourceManager* pManager, unsigned int maxVoices = 32u,
+			VoiceAllocator::StealMode mode = VoiceAllocator::StealMode::Oldest);
+		VoicePool(const VoicePool& other) = delete;
+		VoicePool& operator=(const VoicePool& other) = delete;
+		VoicePool(VoicePool&& other) noexcept;
+		VoicePool& operator=(VoicePool&& other) noexcept;
+		~VoicePool();
+		void Release() override;
+		void Reserve(const WAVEFORMATEX* pFormat, unsigned int count);
+		void Reserve(Sound& sound, unsigned int count);
+		bool Play(Sound& sound, float volume = 1.0f);
+		void StopAll();
+		void SetMaxVoices(unsigned int maxVoices);
+		void SetStealMode(VoiceAllocator::StealMode mode);
+		void SetDefaultSoundLimit(unsigned int limit);
+		void SetSoundLimit(Sound& sound, unsigned int limit);
+		void ClearSoundLimit(Sound& sound);
+		unsigned int GetVoiceCount() const;
+		unsigned int GetActiveCount() const;
+		unsigned int GetActiveCount(Sound& sound) const;
+		VoiceAllocator::Stats GetStats() const;
+	private:
+		class Slot;
+		std::unique_ptr<VoiceAllocator> m_pAllocator;
+		std::vector<std::unique_ptr<Slot>> m_slots;
+		std::vector<std::vector<BYTE>> m_formats;
+		unsigned int FindFormat(const WAVEFORMATEX* pFormat);
+		HRESULT GetVoice(unsigned int slot, unsigned int format, IXAudio2SourceVoice** ppVoice = nullptr);
+		VoiceAllocator& GetAllocator() const;
+	};
+}
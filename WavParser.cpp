@@ -0,0 +1,177 @@
+#include "pch.h"
+
+#include "WavParser.h"
+#include <cstring>
+
+namespace Ice2D
+{
+    static uint16_t Read16(const unsigned char* p)
+    {
+        return (uint16_t)(p[0] | p[1] << 8);
+    }
+
+    static uint32_t Read32(const unsigned char* p)
+    {
+        return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+
+    // Everything past the first two bytes of a WAVE_FORMAT_EXTENSIBLE sub-format GUID
+    static const unsigned char SUBFORMAT_TAIL[14] =
+        { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+    WavParser::WavParser(const void* pData, size_t size) : m_pData(static_cast<const unsigned char*>(pData)),
+        m_position(0u), m_end(0u), m_formType(0u), m_result(Result::Ok)
+    {
+        if (!pData || size < 12u || Read32(m_pData) != FourCC("RIFF"))
+        {
+            m_result = Result::NotRiff;
+            return;
+        }
+
+        // Files cut short still parse up to what is there, the data chunk is clamped below
+        uint64_t riffEnd = 8ull + Read32(m_pData + 4u);
+        m_end = riffEnd < size ? (size_t)riffEnd : size;
+        m_formType = Read32(m_pData + 8u);
+        m_position = 12u;
+    }
+
+    WavParser::Result WavParser::GetResult() const
+    {
+        return m_result;
+    }
+
+    uint32_t WavParser::GetFormType() const
+    {
+        return m_formType;
+    }
+
+    bool WavParser::Next(Chunk& chunk)
+    {
+        // Walks the file once, front to back, chunks are word aligned
+        if (m_result != Result::Ok || m_position + 8u > m_end) return false;
+        chunk.id = Read32(m_pData + m_position);
+        uint32_t size = Read32(m_pData + m_position + 4u);
+        size_t available = m_end - m_position - 8u;
+        if (size > available)
+        {
+            if (chunk.id != FourCC("data"))
+            {
+                m_result = Result::Truncated;
+                return false;
+            }
+            size = (uint32_t)available;
+        }
+        chunk.pData = m_pData + m_position + 8u;
+        chunk.size = size;
+        m_position += 8u + (size_t)size + (size & 1u);
+        return true;
+    }
+
+    WavParser::Result WavParser::Parse(const void* pData, size_t size, Info& info)
+    {
+        std::memset(&info, 0, sizeof(info));
+        WavParser parser(pData, size);
+        if (parser.GetResult() != Result::Ok) return parser.GetResult();
+        if (parser.GetFormType() != FourCC("WAVE")) return Result::NotWave;
+
+        bool hasFormat = false, hasData = false;
+        Chunk chunk;
+        while (parser.Next(chunk))
+        {
+            if (chunk.id == FourCC("fmt ") && !hasFormat)
+            {
+                Result result = ParseFormat(chunk, info);
+                if (result != Result::Ok) return result;
+                hasFormat = true;
+            }
+            else if (chunk.id == FourCC("data") && !hasData)
+            {
+                uint32_t declared = Read32(chunk.pData - 4u);
+                info.pSamples = chunk.pData;
+                info.size = chunk.size;
+                info.truncated = declared != chunk.size;
+                hasData = true;
+            }
+        }
+        if (parser.GetResult() != Result::Ok) return parser.GetResult();
+        if (!hasFormat) return Result::MissingFormat;
+        if (!hasData) return Result::MissingData;
+
+        // Only whole frames are played
+        info.frameCount = info.size / info.blockAlign;
+        info.size = info.frameCount * info.blockAlign;
+        return Result::Ok;
+    }
+
+    const char* WavParser::GetResultName(Result result)
+    {
+        switch (result)
+        {
+        case Result::Ok: return "Ok";
+        case Result::NotRiff: return "Not a RIFF file";
+        case Result::NotWave: return "Not a WAVE file";
+        case Result::Truncated: return "Truncated chunk";
+        case Result::MissingFormat: return "Missing fmt chunk";
+        case Result::MissingData: return "Missing data chunk";
+        case Result::BadFormat: return "Invalid fmt chunk";
+        case Result::Unsupported: return "Unsupported sample format";
+        }
+        return "Unknown";
+    }
+
+    uint32_t WavParser::FourCC(const char id[4])
+    {
+        return Read32(reinterpret_cast<const unsigned char*>(id));
+    }
+
+    WavParser::Result WavParser::ParseFormat(const Chunk& chunk, Info& info)
+    {
+        if (chunk.size < 16u) return Result::BadFormat;
+        const unsigned char* p = chunk.pData;
+        info.pFormat = p;
+        info.formatSize = chunk.size;
+        info.formatTag = Read16(p);
+        info.channels = Read16(p + 2u);
+        info.sampleRate = Read32(p + 4u);
+        info.byteRate = Read32(p + 8u);
+        info.blockAlign = Read16(p + 12u);
+        info.bitsPerSample = Read16(p + 14u);
+        info.validBitsPerSample = info.bitsPerSample;
+
+        if (info.formatTag == FORMAT_EXTENSIBLE)
+        {
+            // cbSize, valid bits, channel mask, then the sub-format GUID whose first word is the real tag
+            if (chunk.size < 40u || Read16(p + 16u) < 22u) return Result::BadFormat;
+            info.extensible = true;
+            info.validBitsPerSample = Read16(p + 18u);
+            info.channelMask = Read32(p + 20u);
+            if (std::memcmp(p + 26u, SUBFORMAT_TAIL, sizeof(SUBFORMAT_TAIL)) != 0) return Result::Unsupported;
+            info.formatTag = Read16(p + 24u);
+            if (info.validBitsPerSample == 0u) info.validBitsPerSample = info.bitsPerSample;
+        }
+
+        if (info.channels == 0u || info.sampleRate == 0u) return Result::BadFormat;
+        if (info.formatTag == FORMAT_PCM)
+        {
+            info.sampleType = SampleType::Int;
+            if (info.bitsPerSample != 8u && info.bitsPerSample != 16u && info.bitsPerSample != 24u &&
+                info.bitsPerSample != 32u)
+            {
+                return Result::Unsupported;
+            }
+        }
+        else if (info.formatTag == FORMAT_FLOAT)
+        {
+            info.sampleType = SampleType::Float;
+            if (info.bitsPerSample != 32u) return Result::Unsupported;
+        }
+        else
+        {
+            return Result::Unsupported;
+        }
+
+        if (info.validBitsPerSample > info.bitsPerSample) return Result::BadFormat;
+        if (info.blockAlign != (uint32_t)info.channels * info.bitsPerSample / 8u) return Result::BadFormat;
+        return Result::Ok;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Ice2D
+{
+	class WavParser
+	{
+	public:
+		enum class Result { Ok, NotRiff, NotWave, Truncated, MissingFormat, MissingData, BadFormat, Unsupported };
+		enum class SampleType { Int, Float };
+		struct Chunk
+		{
+			uint32_t id;
+			const unsigned char* pData;
+			uint32_t size;
+		};
+		struct Info
+		{
+			uint16_t formatTag, channels;
+			uint32_t sampleRate, byteRate;
+			uint16_t blockAlign, bitsPerSample, validBitsPerSample;
+			uint32_t channelMask;
+			SampleType sampleType;
+			bool extensible, truncated;
+			const unsigned char* pFormat;
+			uint32_t formatSize;
+			const unsigned char* pSamples;
+			uint32_t size, frameCount;
+		};
+		static const uint16_t FORMAT_PCM = 0x0001u;
+		static const uint16_t FORMAT_FLOAT = 0x0003u;
+		static const uint16_t FORMAT_EXTENSIBLE = 0xFFFEu;
+		WavParser(const void* pData, size_t size);
+		Result GetResult() const;
+		uint32_t GetFormType() const;
+		bool Next(Chunk& chunk);
+		static Result Parse(const void* pData, size_t size, Info& info);
+		static const char* GetResultName(Result result);
+		static uint32_t FourCC(const char id[4]);
+	private:
+		const unsigned char* m_pData;
+		size_t m_position, m_end;
+		uint32_t m_formType;
+		Result m_result;
+		static Result ParseFormat(const Chunk& chunk, Info& info);
+	};
+}
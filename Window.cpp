@@ -7,7 +7,7 @@ namespace Ice2D
 	HINSTANCE Window::hInstance;
 	Window::Window(HINSTANCE hInstance, const unsigned int clientWidth, const unsigned int clientHeight, LPCWSTR title,
 		const DWORD windowStyle, const int nCmdShow) :
-		m_clientWidth(clientWidth), m_clientHeight(clientHeight), hwnd(NULL)
+		m_clientWidth(clientWidth), m_clientHeight(clientHeight), hwnd(NULL), m_headless(false), m_quitRequested(false)
 	{
 		ClearInput();
 
@@ -43,6 +43,15 @@ namespace Ice2D
 		ShowWindow(hwnd, nCmdShow);
 	}
 
+	Window::Window(const unsigned int clientWidth, const unsigned int clientHeight) :
+		m_clientWidth(clientWidth), m_clientHeight(clientHeight), hwnd(NULL), m_headless(true), m_quitRequested(false)
+	{
+		// No window and no message pump, input stays cleared unless the application sets it
+		ClearInput();
+		input.mouseX = 0;
+		input.mouseY = 0;
+	}
+
 	Window::~Window()
 	{
 		Quit();
@@ -54,8 +63,15 @@ namespace Ice2D
 		for (int i = 0; i < 3; ++i) input.mouseButtons[i] = false;
 	}
 
+	InputQueue& Window::GetInputQueue()
+	{
+		return m_inputQueue;
+	}
+
 	void Window::Quit()
 	{
+		m_quitRequested = true;
+		if (m_headless) return;
 		SendMessage(hwnd, WM_DESTROY, 0, 0);
 		HandleMessages();
 	}
@@ -86,35 +102,66 @@ namespace Ice2D
 
 	LRESULT Window::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
 	{
+		// Every event is also queued with the message time, so presses between two frames aren't lost
+		const uint32_t time = (uint32_t)GetMessageTime();
+		const int x = (short)LOWORD(lParam), y = (short)HIWORD(lParam);
 		switch (uMsg)
 		{
 		case WM_KEYDOWN:
 			input.keyboardState[wParam] = true;
+			m_inputQueue.PushKey((uint8_t)wParam, true, (lParam & (1 << 30)) != 0, time);
 			break;
 		case WM_KEYUP:
 			input.keyboardState[wParam] = false;
+			m_inputQueue.PushKey((uint8_t)wParam, false, false, time);
+			break;
+		case WM_SYSKEYDOWN:
+			m_inputQueue.PushKey((uint8_t)wParam, true, (lParam & (1 << 30)) != 0, time);
+			break;
+		case WM_SYSKEYUP:
+			m_inputQueue.PushKey((uint8_t)wParam, false, false, time);
 			break;
 		case WM_LBUTTONDOWN:
 			input.mouseButtons[0] = true;
+			m_inputQueue.PushButton(InputQueue::Left, true, x, y, time);
 			break;
 		case WM_LBUTTONUP:
 			input.mouseButtons[0] = false;
+			m_inputQueue.PushButton(InputQueue::Left, false, x, y, time);
 			break;
 		case WM_MBUTTONDOWN:
 			input.mouseButtons[1] = true;
+			m_inputQueue.PushButton(InputQueue::Middle, true, x, y, time);
 			break;
 		case WM_MBUTTONUP:
 			input.mouseButtons[1] = false;
+			m_inputQueue.PushButton(InputQueue::Middle, false, x, y, time);
 			break;
 		case WM_RBUTTONDOWN:
 			input.mouseButtons[2] = true;
+			m_inputQueue.PushButton(InputQueue::Right, true, x, y, time);
 			break;
 		case WM_RBUTTONUP:
 			input.mouseButtons[2] = false;
+			m_inputQueue.PushButton(InputQueue::Right, false, x, y, time);
+			break;
+		case WM_XBUTTONDOWN:
+		case WM_XBUTTONUP:
+			m_inputQueue.PushButton(GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? InputQueue::X1 : InputQueue::X2,
+				uMsg == WM_XBUTTONDOWN, x, y, time);
 			break;
 		case WM_MOUSEMOVE:
 			input.mouseX = LOWORD(lParam);
 			input.mouseY = HIWORD(lParam);
+			m_inputQueue.PushMove(x, y, time);
+			break;
+		case WM_MOUSEWHEEL:
+		case WM_MOUSEHWHEEL:
+			// The position of wheel messages is in screen coordinates, so only the delta is kept
+			m_inputQueue.PushWheel(GET_WHEEL_DELTA_WPARAM(wParam), uMsg == WM_MOUSEHWHEEL, time);
+			break;
+		case WM_KILLFOCUS:
+			m_inputQueue.PushFocusLost(time);
 			break;
 		case WM_SIZE:
 			OnResize(LOWORD(lParam), HIWORD(lParam));
@@ -154,6 +201,13 @@ namespace Ice2D
 		return true;
 	}
 
+	bool Window::WaitForMessages(DWORD timeoutMs)
+	{
+		// Blocks the thread until input or any other message is queued, returns false on timeout
+		DWORD result = MsgWaitForMultipleObjectsEx(0, nullptr, timeoutMs, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+		return result == WAIT_OBJECT_0;
+	}
+
 	unsigned int Window::GetClientWidth() const
 	{
 		return m_clientWidth;
@@ -168,4 +222,9 @@ namespace Ice2D
 	{
 		return hwnd;
 	}
+
+	bool Window::IsHeadless() const
+	{
+		return m_headless;
+	}
 }
\ No newline at end of file
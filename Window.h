@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MinWin.h"
+#include "InputQueue.h"
 
 namespace Ice2D
 {
@@ -10,11 +11,14 @@ namespace Ice2D
 		Window(HINSTANCE hInstance, const unsigned int clientWidth, const unsigned int clientHeight, LPCWSTR title,
 			const DWORD windowStyle = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX,
 			const int nCmdShow = SW_SHOWNORMAL);
+		Window(const unsigned int clientWidth, const unsigned int clientHeight);
 		~Window();
 		static bool HandleMessages();
+		static bool WaitForMessages(DWORD timeoutMs = INFINITE);
 		unsigned int GetClientWidth() const;
 		unsigned int GetClientHeight() const;
 		HWND GetWindowHandle() const;
+		bool IsHeadless() const;
 		struct
 		{
 			bool keyboardState[0xFF];
@@ -22,6 +26,7 @@ namespace Ice2D
 			int mouseX, mouseY;
 		} input;
 		void ClearInput();
+		InputQueue& GetInputQueue();
 		void Quit();
 	private:
 		static constexpr LPCWSTR CLASS_NAME = L"Engine Window";
@@ -33,6 +38,8 @@ namespace Ice2D
 	protected:
 		unsigned int m_clientWidth, m_clientHeight;
 		HWND hwnd;
+		bool m_headless, m_quitRequested;
+		InputQueue m_inputQueue;
 		virtual void OnResize(const unsigned int width, const unsigned int height);
 	};
 }
\ No newline at end of file
@@ -1,12 +1,15 @@
 #ifndef PCH_H
 #define PCH_H
 
+// The portable modules and tools also build on other platforms without the Windows headers
+#ifdef _WIN32
 #include "MinWin.h"
 
 #include <d2d1.h>
 #include <dwrite.h>
 #include <wincodec.h>
 #include <xaudio2.h>
+#endif
 #include <stdexcept>
 
 #endif
@@ -1,19 +1,21 @@
 #include "pch.h"
 
 #include "Ice2D.h"
+#include <cstdio>
+#include <cwchar>
 
 class Game : public Ice2D::Application
 {
 public:
 	Game(HINSTANCE hInstance) : Application(hInstance, 800, 500, L"Le Windowe")
 	{}
+	Game(unsigned int width, unsigned int height) : Application(width, height)
+	{}
 private:
 	D2D_POINT_2F pos, vel, size;
-	Ice2D::SolidBrush brush;
 	Ice2D::TextFormat font;
 	void Setup() override
 	{
-		brush = Ice2D::SolidBrush(&manager, D2D1::ColorF(1.0f));
 		font = Ice2D::TextFormat(&manager, L"Impact", 72.0f);
 		font.Get()->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
 		font.Get()->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
@@ -40,10 +42,12 @@ private:
 		
 		rt->Clear();
 		auto rect = D2D1::RectF(pos.x, pos.y, pos.x + size.x, pos.y + size.y);
-		brush.SetColor(0.0f, 0.0f, 1.0f);
-		rt->FillRectangle(rect, brush.Get());
-		brush.SetColor(1.0f);
-		rt->DrawTextW(L"DVD", 4u, font.Get(), rect, brush.Get());
+		// Shared brushes, one per color, asking again every frame is a hash lookup
+		auto& brushes = manager.GetBrushCache();
+		Ice2D::SharedBrush blue = brushes.GetSolid(rt, D2D1::ColorF(0.0f, 0.0f, 1.0f));
+		Ice2D::SharedBrush white = brushes.GetSolid(rt, D2D1::ColorF(1.0f, 1.0f, 1.0f));
+		rt->FillRectangle(rect, blue.Get());
+		font.Draw(L"DVD", 3u, rect, white.Get());
 
 		return rt->EndDraw();
 	}
@@ -51,6 +55,28 @@ private:
 
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR pCmdLine, int nCmdShow)
 {
+	// "-benchmark" draws the scene headless as fast as it can and prints the frame rate to the console
+	if (wcsstr(pCmdLine, L"-benchmark"))
+	{
+		FILE* pOut = nullptr;
+		if (AttachConsole(ATTACH_PARENT_PROCESS)) freopen_s(&pOut, "CONOUT$", "w", stdout);
+		try
+		{
+			Game game(800, 500);
+			auto result = game.Benchmark(1000);
+			game.SaveFrame(L"benchmark.png");
+			printf("%u frames in %.3f s, %.1f fps\n", result.frameCount, result.seconds, result.framesPerSecond);
+			printf("avg %.3f ms, min %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+				result.average, result.min, result.p50, result.p99, result.max);
+		}
+		catch (const std::exception& e)
+		{
+			printf("%s\n", e.what());
+			return -1;
+		}
+		return 0;
+	}
+
 	Game game(hInstance);
 	int exitCode = game.Start();
 	return exitCode;
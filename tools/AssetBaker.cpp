@@ -0,0 +1,278 @@
+// Bakes loose assets into a single pack that AssetPack maps at runtime.
+//
+//   AssetBaker <manifest> <output>
+//
+// Each manifest line is one asset, paths are relative to the manifest:
+//   image <name> <path>
+//   sheet <name> <path> <rows> <cols> <frameCount> <frameRate>
+//   sound <name> <path.wav>
+//   blob <name> <path>
+// Images are stored as premultiplied 32bpp BGRA. BMP and TGA are decoded everywhere, on Windows any
+// format WIC understands works as well.
+#include "pch.h"
+
+#include "AssetPack.h"
+#include "PixelKernels.h"
+#include "WavParser.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include "Images.h"
+#endif
+
+using namespace Ice2D;
+
+static std::vector<unsigned char> ReadFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Failed to open " + path);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static uint32_t Read16(const unsigned char* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8;
+}
+
+static uint32_t Read32(const unsigned char* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+struct Image
+{
+    uint32_t width, height;
+    std::vector<uint32_t> pixels;
+};
+
+static bool DecodeBmp(const std::vector<unsigned char>& file, Image& image)
+{
+    if (file.size() < 54u || file[0] != 'B' || file[1] != 'M') return false;
+    uint32_t dataOffset = Read32(&file[10]);
+    int32_t width = (int32_t)Read32(&file[18]);
+    int32_t height = (int32_t)Read32(&file[22]);
+    uint32_t bpp = Read16(&file[28]);
+    uint32_t compression = Read32(&file[30]);
+    if (width <= 0 || height == 0 || (bpp != 24u && bpp != 32u) || (compression != 0u && compression != 3u))
+    {
+        throw std::runtime_error("Unsupported BMP, only uncompressed 24 and 32-bit files are supported");
+    }
+
+    // Rows are bottom-up unless the height is negative
+    bool topDown = height < 0;
+    image.width = (uint32_t)width;
+    image.height = (uint32_t)(topDown ? -height : height);
+    uint32_t rowSize = (image.width * bpp / 8u + 3u) & ~3u;
+    if (dataOffset + (uint64_t)rowSize * image.height > file.size()) throw std::runtime_error("Truncated BMP");
+
+    image.pixels.resize((size_t)image.width * image.height);
+    bool hasAlpha = false;
+    for (uint32_t y = 0u; y < image.height; ++y)
+    {
+        const unsigned char* pRow = &file[dataOffset + (size_t)rowSize * (topDown ? y : image.height - 1u - y)];
+        uint32_t* pDst = &image.pixels[(size_t)y * image.width];
+        for (uint32_t x = 0u; x < image.width; ++x)
+        {
+            const unsigned char* p = pRow + x * (bpp / 8u);
+            uint32_t a = bpp == 32u ? p[3] : 255u;
+            hasAlpha |= a != 0u;
+            pDst[x] = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | a << 24;
+        }
+    }
+
+    // Most 32-bit BMPs leave the alpha byte at zero and mean opaque
+    if (bpp == 32u && !hasAlpha)
+    {
+        for (uint32_t& pixel : image.pixels) pixel |= 0xFF000000u;
+    }
+    return true;
+}
+
+static bool DecodeTga(const std::vector<unsigned char>& file, const std::string& path, Image& image)
+{
+    if (file.size() < 18u || path.size() < 4u) return false;
+    std::string extension = path.substr(path.size() - 4u);
+    for (char& c : extension) c = (char)std::tolower((unsigned char)c);
+    if (extension != ".tga") return false;
+
+    uint32_t idLength = file[0];
+    uint32_t colorMapType = file[1];
+    uint32_t type = file[2];
+    image.width = Read16(&file[12]);
+    image.height = Read16(&file[14]);
+    uint32_t bpp = file[16];
+    bool topDown = (file[17] & 0x20u) != 0u;
+    if (colorMapType != 0u || (type != 2u && type != 10u) || (bpp != 24u && bpp != 32u))
+    {
+        throw std::runtime_error("Unsupported TGA, only true color 24 and 32-bit files are supported");
+    }
+
+    // Decode to a flat list first, runs in RLE files can cross rows
+    const uint32_t bytes = bpp / 8u;
+    const size_t count = (size_t)image.width * image.height;
+    std::vector<uint32_t> pixels(count);
+    size_t pos = 18u + idLength;
+    auto readPixel = [&](uint32_t& pixel)
+    {
+        if (pos + bytes > file.size()) throw std::runtime_error("Truncated TGA");
+        const unsigned char* p = &file[pos];
+        pixel = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (bytes == 4u ? (uint32_t)p[3] : 255u) << 24;
+        pos += bytes;
+    };
+    for (size_t i = 0u; i < count;)
+    {
+        if (type == 2u)
+        {
+            readPixel(pixels[i++]);
+            continue;
+        }
+        if (pos >= file.size()) throw std::runtime_error("Truncated TGA");
+        uint32_t header = file[pos++];
+        size_t run = (header & 0x7Fu) + 1u;
+        if (i + run > count) throw std::runtime_error("Corrupt TGA");
+        if (header & 0x80u)
+        {
+            uint32_t pixel;
+            readPixel(pixel);
+            for (size_t j = 0u; j < run; ++j) pixels[i++] = pixel;
+        }
+        else
+        {
+            for (size_t j = 0u; j < run; ++j) readPixel(pixels[i++]);
+        }
+    }
+
+    image.pixels.resize(count);
+    for (uint32_t y = 0u; y < image.height; ++y)
+    {
+        uint32_t srcY = topDown ? y : image.height - 1u - y;
+        std::memcpy(&image.pixels[(size_t)y * image.width], &pixels[(size_t)srcY * image.width],
+            image.width * sizeof(uint32_t));
+    }
+    return true;
+}
+
+static Image LoadImage(const std::string& path)
+{
+    Image image;
+#ifdef _WIN32
+    // WIC handles every format and already produces premultiplied BGRA
+    static IWICImagingFactory* pFactory = nullptr;
+    if (!pFactory)
+    {
+        HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&pFactory));
+        if (FAILED(hr)) throw std::runtime_error("Failed to create the WIC factory");
+    }
+    std::wstring widePath(path.begin(), path.end());
+    std::vector<BYTE> bytes;
+    unsigned int width = 0u, height = 0u;
+    IBasicImage::DecodeFile(pFactory, widePath.c_str(), width, height, bytes);
+    image.width = width;
+    image.height = height;
+    image.pixels.resize((size_t)width * height);
+    std::memcpy(image.pixels.data(), bytes.data(), bytes.size());
+    return image;
+#else
+    std::vector<unsigned char> file = ReadFile(path);
+    if (!DecodeBmp(file, image) && !DecodeTga(file, path, image))
+    {
+        throw std::runtime_error("Unsupported image format: " + path);
+    }
+    PixelKernels::Premultiply(image.pixels.data(), image.width * sizeof(uint32_t), image.width, image.height);
+    return image;
+#endif
+}
+
+static void LoadWav(const std::string& path, std::vector<unsigned char>& format, std::vector<unsigned char>& samples)
+{
+    std::vector<unsigned char> file = ReadFile(path);
+    WavParser::Info info;
+    WavParser::Result result = WavParser::Parse(file.data(), file.size(), info);
+    if (result != WavParser::Result::Ok)
+    {
+        throw std::runtime_error(std::string(WavParser::GetResultName(result)) + ": " + path);
+    }
+    format.assign(info.pFormat, info.pFormat + info.formatSize);
+    samples.assign(info.pSamples, info.pSamples + info.size);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::fprintf(stderr, "usage: %s <manifest> <output>\n", argv[0]);
+        return 2;
+    }
+
+#ifdef _WIN32
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+
+    std::string manifest = argv[1];
+    size_t slash = manifest.find_last_of("/\\");
+    std::string root = slash == std::string::npos ? "" : manifest.substr(0u, slash + 1u);
+
+    try
+    {
+        std::ifstream file(manifest);
+        if (!file) throw std::runtime_error("Failed to open " + manifest);
+
+        AssetPackWriter writer;
+        std::string line;
+        for (unsigned int lineNumber = 1u; std::getline(file, line); ++lineNumber)
+        {
+            std::istringstream fields(line);
+            std::string kind, name, path;
+            if (!(fields >> kind) || kind[0] == '#') continue;
+            if (!(fields >> name >> path)) throw std::runtime_error("Line " + std::to_string(lineNumber) + " is incomplete");
+            path = root + path;
+
+            if (kind == "image")
+            {
+                Image image = LoadImage(path);
+                writer.AddImage(name, image.width, image.height, image.pixels.data(), image.width * 4u);
+            }
+            else if (kind == "sheet")
+            {
+                uint32_t rows = 0u, cols = 0u, frameCount = 0u, frameRate = 0u;
+                if (!(fields >> rows >> cols >> frameCount >> frameRate))
+                {
+                    throw std::runtime_error("Line " + std::to_string(lineNumber) + " needs rows, cols, frames and rate");
+                }
+                Image image = LoadImage(path);
+                writer.AddSheet(name, image.width, image.height, image.pixels.data(), image.width * 4u,
+                    rows, cols, frameCount, frameRate);
+            }
+            else if (kind == "sound")
+            {
+                std::vector<unsigned char> format, samples;
+                LoadWav(path, format, samples);
+                writer.AddSound(name, format.data(), (uint32_t)format.size(), samples.data(), (uint32_t)samples.size());
+            }
+            else if (kind == "blob")
+            {
+                std::vector<unsigned char> data = ReadFile(path);
+                writer.AddBlob(name, data.data(), data.size());
+            }
+            else
+            {
+                throw std::runtime_error("Line " + std::to_string(lineNumber) + " has unknown kind " + kind);
+            }
+        }
+
+        writer.Write(argv[2]);
+        std::printf("Baked %u assets into %s\n", (unsigned int)writer.GetCount(), argv[2]);
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
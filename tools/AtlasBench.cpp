@@ -0,0 +1,287 @@
+// Measures Ice2D::AtlasPacker, the skyline packer behind Ice2D::TextureAtlas, and checks where it puts images.
+//
+//   AtlasBench [--images n] [--runs n] [--seed n]
+//
+// Every scene inserts random images into a fresh packer at paddings of 0, 1, 2 and 4 pixels: glyphs, sprites,
+// a mix with long strips, and images close to the page size, so pages grow and new pages are started. The timings
+// are the best of n runs and report inserts per second and the occupancy (image area over page area) at the end.
+// The checks don't count towards the time. Every image plus its padding has to lie inside its page as the page was
+// when the image went in, no two padded images may overlap, pages only double up to the maximum size, a new page is
+// only started once the last one is at the maximum, and the stats have to add up. The tool exits with 1 when a
+// check fails.
+#include "pch.h"
+
+#include "AtlasPacker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Ice2D;
+
+typedef AtlasPacker::Region Region;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+struct Random
+{
+    uint32_t seed;
+    uint32_t Next(uint32_t low, uint32_t high)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return low + (uint32_t)(((uint64_t)(seed >> 1) * (high - low + 1u)) >> 31);
+    }
+};
+
+struct Size
+{
+    unsigned int width, height;
+};
+
+struct Scene
+{
+    const char* name;
+    unsigned int pageSize, maxPageSize;
+    void (*build)(Random&, unsigned int, std::vector<Size>&);
+};
+
+static void Glyphs(Random& random, unsigned int count, std::vector<Size>& sizes)
+{
+    for (unsigned int i = 0u; i < count; ++i) sizes.push_back({ random.Next(4u, 24u), random.Next(10u, 28u) });
+}
+
+static void Sprites(Random& random, unsigned int count, std::vector<Size>& sizes)
+{
+    for (unsigned int i = 0u; i < count; ++i)
+    {
+        unsigned int size = 8u << random.Next(0u, 3u);
+        sizes.push_back({ size + random.Next(0u, size), size + random.Next(0u, size) });
+    }
+}
+
+static void Mixed(Random& random, unsigned int count, std::vector<Size>& sizes)
+{
+    for (unsigned int i = 0u; i < count; ++i)
+    {
+        switch (random.Next(0u, 3u))
+        {
+        case 0: sizes.push_back({ random.Next(100u, 400u), random.Next(2u, 8u) }); break;
+        case 1: sizes.push_back({ random.Next(2u, 8u), random.Next(100u, 400u) }); break;
+        default: sizes.push_back({ random.Next(1u, 90u), random.Next(1u, 90u) }); break;
+        }
+    }
+}
+
+// Large images on small pages start a new page every few inserts
+static void Large(Random& random, unsigned int count, std::vector<Size>& sizes)
+{
+    for (unsigned int i = 0u; i < count / 8u + 1u; ++i)
+    {
+        sizes.push_back({ random.Next(40u, 250u), random.Next(40u, 250u) });
+    }
+}
+
+template<typename F> static double Best(unsigned int runs, F&& body)
+{
+    double best = 1e30;
+    for (unsigned int run = 0u; run < runs; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+// A page side is the start size doubled a few times, or the maximum
+static bool Doubled(unsigned int start, unsigned int size, unsigned int max)
+{
+    while (start < size && start < max) start = std::min(max, start * 2u);
+    return start == size;
+}
+
+// Inserts one image at a time and checks every placement against a map of the padded pixels taken so far
+static bool Check(const Scene& scene, unsigned int padding, const std::vector<Size>& sizes)
+{
+    AtlasPacker packer(scene.pageSize, scene.pageSize, scene.maxPageSize, scene.maxPageSize, padding);
+    const unsigned int max = scene.maxPageSize;
+    std::vector<std::vector<unsigned char>> taken;
+    std::vector<Size> pages;
+    unsigned long long usedArea = 0ull;
+    unsigned int inserts = 0u, rejected = 0u;
+    bool inside = true, overlap = false, growth = true, fits = true;
+    for (const Size& size : sizes)
+    {
+        Region region;
+        const bool oversized = size.width + 2u * padding > max || size.height + 2u * padding > max;
+        if (!packer.Insert(size.width, size.height, region))
+        {
+            // A full set of pages never refuses an image that fits on an empty page
+            fits &= oversized;
+            ++rejected;
+            continue;
+        }
+        fits &= !oversized;
+        ++inserts;
+        usedArea += (unsigned long long)size.width * size.height;
+
+        if (region.page >= packer.GetPageCount() || region.page > pages.size())
+        {
+            inside = false;
+            continue;
+        }
+        if (region.page == pages.size())
+        {
+            // Only a page that can't grow any more is followed by a new one
+            growth &= pages.empty() || (packer.GetPageWidth(region.page - 1u) == max &&
+                packer.GetPageHeight(region.page - 1u) == max);
+            pages.push_back({ scene.pageSize, scene.pageSize });
+            taken.emplace_back((size_t)max * max, (unsigned char)0u);
+        }
+        for (unsigned int page = 0u; page < (unsigned int)pages.size(); ++page)
+        {
+            const unsigned int width = packer.GetPageWidth(page), height = packer.GetPageHeight(page);
+            growth &= width <= max && height <= max && width >= pages[page].width && height >= pages[page].height;
+            growth &= Doubled(scene.pageSize, width, max) && Doubled(scene.pageSize, height, max);
+            pages[page] = { width, height };
+        }
+
+        const Size& page = pages[region.page];
+        if (region.width != size.width || region.height != size.height || region.x < padding ||
+            region.y < padding || region.x + size.width + padding > page.width ||
+            region.y + size.height + padding > page.height)
+        {
+            inside = false;
+            continue;
+        }
+        std::vector<unsigned char>& pixels = taken[region.page];
+        for (unsigned int y = region.y - padding; y < region.y + size.height + padding; ++y)
+        {
+            unsigned char* row = &pixels[(size_t)y * max];
+            for (unsigned int x = region.x - padding; x < region.x + size.width + padding; ++x)
+            {
+                overlap |= row[x] != 0u;
+                row[x] = 1u;
+            }
+        }
+    }
+
+    unsigned long long pageArea = 0ull;
+    for (const Size& page : pages) pageArea += (unsigned long long)page.width * page.height;
+    const AtlasPacker::Stats& stats = packer.GetStats();
+    const bool counted = stats.inserts == inserts && stats.failures == rejected && stats.usedArea == usedArea &&
+        stats.pageArea == pageArea && packer.GetPageCount() == pages.size();
+    Expect(inside, "every padded image is inside its page");
+    Expect(!overlap, "no two padded images overlap");
+    Expect(growth, "pages double up to the maximum before a new one is started");
+    Expect(fits, "only images larger than a page are refused");
+    Expect(counted, "the stats match the inserts and pages");
+    return inside && !overlap && growth && fits && counted;
+}
+
+static void Limits()
+{
+    printf("limits\n");
+    AtlasPacker packer(64u, 64u, 128u, 128u, 2u);
+    Region region = { 9u, 9u, 9u, 9u, 9u };
+    Expect(!packer.Insert(0u, 10u, region) && !packer.Insert(10u, 0u, region), "empty images are refused");
+    Expect(!packer.Insert(125u, 10u, region) && !packer.Insert(10u, 125u, region),
+        "images that don't fit a page with their padding are refused");
+    Expect(packer.GetPageCount() == 0u && packer.GetStats().failures == 4u, "without starting a page");
+    Expect(packer.Insert(124u, 124u, region) && region.page == 0u && region.x == 2u && region.y == 2u,
+        "an image plus padding as large as a page fills it");
+    Expect(packer.GetPageWidth(0u) == 128u && packer.GetPageHeight(0u) == 128u && packer.GetStats().grows == 2u,
+        "after growing it twice");
+    Expect(packer.Insert(1u, 1u, region) && region.page == 1u && packer.GetPageWidth(1u) == 64u,
+        "the next image starts a new page at the start size");
+    packer.Clear();
+    Expect(packer.GetPageCount() == 0u && packer.GetStats().inserts == 0u && packer.GetOccupancy() == 0.0f,
+        "Clear() drops the pages and stats");
+
+    bool thrown = false;
+    try
+    {
+        AtlasPacker invalid(512u, 512u, 256u, 256u, 1u);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    Expect(thrown, "a start size over the maximum throws");
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int count = 4000u, runs = 10u;
+    uint32_t seed = 1u;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--images") == 0) count = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--runs") == 0) runs = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+    }
+    if (runs == 0u) runs = 1u;
+
+    const Scene scenes[] =
+    {
+        { "glyphs", 256u, 1024u, Glyphs },
+        { "sprites", 256u, 2048u, Sprites },
+        { "mixed", 256u, 2048u, Mixed },
+        { "large", 64u, 256u, Large }
+    };
+    const unsigned int paddings[] = { 0u, 1u, 2u, 4u };
+
+    printf("best of %u runs\n", runs);
+    printf("%-8s %7s %7s %6s %6s %10s %12s %10s\n", "scene", "padding", "images", "pages", "grows", "ms",
+        "Minserts/s", "occupancy");
+    for (const Scene& scene : scenes)
+    {
+        Random random = { seed };
+        std::vector<Size> sizes;
+        scene.build(random, count, sizes);
+        for (unsigned int padding : paddings)
+        {
+            AtlasPacker packer(scene.pageSize, scene.pageSize, scene.maxPageSize, scene.maxPageSize, padding);
+            double time = Best(runs, [&]
+            {
+                packer.Clear();
+                Region region;
+                for (const Size& size : sizes) packer.Insert(size.width, size.height, region);
+            });
+            printf("%-8s %7u %7u %6u %6u %10.3f %12.2f %9.1f%%\n", scene.name, padding, (unsigned int)sizes.size(),
+                packer.GetPageCount(), packer.GetStats().grows, time * 1e3, sizes.size() / time * 1e-6,
+                packer.GetOccupancy() * 100.0f);
+            Check(scene, padding, sizes);
+        }
+    }
+
+    // Many small fuzzed runs reach the odd skyline shapes that the large scenes average out
+    printf("random packers\n");
+    Random random = { seed + 1u };
+    bool fuzzed = true;
+    for (unsigned int trial = 0u; trial < 200u && fuzzed; ++trial)
+    {
+        const unsigned int pageSize = 16u << random.Next(0u, 3u);
+        const Scene scene = { "random", pageSize, pageSize << random.Next(0u, 3u), nullptr };
+        std::vector<Size> sizes;
+        const unsigned int limit = scene.maxPageSize / 2u;
+        for (unsigned int i = 0u; i < 400u; ++i)
+        {
+            sizes.push_back({ random.Next(1u, random.Next(1u, limit)), random.Next(1u, random.Next(1u, limit)) });
+        }
+        fuzzed = Check(scene, random.Next(0u, 3u), sizes);
+    }
+    Limits();
+
+    if (failures) printf("%d checks FAILED\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,462 @@
+// Records Ice2D::CommandList commands, replays them into a recording Ice2D::CommandTarget and checks every call.
+//
+//   CommandCheck
+//
+// No device or render target is created. Bitmaps, geometries, meshes, brushes and text formats are stand-ins that
+// only count their references, since the list never calls anything but AddRef() and Release() on them. Each replayed
+// call is written out as one line with its arguments, and the lines have to match the recorded calls exactly. The
+// cases cover every op, the resource table and its references, text stored inline in the list, clip balance, and
+// the arguments the list refuses. The tool needs the Windows SDK headers for the Direct2D types, e.g. from a
+// Developer Command Prompt:
+//
+//   cl /EHsc /O2 /DUNICODE /D_UNICODE /I. tools\CommandCheck.cpp CommandList.cpp HRException.cpp user32.lib
+//
+// The tool prints one line per case and exits with 1 when a check fails.
+#include "pch.h"
+
+#include "CommandList.h"
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Ice2D;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+// Stands in for any Direct2D or DirectWrite object, the list only keeps references to them
+class FakeResource : public IUnknown
+{
+public:
+    FakeResource() : m_references(1u)
+    {
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** ppObject) override
+    {
+        if (ppObject) *ppObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return ++m_references;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        return --m_references;
+    }
+
+    ULONG GetReferences() const
+    {
+        return m_references;
+    }
+
+    template <typename T> T* As()
+    {
+        return reinterpret_cast<T*>(static_cast<IUnknown*>(this));
+    }
+
+private:
+    ULONG m_references;
+};
+
+// Writes every call as a line, resources by name, so a whole replay compares as a list of strings
+class RecordingTarget : public CommandTarget
+{
+public:
+    std::vector<std::string> calls;
+    std::map<const void*, std::string> names;
+
+    void Clear(const D2D1_COLOR_F& color) override
+    {
+        Add("Clear " + Color(color));
+    }
+
+    void SetTransform(const D2D1_MATRIX_3X2_F& t) override
+    {
+        Add("SetTransform " + Numbers({ t._11, t._12, t._21, t._22, t._31, t._32 }));
+    }
+
+    void FillRectangle(const D2D1_RECT_F& rect, const Brush& brush) override
+    {
+        Add("FillRectangle " + Rect(rect) + " " + Name(brush));
+    }
+
+    void DrawRectangle(const D2D1_RECT_F& rect, const Brush& brush, float strokeWidth) override
+    {
+        Add("DrawRectangle " + Rect(rect) + " " + Name(brush) + " " + Numbers({ strokeWidth }));
+    }
+
+    void FillRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush) override
+    {
+        Add("FillRoundedRectangle " + Rect(rect.rect) + " " + Numbers({ rect.radiusX, rect.radiusY }) + " " +
+            Name(brush));
+    }
+
+    void DrawRoundedRectangle(const D2D1_ROUNDED_RECT& rect, const Brush& brush, float strokeWidth) override
+    {
+        Add("DrawRoundedRectangle " + Rect(rect.rect) + " " + Numbers({ rect.radiusX, rect.radiusY }) + " " +
+            Name(brush) + " " + Numbers({ strokeWidth }));
+    }
+
+    void FillEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush) override
+    {
+        Add("FillEllipse " + Numbers({ ellipse.point.x, ellipse.point.y, ellipse.radiusX, ellipse.radiusY }) + " " +
+            Name(brush));
+    }
+
+    void DrawEllipse(const D2D1_ELLIPSE& ellipse, const Brush& brush, float strokeWidth) override
+    {
+        Add("DrawEllipse " + Numbers({ ellipse.point.x, ellipse.point.y, ellipse.radiusX, ellipse.radiusY }) + " " +
+            Name(brush) + " " + Numbers({ strokeWidth }));
+    }
+
+    void DrawLine(const D2D1_POINT_2F& start, const D2D1_POINT_2F& end, const Brush& brush,
+        float strokeWidth) override
+    {
+        Add("DrawLine " + Numbers({ start.x, start.y, end.x, end.y }) + " " + Name(brush) + " " +
+            Numbers({ strokeWidth }));
+    }
+
+    void DrawBitmap(ID2D1Bitmap* pBitmap, const D2D1_RECT_F& dest, float opacity,
+        D2D1_BITMAP_INTERPOLATION_MODE interpolation, const D2D1_RECT_F* pSource) override
+    {
+        Add("DrawBitmap " + Name(pBitmap) + " " + Rect(dest) + " " + Numbers({ opacity, (float)interpolation }) +
+            " " + (pSource ? Rect(*pSource) : std::string("no source")));
+    }
+
+    void FillGeometry(ID2D1Geometry* pGeometry, const Brush& brush) override
+    {
+        Add("FillGeometry " + Name(pGeometry) + " " + Name(brush));
+    }
+
+    void DrawGeometry(ID2D1Geometry* pGeometry, const Brush& brush, float strokeWidth) override
+    {
+        Add("DrawGeometry " + Name(pGeometry) + " " + Name(brush) + " " + Numbers({ strokeWidth }));
+    }
+
+    void FillMesh(ID2D1Mesh* pMesh, const Brush& brush) override
+    {
+        Add("FillMesh " + Name(pMesh) + " " + Name(brush));
+    }
+
+    void DrawText(const wchar_t* text, unsigned int length, IDWriteTextFormat* pFormat,
+        const D2D1_RECT_F& rect, const Brush& brush) override
+    {
+        // The text is only ASCII, anything else would show up as a '?'
+        std::string narrow;
+        for (unsigned int i = 0u; i < length; ++i) narrow += text[i] < 128 ? (char)text[i] : '?';
+        Add("DrawText \"" + narrow + "\" " + Name(pFormat) + " " + Rect(rect) + " " + Name(brush));
+    }
+
+    void PushClip(const D2D1_RECT_F& rect, D2D1_ANTIALIAS_MODE antialiasMode) override
+    {
+        Add("PushClip " + Rect(rect) + " " + Numbers({ (float)antialiasMode }));
+    }
+
+    void PopClip() override
+    {
+        Add("PopClip");
+    }
+
+private:
+    void Add(const std::string& call)
+    {
+        calls.push_back(call);
+    }
+
+    static std::string Numbers(std::initializer_list<float> values)
+    {
+        std::string text;
+        char number[32];
+        for (float value : values)
+        {
+            snprintf(number, sizeof(number), text.empty() ? "%g" : ",%g", value);
+            text += number;
+        }
+        return text;
+    }
+
+    static std::string Rect(const D2D1_RECT_F& rect)
+    {
+        return Numbers({ rect.left, rect.top, rect.right, rect.bottom });
+    }
+
+    static std::string Color(const D2D1_COLOR_F& color)
+    {
+        return "rgba(" + Numbers({ color.r, color.g, color.b, color.a }) + ")";
+    }
+
+    std::string Name(const void* pResource) const
+    {
+        auto found = names.find(pResource);
+        return found != names.end() ? found->second : std::string("unknown");
+    }
+
+    std::string Name(const Brush& brush) const
+    {
+        return brush.pBrush ? Name(static_cast<const void*>(brush.pBrush)) : Color(brush.color);
+    }
+};
+
+struct Resources
+{
+    FakeResource bitmap, geometry, mesh, format, brush;
+    void Name(RecordingTarget& target)
+    {
+        target.names[bitmap.As<ID2D1Bitmap>()] = "bitmap";
+        target.names[geometry.As<ID2D1Geometry>()] = "geometry";
+        target.names[mesh.As<ID2D1Mesh>()] = "mesh";
+        target.names[format.As<IDWriteTextFormat>()] = "format";
+        target.names[brush.As<ID2D1Brush>()] = "brush";
+    }
+};
+
+static bool SameCalls(const std::vector<std::string>& calls, const std::vector<std::string>& expected)
+{
+    if (calls == expected) return true;
+    for (size_t i = 0u; i < calls.size() || i < expected.size(); ++i)
+    {
+        const char* got = i < calls.size() ? calls[i].c_str() : "(nothing)";
+        const char* wanted = i < expected.size() ? expected[i].c_str() : "(nothing)";
+        if (strcmp(got, wanted) != 0)
+        {
+            printf("  call %u is %s, expected %s\n", (unsigned int)i, got, wanted);
+            break;
+        }
+    }
+    return false;
+}
+
+template <typename F> static bool Throws(F&& body)
+{
+    try
+    {
+        body();
+    }
+    catch (const std::runtime_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+// One of every op, with both kinds of brushes and a nested clip
+static void RecordAll(CommandList& list, Resources& r)
+{
+    const D2D1_COLOR_F red = { 1.0f, 0.0f, 0.0f, 1.0f }, blue = { 0.0f, 0.0f, 1.0f, 0.5f };
+    const D2D1::Matrix3x2F transform(2.0f, 0.0f, 0.0f, 2.0f, 10.0f, 20.0f);
+    const D2D1_RECT_F source = { 0.0f, 0.0f, 16.0f, 16.0f };
+    std::wstring text = L"Score: 1200";
+    list.Clear(blue);
+    list.SetTransform(transform);
+    list.FillRectangle({ 1.0f, 2.0f, 3.0f, 4.0f }, red);
+    list.DrawRectangle({ 5.0f, 6.0f, 7.0f, 8.0f }, r.brush.As<ID2D1Brush>(), 2.5f);
+    list.FillRoundedRectangle({ { 0.0f, 0.0f, 50.0f, 20.0f }, 4.0f, 3.0f }, r.brush.As<ID2D1Brush>());
+    list.DrawRoundedRectangle({ { 1.0f, 1.0f, 49.0f, 19.0f }, 4.0f, 3.0f }, blue);
+    list.PushClip({ 0.0f, 0.0f, 100.0f, 100.0f });
+    list.FillEllipse({ { 30.0f, 40.0f }, 5.0f, 6.0f }, red);
+    list.DrawEllipse({ { 30.0f, 40.0f }, 7.0f, 8.0f }, r.brush.As<ID2D1Brush>(), 0.5f);
+    list.PushClip({ 10.0f, 10.0f, 90.0f, 90.0f }, D2D1_ANTIALIAS_MODE_ALIASED);
+    list.DrawLine({ 0.0f, 0.0f }, { 64.0f, 32.0f }, red);
+    list.DrawBitmap(r.bitmap.As<ID2D1Bitmap>(), { 0.0f, 0.0f, 32.0f, 32.0f });
+    list.DrawBitmap(r.bitmap.As<ID2D1Bitmap>(), { 8.0f, 8.0f, 24.0f, 24.0f }, 0.25f,
+        D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR, &source);
+    list.PopClip();
+    list.FillGeometry(r.geometry.As<ID2D1Geometry>(), r.brush.As<ID2D1Brush>());
+    list.DrawGeometry(r.geometry.As<ID2D1Geometry>(), blue, 3.0f);
+    list.FillMesh(r.mesh.As<ID2D1Mesh>(), red);
+    list.DrawText(text.c_str(), (unsigned int)text.size(), r.format.As<IDWriteTextFormat>(),
+        { 0.0f, 0.0f, 200.0f, 30.0f }, r.brush.As<ID2D1Brush>());
+    list.PopClip();
+
+    // The list keeps its own copy of the characters
+    text.assign(text.size(), L'x');
+}
+
+static const std::vector<std::string> ALL_CALLS =
+{
+    "Clear rgba(0,0,1,0.5)",
+    "SetTransform 2,0,0,2,10,20",
+    "FillRectangle 1,2,3,4 rgba(1,0,0,1)",
+    "DrawRectangle 5,6,7,8 brush 2.5",
+    "FillRoundedRectangle 0,0,50,20 4,3 brush",
+    "DrawRoundedRectangle 1,1,49,19 4,3 rgba(0,0,1,0.5) 1",
+    "PushClip 0,0,100,100 0",
+    "FillEllipse 30,40,5,6 rgba(1,0,0,1)",
+    "DrawEllipse 30,40,7,8 brush 0.5",
+    "PushClip 10,10,90,90 1",
+    "DrawLine 0,0,64,32 rgba(1,0,0,1) 1",
+    "DrawBitmap bitmap 0,0,32,32 1,1 no source",
+    "DrawBitmap bitmap 8,8,24,24 0.25,0 0,0,16,16",
+    "PopClip",
+    "FillGeometry geometry brush",
+    "DrawGeometry geometry rgba(0,0,1,0.5) 3",
+    "FillMesh mesh rgba(1,0,0,1)",
+    "DrawText \"Score: 1200\" format 0,0,200,30 brush",
+    "PopClip"
+};
+
+static void EveryOp()
+{
+    printf("every op\n");
+    Resources r;
+    CommandList list;
+    Expect(list.IsEmpty() && list.GetData().empty(), "a new list is empty");
+    RecordAll(list, r);
+    Expect(list.GetCommandCount() == ALL_CALLS.size() && !list.IsEmpty(), "every call is one command");
+
+    RecordingTarget target;
+    r.Name(target);
+    list.Replay(target);
+    Expect(SameCalls(target.calls, ALL_CALLS), "replay makes the recorded calls in order with their arguments");
+    target.calls.clear();
+    list.Replay(target);
+    Expect(SameCalls(target.calls, ALL_CALLS), "and does it again on a second replay");
+
+    // Every command is a header with its padded size, and the sizes add up to the buffer
+    const std::vector<uint8_t>& data = list.GetData();
+    size_t offset = 0u, commands = 0u;
+    bool aligned = true;
+    while (offset + sizeof(CommandList::Header) <= data.size())
+    {
+        CommandList::Header header;
+        memcpy(&header, &data[offset], sizeof(header));
+        aligned &= header.size % 4u == 0u && header.size >= sizeof(header);
+        offset += header.size ? header.size : data.size();
+        ++commands;
+    }
+    Expect(aligned && offset == data.size() && commands == ALL_CALLS.size(),
+        "the commands are padded to 4 bytes and fill the buffer");
+}
+
+static void ResourceTable()
+{
+    printf("resource table\n");
+    Resources r;
+    {
+        CommandList list;
+        RecordAll(list, r);
+        Expect(list.GetResourceCount() == 5u, "a resource used several times is stored once");
+        Expect(list.GetResource(0u) == r.brush.As<IUnknown>() && list.GetResource(1u) == r.bitmap.As<IUnknown>() &&
+            list.GetResource(2u) == r.geometry.As<IUnknown>() && list.GetResource(3u) == r.mesh.As<IUnknown>() &&
+            list.GetResource(4u) == r.format.As<IUnknown>(), "in the order of first use");
+        Expect(Throws([&] { list.GetResource(5u); }), "GetResource() past the end throws");
+        Expect(r.bitmap.GetReferences() == 2u && r.brush.GetReferences() == 2u && r.format.GetReferences() == 2u,
+            "the list holds one reference to each");
+
+        CommandList moved(std::move(list));
+        Expect(list.IsEmpty() && list.GetResourceCount() == 0u && moved.GetResourceCount() == 5u,
+            "moving a list hands over its resources");
+        Expect(r.bitmap.GetReferences() == 2u, "without touching the references");
+        CommandList assigned;
+        assigned.FillMesh(r.mesh.As<ID2D1Mesh>(), r.brush.As<ID2D1Brush>());
+        assigned = std::move(moved);
+        Expect(r.mesh.GetReferences() == 2u && assigned.GetCommandCount() == ALL_CALLS.size(),
+            "move assignment releases what the target list held");
+
+        RecordingTarget target;
+        r.Name(target);
+        assigned.Replay(target);
+        Expect(SameCalls(target.calls, ALL_CALLS), "a moved list replays the same calls");
+        assigned.Reset();
+        Expect(assigned.IsEmpty() && assigned.GetResourceCount() == 0u && r.geometry.GetReferences() == 1u,
+            "Reset() releases the resources");
+        assigned.DrawBitmap(r.bitmap.As<ID2D1Bitmap>(), { 0.0f, 0.0f, 1.0f, 1.0f });
+    }
+    Expect(r.bitmap.GetReferences() == 1u && r.brush.GetReferences() == 1u, "and so does the destructor");
+}
+
+static void Text()
+{
+    printf("inline text\n");
+    Resources r;
+    CommandList list;
+    RecordingTarget target;
+    r.Name(target);
+    {
+        std::wstring temporary(L"Game Over");
+        list.DrawText(temporary.c_str(), 4u, r.format.As<IDWriteTextFormat>(), { 0.0f, 0.0f, 10.0f, 10.0f },
+            D2D1_COLOR_F{ 1.0f, 1.0f, 1.0f, 1.0f });
+    }
+    list.DrawText(nullptr, 0u, r.format.As<IDWriteTextFormat>(), { 0.0f, 0.0f, 1.0f, 1.0f },
+        r.brush.As<ID2D1Brush>());
+    std::wstring odd(L"abc");
+    list.DrawText(odd.c_str(), 3u, r.format.As<IDWriteTextFormat>(), { 0.0f, 0.0f, 1.0f, 1.0f },
+        r.brush.As<ID2D1Brush>());
+    list.FillRectangle({ 0.0f, 0.0f, 1.0f, 1.0f }, r.brush.As<ID2D1Brush>());
+    list.Replay(target);
+    Expect(SameCalls(target.calls, {
+        "DrawText \"Game\" format 0,0,10,10 rgba(1,1,1,1)",
+        "DrawText \"\" format 0,0,1,1 brush",
+        "DrawText \"abc\" format 0,0,1,1 brush",
+        "FillRectangle 0,0,1,1 brush" }), "text is copied into the list, only up to the length given");
+
+    std::wstring huge(40000u, L'a');
+    Expect(Throws([&] { list.DrawText(huge.c_str(), (unsigned int)huge.size(), r.format.As<IDWriteTextFormat>(),
+        { 0.0f, 0.0f, 1.0f, 1.0f }, r.brush.As<ID2D1Brush>()); }), "text that doesn't fit a command throws");
+    Expect(list.GetCommandCount() == 4u, "and records nothing");
+}
+
+static void Clips()
+{
+    printf("clip balance\n");
+    CommandList list;
+    RecordingTarget target;
+    Expect(Throws([&] { list.PopClip(); }), "PopClip() without a clip throws");
+    Expect(list.IsEmpty(), "and records nothing");
+    list.PushClip({ 0.0f, 0.0f, 1.0f, 1.0f });
+    list.PushClip({ 0.0f, 0.0f, 1.0f, 1.0f });
+    list.PopClip();
+    Expect(Throws([&] { list.Replay(target); }) && target.calls.empty(),
+        "an open clip stops the replay before any call");
+    list.PopClip();
+    Expect(!Throws([&] { list.Replay(target); }) && target.calls.size() == 4u, "a balanced list replays");
+    list.PushClip({ 0.0f, 0.0f, 1.0f, 1.0f });
+    list.Reset();
+    target.calls.clear();
+    Expect(!Throws([&] { list.Replay(target); }) && target.calls.empty(), "Reset() forgets an open clip");
+}
+
+static void Refused()
+{
+    printf("refused arguments\n");
+    Resources r;
+    CommandList list;
+    Expect(Throws([&] { list.DrawBitmap(nullptr, { 0.0f, 0.0f, 1.0f, 1.0f }); }), "a null bitmap throws");
+    Expect(Throws([&] { list.FillGeometry(nullptr, r.brush.As<ID2D1Brush>()); }) &&
+        Throws([&] { list.DrawGeometry(nullptr, r.brush.As<ID2D1Brush>()); }), "a null geometry throws");
+    Expect(Throws([&] { list.FillMesh(nullptr, r.brush.As<ID2D1Brush>()); }), "a null mesh throws");
+    Expect(Throws([&] { list.DrawText(L"a", 1u, nullptr, { 0.0f, 0.0f, 1.0f, 1.0f }, r.brush.As<ID2D1Brush>()); }) &&
+        Throws([&] { list.DrawText(nullptr, 1u, r.format.As<IDWriteTextFormat>(), { 0.0f, 0.0f, 1.0f, 1.0f },
+        r.brush.As<ID2D1Brush>()); }), "a null format, or null text with a length, throws");
+    Expect(Throws([&] { list.FillRectangle({ 0.0f, 0.0f, 1.0f, 1.0f }, (ID2D1Brush*)nullptr); }),
+        "a null brush throws");
+    Expect(list.IsEmpty() && list.GetResourceCount() == 0u && r.brush.GetReferences() == 1u,
+        "and none of them records anything or keeps a reference");
+}
+
+int main()
+{
+    EveryOp();
+    ResourceTable();
+    Text();
+    Clips();
+    Refused();
+    if (failures) printf("%d checks FAILED\n", failures);
+    else printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
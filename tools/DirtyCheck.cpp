@@ -0,0 +1,217 @@
+// Marks random writes in Ice2D::DirtyRegion and checks the rects it keeps against every pixel that was marked.
+//
+//   DirtyCheck [--trials n] [--seed n]
+//
+// Each trial picks a surface size and a rect cap, then adds random writes: small sprites, long rows, writes that
+// hang over the edges or start outside. After every write, each marked pixel has to be inside one of the rects, the
+// rects have to stay inside the surface and under the cap, and a region that isn't full has to cover less than
+// three quarters of the surface. A few exact cases check merging, the cap, the full-surface fallback and the upload
+// stats. The tool exits with 1 when a check fails.
+#include "pch.h"
+
+#include "DirtyRegion.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Ice2D;
+
+typedef DirtyRegion::Rect Rect;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+struct Random
+{
+    uint32_t seed;
+    uint32_t Next(uint32_t count)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (uint32_t)(((uint64_t)(seed >> 1) * count) >> 31);
+    }
+};
+
+static bool Same(const Rect& a, const Rect& b)
+{
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static bool Covered(const DirtyRegion& region, unsigned int x, unsigned int y)
+{
+    for (const Rect& r : region.GetRects())
+    {
+        if (x >= r.left && x < r.right && y >= r.top && y < r.bottom) return true;
+    }
+    return false;
+}
+
+static void Fuzz(unsigned int trials, uint32_t seed)
+{
+    printf("%u trials of random writes\n", trials);
+    Random random = { seed };
+    unsigned long long writes = 0ull, rects = 0ull, saved = 0ull, total = 0ull;
+    bool coverage = true, inside = true, capped = true, fallback = true, stats = true;
+    for (unsigned int trial = 0u; trial < trials; ++trial)
+    {
+        const unsigned int width = 1u + random.Next(300u), height = 1u + random.Next(200u);
+        DirtyRegion region(1u + random.Next(16u));
+        region.SetBounds(width, height);
+        region.Clear();
+        std::vector<unsigned char> marked((size_t)width * height);
+        const unsigned int count = 1u + random.Next(60u);
+        for (unsigned int i = 0u; i < count; ++i)
+        {
+            unsigned int x = random.Next(width + 20u), y = random.Next(height + 20u), w, h;
+            switch (random.Next(4u))
+            {
+            case 0: w = 1u + random.Next(16u); h = 1u + random.Next(16u); break;
+            case 1: w = 1u + random.Next(width); h = 1u; break;
+            case 2: w = 0xFFFFFFFFu; h = 1u + random.Next(4u); break;
+            default: w = 1u + random.Next(64u); h = 1u + random.Next(64u); break;
+            }
+            region.Add(x, y, w, h);
+            for (unsigned int py = y; py < height && py - y < h; ++py)
+            {
+                for (unsigned int px = x; px < width && px - x < w; ++px) marked[(size_t)py * width + px] = 1u;
+            }
+            ++writes;
+
+            for (unsigned int py = 0u; py < height; ++py)
+            {
+                for (unsigned int px = 0u; px < width; ++px)
+                {
+                    if (marked[(size_t)py * width + px]) coverage &= Covered(region, px, py);
+                }
+            }
+            for (const Rect& r : region.GetRects())
+            {
+                inside &= r.left < r.right && r.top < r.bottom && r.right <= width && r.bottom <= height;
+            }
+            capped &= region.GetRects().size() <= region.GetMaxRects();
+            if (region.IsFull())
+            {
+                fallback &= region.GetRects().size() == 1u && Same(region.GetRects()[0], { 0u, 0u, width, height });
+            }
+            else
+            {
+                fallback &= region.GetArea() * 4u < (unsigned long long)width * height * 3u;
+            }
+        }
+
+        // The saving is whatever the rects leave out of a full upload
+        const unsigned long long surface = (unsigned long long)width * height * 4u;
+        const unsigned long long uploaded = region.IsFull() ? surface : std::min(region.GetArea() * 4u, surface);
+        region.RecordUpload(4u, false);
+        const DirtyRegion::Stats& s = region.GetStats();
+        stats &= s.uploads == 1u && s.bytesUploaded == uploaded && s.bytesSaved == surface - uploaded;
+        stats &= s.rects == (region.IsFull() ? 1u : region.GetRects().size());
+        rects += region.GetRects().size();
+        saved += s.bytesSaved;
+        total += surface;
+    }
+    printf("  %llu writes, %.1f rects per upload, %.1f%% of the bytes saved\n", writes, (double)rects / trials,
+        100.0 * saved / total);
+    Expect(coverage, "every marked pixel is inside a rect");
+    Expect(inside, "every rect is inside the surface and not empty");
+    Expect(capped, "the rect cap holds");
+    Expect(fallback, "a region is full, or covers less than three quarters of the surface");
+    Expect(stats, "the upload stats match the rects");
+}
+
+static void Merging()
+{
+    printf("merging and the cap\n");
+    DirtyRegion region(3u);
+    region.SetBounds(1000u, 1000u);
+    Expect(region.IsFull(), "new bounds mark everything");
+    region.Clear();
+    Expect(region.IsEmpty() && !region.IsFull(), "Clear() empties it");
+
+    region.Add(10u, 10u, 10u, 10u);
+    region.Add(20u, 10u, 10u, 10u);
+    Expect(region.GetRects().size() == 1u && Same(region.GetRects()[0], { 10u, 10u, 30u, 20u }),
+        "two touching rects of the same height merge");
+    region.Add(12u, 12u, 4u, 4u);
+    Expect(region.GetRects().size() == 1u, "a rect inside another adds nothing");
+    region.Add(500u, 500u, 10u, 10u);
+    region.Add(900u, 10u, 10u, 10u);
+    Expect(region.GetRects().size() == 3u, "far apart rects stay separate up to the cap");
+
+    // A fourth rect next to the first one merges with it, the cheapest pair
+    region.Add(10u, 40u, 20u, 10u);
+    Expect(region.GetRects().size() == 3u, "the cap merges the pair that adds the least area");
+    Expect(Covered(region, 10u, 10u) && Covered(region, 29u, 49u) && Covered(region, 505u, 505u) &&
+        Covered(region, 905u, 15u), "and keeps covering every write");
+    Expect(region.GetArea() == 20u * 40u + 100u + 100u, "the merged rect spans both");
+
+    region.SetMaxRects(1u);
+    Expect(region.GetRects().size() == 1u && Same(region.GetRects()[0], { 10u, 10u, 910u, 510u }),
+        "a lower cap merges what's there");
+    Expect(!region.IsFull(), "less than three quarters isn't full");
+
+    region.Add(0u, 600u, 1000u, 400u);
+    Expect(region.IsFull() && Same(region.GetRects()[0], { 0u, 0u, 1000u, 1000u }),
+        "three quarters of the surface falls back to the full surface");
+    region.Add(5u, 5u, 1u, 1u);
+    Expect(region.GetRects().size() == 1u, "writes to a full region change nothing");
+
+    region.Clear();
+    region.Add(2000u, 0u, 5u, 5u);
+    region.Add(995u, 995u, 100u, 100u);
+    Expect(region.GetRects().size() == 1u && Same(region.GetRects()[0], { 995u, 995u, 1000u, 1000u }),
+        "writes are clipped to the surface, and outside ones are dropped");
+}
+
+static void Stats()
+{
+    printf("upload stats\n");
+    DirtyRegion region;
+    region.SetBounds(100u, 100u);
+    region.RecordUpload(4u, false);
+    region.Clear();
+    region.Add(0u, 0u, 10u, 10u);
+    region.Add(50u, 50u, 20u, 5u);
+    region.RecordUpload(4u, false);
+    region.Clear();
+    region.Add(0u, 0u, 1u, 1u);
+    region.RecordUpload(4u, true);
+    const DirtyRegion::Stats& s = region.GetStats();
+    Expect(s.uploads == 3u && s.fullUploads == 2u, "new bounds and a forced upload count as full");
+    Expect(s.rects == 1u + 2u + 1u, "a full upload is one rect");
+    Expect(s.bytesUploaded == 40000u + 200u * 4u + 40000u, "the partial upload sends only its rects");
+    Expect(s.bytesSaved == 40000u - 200u * 4u, "and saves the rest");
+    region.ResetStats();
+    Expect(region.GetStats().uploads == 0u && region.GetStats().bytesSaved == 0u, "ResetStats() zeroes them");
+
+    DirtyRegion empty;
+    empty.SetBounds(0u, 0u);
+    empty.Add(0u, 0u, 10u, 10u);
+    Expect(empty.IsEmpty() && !empty.IsFull(), "a surface without pixels never gets dirty");
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int trials = 2000u;
+    uint32_t seed = 1u;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--trials") == 0) trials = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+    }
+    if (trials == 0u) trials = 1u;
+
+    Fuzz(trials, seed);
+    Merging();
+    Stats();
+    if (failures) printf("%d checks FAILED\n", failures);
+    else printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,444 @@
+// Measures Ice2D::GlyphTable, the layout core of Ice2D::BitmapFont, and checks its quads.
+//
+//   FontBench [--runs n] [--font file.fnt]
+//
+// A font with Latin-1 and Greek glyphs on two pages and a few hundred kerning pairs is generated in the BMFont text
+// format and parsed back. The scenes lay out damage numbers, debug overlay lines and chat messages the way a game
+// does every frame, one string at a time into a reused quad buffer. The timings are the best of n runs. Every
+// string is also laid out by a slow reference that works straight from the generated metrics, and the quads have to
+// match; UTF-8 and wide strings have to give the same quads, and broken files have to be rejected. --font parses a
+// real .fnt file and times the debug scene with it. The tool exits with 1 when a check fails.
+#include "pch.h"
+
+#include "GlyphTable.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace Ice2D;
+
+struct RefGlyph
+{
+    int x, y, width, height, offsetX, offsetY, advance, page;
+};
+
+struct RefFont
+{
+    std::map<uint32_t, RefGlyph> glyphs;
+    std::map<std::pair<uint32_t, uint32_t>, int> kerning;
+    std::string text;
+};
+
+static const int LINE_HEIGHT = 24;
+static const int PAGE_SIZE = 256;
+static const int CELL = 20;
+
+static RefFont MakeFont()
+{
+    RefFont font;
+    std::vector<uint32_t> codepoints;
+    for (uint32_t c = 32u; c < 127u; ++c) codepoints.push_back(c);
+    for (uint32_t c = 160u; c < 256u; ++c) codepoints.push_back(c);
+    for (uint32_t c = 0x391u; c <= 0x3C9u; ++c) if (c != 0x3A2u) codepoints.push_back(c);
+
+    const int perPage = (PAGE_SIZE / CELL) * (PAGE_SIZE / CELL);
+    for (size_t i = 0u; i < codepoints.size(); ++i)
+    {
+        uint32_t c = codepoints[i];
+        int cell = (int)i % perPage;
+        RefGlyph glyph;
+        glyph.page = (int)i / perPage;
+        glyph.x = (cell % (PAGE_SIZE / CELL)) * CELL;
+        glyph.y = (cell / (PAGE_SIZE / CELL)) * CELL;
+        glyph.width = c == 32u || c == 160u ? 0 : 6 + (int)(c * 7u % 10u);
+        glyph.height = c == 32u || c == 160u ? 0 : 10 + (int)(c * 3u % 8u);
+        glyph.offsetX = (int)(c % 3u) - 1;
+        glyph.offsetY = 2 + (int)(c % 5u);
+        glyph.advance = c == 32u || c == 160u ? 5 : glyph.width + 1;
+        font.glyphs[c] = glyph;
+    }
+    for (uint32_t a = 'A'; a <= 'z'; ++a)
+    {
+        for (uint32_t b = 'A'; b <= 'z'; ++b)
+        {
+            if ((a * 31u + b) % 7u == 0u) font.kerning[std::make_pair(a, b)] = -(int)((a + b) % 3u + 1u);
+        }
+    }
+    font.kerning[std::make_pair(0x3A4u, 0x3B1u)] = -2;
+
+    char line[256];
+    snprintf(line, sizeof(line), "info face=\"Bench Sans\" size=20 bold=0 italic=0 charset=\"\" unicode=1 "
+        "stretchH=100 smooth=1 aa=1 padding=0,0,0,0 spacing=1,1\r\n");
+    font.text += line;
+    snprintf(line, sizeof(line), "common lineHeight=%d base=18 scaleW=%d scaleH=%d pages=2 packed=0\r\n",
+        LINE_HEIGHT, PAGE_SIZE, PAGE_SIZE);
+    font.text += line;
+    font.text += "page id=0 file=\"bench_0.png\"\r\npage id=1 file=\"bench_1.png\"\r\n";
+    snprintf(line, sizeof(line), "chars count=%u\r\n", (unsigned int)font.glyphs.size());
+    font.text += line;
+    for (const auto& entry : font.glyphs)
+    {
+        const RefGlyph& g = entry.second;
+        snprintf(line, sizeof(line), "char id=%-5u x=%-5d y=%-5d width=%-5d height=%-5d xoffset=%-5d yoffset=%-5d "
+            "xadvance=%-5d page=%d  chnl=15\r\n", entry.first, g.x, g.y, g.width, g.height, g.offsetX, g.offsetY,
+            g.advance, g.page);
+        font.text += line;
+    }
+    snprintf(line, sizeof(line), "kernings count=%u\r\n", (unsigned int)font.kerning.size());
+    font.text += line;
+    for (const auto& entry : font.kerning)
+    {
+        snprintf(line, sizeof(line), "kerning first=%u second=%u amount=%d\r\n", entry.first.first,
+            entry.first.second, entry.second);
+        font.text += line;
+    }
+    return font;
+}
+
+static std::string ToUtf8(const std::u32string& text)
+{
+    std::string result;
+    for (char32_t c : text)
+    {
+        if (c < 0x80u) result += (char)c;
+        else if (c < 0x800u)
+        {
+            result += (char)(0xC0u | (c >> 6));
+            result += (char)(0x80u | (c & 0x3Fu));
+        }
+        else if (c < 0x10000u)
+        {
+            result += (char)(0xE0u | (c >> 12));
+            result += (char)(0x80u | ((c >> 6) & 0x3Fu));
+            result += (char)(0x80u | (c & 0x3Fu));
+        }
+        else
+        {
+            result += (char)(0xF0u | (c >> 18));
+            result += (char)(0x80u | ((c >> 12) & 0x3Fu));
+            result += (char)(0x80u | ((c >> 6) & 0x3Fu));
+            result += (char)(0x80u | (c & 0x3Fu));
+        }
+    }
+    return result;
+}
+
+static std::wstring ToWide(const std::u32string& text)
+{
+    // UTF-16 where wchar_t is 16 bits, like on Windows
+    std::wstring result;
+    for (char32_t c : text)
+    {
+        if (sizeof(wchar_t) == 2u && c >= 0x10000u)
+        {
+            result += (wchar_t)(0xD800u + ((c - 0x10000u) >> 10));
+            result += (wchar_t)(0xDC00u + ((c - 0x10000u) & 0x3FFu));
+        }
+        else
+        {
+            result += (wchar_t)c;
+        }
+    }
+    return result;
+}
+
+// Straight from the generated metrics, with the fallback to '?' for missing characters
+static void ReferenceLayout(const RefFont& font, const std::u32string& text, float x, float y, float scale,
+    std::vector<GlyphTable::Quad>& quads, GlyphTable::Size& size)
+{
+    quads.clear();
+    float penX = x, lineY = y, width = 0.0f;
+    uint32_t previous = 0u;
+    bool hasPrevious = false;
+    for (char32_t c : text)
+    {
+        if (c == U'\n')
+        {
+            width = std::max(width, penX - x);
+            penX = x;
+            lineY += LINE_HEIGHT * scale;
+            hasPrevious = false;
+            continue;
+        }
+        uint32_t codepoint = font.glyphs.count((uint32_t)c) ? (uint32_t)c : (uint32_t)'?';
+        if (hasPrevious)
+        {
+            auto kerning = font.kerning.find(std::make_pair(previous, codepoint));
+            if (kerning != font.kerning.end()) penX += (float)kerning->second * scale;
+        }
+        const RefGlyph& g = font.glyphs.at(codepoint);
+        if (g.width && g.height)
+        {
+            GlyphTable::Quad quad;
+            quad.left = penX + g.offsetX * scale;
+            quad.top = lineY + g.offsetY * scale;
+            quad.right = quad.left + g.width * scale;
+            quad.bottom = quad.top + g.height * scale;
+            quad.sourceLeft = (uint32_t)g.x;
+            quad.sourceTop = (uint32_t)g.y;
+            quad.sourceRight = (uint32_t)(g.x + g.width);
+            quad.sourceBottom = (uint32_t)(g.y + g.height);
+            quad.page = (uint32_t)g.page;
+            quads.push_back(quad);
+        }
+        penX += g.advance * scale;
+        previous = codepoint;
+        hasPrevious = true;
+    }
+    size.width = std::max(width, penX - x);
+    size.height = text.empty() ? 0.0f : (float)(std::count(text.begin(), text.end(), U'\n') + 1) * LINE_HEIGHT * scale;
+}
+
+static bool SameQuads(const std::vector<GlyphTable::Quad>& a, const std::vector<GlyphTable::Quad>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0u; i < a.size(); ++i)
+    {
+        if (std::fabs(a[i].left - b[i].left) > 1e-3f || std::fabs(a[i].top - b[i].top) > 1e-3f ||
+            std::fabs(a[i].right - b[i].right) > 1e-3f || std::fabs(a[i].bottom - b[i].bottom) > 1e-3f ||
+            a[i].sourceLeft != b[i].sourceLeft || a[i].sourceTop != b[i].sourceTop ||
+            a[i].sourceRight != b[i].sourceRight || a[i].sourceBottom != b[i].sourceBottom || a[i].page != b[i].page)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Random
+{
+    uint32_t seed;
+    uint32_t Next(uint32_t count)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % count;
+    }
+};
+
+static std::vector<std::u32string> DamageNumbers(Random& random)
+{
+    std::vector<std::u32string> strings;
+    for (int i = 0; i < 20000; ++i)
+    {
+        char text[16];
+        snprintf(text, sizeof(text), random.Next(4u) ? "%u" : "-%u!", random.Next(100000u));
+        strings.push_back(std::u32string(text, text + strlen(text)));
+    }
+    return strings;
+}
+
+static std::vector<std::u32string> DebugLines(Random& random)
+{
+    std::vector<std::u32string> strings;
+    for (int i = 0; i < 4000; ++i)
+    {
+        char text[128];
+        snprintf(text, sizeof(text), "frame %5u  update %.3f ms  draw %.3f ms  sprites %4u  batches %3u  voices %2u",
+            random.Next(100000u), random.Next(10000u) * 1e-3, random.Next(10000u) * 1e-3, random.Next(5000u),
+            random.Next(200u), random.Next(64u));
+        strings.push_back(std::u32string(text, text + strlen(text)));
+    }
+    return strings;
+}
+
+static std::vector<std::u32string> ChatMessages(Random& random)
+{
+    static const char32_t* words[] = { U"Hallo", U"Straße", U"über", U"Ärger", U"Tour", U"AVATAR", U"façade",
+        U"Wave", U"coöperate", U"naïve", U"Ταχύ", U"Ωμέγα", U"You", U"LTA", U"¿qué?", U"¡olé!", U"Keyboard",
+        U"TAVERN", U"løbe", U"æble", U"\U0001F600" };
+    std::vector<std::u32string> strings;
+    for (int i = 0; i < 2000; ++i)
+    {
+        std::u32string text = U"<Player" + std::u32string(1, U'0' + (char32_t)random.Next(10u)) + U"> ";
+        while (text.size() < 100u)
+        {
+            text += words[random.Next((uint32_t)(sizeof(words) / sizeof(words[0])))];
+            text += random.Next(12u) ? U" " : U"\n";
+        }
+        strings.push_back(text);
+    }
+    return strings;
+}
+
+struct Scene
+{
+    const char* name;
+    std::vector<std::u32string> (*build)(Random& random);
+};
+
+template <typename String> static double Time(const GlyphTable& table, const std::vector<String>& strings,
+    unsigned int runs, std::vector<GlyphTable::Quad>& quads, unsigned long long& glyphs)
+{
+    double best = 1e30;
+    for (unsigned int run = 0u; run < runs; ++run)
+    {
+        glyphs = 0ull;
+        float y = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        for (const String& text : strings)
+        {
+            quads.clear();
+            glyphs += table.Layout(text.data(), text.size(), 10.0f, y, 1.0f, quads);
+            y = y > 1000.0f ? 0.0f : y + 1.0f;
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static bool CheckRejects()
+{
+    struct Case
+    {
+        const char* text;
+        GlyphTable::Result result;
+    };
+    const Case cases[] =
+    {
+        { "", GlyphTable::Result::Empty },
+        { "BMF\x03", GlyphTable::Result::Binary },
+        { "  <?xml version=\"1.0\"?>", GlyphTable::Result::Xml },
+        { "char id=65 x=0 y=0 width=4 height=4 xoffset=0 yoffset=0 xadvance=5 page=0\n",
+            GlyphTable::Result::MissingCommon },
+        { "common lineHeight=10 base=8 scaleW=16 scaleH=16 pages=1\npage id=0 file=\"a.png\"\n",
+            GlyphTable::Result::NoGlyphs },
+        { "common lineHeight=10 base=8 scaleW=16 scaleH=16 pages=1\npage id=0 file=\"a.png\"\n"
+            "char id=65 x=14 y=0 width=4 height=4 xoffset=0 yoffset=0 xadvance=5 page=0\n",
+            GlyphTable::Result::BadGlyph },
+        { "common lineHeight=10 base=8 scaleW=16 scaleH=16 pages=2\npage id=0 file=\"a.png\"\n"
+            "char id=65 x=0 y=0 width=4 height=4 xoffset=0 yoffset=0 xadvance=5 page=0\n",
+            GlyphTable::Result::MissingPage },
+        { "common lineHeight=10 base=8 scaleW=16 scaleH=16 pages=1\npage id=0 file=\"a.png\"\n"
+            "char id=65 x=0 y=0 width=4 height=4 xoffset=0 yoffset=0 xadvance=5 page=1\n",
+            GlyphTable::Result::BadGlyph },
+        { "common lineHeight=10 base=8 scaleW=16 scaleH=16 pages=1\npage id=0 file=\"a.png\n",
+            GlyphTable::Result::BadLine },
+        { "common lineHeight=10 base=8 scaleW=16 scaleH=16 pages=1\npage id=0 file=\"a.png\"\n"
+            "char id=65 x=0 y=zero width=4 height=4 xoffset=0 yoffset=0 xadvance=5 page=0\n",
+            GlyphTable::Result::BadLine },
+        { "\xEF\xBB\xBF" "common lineHeight=10 base=8 scaleW=16 scaleH=16 pages=1\npage id=0 file=\"a.png\"\n"
+            "char id=-1 x=0 y=0 width=4 height=4 xoffset=0 yoffset=0 xadvance=5 page=0\n"
+            "char id=65 x=0 y=0 width=4 height=4 xoffset=0 yoffset=0 xadvance=5 page=0",
+            GlyphTable::Result::Ok },
+    };
+
+    bool ok = true;
+    for (const Case& c : cases)
+    {
+        GlyphTable table;
+        GlyphTable::Result result = table.Parse(c.text, strlen(c.text));
+        if (result != c.result)
+        {
+            printf("  file %.40s...: expected \"%s\", got \"%s\"\n", c.text, GlyphTable::GetResultName(c.result),
+                GlyphTable::GetResultName(result));
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int runs = 5u;
+    const char* fontPath = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--runs") == 0) runs = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--font") == 0) fontPath = argv[i + 1];
+    }
+    if (runs == 0u) runs = 1u;
+
+    int result = 0;
+    RefFont font = MakeFont();
+    GlyphTable table;
+    auto parseStart = std::chrono::steady_clock::now();
+    GlyphTable::Result parsed = table.Parse(font.text.data(), font.text.size());
+    double parseTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - parseStart).count();
+    if (parsed != GlyphTable::Result::Ok || table.GetGlyphCount() != font.glyphs.size() ||
+        table.GetKerningCount() != font.kerning.size() || table.GetPageCount() != 2u || table.GetPage(1u) != "bench_1.png")
+    {
+        printf("generated font: %s, %u glyphs, %u kerning pairs\n", GlyphTable::GetResultName(parsed),
+            (unsigned int)table.GetGlyphCount(), (unsigned int)table.GetKerningCount());
+        return 1;
+    }
+    printf("font: %u glyphs, %u kerning pairs, %u KB parsed in %.2f ms\n", (unsigned int)table.GetGlyphCount(),
+        (unsigned int)table.GetKerningCount(), (unsigned int)(font.text.size() / 1024u), parseTime * 1e3);
+    if (!CheckRejects()) result = 1;
+
+    const Scene scenes[] = { { "damage", DamageNumbers }, { "debug", DebugLines }, { "chat", ChatMessages } };
+    printf("%-8s %7s %9s %10s %10s %10s %10s\n", "scene", "strings", "glyphs", "ms wide", "Mglyph/s", "ms utf-8",
+        "Mglyph/s");
+    std::vector<GlyphTable::Quad> quads, wideQuads, reference;
+    for (const Scene& scene : scenes)
+    {
+        Random random = { 11u };
+        std::vector<std::u32string> strings = scene.build(random);
+        std::vector<std::wstring> wide;
+        std::vector<std::string> utf8;
+        for (const std::u32string& text : strings)
+        {
+            wide.push_back(ToWide(text));
+            utf8.push_back(ToUtf8(text));
+        }
+
+        unsigned long long glyphs = 0ull, utf8Glyphs = 0ull;
+        double wideTime = Time(table, wide, runs, quads, glyphs);
+        double utf8Time = Time(table, utf8, runs, quads, utf8Glyphs);
+        printf("%-8s %7u %9llu %10.2f %10.1f %10.2f %10.1f\n", scene.name, (unsigned int)strings.size(), glyphs,
+            wideTime * 1e3, glyphs / wideTime * 1e-6, utf8Time * 1e3, utf8Glyphs / utf8Time * 1e-6);
+
+        unsigned int failed = 0u;
+        for (size_t i = 0u; i < strings.size(); ++i)
+        {
+            const float scale = i % 3u == 0u ? 1.5f : 1.0f;
+            GlyphTable::Size size;
+            ReferenceLayout(font, strings[i], 3.0f, 7.0f, scale, reference, size);
+            quads.clear();
+            wideQuads.clear();
+            table.Layout(utf8[i].data(), utf8[i].size(), 3.0f, 7.0f, scale, quads);
+            table.Layout(wide[i].data(), wide[i].size(), 3.0f, 7.0f, scale, wideQuads);
+            GlyphTable::Size measured = table.Measure(wide[i].data(), wide[i].size(), scale);
+            bool ok = SameQuads(reference, quads) && SameQuads(reference, wideQuads) &&
+                std::fabs(measured.width - size.width) < 1e-3f && measured.height == size.height;
+            if (!ok && failed < 5u) printf("  string %u doesn't match the reference layout\n", (unsigned int)i);
+            if (!ok) ++failed;
+        }
+        if (failed)
+        {
+            printf("  %u of %u strings failed\n", failed, (unsigned int)strings.size());
+            result = 1;
+        }
+    }
+
+    if (fontPath)
+    {
+        MappedFile file(fontPath);
+        GlyphTable custom;
+        GlyphTable::Result customResult = file.IsOpen() ? custom.Parse(file.GetData(), file.GetSize()) :
+            GlyphTable::Result::Empty;
+        if (customResult != GlyphTable::Result::Ok)
+        {
+            printf("%s: %s\n", fontPath, file.IsOpen() ? GlyphTable::GetResultName(customResult) : "Can't open file");
+            return 1;
+        }
+        Random random = { 11u };
+        std::vector<std::u32string> strings = DebugLines(random);
+        std::vector<std::wstring> wide;
+        for (const std::u32string& text : strings) wide.push_back(ToWide(text));
+        unsigned long long glyphs = 0ull;
+        double time = Time(custom, wide, runs, quads, glyphs);
+        printf("%s: %u glyphs, %u kerning pairs, %u pages, debug scene %llu glyphs in %.2f ms, %.1f Mglyph/s\n",
+            fontPath, (unsigned int)custom.GetGlyphCount(), (unsigned int)custom.GetKerningCount(),
+            custom.GetPageCount(), glyphs, time * 1e3, glyphs / time * 1e-6);
+    }
+
+    printf(result ? "checks failed\n" : "all checks passed\n");
+    return result;
+}
@@ -0,0 +1,243 @@
+// Times the RawImage::ForEach() variants on a plain 32bpp buffer and checks they all give the same pixels.
+//
+//   ForEachBench [--width n] [--height n] [--runs n] [--threads n]
+//
+// RawImage needs WIC, so the loops here are the same as the ones in Images.h, over a buffer of the same layout:
+// a function pointer per pixel (the old ForEach()), an inlined callable per pixel, whole rows, and both of those
+// split into bands on an Ice2D::ThreadPool. Three filters go from trivial to heavy: an invert, a procedural
+// plasma and a 5x5 blur from a second buffer. Times are the best of n runs. Every variant has to match the
+// function pointer result exactly, and the parallel ones have to match with 1, 2 and all threads. The tool exits
+// with 1 when a check fails.
+#include "pch.h"
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Ice2D;
+
+// Stands in for RawImage::PixelColor, same layout
+struct PixelColor
+{
+    uint32_t data;
+};
+
+struct Image
+{
+    unsigned int width, height;
+    std::vector<PixelColor> pixels;
+    PixelColor* Row(unsigned int y) { return pixels.data() + (size_t)y * width; }
+};
+
+// The loops below are RawImage's, minus the lock check and the dirty rows
+static void ForEachPointer(Image& image, void (*process)(unsigned int x, unsigned int y, PixelColor& c))
+{
+    for (unsigned int y = 0; y < image.height; ++y)
+    {
+        PixelColor* pRow = image.Row(y);
+        for (unsigned int x = 0; x < image.width; ++x) process(x, y, pRow[x]);
+    }
+}
+
+template <typename F>
+static void ForEachRow(Image& image, F&& process)
+{
+    for (unsigned int y = 0; y < image.height; ++y) process(y, image.Row(y), image.width);
+}
+
+template <typename F>
+static void ForEach(Image& image, F&& process)
+{
+    ForEachRow(image, [&process](unsigned int y, PixelColor* pRow, unsigned int width)
+    {
+        for (unsigned int x = 0; x < width; ++x) process(x, y, pRow[x]);
+    });
+}
+
+template <typename F>
+static void ParallelForEachRow(Image& image, F&& process, ThreadPool& pool)
+{
+    pool.ParallelFor(0u, image.height, [&image, &process](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int y = begin; y < end; ++y) process(y, image.Row(y), image.width);
+    }, 16u);
+}
+
+template <typename F>
+static void ParallelForEach(Image& image, F&& process, ThreadPool& pool)
+{
+    ParallelForEachRow(image, [&process](unsigned int y, PixelColor* pRow, unsigned int width)
+    {
+        for (unsigned int x = 0; x < width; ++x) process(x, y, pRow[x]);
+    }, pool);
+}
+
+// Filters, each as a per-pixel body that the function pointer and the callables share
+static inline void Invert(unsigned int, unsigned int, PixelColor& c)
+{
+    c.data = (c.data & 0xFF000000u) | (~c.data & 0x00FFFFFFu);
+}
+
+static inline void Plasma(unsigned int x, unsigned int y, PixelColor& c)
+{
+    float v = std::sin(x * 0.031f) + std::sin(y * 0.047f) + std::sin((x + y) * 0.023f);
+    uint32_t r = (uint32_t)(127.5f + 42.0f * v), g = (uint32_t)(127.5f - 42.0f * v), b = (x ^ y) & 0xFFu;
+    c.data = 0xFF000000u | (r << 16) | (g << 8) | b;
+}
+
+static const Image* pBlurSource = nullptr;
+
+static inline void Blur(unsigned int x, unsigned int y, PixelColor& c)
+{
+    // 5x5 box over the source, clamped at the edges
+    const Image& src = *pBlurSource;
+    uint32_t sum[4] = {};
+    for (int dy = -2; dy <= 2; ++dy)
+    {
+        unsigned int sy = (unsigned int)std::min(std::max((int)y + dy, 0), (int)src.height - 1);
+        const PixelColor* pRow = src.pixels.data() + (size_t)sy * src.width;
+        for (int dx = -2; dx <= 2; ++dx)
+        {
+            uint32_t p = pRow[std::min(std::max((int)x + dx, 0), (int)src.width - 1)].data;
+            for (unsigned int i = 0u; i < 4u; ++i) sum[i] += (p >> (i * 8u)) & 0xFFu;
+        }
+    }
+    c.data = 0u;
+    for (unsigned int i = 0u; i < 4u; ++i) c.data |= ((sum[i] + 12u) / 25u) << (i * 8u);
+}
+
+struct Filter
+{
+    const char* name;
+    void (*pointer)(unsigned int x, unsigned int y, PixelColor& c);
+    int id;
+};
+
+template <int ID>
+struct Body
+{
+};
+
+template <>
+struct Body<0>
+{
+    void operator()(unsigned int x, unsigned int y, PixelColor& c) const { Invert(x, y, c); }
+};
+
+template <>
+struct Body<1>
+{
+    void operator()(unsigned int x, unsigned int y, PixelColor& c) const { Plasma(x, y, c); }
+};
+
+template <>
+struct Body<2>
+{
+    void operator()(unsigned int x, unsigned int y, PixelColor& c) const { Blur(x, y, c); }
+};
+
+template <typename F>
+static double Best(unsigned int runs, Image& image, const Image& input, F&& body)
+{
+    double best = 1e30;
+    for (unsigned int run = 0u; run < runs; ++run)
+    {
+        image.pixels = input.pixels;
+        auto start = std::chrono::steady_clock::now();
+        body();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static bool Same(const Image& a, const Image& b)
+{
+    return memcmp(a.pixels.data(), b.pixels.data(), a.pixels.size() * sizeof(PixelColor)) == 0;
+}
+
+template <int ID>
+static int Run(const char* name, unsigned int runs, const Image& input, ThreadPool& pool)
+{
+    const Body<ID> body;
+    Image image = input, expected = input;
+    static void (* const pointers[3])(unsigned int, unsigned int, PixelColor&) = { Invert, Plasma, Blur };
+    // Through a volatile pointer, so the compiler can't turn it into a direct call
+    void (* volatile pointer)(unsigned int, unsigned int, PixelColor&) = pointers[ID];
+
+    double tPointer = Best(runs, image, input, [&] { ForEachPointer(image, pointer); });
+    expected.pixels = image.pixels;
+    double tCallable = Best(runs, image, input, [&] { ForEach(image, body); });
+    bool same = Same(image, expected);
+    double tRow = Best(runs, image, input, [&]
+    {
+        ForEachRow(image, [&body](unsigned int y, PixelColor* pRow, unsigned int width)
+        {
+            for (unsigned int x = 0; x < width; ++x) body(x, y, pRow[x]);
+        });
+    });
+    same &= Same(image, expected);
+    double tParallel = Best(runs, image, input, [&] { ParallelForEach(image, body, pool); });
+    same &= Same(image, expected);
+    double tParallelRow = Best(runs, image, input, [&]
+    {
+        ParallelForEachRow(image, [&body](unsigned int y, PixelColor* pRow, unsigned int width)
+        {
+            for (unsigned int x = 0; x < width; ++x) body(x, y, pRow[x]);
+        }, pool);
+    });
+    same &= Same(image, expected);
+
+    printf("%-8s %9.2fms %9.2fms %9.2fms %9.2fms %9.2fms %8.1fx\n", name, tPointer * 1e3, tCallable * 1e3,
+        tRow * 1e3, tParallel * 1e3, tParallelRow * 1e3, tPointer / std::min(tParallel, tParallelRow));
+
+    // Bands don't depend on timing, so any thread count gives the same pixels
+    for (unsigned int threads : { 1u, 2u })
+    {
+        ThreadPool other(threads);
+        image.pixels = input.pixels;
+        ParallelForEach(image, body, other);
+        same &= Same(image, expected);
+    }
+    if (!same) printf("  %s: a variant gave different pixels than the function pointer\n", name);
+    return same ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int width = 1920u, height = 1080u, runs = 5u, threads = ThreadPool::DefaultThreadCount();
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--width") == 0) width = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--height") == 0) height = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--runs") == 0) runs = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0) threads = (unsigned int)atoi(argv[i + 1]);
+    }
+    if (width == 0u) width = 1u;
+    if (height == 0u) height = 1u;
+    if (runs == 0u) runs = 1u;
+
+    Image input = { width, height, std::vector<PixelColor>((size_t)width * height) };
+    uint32_t seed = 1u;
+    for (PixelColor& c : input.pixels)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        c.data = 0xFF000000u | (seed >> 8);
+    }
+    pBlurSource = &input;
+
+    ThreadPool pool(threads);
+    printf("%ux%u, best of %u runs, %u threads\n", width, height, runs, pool.GetThreadCount());
+    printf("%-8s %11s %11s %11s %11s %11s %9s\n", "filter", "pointer", "callable", "row", "parallel", "par. row",
+        "speedup");
+
+    int result = 0;
+    result |= Run<0>("invert", runs, input, pool);
+    result |= Run<1>("plasma", runs, input, pool);
+    result |= Run<2>("blur", runs, input, pool);
+    return result;
+}
@@ -0,0 +1,195 @@
+// Feeds Ice2D::InputQueue and Ice2D::InputState scripted events and checks the state each frame sees.
+//
+//   InputCheck
+//
+// Events are pushed the way the window procedure does, with made up message times, and every Update() is a frame.
+// The cases cover taps that start and end between two frames, auto-repeat, merging of mouse moves and wheel steps,
+// growing the ring while it has wrapped around, and focus loss with keys and buttons held. No window is involved.
+// The tool prints one line per case and exits with 1 when a check fails.
+#include "pch.h"
+
+#include "InputQueue.h"
+#include <cstdio>
+
+using namespace Ice2D;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+static const uint8_t KEY_SPACE = 0x20u, KEY_A = 0x41u, KEY_SHIFT = 0x10u;
+
+static void Taps()
+{
+    printf("taps between two frames\n");
+    InputQueue queue;
+    InputState state;
+    queue.PushKey(KEY_SPACE, true, false, 10u);
+    queue.PushKey(KEY_SPACE, false, false, 12u);
+    queue.PushButton(InputQueue::Left, true, 5, 6, 13u);
+    queue.PushButton(InputQueue::Left, false, 5, 6, 14u);
+    state.Update(queue);
+    Expect(state.WasKeyPressed(KEY_SPACE) && state.WasKeyReleased(KEY_SPACE), "the tap is both pressed and released");
+    Expect(!state.IsKeyDown(KEY_SPACE), "and the key is up again");
+    Expect(state.WasButtonPressed(InputQueue::Left) && state.WasButtonReleased(InputQueue::Left) &&
+        !state.IsButtonDown(InputQueue::Left), "a click between frames shows up the same way");
+    Expect(state.GetEvents().size() == 4u && state.GetEvents()[0].time == 10u && state.GetEvents()[3].time == 14u,
+        "the frame's events are kept in order with their times");
+    uint8_t keys[4] = {};
+    Expect(state.AnyKeyPressed() && state.GetPressedKeys(keys, 4u) == 1u && keys[0] == KEY_SPACE,
+        "GetPressedKeys() lists the tapped key");
+
+    state.Update(queue);
+    Expect(!state.WasKeyPressed(KEY_SPACE) && !state.WasKeyReleased(KEY_SPACE) && !state.AnyKeyPressed(),
+        "the next frame has no edges");
+    Expect(state.GetEvents().empty(), "and no events");
+
+    // Keys in every word of the bit set
+    const uint8_t spread[4] = { 0u, 63u, 64u, 255u };
+    for (uint8_t key : spread) queue.PushKey(key, true, false, 20u);
+    state.Update(queue);
+    Expect(state.GetPressedKeys(keys, 4u) == 4u && keys[0] == 0u && keys[1] == 63u && keys[2] == 64u &&
+        keys[3] == 255u, "keys 0, 63, 64 and 255 are listed in order");
+    Expect(state.GetPressedKeys(keys, 2u) == 2u, "and no more than asked for");
+    Expect(!state.IsKeyDown(1u) && !state.IsKeyDown(128u), "the keys next to them stay up");
+}
+
+static void Repeats()
+{
+    printf("auto-repeat\n");
+    InputQueue queue;
+    InputState state;
+    queue.PushKey(KEY_A, true, false, 1u);
+    queue.PushKey(KEY_A, true, true, 2u);
+    queue.PushKey(KEY_A, true, true, 3u);
+    state.Update(queue);
+    Expect(state.WasKeyPressed(KEY_A) && state.WasKeyRepeated(KEY_A), "the first frame has the press and a repeat");
+    queue.PushKey(KEY_A, true, true, 4u);
+    state.Update(queue);
+    Expect(!state.WasKeyPressed(KEY_A) && state.WasKeyRepeated(KEY_A) && state.IsKeyDown(KEY_A),
+        "a frame with only repeats isn't a new press");
+    state.Update(queue);
+    Expect(!state.WasKeyRepeated(KEY_A) && state.IsKeyDown(KEY_A), "a frame without events keeps the key down");
+
+    // The key went down while another window had focus
+    queue.PushKey(KEY_SHIFT, true, true, 5u);
+    queue.PushKey(KEY_SPACE, false, false, 6u);
+    state.Update(queue);
+    Expect(state.WasKeyPressed(KEY_SHIFT) && !state.WasKeyRepeated(KEY_SHIFT), "a repeat of an unseen key is a press");
+    Expect(!state.WasKeyReleased(KEY_SPACE), "a key up of a key that isn't down is ignored");
+}
+
+static void Merging()
+{
+    printf("mouse move and wheel merging\n");
+    InputQueue queue;
+    InputState state;
+    for (int i = 1; i <= 100; ++i) queue.PushMove(i, 2 * i, (uint32_t)i);
+    Expect(queue.Size() == 1u && queue.GetStats().coalesced == 99ull, "100 moves in a row are one event");
+    state.Update(queue);
+    Expect(state.GetMouseX() == 100 && state.GetMouseY() == 200, "with the last position");
+    Expect(state.GetMouseDeltaX() == 100 && state.GetMouseDeltaY() == 200, "and the whole motion as the delta");
+    Expect(state.GetEvents().size() == 1u && state.GetEvents()[0].time == 100u, "and the last time");
+
+    queue.PushMove(110, 200, 101u);
+    queue.PushButton(InputQueue::Right, true, 120, 200, 102u);
+    queue.PushMove(130, 190, 103u);
+    queue.PushMove(140, 180, 104u);
+    Expect(queue.Size() == 3u, "moves don't merge across a click");
+    state.Update(queue);
+    Expect(state.GetMouseDeltaX() == 40 && state.GetMouseDeltaY() == -20, "the click's position is part of the delta");
+    Expect(state.IsButtonDown(InputQueue::Right), "the button is down");
+
+    queue.PushWheel(120, false, 110u);
+    queue.PushWheel(120, false, 111u);
+    queue.PushWheel(-60, false, 112u);
+    queue.PushWheel(240, true, 113u);
+    Expect(queue.Size() == 2u, "vertical steps add up, horizontal ones are kept apart");
+    state.Update(queue);
+    Expect(state.GetWheel() == 1.5f && state.GetWheelX() == 2.0f, "the wheel is counted in notches");
+
+    // Steps that would overflow the 16-bit delta start a new event
+    queue.PushWheel(30000, false, 120u);
+    queue.PushWheel(30000, false, 121u);
+    Expect(queue.Size() == 2u, "an overflowing sum isn't merged");
+    state.Update(queue);
+    Expect(state.GetWheel() == 60000 / 120.0f, "and nothing is lost");
+
+    queue.PushMove(40000, -40000, 130u);
+    state.Update(queue);
+    Expect(state.GetMouseX() == 32767 && state.GetMouseY() == -32768, "positions are clamped to 16 bits");
+}
+
+static void Growth()
+{
+    printf("ring growth\n");
+    InputQueue queue(4u);
+    Expect(queue.GetCapacity() == 16u, "the ring starts at 16 events");
+
+    // Wrap the ring around before it has to grow, so the copy has to unwrap it
+    InputQueue::Event e;
+    for (uint32_t i = 0u; i < 10u; ++i) queue.PushKey(KEY_A, i % 2u == 0u, false, i);
+    for (int i = 0; i < 10; ++i) queue.Pop(e);
+    uint32_t time = 100u;
+    for (; time < 1100u; ++time) queue.PushKey((uint8_t)time, true, false, time);
+    Expect(queue.Size() == 1000u && queue.GetCapacity() == 1024u, "1000 key events grow the ring to 1024");
+    Expect(queue.GetStats().grown == 6ull, "in six doublings");
+    bool order = true;
+    for (uint32_t expected = 100u; queue.Pop(e); ++expected) order &= e.time == expected && e.code == (uint8_t)expected;
+    Expect(order, "no event was lost or reordered");
+    Expect(queue.Size() == 0u && !queue.Pop(e), "the ring is empty afterwards");
+
+    queue.PushKey(KEY_A, true, false, time);
+    queue.Clear();
+    Expect(queue.Size() == 0u && queue.GetCapacity() == 1024u, "Clear() drops the events but keeps the ring");
+}
+
+static void Focus()
+{
+    printf("focus loss\n");
+    InputQueue queue;
+    InputState state;
+    queue.PushKey(KEY_SHIFT, true, false, 1u);
+    queue.PushKey(200u, true, false, 2u);
+    queue.PushButton(InputQueue::Middle, true, 0, 0, 3u);
+    state.Update(queue);
+    queue.PushFocusLost(4u);
+    state.Update(queue);
+    Expect(!state.IsKeyDown(KEY_SHIFT) && !state.IsKeyDown(200u) && !state.IsButtonDown(InputQueue::Middle),
+        "everything held is up");
+    Expect(state.WasKeyReleased(KEY_SHIFT) && state.WasKeyReleased(200u) && state.WasButtonReleased(InputQueue::Middle),
+        "and reported as released");
+    Expect(!state.WasKeyReleased(KEY_A), "keys that weren't held aren't released");
+
+    queue.PushKey(KEY_SHIFT, false, false, 5u);
+    state.Update(queue);
+    Expect(!state.WasKeyReleased(KEY_SHIFT), "the late key up after regaining focus is ignored");
+
+    // With a fixed timestep, the first tick of a frame sees the edges and ClearEdges() hides them from the rest
+    queue.PushKey(KEY_A, true, false, 6u);
+    queue.PushMove(10, 10, 7u);
+    state.Update(queue);
+    state.ClearEdges();
+    Expect(!state.WasKeyPressed(KEY_A) && state.IsKeyDown(KEY_A), "ClearEdges() keeps the key down");
+    Expect(state.GetMouseDeltaX() == 0 && state.GetMouseX() == 10, "and the position, without the delta");
+    state.Reset();
+    Expect(!state.IsKeyDown(KEY_A) && !state.WasKeyReleased(KEY_A) && state.GetEvents().empty(),
+        "Reset() forgets everything without edges");
+}
+
+int main()
+{
+    Taps();
+    Repeats();
+    Merging();
+    Growth();
+    Focus();
+    if (failures) printf("%d checks FAILED\n", failures);
+    else printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
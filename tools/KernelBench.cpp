@@ -0,0 +1,236 @@
+// Times Ice2D::PixelKernels at every instruction set level against a per-pixel loop like RawImage::ForEach().
+//
+//   KernelBench [--width n] [--height n] [--runs n]
+//
+// The buffer is 1920x1080 by default and filled with premultiplied pixels: runs of opaque, empty and translucent
+// pixels, so the unpremultiply shortcuts see what real images give them. The per-pixel column calls a function
+// pointer for every pixel, which is what ForEach() did before the kernels. Every level supported by the CPU is
+// timed (best of n runs) and its output is compared with a straightforward per-pixel reference, bit for bit. The
+// tool exits with 1 when a level gives a different result.
+#include "pch.h"
+
+#include "PixelKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Ice2D;
+
+struct Random
+{
+    uint32_t seed;
+    uint32_t Next()
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    }
+};
+
+// The reference rounds x / 255 to nearest, which is what the kernels' shift trick computes
+static inline uint32_t Div255(uint32_t x)
+{
+    return (2u * x + 255u) / 510u;
+}
+
+// State for the per-pixel functions, which only get the pixel like a ForEach() callback
+static uint32_t tintColor = 0xC080FF40u;
+static const uint32_t* pBlendSource = nullptr;
+static unsigned int blendWidth = 0u;
+static const unsigned char swizzleOrder[4] = { 2u, 1u, 0u, 3u };
+
+static void FillPixel(unsigned int, unsigned int, uint32_t& c)
+{
+    c = 0xFF336699u;
+}
+
+static void PremultiplyPixel(unsigned int, unsigned int, uint32_t& c)
+{
+    uint32_t a = c >> 24;
+    c = (a << 24) | (Div255(((c >> 16) & 0xFFu) * a) << 16) | (Div255(((c >> 8) & 0xFFu) * a) << 8) |
+        Div255((c & 0xFFu) * a);
+}
+
+static void UnpremultiplyPixel(unsigned int, unsigned int, uint32_t& c)
+{
+    uint32_t a = c >> 24;
+    if (a == 0u) return;
+    uint32_t out = a << 24;
+    for (unsigned int shift = 0u; shift < 24u; shift += 8u)
+    {
+        out |= std::min((((c >> shift) & 0xFFu) * 255u + a / 2u) / a, 255u) << shift;
+    }
+    c = out;
+}
+
+static void BlendPixel(unsigned int x, unsigned int y, uint32_t& c)
+{
+    uint32_t src = pBlendSource[(size_t)y * blendWidth + x], inv = 255u - (src >> 24), out = 0u;
+    for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+    {
+        out |= std::min(((src >> shift) & 0xFFu) + Div255(((c >> shift) & 0xFFu) * inv), 255u) << shift;
+    }
+    c = out;
+}
+
+static void TintPixel(unsigned int, unsigned int, uint32_t& c)
+{
+    uint32_t out = 0u;
+    for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+    {
+        out |= Div255(((c >> shift) & 0xFFu) * ((tintColor >> shift) & 0xFFu)) << shift;
+    }
+    c = out;
+}
+
+static void GrayscalePixel(unsigned int, unsigned int, uint32_t& c)
+{
+    uint32_t y = (((c >> 16) & 0xFFu) * 77u + ((c >> 8) & 0xFFu) * 150u + (c & 0xFFu) * 29u + 128u) >> 8;
+    c = (c & 0xFF000000u) | (y << 16) | (y << 8) | y;
+}
+
+static void SwizzlePixel(unsigned int, unsigned int, uint32_t& c)
+{
+    uint32_t out = 0u;
+    for (unsigned int i = 0u; i < 4u; ++i) out |= ((c >> (swizzleOrder[i] * 8u)) & 0xFFu) << (i * 8u);
+    c = out;
+}
+
+struct Kernel
+{
+    const char* name;
+    void (*perPixel)(unsigned int x, unsigned int y, uint32_t& c);
+    void (*bulk)(uint32_t* p, size_t stride, unsigned int width, unsigned int height);
+    bool premultipliedInput;
+};
+
+static const uint32_t* pCopySource = nullptr;
+
+static const Kernel kernels[] =
+{
+    { "fill", FillPixel, [](uint32_t* p, size_t stride, unsigned int w, unsigned int h) {
+        PixelKernels::Fill(p, stride, w, h, 0xFF336699u); }, true },
+    { "copy", [](unsigned int x, unsigned int y, uint32_t& c) { c = pCopySource[(size_t)y * blendWidth + x]; },
+        [](uint32_t* p, size_t stride, unsigned int w, unsigned int h) {
+        PixelKernels::CopyRect(p, stride, pCopySource, blendWidth * 4u, w, h); }, true },
+    { "premul", PremultiplyPixel, [](uint32_t* p, size_t stride, unsigned int w, unsigned int h) {
+        PixelKernels::Premultiply(p, stride, w, h); }, false },
+    { "unpremul", UnpremultiplyPixel, [](uint32_t* p, size_t stride, unsigned int w, unsigned int h) {
+        PixelKernels::Unpremultiply(p, stride, w, h); }, true },
+    { "blend", BlendPixel, [](uint32_t* p, size_t stride, unsigned int w, unsigned int h) {
+        PixelKernels::Blend(p, stride, pBlendSource, blendWidth * 4u, w, h); }, true },
+    { "tint", TintPixel, [](uint32_t* p, size_t stride, unsigned int w, unsigned int h) {
+        PixelKernels::Tint(p, stride, w, h, tintColor); }, true },
+    { "grayscale", GrayscalePixel, [](uint32_t* p, size_t stride, unsigned int w, unsigned int h) {
+        PixelKernels::Grayscale(p, stride, w, h); }, true },
+    { "swizzle", SwizzlePixel, [](uint32_t* p, size_t stride, unsigned int w, unsigned int h) {
+        PixelKernels::Swizzle(p, stride, w, h, swizzleOrder); }, true }
+};
+
+// Like ForEach(): the callback goes through a pointer the compiler can't see through, so it isn't inlined
+static void ForEachPixel(uint32_t* p, unsigned int width, unsigned int height,
+    void (* volatile process)(unsigned int x, unsigned int y, uint32_t& c))
+{
+    for (unsigned int y = 0u; y < height; ++y)
+    {
+        uint32_t* row = p + (size_t)y * width;
+        for (unsigned int x = 0u; x < width; ++x) process(x, y, row[x]);
+    }
+}
+
+static void MakePixels(std::vector<uint32_t>& pixels, uint32_t seed, bool premultiplied)
+{
+    // Runs of 16 pixels that are opaque, empty or translucent, colors never above alpha when premultiplied
+    Random random = { seed };
+    for (size_t i = 0u; i < pixels.size(); i += 16u)
+    {
+        uint32_t kind = random.Next() % 4u;
+        for (size_t j = i; j < std::min(i + 16u, pixels.size()); ++j)
+        {
+            uint32_t a = kind == 0u ? 255u : kind == 1u ? 0u : random.Next() % 256u;
+            uint32_t c = a << 24;
+            for (unsigned int shift = 0u; shift < 24u; shift += 8u)
+            {
+                uint32_t limit = premultiplied ? a : 255u;
+                c |= (limit ? random.Next() % (limit + 1u) : 0u) << shift;
+            }
+            pixels[j] = c;
+        }
+    }
+}
+
+template<typename F>
+static double Best(unsigned int runs, std::vector<uint32_t>& work, const std::vector<uint32_t>& input, F&& body)
+{
+    double best = 1e30;
+    for (unsigned int run = 0u; run < runs; ++run)
+    {
+        work = input;
+        auto start = std::chrono::steady_clock::now();
+        body();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int width = 1920u, height = 1080u, runs = 5u;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--width") == 0) width = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--height") == 0) height = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--runs") == 0) runs = (unsigned int)atoi(argv[i + 1]);
+    }
+    if (width == 0u) width = 1u;
+    if (height == 0u) height = 1u;
+    if (runs == 0u) runs = 1u;
+
+    const size_t count = (size_t)width * height;
+    std::vector<uint32_t> premultiplied(count), straight(count), source(count), work(count), expected(count);
+    MakePixels(premultiplied, 1u, true);
+    MakePixels(straight, 2u, false);
+    MakePixels(source, 3u, true);
+    pBlendSource = pCopySource = source.data();
+    blendWidth = width;
+
+    const PixelKernels::Level supported = PixelKernels::GetSupportedLevel();
+    std::vector<PixelKernels::Level> levels = { PixelKernels::Level::Scalar };
+    if (supported >= PixelKernels::Level::SSE2) levels.push_back(PixelKernels::Level::SSE2);
+    if (supported >= PixelKernels::Level::AVX2) levels.push_back(PixelKernels::Level::AVX2);
+
+    printf("%ux%u, best of %u runs, CPU supports %s\n", width, height, runs, PixelKernels::GetLevelName(supported));
+    printf("%-10s %10s", "kernel", "per-pixel");
+    for (PixelKernels::Level level : levels) printf(" %10s", PixelKernels::GetLevelName(level));
+    printf(" %9s\n", "speedup");
+
+    int result = 0;
+    for (const Kernel& kernel : kernels)
+    {
+        const std::vector<uint32_t>& input = kernel.premultipliedInput ? premultiplied : straight;
+        double perPixel = Best(runs, work, input, [&] { ForEachPixel(work.data(), width, height, kernel.perPixel); });
+        expected = work;
+        printf("%-10s %8.2fms", kernel.name, perPixel * 1e3);
+
+        double fastest = perPixel;
+        std::vector<const char*> mismatched;
+        for (PixelKernels::Level level : levels)
+        {
+            PixelKernels::SetLevel(level);
+            double seconds = Best(runs, work, input, [&] { kernel.bulk(work.data(), width * 4u, width, height); });
+            printf(" %8.2fms", seconds * 1e3);
+            fastest = std::min(fastest, seconds);
+            if (work != expected) mismatched.push_back(PixelKernels::GetLevelName(level));
+        }
+        printf(" %8.1fx\n", perPixel / fastest);
+        for (const char* name : mismatched)
+        {
+            printf("  %s: %s doesn't match the per-pixel result\n", kernel.name, name);
+            result = 1;
+        }
+    }
+    PixelKernels::SetLevel(supported);
+    return result;
+}
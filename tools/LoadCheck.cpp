@@ -0,0 +1,195 @@
+// Runs jobs through Ice2D::LoadQueue without workers and with them, and checks statuses, progress and budgets.
+//
+//   LoadCheck
+//
+// With 0 threads the queue runs every job inside Pump(), so most cases are exact: jobs finish in order, a zero
+// budget finishes one job per Pump(), a budget stops the pump once it's used up, and progress, cancellation and
+// exceptions from either stage end up in the ticket. With workers, a job is cancelled after its worker stage, the
+// finish callbacks have to run on the pumping thread only, and Shutdown() cancels what is left. The tool prints one
+// line per case and exits with 1 when a check fails.
+#include "pch.h"
+
+#include "LoadQueue.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace Ice2D;
+
+typedef LoadTicket::Status Status;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+static void Spin(std::chrono::microseconds duration)
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+static void Order()
+{
+    printf("jobs without workers\n");
+    LoadQueue queue(0u);
+    std::vector<int> done;
+    std::vector<LoadHandle> tickets;
+    for (int i = 0; i < 5; ++i) tickets.push_back(queue.Enqueue(nullptr, [&done, i] { done.push_back(i); }));
+    Expect(tickets[0]->GetStatus() == Status::Queued && queue.GetPendingCount() == 5u, "nothing runs before Pump()");
+    Expect(queue.Pump() == 5u && queue.GetPendingCount() == 0u, "Pump() without a budget runs everything");
+    Expect(done == std::vector<int>({ 0, 1, 2, 3, 4 }), "in the order they were queued");
+    bool completed = true;
+    for (const LoadHandle& ticket : tickets) completed &= ticket->GetStatus() == Status::Completed && ticket->IsDone();
+    Expect(completed, "and every ticket is completed");
+    Expect(queue.Pump() == 0u, "an empty queue pumps nothing");
+}
+
+static void Budget()
+{
+    printf("pump budget\n");
+    LoadQueue queue(0u);
+    unsigned int finished = 0u;
+    for (int i = 0; i < 10; ++i)
+    {
+        queue.Enqueue(nullptr, [&finished] { Spin(std::chrono::microseconds(2000)); ++finished; });
+    }
+    Expect(queue.Pump(std::chrono::microseconds(0)) == 1u, "a zero budget still finishes one job");
+
+    // 2 ms per job on a 5 ms budget stops after the third, a slow machine can only finish fewer
+    unsigned int pumped = queue.Pump(std::chrono::microseconds(5000));
+    Expect(pumped >= 1u && pumped <= 3u, "a 5 ms budget finishes at most three 2 ms jobs");
+    Expect(queue.GetPendingCount() == 9u - pumped, "the rest stays queued");
+    Expect(queue.Pump() == 9u - pumped && finished == 10u, "and a later Pump() finishes it");
+}
+
+static void Progress()
+{
+    printf("progress\n");
+    LoadQueue queue(0u);
+    std::vector<float> seen;
+    LoadHandle ticket = queue.Enqueue([&seen](LoadTicket& t)
+    {
+        seen.push_back(t.GetProgress());
+        t.SetProgress(0.25f);
+        seen.push_back(t.GetProgress());
+        seen.push_back((float)(t.GetStatus() == Status::Loading));
+        t.SetProgress(2.0f);
+        seen.push_back(t.GetProgress());
+        t.SetProgress(-1.0f);
+        seen.push_back(t.GetProgress());
+        t.SetProgress(0.5f);
+    }, [&seen, &ticket]
+    {
+        seen.push_back(ticket->GetProgress());
+        seen.push_back((float)(ticket->GetStatus() == Status::Staged));
+    });
+    queue.Pump();
+    Expect(seen == std::vector<float>({ 0.0f, 0.25f, 1.0f, 1.0f, 0.0f, 0.5f, 1.0f }),
+        "progress starts at 0, is clamped to [0, 1], and the status is Loading, then Staged");
+    Expect(ticket->GetProgress() == 1.0f && ticket->GetStatus() == Status::Completed, "a finished job is at 1");
+}
+
+static void Cancelling()
+{
+    printf("cancelling\n");
+    LoadQueue queue(0u);
+    bool worked = false, finished = false;
+    LoadHandle before = queue.Enqueue([&worked](LoadTicket&) { worked = true; }, [&finished] { finished = true; });
+    before->Cancel();
+    Expect(queue.Pump() == 0u && !worked && !finished, "a job cancelled while queued never runs");
+    Expect(before->GetStatus() == Status::Cancelled && before->IsDone(), "and ends up cancelled");
+
+    // Cancel() from another thread lands while the work runs
+    LoadHandle during = queue.Enqueue([](LoadTicket& t) { t.Cancel(); }, [&finished] { finished = true; });
+    Expect(queue.Pump() == 0u && !finished && during->GetStatus() == Status::Cancelled,
+        "a job cancelled during its work is never finished");
+
+    queue.Enqueue(nullptr, [&finished] { finished = true; });
+    queue.Enqueue(nullptr, [&finished] { finished = true; });
+    queue.CancelAll();
+    Expect(queue.Pump() == 0u && !finished && queue.GetPendingCount() == 0u, "CancelAll() cancels everything queued");
+
+    // With a worker, the job can be cancelled after its work but before it's finished
+    LoadQueue threaded(1u);
+    LoadHandle staged = threaded.Enqueue([&worked](LoadTicket&) { worked = true; }, [&finished] { finished = true; });
+    while (staged->GetStatus() != Status::Staged) std::this_thread::yield();
+    staged->Cancel();
+    Expect(threaded.Pump() == 0u && worked && !finished, "a staged job cancelled before Pump() isn't finished");
+    Expect(staged->GetStatus() == Status::Cancelled, "and ends up cancelled");
+}
+
+static void Errors()
+{
+    printf("exceptions\n");
+    LoadQueue queue(0u);
+    bool finished = false;
+    LoadHandle work = queue.Enqueue([](LoadTicket&) { throw std::runtime_error("Could not decode file."); },
+        [&finished] { finished = true; });
+    LoadHandle unknown = queue.Enqueue([](LoadTicket&) { throw 42; }, nullptr);
+    LoadHandle finish = queue.Enqueue(nullptr, [] { throw std::runtime_error("Could not create bitmap."); });
+    LoadHandle fine = queue.Enqueue(nullptr, nullptr);
+    Expect(queue.Pump() == 1u, "only the job that didn't throw counts as finished");
+    Expect(work->GetStatus() == Status::Failed && work->GetError() == "Could not decode file." && !finished,
+        "an exception in the work fails the ticket with its message and skips the finish");
+    Expect(unknown->GetStatus() == Status::Failed && unknown->GetError() == "Unknown error.",
+        "anything else thrown is an unknown error");
+    Expect(finish->GetStatus() == Status::Failed && finish->GetError() == "Could not create bitmap.",
+        "an exception in the finish fails the ticket too");
+    Expect(fine->GetStatus() == Status::Completed && fine->GetError().empty(), "and doesn't affect the next job");
+}
+
+static void Workers()
+{
+    printf("jobs on 4 workers\n");
+    LoadQueue queue(4u);
+    unsigned int started = 0u, exited = 0u;
+    std::mutex hookMutex;
+    queue.SetThreadHooks([&] { std::lock_guard<std::mutex> lock(hookMutex); ++started; },
+        [&] { std::lock_guard<std::mutex> lock(hookMutex); ++exited; });
+    const std::thread::id main = std::this_thread::get_id();
+    unsigned int finished = 0u;
+    bool mainOnly = true;
+    std::vector<LoadHandle> tickets;
+    for (int i = 0; i < 1000; ++i)
+    {
+        tickets.push_back(queue.Enqueue([](LoadTicket& t) { Spin(std::chrono::microseconds(20)); t.SetProgress(0.5f); },
+            [&] { mainOnly &= std::this_thread::get_id() == main; ++finished; }));
+    }
+    unsigned int pumped = 0u;
+    while (pumped < 1000u) pumped += queue.Pump(std::chrono::microseconds(2000));
+    Expect(finished == 1000u && mainOnly, "every finish runs once, on the pumping thread");
+
+    for (int i = 0; i < 100; ++i)
+    {
+        tickets.push_back(queue.Enqueue([](LoadTicket&) { Spin(std::chrono::microseconds(100)); }, nullptr));
+    }
+    queue.Shutdown();
+    bool done = true;
+    for (const LoadHandle& ticket : tickets) done &= ticket->IsDone();
+    Expect(done, "Shutdown() leaves nothing queued or loading");
+    Expect(queue.GetPendingCount() == 0u, "and drops what was staged");
+    Expect(started == 4u && exited == 4u, "the thread hooks ran once per worker");
+}
+
+int main()
+{
+    Order();
+    Budget();
+    Progress();
+    Cancelling();
+    Errors();
+    Workers();
+    if (failures) printf("%d checks FAILED\n", failures);
+    else printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+// Mixes many voices through Ice2D::Mixer without a sound card, reports the cost per block and checks the mix.
+//
+//   MixBench [voices] [seconds] [output.wav]
+//
+// Voices loop over generated clips: mono 16-bit at 44.1 kHz, so every voice is resampled, and stereo float at
+// 48 kHz, which takes the direct path. Each voice gets its own gain, pan and pitch. With an output path the mix
+// is also written as a 16-bit WAV file, which is deterministic and can be compared against a known good one.
+// Before the timing, a few short mixes with a fixed number of voices are checked against the golden checksums
+// below: FNV-1a hashes of the 16-bit samples a WAV output would get from a known good build. One only resamples,
+// one only takes the direct path, and one changes gain, pan and pitch and stops voices between blocks. Like
+// RasterBench, they hold for builds that don't contract float math into FMA instructions. The tool exits with 1
+// when a checksum doesn't match.
+#include "pch.h"
+
+#include "Mixer.h"
+#include "MixerOutput.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace Ice2D;
+
+// Hashes the mix as the 16-bit samples WavFileOutput writes, in file byte order
+class ChecksumOutput : public MixerOutput
+{
+public:
+    ChecksumOutput() : m_hash(14695981039346656037ull)
+    {
+    }
+
+    void Write(const float* pSamples, uint32_t frameCount, uint16_t channels, uint32_t) override
+    {
+        for (size_t i = 0u; i < (size_t)frameCount * channels; ++i)
+        {
+            float value = pSamples[i] < -1.0f ? -1.0f : pSamples[i] > 1.0f ? 1.0f : pSamples[i];
+            uint32_t sample = (uint32_t)(int32_t)std::lrintf(value * 32767.0f);
+            m_hash = (m_hash ^ (sample & 0xFFu)) * 1099511628211ull;
+            m_hash = (m_hash ^ ((sample >> 8) & 0xFFu)) * 1099511628211ull;
+        }
+    }
+
+    uint64_t GetHash() const
+    {
+        return m_hash;
+    }
+
+private:
+    uint64_t m_hash;
+};
+
+struct Check
+{
+    const char* name;
+    unsigned int voices, firstClip, clipStep;
+    bool commands;
+    uint64_t golden;
+};
+
+// Two seconds of a fixed mix, with voice changes every few blocks when asked for
+static uint64_t RenderCheck(const Check& check, const Mixer::Clip* clips)
+{
+    ChecksumOutput output;
+    Mixer mixer(&output, 48000u, 512u, check.voices, 256u);
+    std::vector<uint32_t> ids;
+    for (unsigned int i = 0u; i < check.voices; ++i)
+    {
+        const unsigned int clip = (check.firstClip + i * check.clipStep) % 2u;
+        ids.push_back(mixer.Play(clips[clip], 0.5f / check.voices + 0.01f * (i % 5u),
+            (float)(i % 9u) / 4.0f - 1.0f, clip ? 1.0f : 0.5f + (float)(i % 7u) * 0.125f, true));
+    }
+    for (unsigned int block = 0u; block < 188u; ++block)
+    {
+        if (check.commands && block % 10u == 5u)
+        {
+            const unsigned int i = block / 10u % check.voices;
+            mixer.SetGain(ids[i], 0.05f * (float)(block % 7u));
+            mixer.SetPan(ids[(i + 3u) % check.voices], (float)(block % 5u) * 0.5f - 1.0f);
+            mixer.SetPitch(ids[(i + 5u) % check.voices], 0.8f + (float)(block % 3u) * 0.3f);
+            if (block % 40u == 25u) mixer.Stop(ids[(i + 7u) % check.voices]);
+        }
+        mixer.Render(1u);
+    }
+    return output.GetHash();
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned int voices = argc > 1 ? (unsigned int)atoi(argv[1]) : 256u;
+    const double seconds = argc > 2 ? atof(argv[2]) : 10.0;
+    const char* outputPath = argc > 3 ? argv[3] : nullptr;
+
+    try
+    {
+        std::vector<int16_t> mono(44100u);
+        for (size_t i = 0u; i < mono.size(); ++i)
+        {
+            mono[i] = (int16_t)(8000.0 * std::sin(i * 2.0 * 3.14159265358979 * 440.0 / 44100.0));
+        }
+        std::vector<float> stereo(48000u * 2u);
+        uint32_t seed = 1u;
+        for (float& sample : stereo)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            sample = ((seed >> 9) * (1.0f / 8388608.0f) - 1.0f) * 0.1f;
+        }
+        const Mixer::Clip clips[2] =
+        {
+            { mono.data(), (uint32_t)mono.size(), 44100u, 1u, 16u, false },
+            { stereo.data(), (uint32_t)(stereo.size() / 2u), 48000u, 2u, 32u, true }
+        };
+
+        const Check checks[] =
+        {
+            { "resampled", 16u, 0u, 2u, false, 0x7c3f9d34da4d19c3ull },
+            { "direct", 16u, 1u, 2u, false, 0xefa012d522f0eeabull },
+            { "commands", 32u, 0u, 1u, true, 0x87784cee7b14b576ull }
+        };
+        int result = 0;
+        for (const Check& check : checks)
+        {
+            uint64_t checksum = RenderCheck(check, clips);
+            printf("%s: checksum %016llx, %s\n", check.name, (unsigned long long)checksum,
+                checksum == check.golden ? "ok" : "FAILED, doesn't match the golden mix");
+            if (checksum != check.golden) result = 1;
+        }
+
+        NullOutput null;
+        std::unique_ptr<WavFileOutput> pFile;
+        if (outputPath) pFile.reset(new WavFileOutput(outputPath));
+        MixerOutput* pOutput = pFile ? static_cast<MixerOutput*>(pFile.get()) : &null;
+
+        Mixer mixer(pOutput, 48000u, 512u, voices, voices + 16u);
+        for (unsigned int i = 0u; i < voices; ++i)
+        {
+            float pan = (float)(i % 17u) / 8.0f - 1.0f;
+            float pitch = 0.75f + (float)(i % 11u) * 0.05f;
+            mixer.Play(clips[i % 2u], 1.0f / voices, pan, i % 2u ? 1.0f : pitch, true);
+        }
+
+        const unsigned int blocks = (unsigned int)(seconds * mixer.GetSampleRate() / mixer.GetBlockFrames());
+        mixer.Render(blocks);
+        if (pFile) pFile->Close();
+
+        Mixer::Stats stats = mixer.GetStats();
+        const double audioSeconds = (double)stats.frames / mixer.GetSampleRate();
+        printf("%u voices, %llu blocks of %u frames\n", voices, stats.blocks, mixer.GetBlockFrames());
+        printf("mix time %.3f s for %.3f s of audio, %.1fx real time\n", stats.mixSeconds, audioSeconds,
+            audioSeconds / stats.mixSeconds);
+        printf("%.2f us per block, %.1f ns per voice block\n", stats.mixSeconds * 1e6 / stats.blocks,
+            stats.mixSeconds * 1e9 / (stats.voicesMixed ? stats.voicesMixed : 1u));
+        if (!pFile) printf("peak %.3f\n", null.GetPeak());
+        return result;
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
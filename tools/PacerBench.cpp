@@ -0,0 +1,247 @@
+// Drives Ice2D::FramePacer with simulated clocks that oversleep and reports the frame time error.
+//
+//   PacerBench [--frames n] [--fps n] [--seed n]
+//
+// The clock is an Ice2D::IBasicClock that only moves when the pacer sleeps or spins, or when a frame does its work
+// (a random 10 to 50% of the frame). Each profile wakes up late the way a real timer does: a fine timer with tens
+// of microseconds of jitter, timers that only wake on 1 ms and 15.6 ms ticks, and a fine timer that is sometimes
+// preempted for a few milliseconds. For every profile the pacer is compared with a plain sleep for the remaining
+// time. The error is the time between two Wait() returns minus the frame time, reported as percentiles in
+// microseconds, along with the time spun per frame and the frames that fell more than half a frame behind. The runs
+// are deterministic for a given seed. The pacer has to stay within one spin of an exact clock. On every timer with
+// ticks shorter than a frame, it has to beat the plain sleep at the 99th percentile (the 90th when preemptions
+// dominate the tail) and, unless preempted, keep the average rate. Timers with longer ticks can't hold the rate
+// either way and are only reported. After a stall, the pacer has to resynchronize instead of bursting. The tool
+// exits with 1 when a check fails.
+#include "pch.h"
+
+#include "FramePacer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Ice2D;
+
+typedef std::chrono::high_resolution_clock::duration Duration;
+typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+static Duration Microseconds(double count)
+{
+    return std::chrono::duration_cast<Duration>(std::chrono::nanoseconds((long long)(count * 1000.0)));
+}
+
+static double ToMicroseconds(Duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+struct Random
+{
+    uint32_t seed;
+    double Next(double low, double high)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return low + (high - low) * ((seed >> 8) * (1.0 / 16777216.0));
+    }
+};
+
+struct Profile
+{
+    const char* name;
+    double tick, jitterLow, jitterHigh, spikeChance, spikeLow, spikeHigh;
+};
+
+// Wakes up on the next timer tick after the requested time, plus jitter and the odd preemption
+class SimulatedClock : public IBasicClock
+{
+public:
+    SimulatedClock(const Profile& profile, uint32_t seed) : m_profile(profile), m_random({ seed }), m_now(),
+        m_spun()
+    {
+    }
+
+    TimePoint Now() override
+    {
+        return m_now;
+    }
+
+    void Sleep(Duration duration) override
+    {
+        if (duration.count() <= 0) return;
+        double wake = ToMicroseconds((m_now + duration).time_since_epoch());
+        if (m_profile.tick > 0.0) wake = std::ceil(wake / m_profile.tick) * m_profile.tick;
+        wake += m_random.Next(m_profile.jitterLow, m_profile.jitterHigh);
+        if (m_random.Next(0.0, 1.0) < m_profile.spikeChance) wake += m_random.Next(m_profile.spikeLow, m_profile.spikeHigh);
+        m_now = TimePoint(Microseconds(wake));
+    }
+
+    void Spin() override
+    {
+        m_now += Microseconds(1.0);
+        m_spun += Microseconds(1.0);
+    }
+
+    void Advance(Duration duration)
+    {
+        m_now += duration;
+    }
+
+    double Work(double frameTime)
+    {
+        return m_random.Next(0.1 * frameTime, 0.5 * frameTime);
+    }
+
+    Duration GetSpun() const
+    {
+        return m_spun;
+    }
+
+private:
+    Profile m_profile;
+    Random m_random;
+    TimePoint m_now;
+    Duration m_spun;
+};
+
+struct Result
+{
+    std::vector<double> errors;
+    double spunPerFrame, averageFrame;
+    unsigned int behind;
+    double Percentile(double p) const
+    {
+        std::vector<double> sorted = errors;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[std::min(sorted.size() - 1u, (size_t)(p * sorted.size()))];
+    }
+};
+
+// Runs frames of random work, paced either by FramePacer or by one plain sleep for what's left of the frame
+static Result Run(const Profile& profile, unsigned int frames, unsigned int fps, uint32_t seed, bool pacer)
+{
+    SimulatedClock clock(profile, seed);
+    FramePacer framePacer(&clock);
+    framePacer.SetTargetFPS(fps);
+    const Duration frameTime = Microseconds(1e6 / fps);
+
+    Result result = { {}, 0.0, 0.0, 0u };
+    result.errors.reserve(frames);
+    TimePoint last = clock.Now(), first = last, next = last + frameTime;
+    for (unsigned int i = 0u; i <= frames; ++i)
+    {
+        clock.Advance(Microseconds(clock.Work(ToMicroseconds(frameTime))));
+        if (pacer)
+        {
+            framePacer.Wait();
+        }
+        else
+        {
+            clock.Sleep(next - clock.Now());
+            next = std::max(next + frameTime, clock.Now());
+        }
+        TimePoint now = clock.Now();
+        if (i == 0u) first = now;
+        else
+        {
+            double error = ToMicroseconds(now - last - frameTime);
+            result.errors.push_back(std::fabs(error));
+            if (error > ToMicroseconds(frameTime) * 0.5) ++result.behind;
+        }
+        last = now;
+    }
+    result.spunPerFrame = ToMicroseconds(clock.GetSpun()) / frames;
+    result.averageFrame = ToMicroseconds(last - first) / frames;
+    return result;
+}
+
+static void Report(const char* name, const char* method, const Result& result)
+{
+    printf("%-14s %-7s %9.1f %9.1f %9.1f %9.1f %9.1f %7u\n", name, method, result.Percentile(0.5),
+        result.Percentile(0.9), result.Percentile(0.99), result.Percentile(1.0), result.spunPerFrame, result.behind);
+}
+
+static void Stall(unsigned int fps)
+{
+    // A 100 ms hitch must not be made up with a burst of short frames
+    const Profile exact = { "exact", 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    SimulatedClock clock(exact, 1u);
+    FramePacer pacer(&clock);
+    pacer.SetTargetFPS(fps);
+    const Duration frameTime = Microseconds(1e6 / fps);
+    for (int i = 0; i < 10; ++i) pacer.Wait();
+    clock.Advance(Microseconds(100000.0));
+    TimePoint before = clock.Now();
+    pacer.Wait();
+    Expect(clock.Now() == before, "Wait() after a stall returns right away");
+    Expect(ToMicroseconds(pacer.GetLastLateness()) > 100000.0 - ToMicroseconds(frameTime) - 1.0,
+        "and reports how late the frame was");
+    pacer.Wait();
+    Expect(std::fabs(ToMicroseconds(clock.Now() - before - frameTime)) <= 1.0,
+        "the next frame is a whole frame later, not a burst");
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int frames = 10000u, fps = 60u;
+    uint32_t seed = 1u;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--frames") == 0) frames = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--fps") == 0) fps = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+    }
+    if (frames == 0u) frames = 1u;
+    if (fps == 0u) fps = 60u;
+
+    // Tick and jitter in microseconds, spikes are preemptions of a few milliseconds
+    const Profile profiles[] =
+    {
+        { "exact", 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+        { "fine timer", 0.0, 20.0, 80.0, 0.0, 0.0, 0.0 },
+        { "1 ms ticks", 1000.0, 0.0, 150.0, 0.0, 0.0, 0.0 },
+        { "15.6 ms ticks", 15625.0, 0.0, 150.0, 0.0, 0.0, 0.0 },
+        { "preempted", 0.0, 20.0, 80.0, 0.02, 2000.0, 8000.0 }
+    };
+
+    printf("%u frames at %u fps, 10-50%% of each frame is work, errors in us\n", frames, fps);
+    printf("%-14s %-7s %9s %9s %9s %9s %9s %7s\n", "clock", "method", "p50", "p90", "p99", "max", "spun/fr",
+        "behind");
+    const double frameTime = ToMicroseconds(Microseconds(1e6 / fps));
+    for (const Profile& profile : profiles)
+    {
+        Result paced = Run(profile, frames, fps, seed, true);
+        Result slept = Run(profile, frames, fps, seed, false);
+        Report(profile.name, "pacer", paced);
+        Report(profile.name, "sleep", slept);
+
+        // The pacer ends on a spin, so it can be one spin late even when the clock is exact
+        if (profile.tick == 0.0 && profile.jitterHigh == 0.0)
+        {
+            Expect(paced.Percentile(1.0) <= 1.0, "an exact clock gives frames within one spin");
+            continue;
+        }
+        if (profile.tick >= frameTime) continue;
+        if (profile.spikeChance == 0.0)
+        {
+            Expect(std::fabs(paced.averageFrame - frameTime) < frameTime * 1e-3, "the average frame time holds");
+        }
+        const double tail = profile.spikeChance == 0.0 ? 0.99 : 0.9;
+        Expect(paced.Percentile(tail) < slept.Percentile(tail), "the pacer is more accurate than a plain sleep");
+    }
+    Stall(fps);
+
+    if (failures) printf("%d checks FAILED\n", failures);
+    return failures ? 1 : 0;
+}
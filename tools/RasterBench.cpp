@@ -0,0 +1,287 @@
+// Measures the fill rate of Ice2D::SoftwareCanvas and checks its output against golden images.
+//
+//   RasterBench [--frames n] [--write dir] [--compare dir]
+//
+// Every scene is drawn into a 1024x768 image on one thread and again on the shared thread pool. The two results
+// have to be identical. The timings are reported as frames per second and millions of covered pixels per second.
+// The images are checked against the golden checksums below, which are FNV-1a hashes of the pixels a known good
+// build saves to the TGA files. They hold for builds that don't contract float math into FMA instructions, which
+// is MSVC's default and g++'s unless -march enables FMA (then add -ffp-contract=off). --write saves each scene as
+// dir/<scene>.tga. --compare checks the scenes against such files instead of the checksums, and only fails if a
+// channel is off by more than 1. The tool exits with 1 when a check fails.
+#include "pch.h"
+
+#include "SoftwareCanvas.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Ice2D;
+
+static const unsigned int WIDTH = 1024u, HEIGHT = 768u;
+
+struct Random
+{
+    uint32_t seed;
+    float Next(float low, float high)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return low + (high - low) * ((seed >> 8) * (1.0f / 16777216.0f));
+    }
+    SoftwareCanvas::Color NextColor(float alpha)
+    {
+        return { Next(0.0f, 1.0f), Next(0.0f, 1.0f), Next(0.0f, 1.0f), alpha };
+    }
+};
+
+static std::vector<uint32_t> s_texture;
+
+static void Rects(SoftwareCanvas& canvas)
+{
+    Random random = { 1u };
+    for (int i = 0; i < 500; ++i)
+    {
+        float x = random.Next(-50.0f, (float)WIDTH), y = random.Next(-50.0f, (float)HEIGHT);
+        canvas.FillRect(x, y, x + random.Next(4.0f, 200.0f), y + random.Next(4.0f, 200.0f),
+            SoftwareCanvas::Paint::Solid(random.NextColor(i % 2 ? 1.0f : 0.6f)));
+    }
+}
+
+static void Ellipses(SoftwareCanvas& canvas)
+{
+    Random random = { 2u };
+    for (int i = 0; i < 300; ++i)
+    {
+        canvas.FillEllipse(random.Next(0.0f, (float)WIDTH), random.Next(0.0f, (float)HEIGHT),
+            random.Next(2.0f, 120.0f), random.Next(2.0f, 120.0f), SoftwareCanvas::Paint::Solid(random.NextColor(0.8f)));
+    }
+}
+
+static void Gradients(SoftwareCanvas& canvas)
+{
+    Random random = { 3u };
+    for (int i = 0; i < 100; ++i)
+    {
+        SoftwareCanvas::GradientStop stops[3] =
+        {
+            { 0.0f, random.NextColor(1.0f) }, { 0.5f, random.NextColor(0.5f) }, { 1.0f, random.NextColor(1.0f) }
+        };
+        float x = random.Next(0.0f, (float)WIDTH), y = random.Next(0.0f, (float)HEIGHT);
+        float rx = random.Next(20.0f, 200.0f), ry = random.Next(20.0f, 200.0f);
+        if (i % 2)
+        {
+            canvas.FillRoundedRect(x - rx, y - ry, x + rx, y + ry, 16.0f, 16.0f,
+                SoftwareCanvas::Paint::Linear(x - rx, y, x + rx, y + ry, stops, 3u));
+        }
+        else
+        {
+            canvas.FillEllipse(x, y, rx, ry, SoftwareCanvas::Paint::Radial(x, y, rx, ry, stops, 3u, rx * 0.3f, 0.0f));
+        }
+    }
+}
+
+static void Strokes(SoftwareCanvas& canvas)
+{
+    Random random = { 4u };
+    PathData::Point points[8];
+    for (int i = 0; i < 200; ++i)
+    {
+        for (PathData::Point& point : points)
+        {
+            point = { random.Next(0.0f, (float)WIDTH), random.Next(0.0f, (float)HEIGHT) };
+        }
+        canvas.DrawPolyline(points, 8u, i % 3 == 0, SoftwareCanvas::Paint::Solid(random.NextColor(0.9f)),
+            random.Next(1.0f, 6.0f));
+    }
+    canvas.SetTransform(Matrix2D::Rotation(15.0f, WIDTH * 0.5f, HEIGHT * 0.5f));
+    for (int i = 0; i < 50; ++i)
+    {
+        canvas.DrawEllipse(WIDTH * 0.5f, HEIGHT * 0.5f, 10.0f + i * 8.0f, 6.0f + i * 5.0f,
+            SoftwareCanvas::Paint::Solid({ 1.0f, 1.0f, 1.0f, 0.7f }), 2.0f);
+    }
+    canvas.SetTransform(Matrix2D::Identity());
+}
+
+static void Bitmaps(SoftwareCanvas& canvas)
+{
+    Random random = { 5u };
+    for (int i = 0; i < 100; ++i)
+    {
+        float x = random.Next(-64.0f, (float)WIDTH), y = random.Next(-64.0f, (float)HEIGHT);
+        float size = random.Next(32.0f, 256.0f);
+        canvas.SetTransform(Matrix2D::Rotation(random.Next(0.0f, 360.0f), x + size * 0.5f, y + size * 0.5f));
+        canvas.DrawBitmap(s_texture.data(), 64u, 64u, 64u * 4u, x, y, x + size, y + size, random.Next(0.5f, 1.0f),
+            i % 2 == 0);
+    }
+    canvas.SetTransform(Matrix2D::Identity());
+}
+
+struct Scene
+{
+    const char* name;
+    void (*draw)(SoftwareCanvas& canvas);
+    uint64_t golden;
+};
+
+// Hashes the pixels in the byte order the TGA files have them
+static uint64_t Checksum(const std::vector<uint32_t>& pixels)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t pixel : pixels)
+    {
+        for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+        {
+            hash = (hash ^ ((pixel >> shift) & 0xFFu)) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static double Render(const Scene& scene, ThreadPool* pPool, unsigned int frames, std::vector<uint32_t>& pixels,
+    unsigned long long& covered)
+{
+    pixels.assign(WIDTH * HEIGHT, 0u);
+    SoftwareCanvas canvas(pixels.data(), WIDTH, HEIGHT, WIDTH * 4u, pPool);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0u; i < frames; ++i)
+    {
+        canvas.Clear({ 0.1f, 0.1f, 0.15f, 1.0f });
+        scene.draw(canvas);
+    }
+    covered = canvas.GetStats().pixels;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool WriteTga(const std::string& path, const std::vector<uint32_t>& pixels)
+{
+    FILE* pFile = fopen(path.c_str(), "wb");
+    if (!pFile) return false;
+    // Uncompressed 32-bit true color with the origin at the top left
+    const unsigned char header[18] = { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, (unsigned char)(WIDTH & 0xFFu),
+        (unsigned char)(WIDTH >> 8), (unsigned char)(HEIGHT & 0xFFu), (unsigned char)(HEIGHT >> 8), 32, 0x28 };
+    bool ok = fwrite(header, 1u, sizeof(header), pFile) == sizeof(header) &&
+        fwrite(pixels.data(), 4u, pixels.size(), pFile) == pixels.size();
+    return fclose(pFile) == 0 && ok;
+}
+
+static bool ReadTga(const std::string& path, std::vector<uint32_t>& pixels)
+{
+    FILE* pFile = fopen(path.c_str(), "rb");
+    if (!pFile) return false;
+    unsigned char header[18];
+    pixels.resize(WIDTH * HEIGHT);
+    bool ok = fread(header, 1u, sizeof(header), pFile) == sizeof(header) && header[2] == 2 && header[16] == 32 &&
+        (header[12] | header[13] << 8) == (int)WIDTH && (header[14] | header[15] << 8) == (int)HEIGHT &&
+        fread(pixels.data(), 4u, pixels.size(), pFile) == pixels.size();
+    fclose(pFile);
+    return ok;
+}
+
+static unsigned int MaxDifference(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+    unsigned int difference = 0u;
+    for (size_t i = 0u; i < a.size(); ++i)
+    {
+        for (unsigned int shift = 0u; shift < 32u; shift += 8u)
+        {
+            int d = (int)((a[i] >> shift) & 0xFFu) - (int)((b[i] >> shift) & 0xFFu);
+            difference = std::max(difference, (unsigned int)(d < 0 ? -d : d));
+        }
+    }
+    return difference;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int frames = 20u;
+    const char* writeDir = nullptr;
+    const char* compareDir = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--frames") == 0) frames = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--write") == 0) writeDir = argv[i + 1];
+        else if (strcmp(argv[i], "--compare") == 0) compareDir = argv[i + 1];
+    }
+    if (frames == 0u) frames = 1u;
+
+    try
+    {
+        s_texture.resize(64u * 64u);
+        for (unsigned int y = 0u; y < 64u; ++y)
+        {
+            for (unsigned int x = 0u; x < 64u; ++x)
+            {
+                s_texture[y * 64u + x] = ((x / 8u + y / 8u) % 2u) ? 0xFFE0A020u : 0xC0202080u;
+            }
+        }
+
+        const Scene scenes[] =
+        {
+            // Update a checksum only after checking the new image by eye, --write saves it
+            { "rects", Rects, 0x439df4d88bd0b093ull },
+            { "ellipses", Ellipses, 0xb156497fbe05541bull },
+            { "gradients", Gradients, 0xd15f6ec91328d2b5ull },
+            { "strokes", Strokes, 0x455f7fb5dcc722aaull },
+            { "bitmaps", Bitmaps, 0x28812baf01c2bd57ull }
+        };
+        ThreadPool& pool = ThreadPool::GetShared();
+        printf("%ux%u, %u frames per scene, %u threads\n", WIDTH, HEIGHT, frames, pool.GetThreadCount());
+        printf("%-10s %12s %12s %12s %12s %8s\n", "scene", "1T fps", "1T Mpix/s", "NT fps", "NT Mpix/s", "speedup");
+
+        int result = 0;
+        std::vector<uint32_t> single, parallel, golden;
+        for (const Scene& scene : scenes)
+        {
+            unsigned long long singleCovered, parallelCovered;
+            double singleTime = Render(scene, nullptr, frames, single, singleCovered);
+            double parallelTime = Render(scene, &pool, frames, parallel, parallelCovered);
+            printf("%-10s %12.1f %12.1f %12.1f %12.1f %7.2fx\n", scene.name, frames / singleTime,
+                singleCovered / singleTime * 1e-6, frames / parallelTime, parallelCovered / parallelTime * 1e-6,
+                singleTime / parallelTime);
+
+            if (single != parallel)
+            {
+                printf("  %s: threaded output differs from single threaded output\n", scene.name);
+                result = 1;
+            }
+            std::string file = std::string(scene.name) + ".tga";
+            if (writeDir && !WriteTga(std::string(writeDir) + "/" + file, single))
+            {
+                printf("  %s: could not write %s\n", scene.name, file.c_str());
+                result = 1;
+            }
+            if (compareDir)
+            {
+                if (!ReadTga(std::string(compareDir) + "/" + file, golden))
+                {
+                    printf("  %s: could not read %s\n", scene.name, file.c_str());
+                    result = 1;
+                }
+                else
+                {
+                    unsigned int difference = MaxDifference(single, golden);
+                    printf("  %s: max channel difference %u, %s\n", scene.name, difference,
+                        difference <= 1u ? "ok" : "FAILED");
+                    if (difference > 1u) result = 1;
+                }
+            }
+            else
+            {
+                uint64_t checksum = Checksum(single);
+                printf("  %s: checksum %016llx, %s\n", scene.name, (unsigned long long)checksum,
+                    checksum == scene.golden ? "ok" : "FAILED, doesn't match the golden image");
+                if (checksum != scene.golden) result = 1;
+            }
+        }
+        return result;
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,230 @@
+// Registers and unregisters a million resources in Ice2D::ResourceRegistry and in a std::list tracker like the one
+// it replaced, without a render target.
+//
+//   RegistryBench [--count n] [--runs n]
+//
+// Each scene is timed for both trackers, best of n runs: registering everything and removing it in the same order,
+// removing it in random order, churn with a steady number of live resources, and walking all of them the way
+// FreeAll() does. The registry is also checked: every handle finds its resource, removed and cleared handles are
+// rejected, and once the registry has grown, the scenes don't allocate. The tool exits with 1 when a check fails.
+#include "pch.h"
+
+#include "ResourceRegistry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <new>
+#include <vector>
+
+using namespace Ice2D;
+
+// Counts every allocation, so the registry scenes can show they don't make any
+static unsigned long long allocations = 0ull;
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    void* p = malloc(size ? size : 1u);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+// The registry only stores pointers, so the resources are plain structs standing in for IBasicResource
+struct FakeResource
+{
+    unsigned int id;
+    ResourceRegistry::Handle handle;
+    std::list<FakeResource*>::iterator listRef;
+};
+
+static IBasicResource* AsResource(FakeResource* p)
+{
+    return reinterpret_cast<IBasicResource*>(p);
+}
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+struct Random
+{
+    uint32_t seed;
+    uint32_t Next(uint32_t count)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (uint32_t)(((uint64_t)(seed >> 1) * count) >> 31);
+    }
+};
+
+template<typename F>
+static double Best(unsigned int runs, F&& body)
+{
+    double best = 1e30;
+    for (unsigned int run = 0u; run < runs; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static void Report(const char* scene, unsigned long long ops, double registrySeconds, double listSeconds,
+    unsigned long long registryAllocations)
+{
+    printf("%-10s %10llu %10.2f %10.2f %8.1fx %12llu\n", scene, ops, registrySeconds * 1e9 / ops,
+        listSeconds * 1e9 / ops, listSeconds / registrySeconds, registryAllocations);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int count = 1000000u, runs = 5u;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--count") == 0) count = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--runs") == 0) runs = (unsigned int)atoi(argv[i + 1]);
+    }
+    if (count == 0u) count = 1u;
+    if (runs == 0u) runs = 1u;
+
+    std::vector<FakeResource> resources(count);
+    for (unsigned int i = 0u; i < count; ++i) resources[i].id = i;
+    std::vector<unsigned int> shuffled(count);
+    for (unsigned int i = 0u; i < count; ++i) shuffled[i] = i;
+    Random random = { 1u };
+    for (unsigned int i = count - 1u; i > 0u; --i) std::swap(shuffled[i], shuffled[random.Next(i + 1u)]);
+
+    // Grown once up front, like ReserveResources(), so the timed scenes show the steady state
+    ResourceRegistry registry;
+    registry.Reserve(count);
+    std::list<FakeResource*> trackers;
+
+    printf("%u resources, best of %u runs\n", count, runs);
+    printf("%-10s %10s %10s %10s %9s %12s\n", "scene", "ops", "registry", "list", "speedup", "allocations");
+    printf("%-10s %10s %10s %10s %9s %12s\n", "", "", "ns/op", "ns/op", "", "(registry)");
+
+    // Register everything, then remove it in the order it was added
+    unsigned long long before = allocations;
+    double registrySeconds = Best(runs, [&]
+    {
+        for (FakeResource& r : resources) r.handle = registry.Add(AsResource(&r));
+        for (FakeResource& r : resources) registry.Remove(r.handle);
+    });
+    unsigned long long registryAllocations = allocations - before;
+    double listSeconds = Best(runs, [&]
+    {
+        for (FakeResource& r : resources) r.listRef = trackers.insert(trackers.end(), &r);
+        for (FakeResource& r : resources) trackers.erase(r.listRef);
+    });
+    Report("in order", 2ull * count, registrySeconds, listSeconds, registryAllocations);
+    Expect(registry.Size() == 0u, "everything was removed");
+    Expect(!registry.Contains(resources[0].handle), "a removed handle is rejected");
+    Expect(registryAllocations == 0ull, "registering into a grown registry doesn't allocate");
+
+    // Register everything, check every handle, then remove it in random order
+    for (FakeResource& r : resources) r.handle = registry.Add(AsResource(&r));
+    bool found = true;
+    for (FakeResource& r : resources) found &= registry.Get(r.handle) == AsResource(&r);
+    Expect(found, "every handle finds its resource");
+    for (FakeResource& r : resources) registry.Remove(r.handle);
+
+    before = allocations;
+    registrySeconds = Best(runs, [&]
+    {
+        for (FakeResource& r : resources) r.handle = registry.Add(AsResource(&r));
+        for (unsigned int i : shuffled) registry.Remove(resources[i].handle);
+    });
+    registryAllocations = allocations - before;
+    listSeconds = Best(runs, [&]
+    {
+        for (FakeResource& r : resources) r.listRef = trackers.insert(trackers.end(), &r);
+        for (unsigned int i : shuffled) trackers.erase(resources[i].listRef);
+    });
+    Report("shuffled", 2ull * count, registrySeconds, listSeconds, registryAllocations);
+    Expect(registryAllocations == 0ull, "removing in random order doesn't allocate");
+
+    // A steady population with resources coming and going, like brushes and images made during play
+    const unsigned int live = std::max(1u, count / 100u);
+    for (unsigned int i = 0u; i < live; ++i) resources[i].handle = registry.Add(AsResource(&resources[i]));
+    for (unsigned int i = 0u; i < live; ++i) resources[i].listRef = trackers.insert(trackers.end(), &resources[i]);
+    before = allocations;
+    registrySeconds = Best(runs, [&]
+    {
+        Random churn = { 2u };
+        for (unsigned int i = 0u; i < count; ++i)
+        {
+            FakeResource& r = resources[churn.Next(live)];
+            registry.Remove(r.handle);
+            r.handle = registry.Add(AsResource(&r));
+        }
+    });
+    registryAllocations = allocations - before;
+    listSeconds = Best(runs, [&]
+    {
+        Random churn = { 2u };
+        for (unsigned int i = 0u; i < count; ++i)
+        {
+            FakeResource& r = resources[churn.Next(live)];
+            trackers.erase(r.listRef);
+            r.listRef = trackers.insert(trackers.end(), &r);
+        }
+    });
+    Report("churn", 2ull * count, registrySeconds, listSeconds, registryAllocations);
+    Expect(registry.Size() == live, "churn keeps the population");
+    found = true;
+    for (unsigned int i = 0u; i < live; ++i) found &= registry.Get(resources[i].handle) == AsResource(&resources[i]);
+    Expect(found, "every handle still finds its resource after churn");
+    registry.Clear();
+    trackers.clear();
+
+    // Walk everything like FreeAll(), the list was filled in shuffled order, as a long running game leaves it
+    for (FakeResource& r : resources) r.handle = registry.Add(AsResource(&r));
+    for (unsigned int i : shuffled) trackers.push_back(&resources[i]);
+    unsigned long long registrySum = 0ull, listSum = 0ull;
+    before = allocations;
+    registrySeconds = Best(runs, [&]
+    {
+        registrySum = 0ull;
+        for (IBasicResource* p : registry) registrySum += reinterpret_cast<FakeResource*>(p)->id;
+    });
+    registryAllocations = allocations - before;
+    listSeconds = Best(runs, [&]
+    {
+        listSum = 0ull;
+        for (FakeResource* p : trackers) listSum += p->id;
+    });
+    Report("walk", count, registrySeconds, listSeconds, registryAllocations);
+    Expect(registrySum == listSum && registrySum == (unsigned long long)count * (count - 1u) / 2u,
+        "the walk visits every resource once");
+
+    // FreeAll() clears the registry, old handles must not find the slots their resources had
+    const ResourceRegistry::Handle stale = resources[count / 2u].handle;
+    registry.Clear();
+    Expect(registry.Size() == 0u && !registry.Contains(stale), "Clear() rejects the handles from before");
+    FakeResource late = { count, {}, {} };
+    ResourceRegistry::Handle reused = registry.Add(AsResource(&late));
+    Expect(!registry.Contains(stale) && registry.Get(reused) == AsResource(&late),
+        "a reused slot doesn't answer to an old handle");
+    Expect(!registry.Contains(ResourceRegistry::Handle()), "a zeroed handle is never valid");
+
+    if (failures) printf("%d checks FAILED\n", failures);
+    return failures ? 1 : 0;
+}
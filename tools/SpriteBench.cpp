@@ -0,0 +1,216 @@
+// Measures the sort of Ice2D::SpriteQueue, the portable part of Ice2D::SpriteBatch, and checks its order.
+//
+//   SpriteBench [--sprites n] [--runs n] [--seed n]
+//
+// Every scene queues random sprites over a number of layers and textures, the way a frame of a game does: a few
+// atlases, hundreds of small textures, one layer, and layers far outside the 16 bits the sort key keeps. The timings
+// are the best of n runs of Sort() on the same queue, next to std::stable_sort of the same keys. The checks don't
+// count towards the time. In every mode the sprites have to come out in the order of a std::stable_sort by layer,
+// then by the order in which the textures were first used, with the queue order breaking ties, and the batches have
+// to split them exactly where the texture changes. The tool exits with 1 when a check fails.
+#include "pch.h"
+
+#include "SpriteQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+using namespace Ice2D;
+
+typedef SpriteQueue::SortMode SortMode;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+struct Random
+{
+    uint32_t seed;
+    uint32_t Next(uint32_t count)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (uint32_t)(((uint64_t)(seed >> 1) * count) >> 31);
+    }
+};
+
+struct Scene
+{
+    const char* name;
+    unsigned int layers, textures;
+    int layerLow, layerStep;
+};
+
+template<typename F> static double Best(unsigned int runs, F&& body)
+{
+    double best = 1e30;
+    for (unsigned int run = 0u; run < runs; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+// The queue position rides along in the transform, so the sorted sprites can be traced back
+static void Fill(SpriteQueue& queue, const Scene& scene, unsigned int count, const std::vector<int>& textures,
+    Random& random)
+{
+    queue.Clear();
+    unsigned int texture = 0u;
+    for (unsigned int i = 0u; i < count; ++i)
+    {
+        // Runs of the same texture, like the tiles or particles of one system
+        if (random.Next(4u) == 0u) texture = random.Next(scene.textures);
+        SpriteQueue::Sprite sprite = {};
+        sprite.dest = { 0.0f, 0.0f, 16.0f, 16.0f };
+        sprite.source = { 0u, 0u, 16u, 16u };
+        sprite.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+        sprite.transform = SpriteQueue::IDENTITY;
+        sprite.transform.dx = (float)i;
+        sprite.pTexture = &textures[texture];
+        sprite.layer = scene.layerLow + (int)random.Next(scene.layers) * scene.layerStep;
+        queue.Add(sprite);
+    }
+}
+
+// Layer in the high bits and the texture's first use in the low bits, without the queue's clamping shortcuts
+static std::vector<unsigned long long> ReferenceKeys(const std::vector<SpriteQueue::Sprite>& sprites, SortMode mode)
+{
+    std::vector<unsigned long long> keys(sprites.size(), 0ull);
+    if (mode == SortMode::Deferred) return keys;
+    std::unordered_map<const void*, unsigned long long> ids;
+    for (size_t i = 0u; i < sprites.size(); ++i)
+    {
+        const int layer = std::max(-32768, std::min(32767, sprites[i].layer));
+        unsigned long long texture = 0ull;
+        if (mode == SortMode::LayerTexture)
+        {
+            auto found = ids.emplace(sprites[i].pTexture, (unsigned long long)ids.size()).first;
+            texture = std::min(found->second, 0xFFFFull);
+        }
+        keys[i] = ((unsigned long long)(layer + 32768) << 32) | texture;
+    }
+    return keys;
+}
+
+static std::vector<unsigned int> ReferenceOrder(const std::vector<unsigned long long>& keys)
+{
+    std::vector<unsigned int> order(keys.size());
+    for (unsigned int i = 0u; i < (unsigned int)keys.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&keys](unsigned int a, unsigned int b) { return keys[a] < keys[b]; });
+    return order;
+}
+
+static bool Check(const SpriteQueue& queue, const std::vector<SpriteQueue::Sprite>& queued,
+    const std::vector<unsigned int>& order)
+{
+    const std::vector<SpriteQueue::Sprite>& sprites = queue.GetSprites();
+    bool ordered = sprites.size() == order.size();
+    for (size_t i = 0u; ordered && i < sprites.size(); ++i)
+    {
+        const SpriteQueue::Sprite& expected = queued[order[i]];
+        ordered = sprites[i].transform.dx == (float)order[i] && sprites[i].pTexture == expected.pTexture &&
+            sprites[i].layer == expected.layer;
+    }
+
+    // Batches cover every sprite once and only break where the texture does
+    bool batched = true;
+    unsigned int next = 0u;
+    const std::vector<SpriteQueue::Batch>& batches = queue.GetBatches();
+    for (size_t b = 0u; batched && b < batches.size(); ++b)
+    {
+        const SpriteQueue::Batch& batch = batches[b];
+        batched = batch.first == next && batch.count > 0u && batch.first + batch.count <= sprites.size();
+        for (unsigned int i = batch.first; batched && i < batch.first + batch.count; ++i)
+        {
+            batched = sprites[i].pTexture == batch.pTexture;
+        }
+        if (batched && b > 0u) batched = batches[b - 1u].pTexture != batch.pTexture;
+        next += batch.count;
+    }
+    batched = batched && next == sprites.size();
+    Expect(ordered, "the sprites are in stable (layer, texture) order");
+    Expect(batched, "the batches split the sprites where the texture changes");
+    return ordered && batched;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int count = 20000u, runs = 20u;
+    uint32_t seed = 1u;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--sprites") == 0) count = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--runs") == 0) runs = (unsigned int)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+    }
+    if (runs == 0u) runs = 1u;
+
+    const Scene scenes[] =
+    {
+        { "atlases", 8u, 4u, 0, 1 },
+        { "textures", 16u, 700u, -8, 1 },
+        { "one layer", 1u, 64u, 0, 1 },
+        { "wide layers", 12u, 32u, -60000, 10000 }
+    };
+    const struct { SortMode mode; const char* name; } modes[] =
+    {
+        { SortMode::LayerTexture, "layer+tex" },
+        { SortMode::Layer, "layer" },
+        { SortMode::Deferred, "deferred" }
+    };
+    std::vector<int> textures(1024u);
+
+    printf("%u sprites, best of %u runs\n", count, runs);
+    printf("%-12s %-10s %8s %10s %12s %12s\n", "scene", "mode", "batches", "ms", "Msprite/s", "stable_sort");
+    SpriteQueue queue;
+    for (const Scene& scene : scenes)
+    {
+        Random random = { seed };
+        Fill(queue, scene, count, textures, random);
+        queue.Sort(SortMode::Deferred);
+        const std::vector<SpriteQueue::Sprite> queued = queue.GetSprites();
+        for (const auto& mode : modes)
+        {
+            const std::vector<unsigned long long> keys = ReferenceKeys(queued, mode.mode);
+            double time = Best(runs, [&] { queue.Sort(mode.mode); });
+            std::vector<unsigned int> order;
+            double reference = Best(runs, [&] { order = ReferenceOrder(keys); });
+            printf("%-12s %-10s %8u %10.3f %12.1f %12.1f\n", scene.name, mode.name,
+                (unsigned int)queue.GetBatches().size(), time * 1e3, count / time * 1e-6, count / reference * 1e-6);
+            Check(queue, queued, order);
+        }
+    }
+
+    // Sorting again after a refill reuses the texture table, stale slots must not leak ids into the next frame
+    printf("refills of a reused queue\n");
+    Random random = { seed + 1u };
+    bool reused = true;
+    for (unsigned int frame = 0u; frame < 50u; ++frame)
+    {
+        const Scene scene = { "frame", 1u + random.Next(8u), 1u + random.Next(1000u), 0, 1 };
+        Fill(queue, scene, 1u + random.Next(2000u), textures, random);
+        queue.Sort(SortMode::Deferred);
+        const std::vector<SpriteQueue::Sprite> queued = queue.GetSprites();
+        queue.Sort(SortMode::LayerTexture);
+        reused &= Check(queue, queued, ReferenceOrder(ReferenceKeys(queued, SortMode::LayerTexture)));
+    }
+    Expect(reused, "every frame sorts like a fresh queue");
+
+    queue.Clear();
+    queue.Sort(SortMode::LayerTexture);
+    Expect(queue.GetSprites().empty() && queue.GetBatches().empty(), "an empty queue sorts to nothing");
+
+    if (failures) printf("%d checks FAILED\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,288 @@
+// Plays Ice2D::AudioStream into a fake sink and checks every byte that comes out against the file.
+//
+//   StreamCheck
+//
+// The file is a pattern in memory, and the sink keeps the submitted blocks in order the way a voice does. The check
+// plays them back on the main thread and recycles each one after copying it, while the stream reads ahead on its own
+// thread. The cases cover a plain read to the end with block and file sizes trimmed to the block alignment, looping
+// across the end of the file and back out of it, a seek while blocks are queued where the sink's flush drops the old
+// blocks, and a short read. The tool prints one line per case and exits with 1 when a check fails.
+#include "pch.h"
+
+#include "AudioStream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+using namespace Ice2D;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+// Keeps submitted blocks until they're played, a flush hands all of them back at once
+class FakeSink : public AudioStreamSink
+{
+public:
+    struct Submission
+    {
+        std::vector<unsigned char> data;
+        unsigned int block;
+        bool endOfStream;
+    };
+
+    FakeSink() : m_pStream(nullptr), m_flushes(0u)
+    {
+    }
+
+    void SetStream(AudioStream* pStream)
+    {
+        m_pStream = pStream;
+    }
+
+    void Submit(const unsigned char* pData, uint32_t size, unsigned int block, bool endOfStream) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back({ std::vector<unsigned char>(pData, pData + size), block, endOfStream });
+        m_changed.notify_all();
+    }
+
+    void Flush() override
+    {
+        std::deque<Submission> dropped;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            dropped.swap(m_pending);
+            ++m_flushes;
+        }
+        for (const Submission& submission : dropped) m_pStream->Recycle(submission.block);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changed.notify_all();
+    }
+
+    // Takes the oldest block, or gives up after a second without one
+    bool Next(Submission& submission)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_changed.wait_for(lock, std::chrono::seconds(1), [this] { return !m_pending.empty(); })) return false;
+        submission = std::move(m_pending.front());
+        m_pending.pop_front();
+        return true;
+    }
+
+    bool WaitForFlush(unsigned int count)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_changed.wait_for(lock, std::chrono::seconds(1), [this, count] { return m_flushes >= count; });
+    }
+
+private:
+    AudioStream* m_pStream;
+    std::deque<Submission> m_pending;
+    unsigned int m_flushes;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+};
+
+static std::vector<unsigned char> MakeFile(size_t size)
+{
+    // Never repeats within a block, so a block from the wrong offset can't match by accident
+    std::vector<unsigned char> file(size);
+    for (size_t i = 0u; i < size; ++i) file[i] = (unsigned char)(i * 7u + (i >> 8) * 13u + (i >> 16));
+    return file;
+}
+
+static AudioStream::Reader ReadFrom(const std::vector<unsigned char>& file)
+{
+    return [&file](uint64_t offset, void* pBuffer, size_t size)
+    {
+        size_t count = offset < file.size() ? std::min(size, file.size() - (size_t)offset) : 0u;
+        memcpy(pBuffer, file.data() + offset, count);
+        return count;
+    };
+}
+
+struct Played
+{
+    std::vector<unsigned char> data;
+    unsigned int blocks, endings;
+    uint32_t largest;
+    bool aligned, timedOut;
+};
+
+// Plays blocks until the end of the stream or until enough bytes came out
+static void Play(FakeSink& sink, AudioStream& stream, size_t limit, uint32_t blockAlign, Played& played)
+{
+    FakeSink::Submission submission;
+    while (played.data.size() < limit)
+    {
+        if (!sink.Next(submission))
+        {
+            played.timedOut = true;
+            return;
+        }
+        played.data.insert(played.data.end(), submission.data.begin(), submission.data.end());
+        played.aligned &= submission.data.size() % blockAlign == 0u;
+        played.largest = std::max(played.largest, (uint32_t)submission.data.size());
+        ++played.blocks;
+        stream.Recycle(submission.block);
+        if (submission.endOfStream)
+        {
+            ++played.endings;
+            return;
+        }
+    }
+}
+
+static bool Matches(const std::vector<unsigned char>& played, const std::vector<unsigned char>& file, size_t start,
+    size_t size)
+{
+    // What a looping voice plays from start on, wrapping around at size
+    for (size_t i = 0u; i < played.size(); ++i)
+    {
+        if (played[i] != file[(start + i) % size]) return false;
+    }
+    return true;
+}
+
+static void WaitUntilFinished(const AudioStream& stream)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!stream.IsFinished() && std::chrono::steady_clock::now() < end) std::this_thread::yield();
+}
+
+static void Sequential()
+{
+    printf("reading to the end\n");
+    const std::vector<unsigned char> file = MakeFile(100007u);
+    FakeSink sink;
+    AudioStream stream(ReadFrom(file), file.size(), &sink, 4099u, 3u, 4u);
+    sink.SetStream(&stream);
+    Expect(stream.GetSize() == 100004u, "the size is trimmed to whole blocks of 4 bytes");
+    stream.Start();
+    Played played = {};
+    played.aligned = true;
+    Play(sink, stream, file.size() * 2u, 4u, played);
+    WaitUntilFinished(stream);
+    Expect(!played.timedOut && played.endings == 1u, "the last block ends the stream");
+    Expect(played.data.size() == 100004u && Matches(played.data, file, 0u, file.size()), "every byte is played once");
+    Expect(played.aligned && played.largest == 4096u, "blocks are trimmed to the alignment too");
+    Expect(played.blocks == 25u, "in 25 blocks");
+    Expect(stream.IsFinished() && !stream.HasFailed() && stream.GetPlayPosition() == 100004u,
+        "the stream is finished at the end");
+    AudioStream::Stats stats = stream.GetStats();
+    Expect(stats.blocksRead == 25u && stats.bytesRead == 100004u, "and counted what it read");
+
+    FakeSink emptySink;
+    AudioStream empty(ReadFrom(file), 3u, &emptySink, 4096u, 2u, 4u);
+    empty.Start();
+    Expect(empty.GetSize() == 0u && empty.IsFinished(), "a file shorter than one sample is finished right away");
+}
+
+static void Looping()
+{
+    printf("looping\n");
+    const std::vector<unsigned char> file = MakeFile(10000u);
+    FakeSink sink;
+    AudioStream stream(ReadFrom(file), file.size(), &sink, 3000u, 3u, 2u);
+    sink.SetStream(&stream);
+    stream.SetLooping(true);
+    stream.Start();
+    Played played = {};
+    played.aligned = true;
+    Play(sink, stream, 35000u, 2u, played);
+    Expect(!played.timedOut && played.endings == 0u, "a looping stream doesn't end");
+    Expect(played.data.size() >= 35000u && Matches(played.data, file, 0u, file.size()),
+        "it wraps around to the start without a gap or a repeat");
+    Expect(played.largest == 3000u && played.aligned, "blocks keep to the block size and alignment");
+
+    // The blocks already read still loop, then the stream plays up to the end of the file
+    stream.SetLooping(false);
+    Play(sink, stream, played.data.size() + file.size() * 4u, 2u, played);
+    WaitUntilFinished(stream);
+    Expect(!played.timedOut && played.endings == 1u, "turning looping off ends the stream");
+    Expect(played.data.size() % file.size() == 0u && Matches(played.data, file, 0u, file.size()),
+        "at the end of the file");
+    Expect(stream.IsFinished(), "the stream is finished");
+}
+
+static void Seeking()
+{
+    printf("seeking\n");
+    const std::vector<unsigned char> file = MakeFile(64000u);
+    FakeSink sink;
+    AudioStream stream(ReadFrom(file), file.size(), &sink, 2000u, 4u, 4u);
+    sink.SetStream(&stream);
+    stream.Start();
+    Played played = {};
+    played.aligned = true;
+    Play(sink, stream, 1u, 4u, played);
+    Expect(played.data.size() == 2000u && stream.GetPlayPosition() == 2000u, "the first block plays");
+
+    // The blocks queued before the flush belong to the old position and never play
+    stream.Seek(40003u);
+    Expect(sink.WaitForFlush(1u), "Seek() flushes the sink");
+    Expect(stream.GetPlayPosition() == 40000u, "the play position moves to the aligned offset");
+    played.data.clear();
+    Play(sink, stream, file.size(), 4u, played);
+    WaitUntilFinished(stream);
+    Expect(played.data.size() == 24000u && Matches(played.data, file, 40000u, file.size()),
+        "playback restarts at the requested offset");
+    Expect(played.endings == 1u && stream.IsFinished(), "and runs to the end");
+
+    stream.SetLooping(true);
+    stream.Seek(64000u);
+    Expect(sink.WaitForFlush(2u), "a seek after the end flushes again");
+    played.data.clear();
+    Play(sink, stream, 10000u, 4u, played);
+    Expect(played.data.size() >= 10000u && Matches(played.data, file, 0u, file.size()),
+        "a looping stream seeked to the end starts over");
+    stream.Stop();
+
+    stream.SetLooping(false);
+    stream.Seek(1000000u);
+    stream.Start();
+    Expect(sink.WaitForFlush(3u), "a seek past the end still flushes");
+    WaitUntilFinished(stream);
+    Expect(stream.IsFinished() && stream.GetPlayPosition() == 64000u, "and finishes at the end");
+}
+
+static void ShortRead()
+{
+    printf("short read\n");
+    const std::vector<unsigned char> file = MakeFile(30000u);
+    FakeSink sink;
+    AudioStream::Reader reader = ReadFrom(file);
+    AudioStream stream([&reader](uint64_t offset, void* pBuffer, size_t size)
+    {
+        return offset >= 12000u ? reader(offset, pBuffer, size / 2u) : reader(offset, pBuffer, size);
+    }, file.size(), &sink, 4000u, 3u, 1u);
+    sink.SetStream(&stream);
+    stream.Start();
+    Played played = {};
+    played.aligned = true;
+    Play(sink, stream, file.size(), 1u, played);
+    WaitUntilFinished(stream);
+    Expect(played.endings == 1u && played.data.size() == 14000u && Matches(played.data, file, 0u, file.size()),
+        "the stream ends after what did arrive");
+    Expect(stream.HasFailed() && stream.IsFinished(), "and reports the failure");
+}
+
+int main()
+{
+    Sequential();
+    Looping();
+    Seeking();
+    ShortRead();
+    if (failures) printf("%d checks FAILED\n", failures);
+    else printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,354 @@
+// Measures Ice2D::Tessellator on large sets of polygons and checks its triangles against the paths.
+//
+//   TessBench [--runs n]
+//
+// Every scene is a list of paths: stars, shapes with holes, curves, self-intersecting polygons in both fill modes,
+// and a few very large paths. The timings are the best of n runs with one reused tessellator. The checks don't count
+// towards the time. For every path, the triangle area has to match the area of the filled path, random points have
+// to land inside a triangle exactly when they're inside the path, and a fresh tessellator has to give the same
+// triangles bit for bit. The tool exits with 1 when a check fails.
+#include "pch.h"
+
+#include "Tessellator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Ice2D;
+
+static const float PI = 3.14159265358979f;
+
+struct Random
+{
+    uint32_t seed;
+    float Next(float low, float high)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return low + (high - low) * ((seed >> 8) * (1.0f / 16777216.0f));
+    }
+};
+
+static void AddStar(PathData& path, float x, float y, float outer, float inner, unsigned int spikes, float angle,
+    bool reverse)
+{
+    std::vector<PathData::Point> points(spikes * 2u);
+    for (unsigned int i = 0u; i < spikes * 2u; ++i)
+    {
+        float radius = i % 2u ? inner : outer;
+        float a = angle + (reverse ? -1.0f : 1.0f) * PI * i / spikes;
+        points[i] = { x + radius * std::cos(a), y + radius * std::sin(a) };
+    }
+    path.AddPolygon(points.data(), (unsigned int)points.size());
+}
+
+static void Stars(std::vector<PathData>& paths)
+{
+    Random random = { 1u };
+    for (int i = 0; i < 2000; ++i)
+    {
+        PathData path;
+        float outer = random.Next(10.0f, 200.0f);
+        AddStar(path, random.Next(0.0f, 1024.0f), random.Next(0.0f, 768.0f), outer, outer * random.Next(0.2f, 0.8f),
+            5u + (unsigned int)random.Next(0.0f, 35.0f), random.Next(0.0f, 2.0f * PI), false);
+        path.SetFillMode(i % 2 ? PathData::FillMode::Winding : PathData::FillMode::Alternate);
+        paths.push_back(path);
+    }
+}
+
+static void Holes(std::vector<PathData>& paths)
+{
+    // Holes wind the other way, so both fill modes leave them empty
+    Random random = { 2u };
+    for (int i = 0; i < 500; ++i)
+    {
+        PathData path;
+        float x = random.Next(0.0f, 1024.0f), y = random.Next(0.0f, 768.0f), size = random.Next(40.0f, 300.0f);
+        AddStar(path, x, y, size, size * 0.9f, 48u, 0.0f, false);
+        for (int j = 0; j < 3; ++j)
+        {
+            float angle = j * 2.0f * PI / 3.0f;
+            AddStar(path, x + size * 0.45f * std::cos(angle), y + size * 0.45f * std::sin(angle), size * 0.3f,
+                size * 0.2f, 6u + j, random.Next(0.0f, PI), true);
+        }
+        path.SetFillMode(i % 2 ? PathData::FillMode::Winding : PathData::FillMode::Alternate);
+        paths.push_back(path);
+    }
+}
+
+static void Curves(std::vector<PathData>& paths)
+{
+    Random random = { 3u };
+    for (int i = 0; i < 500; ++i)
+    {
+        PathData path;
+        float x = random.Next(0.0f, 1024.0f), y = random.Next(0.0f, 768.0f);
+        path.AddRoundedRect(x, y, x + random.Next(20.0f, 300.0f), y + random.Next(20.0f, 300.0f), 16.0f, 24.0f);
+        path.AddEllipse(x, y, random.Next(5.0f, 150.0f), random.Next(5.0f, 150.0f));
+        path.MoveTo(x, y);
+        path.BezierTo(x + random.Next(-200.0f, 200.0f), y + random.Next(-200.0f, 200.0f),
+            x + random.Next(-200.0f, 200.0f), y + random.Next(-200.0f, 200.0f), x + 100.0f, y);
+        path.QuadraticTo(x + random.Next(-200.0f, 200.0f), y + random.Next(-200.0f, 200.0f), x, y + 50.0f);
+        path.Close();
+        path.SetFillMode(i % 2 ? PathData::FillMode::Winding : PathData::FillMode::Alternate);
+        paths.push_back(path);
+    }
+}
+
+static void Tangled(std::vector<PathData>& paths)
+{
+    Random random = { 4u };
+    for (int i = 0; i < 200; ++i)
+    {
+        PathData path;
+        PathData::Point points[64];
+        float x = random.Next(0.0f, 1024.0f), y = random.Next(0.0f, 768.0f), size = random.Next(20.0f, 400.0f);
+        for (PathData::Point& point : points)
+        {
+            point = { x + random.Next(-size, size), y + random.Next(-size, size) };
+        }
+        path.AddPolygon(points, 64u);
+        path.SetFillMode(i % 2 ? PathData::FillMode::Winding : PathData::FillMode::Alternate);
+        paths.push_back(path);
+    }
+}
+
+static void Large(std::vector<PathData>& paths)
+{
+    // A wavy ring with 200000 points, and 10000 rotated squares in one path
+    const unsigned int count = 200000u;
+    std::vector<PathData::Point> points(count);
+    PathData ring;
+    for (int figure = 0; figure < 2; ++figure)
+    {
+        for (unsigned int i = 0u; i < count; ++i)
+        {
+            float a = 2.0f * PI * i / count * (figure ? -1.0f : 1.0f);
+            float radius = (figure ? 250.0f : 380.0f) + 12.0f * std::sin(a * 400.0f);
+            points[i] = { 512.0f + radius * std::cos(a), 384.0f + radius * std::sin(a) };
+        }
+        ring.AddPolygon(points.data(), count);
+    }
+    paths.push_back(ring);
+
+    PathData grid;
+    grid.SetFillMode(PathData::FillMode::Winding);
+    for (int y = 0; y < 100; ++y)
+    {
+        for (int x = 0; x < 100; ++x)
+        {
+            PathData square;
+            square.AddRect(-4.0f, -4.0f, 4.0f, 4.0f);
+            square.Transform(Matrix2D::Rotation((float)(x * 7 + y * 13), 0.0f, 0.0f) *
+                Matrix2D::Translation(x * 10.0f + 5.0f, y * 7.5f + 5.0f));
+            const PathData::Point* pPoints = square.GetPoints().data();
+            grid.AddPolygon(pPoints, 4u);
+        }
+    }
+    paths.push_back(grid);
+}
+
+struct Scene
+{
+    const char* name;
+    void (*build)(std::vector<PathData>& paths);
+};
+
+static bool InsidePath(const PathData& path, float x, float y)
+{
+    int winding = 0;
+    const std::vector<PathData::Point>& points = path.GetPoints();
+    for (const PathData::Figure& figure : path.GetFigures())
+    {
+        if (figure.count < 3u) continue;
+        for (unsigned int i = 0u; i < figure.count; ++i)
+        {
+            const PathData::Point& a = points[figure.first + i];
+            const PathData::Point& b = points[figure.first + (i + 1u) % figure.count];
+            if ((a.y <= y) == (b.y <= y)) continue;
+            float t = (y - a.y) / (b.y - a.y);
+            if (a.x + t * (b.x - a.x) > x) winding += a.y < b.y ? 1 : -1;
+        }
+    }
+    return path.GetFillMode() == PathData::FillMode::Winding ? winding != 0 : (winding & 1) != 0;
+}
+
+static double Cross(const PathData::Point& a, const PathData::Point& b, const PathData::Point& c)
+{
+    return ((double)b.x - a.x) * ((double)c.y - a.y) - ((double)b.y - a.y) * ((double)c.x - a.x);
+}
+
+static bool InsideTriangles(const std::vector<Tessellator::Triangle>& triangles, float x, float y)
+{
+    const PathData::Point p = { x, y };
+    for (const Tessellator::Triangle& t : triangles)
+    {
+        if (Cross(t.a, t.b, p) >= 0.0 && Cross(t.b, t.c, p) >= 0.0 && Cross(t.c, t.a, p) >= 0.0) return true;
+    }
+    return false;
+}
+
+// Integrates the filled width of the path over many rows, independently of the tessellator
+static double PathArea(const PathData& path, float top, float bottom)
+{
+    struct Segment
+    {
+        float x0, y0, x1, y1;
+        int winding;
+    };
+    struct Crossing
+    {
+        float x;
+        int winding;
+    };
+    std::vector<Segment> segments;
+    const std::vector<PathData::Point>& points = path.GetPoints();
+    for (const PathData::Figure& figure : path.GetFigures())
+    {
+        if (figure.count < 3u) continue;
+        for (unsigned int i = 0u; i < figure.count; ++i)
+        {
+            const PathData::Point& a = points[figure.first + i];
+            const PathData::Point& b = points[figure.first + (i + 1u) % figure.count];
+            if (a.y == b.y) continue;
+            segments.push_back(a.y < b.y ? Segment{ a.x, a.y, b.x, b.y, 1 } : Segment{ b.x, b.y, a.x, a.y, -1 });
+        }
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.y0 < b.y0; });
+
+    const int rows = 8192;
+    const double step = ((double)bottom - top) / rows;
+    const bool nonZero = path.GetFillMode() == PathData::FillMode::Winding;
+    std::vector<const Segment*> active;
+    std::vector<Crossing> crossings;
+    size_t next = 0u;
+    double area = 0.0;
+    for (int row = 0; row < rows; ++row)
+    {
+        double y = top + (row + 0.5) * step;
+        for (; next < segments.size() && segments[next].y0 <= y; ++next) active.push_back(&segments[next]);
+        active.erase(std::remove_if(active.begin(), active.end(),
+            [y](const Segment* s) { return s->y1 <= y; }), active.end());
+        crossings.clear();
+        for (const Segment* s : active)
+        {
+            if (s->y0 > y) continue;
+            crossings.push_back({ (float)(s->x0 + (y - s->y0) / ((double)s->y1 - s->y0) * ((double)s->x1 - s->x0)),
+                s->winding });
+        }
+        std::sort(crossings.begin(), crossings.end(), [](const Crossing& a, const Crossing& b) { return a.x < b.x; });
+        int winding = 0;
+        for (size_t i = 0u; i + 1u < crossings.size(); ++i)
+        {
+            winding += crossings[i].winding;
+            if (nonZero ? winding != 0 : (winding & 1) != 0) area += ((double)crossings[i + 1u].x - crossings[i].x);
+        }
+    }
+    return area * step;
+}
+
+static bool Check(const PathData& path, const std::vector<Tessellator::Triangle>& triangles, Random& random,
+    unsigned int samples)
+{
+    float left, top, right, bottom;
+    if (!path.GetBounds(left, top, right, bottom)) return triangles.empty();
+
+    double triangleArea = 0.0;
+    for (const Tessellator::Triangle& t : triangles)
+    {
+        if (Cross(t.a, t.b, t.c) < 0.0) return false;
+        triangleArea += Cross(t.a, t.b, t.c) * 0.5;
+    }
+    double pathArea = PathArea(path, top, bottom);
+    double tolerance = 1e-3 * pathArea + 0.05 * (bottom - top) / 8192.0 * path.GetPoints().size() + 1e-3;
+    if (std::fabs(triangleArea - pathArea) > tolerance)
+    {
+        printf("  area %.3f, triangles cover %.3f\n", pathArea, triangleArea);
+        return false;
+    }
+
+    // Points right on an edge can go either way, so a handful of disagreements is allowed
+    unsigned int mismatches = 0u;
+    for (unsigned int i = 0u; i < samples; ++i)
+    {
+        float x = random.Next(left, right), y = random.Next(top, bottom);
+        if (InsidePath(path, x, y) != InsideTriangles(triangles, x, y)) ++mismatches;
+    }
+    if (mismatches > samples / 1000u)
+    {
+        printf("  %u of %u points disagree\n", mismatches, samples);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int runs = 5u;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--runs") == 0) runs = (unsigned int)atoi(argv[i + 1]);
+    }
+    if (runs == 0u) runs = 1u;
+
+    const Scene scenes[] =
+    {
+        { "stars", Stars }, { "holes", Holes }, { "curves", Curves }, { "tangled", Tangled }, { "large", Large }
+    };
+    printf("%-8s %7s %9s %9s %9s %9s %10s %s\n", "scene", "paths", "vertices", "bands", "regions", "triangles", "ms",
+        "Mvert/s");
+
+    int result = 0;
+    Tessellator tessellator;
+    for (const Scene& scene : scenes)
+    {
+        std::vector<PathData> paths;
+        scene.build(paths);
+        unsigned long long vertices = 0ull, bands = 0ull, regions = 0ull, triangles = 0ull;
+        for (const PathData& path : paths) vertices += path.GetPoints().size();
+
+        double best = 1e30;
+        for (unsigned int run = 0u; run < runs; ++run)
+        {
+            bands = regions = triangles = 0ull;
+            auto start = std::chrono::steady_clock::now();
+            for (const PathData& path : paths)
+            {
+                tessellator.Tessellate(path);
+                bands += tessellator.GetStats().bands;
+                regions += tessellator.GetStats().regions;
+                triangles += tessellator.GetStats().triangles;
+            }
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        printf("%-8s %7u %9llu %9llu %9llu %9llu %10.2f %.1f\n", scene.name, (unsigned int)paths.size(), vertices,
+            bands, regions, triangles, best * 1e3, vertices / best * 1e-6);
+
+        Random random = { 7u };
+        unsigned int failed = 0u;
+        for (size_t i = 0u; i < paths.size(); ++i)
+        {
+            tessellator.Tessellate(paths[i]);
+            Tessellator fresh;
+            fresh.Tessellate(paths[i]);
+            const std::vector<Tessellator::Triangle>& a = tessellator.GetTriangles();
+            const std::vector<Tessellator::Triangle>& b = fresh.GetTriangles();
+            bool same = a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(a[0])) == 0);
+            if (!same) printf("  path %u: a reused tessellator gave different triangles\n", (unsigned int)i);
+            if (!same || !Check(paths[i], a, random, paths.size() > 10u ? 200u : 2000u))
+            {
+                if (same) printf("  path %u: triangles don't match the path\n", (unsigned int)i);
+                ++failed;
+            }
+        }
+        if (failed)
+        {
+            printf("  %s: %u of %u paths FAILED\n", scene.name, failed, (unsigned int)paths.size());
+            result = 1;
+        }
+    }
+    return result;
+}
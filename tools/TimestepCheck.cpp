@@ -0,0 +1,175 @@
+// Drives Ice2D::FixedTimestep with a fake clock and checks the tick count, the catch-up clamp and the alpha.
+//
+//   TimestepCheck
+//
+// Every case feeds frame times the way Application::RunFrame() does: the time since the last frame, taken from a
+// clock that only moves when the case says so. No window or timer is involved, so the results are exact and the
+// same on every machine. The tool prints one line per case and exits with 1 when a check fails.
+#include "pch.h"
+
+#include "Timestep.h"
+#include <cmath>
+#include <cstdio>
+
+using namespace Ice2D;
+
+typedef std::chrono::high_resolution_clock::duration Duration;
+typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+static Duration Nanoseconds(long long count)
+{
+    return std::chrono::duration_cast<Duration>(std::chrono::nanoseconds(count));
+}
+
+// Stands in for the high resolution clock, RunFrame() only ever sees differences between two readings
+struct FakeClock
+{
+    TimePoint now;
+    void Advance(Duration elapsed) { now += elapsed; }
+};
+
+struct Frame
+{
+    FakeClock& clock;
+    FixedTimestep& timestep;
+    TimePoint last;
+    unsigned int Run(Duration frameTime)
+    {
+        clock.Advance(frameTime);
+        Duration elapsed = clock.now - last;
+        last = clock.now;
+        return timestep.Advance(elapsed);
+    }
+};
+
+static void SteadyRate()
+{
+    printf("steady 60 Hz frames at 60 Hz\n");
+    FakeClock clock = {};
+    FixedTimestep timestep(60u);
+    Frame frame = { clock, timestep, clock.now };
+    bool oneEach = true;
+    for (int i = 0; i < 600; ++i) oneEach &= frame.Run(Nanoseconds(16666667)) == 1u;
+    Expect(oneEach, "every frame runs exactly one tick");
+    Expect(timestep.GetTickCount() == 600ull, "600 frames run 600 ticks");
+    Expect(timestep.GetDroppedTicks() == 0ull, "no ticks are dropped");
+    Expect(timestep.GetAlpha() >= 0.0f && timestep.GetAlpha() < 0.01f, "the alpha stays near zero");
+}
+
+static void FastDisplay()
+{
+    // 100 Hz frames on a 25 Hz simulation tick on every fourth frame, the alpha climbs by a quarter in between
+    printf("100 Hz frames at 25 Hz\n");
+    FakeClock clock = {};
+    FixedTimestep timestep(25u);
+    Frame frame = { clock, timestep, clock.now };
+    const Duration frameTime = timestep.GetStep() / 4;
+    bool pattern = true, alpha = true;
+    for (int i = 1; i <= 400; ++i)
+    {
+        unsigned int steps = frame.Run(frameTime);
+        pattern &= steps == (i % 4 == 0 ? 1u : 0u);
+        alpha &= std::fabs(timestep.GetAlpha() - (i % 4) * 0.25f) < 1e-4f;
+    }
+    Expect(pattern, "a tick runs on every fourth frame");
+    Expect(alpha, "the alpha is 0, 0.25, 0.5, 0.75 between ticks");
+    Expect(timestep.GetTickCount() == 100ull, "400 frames run 100 ticks");
+}
+
+static void SlowDisplay()
+{
+    // 24 Hz frames on a 60 Hz tick alternate between 2 and 3 ticks, and the total never drifts
+    printf("24 Hz frames at 60 Hz\n");
+    FakeClock clock = {};
+    FixedTimestep timestep(60u);
+    Frame frame = { clock, timestep, clock.now };
+    const Duration frameTime = Nanoseconds(41666667);
+    bool range = true, alpha = true;
+    for (int i = 0; i < 2400; ++i)
+    {
+        unsigned int steps = frame.Run(frameTime);
+        range &= steps == 2u || steps == 3u;
+        alpha &= timestep.GetAlpha() >= 0.0f && timestep.GetAlpha() < 1.0f;
+    }
+    const unsigned long long expected = (unsigned long long)((clock.now.time_since_epoch()) / timestep.GetStep());
+    Expect(range, "every frame runs 2 or 3 ticks");
+    Expect(alpha, "the alpha stays in [0, 1)");
+    Expect(timestep.GetTickCount() == expected, "the tick count matches the elapsed time");
+}
+
+static void SpiralClamp()
+{
+    // A one second hitch would owe 60 ticks, only maxSteps run and the rest are dropped with the phase kept
+    printf("1 s hitch at 60 Hz, 5 catch-up ticks\n");
+    FakeClock clock = {};
+    FixedTimestep timestep(60u, 5u);
+    Frame frame = { clock, timestep, clock.now };
+    frame.Run(Nanoseconds(16666667));
+    const Duration hitch = timestep.GetStep() * 60 + timestep.GetStep() / 2;
+    unsigned int steps = frame.Run(hitch);
+    Expect(steps == 5u, "the hitch frame runs maxSteps ticks");
+    Expect(timestep.GetDroppedTicks() == 55ull, "the other 55 ticks are dropped");
+    Expect(std::fabs(timestep.GetAlpha() - 0.5f) < 1e-3f, "the half tick left over stays in the alpha");
+    steps = frame.Run(Nanoseconds(16666667));
+    Expect(steps == 1u, "the next frame is back to one tick");
+    Expect(timestep.GetTickCount() == 7ull, "1 + 5 + 1 ticks ran");
+
+    FixedTimestep unlimited(60u, 0u);
+    Expect(unlimited.Advance(hitch) == 60u, "maxSteps 0 catches up without a limit");
+    Expect(unlimited.GetDroppedTicks() == 0ull, "and drops nothing");
+}
+
+static void ClockGoingBack()
+{
+    printf("zero and negative frame times\n");
+    FixedTimestep timestep(60u);
+    timestep.Advance(timestep.GetStep() / 2);
+    Expect(timestep.Advance(Duration::zero()) == 0u, "a zero frame time runs nothing");
+    Expect(timestep.Advance(-timestep.GetStep() * 3) == 0u, "a negative frame time runs nothing");
+    Expect(std::fabs(timestep.GetAlpha() - 0.5f) < 1e-3f, "and doesn't eat into the accumulated time");
+    timestep.Reset();
+    Expect(timestep.GetAlpha() == 0.0f && timestep.GetTickCount() == 0ull, "Reset() clears the time and counts");
+}
+
+static void Settings()
+{
+    printf("tick rate changes\n");
+    FixedTimestep timestep(60u);
+    timestep.Advance(timestep.GetStep() / 2);
+    timestep.SetTickRate(120u);
+    Expect(timestep.GetAlpha() == 0.0f, "a new tick rate starts from a whole tick");
+    Expect(timestep.GetStep() == Nanoseconds(1000000000 / 120), "the step is one 120th of a second");
+    bool threw = false;
+    try
+    {
+        timestep.SetTickRate(0u);
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    Expect(threw, "a tick rate of zero throws");
+    Expect(timestep.GetTickRate() == 120u, "and keeps the old rate");
+}
+
+int main()
+{
+    SteadyRate();
+    FastDisplay();
+    SlowDisplay();
+    SpiralClamp();
+    ClockGoingBack();
+    Settings();
+    if (failures) printf("%d checks FAILED\n", failures);
+    else printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,303 @@
+// Drives Ice2D::VoiceAllocator through a stub backend and checks steal order, per-sound caps and stale generations.
+//
+//   VoiceCheck [--count n]
+//
+// The backend stands in for VoicePool and XAudio2: it keeps one fake voice per slot, starts and stops it the way
+// Play() does, and ends buffers by calling Release() with the generation the buffer was submitted with, like the
+// buffer-end callback. A stolen voice leaves its old buffer end behind, which has to be ignored. The last scene
+// acquires n voices (a million by default) while a second thread ends them, and reports the time per acquire.
+// The tool prints one line per scene and exits with 1 when a check fails.
+#include "pch.h"
+
+#include "VoiceAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Ice2D;
+
+static int failures = 0;
+
+static void Expect(bool condition, const char* what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what);
+    ++failures;
+}
+
+// Sounds are only compared by address, like the sample data VoicePool passes
+static const char soundA = 'a', soundB = 'b', soundC = 'c', soundD = 'd';
+
+struct StubBackend
+{
+    struct Voice
+    {
+        unsigned int format, generation;
+        const void* pSound;
+        bool playing;
+    };
+    struct BufferEnd
+    {
+        unsigned int slot, generation;
+    };
+    VoiceAllocator& allocator;
+    std::vector<Voice> voices;
+    std::vector<BufferEnd> stale;
+
+    // Returns the slot, or -1 when the allocator rejected the play
+    int Play(unsigned int format, const void* pSound, float volume = 1.0f)
+    {
+        VoiceAllocator::Allocation allocation;
+        if (!allocator.Acquire(format, pSound, volume, allocation)) return -1;
+        if (allocation.stopped >= 0)
+        {
+            // Stopping and flushing a voice still ends its buffer, with the generation it was submitted with
+            Voice& stopped = voices[allocation.stopped];
+            Expect(stopped.playing, "only a playing voice is stolen");
+            stopped.playing = false;
+            stale.push_back({ (unsigned int)allocation.stopped, stopped.generation });
+        }
+        if (allocation.created)
+        {
+            Expect(allocation.slot == voices.size(), "a created slot comes right after the existing ones");
+            voices.push_back({ format, 0u, nullptr, false });
+        }
+        Voice& voice = voices[allocation.slot];
+        Expect(voice.format == format, "the slot has the format that was asked for");
+        Expect(!voice.playing, "the slot handed out isn't playing");
+        voice = { format, allocation.generation, pSound, true };
+        return (int)allocation.slot;
+    }
+
+    bool End(unsigned int slot)
+    {
+        Voice& voice = voices[slot];
+        voice.playing = false;
+        return allocator.Release(slot, voice.generation);
+    }
+
+    bool EndStale()
+    {
+        // Every stale buffer end has to be rejected
+        bool rejected = true;
+        for (const BufferEnd& end : stale) rejected &= !allocator.Release(end.slot, end.generation);
+        stale.clear();
+        return rejected;
+    }
+
+    unsigned int Playing() const
+    {
+        unsigned int count = 0u;
+        for (const Voice& voice : voices) count += voice.playing ? 1u : 0u;
+        return count;
+    }
+};
+
+static void StealOldest()
+{
+    printf("oldest voice is stolen at the cap\n");
+    VoiceAllocator allocator(4u, VoiceAllocator::StealMode::Oldest);
+    StubBackend backend = { allocator, {}, {} };
+    for (int i = 0; i < 4; ++i) backend.Play(0u, &soundA + i);
+    Expect(allocator.GetActiveCount() == 4u && backend.voices.size() == 4u, "four voices play in four slots");
+    Expect(backend.Play(0u, &soundB) == 0, "the fifth play reuses the first slot");
+    Expect(backend.Play(0u, &soundB) == 1, "the sixth reuses the second");
+    Expect(allocator.GetActiveCount() == 4u && backend.Playing() == 4u, "the cap holds");
+    backend.End(2u);
+    Expect(backend.Play(0u, &soundC) == 2, "a free slot is used before stealing");
+    Expect(backend.Play(0u, &soundC) == 3, "then the oldest again");
+    Expect(backend.EndStale(), "buffer ends of stolen voices are ignored");
+    VoiceAllocator::Stats stats = allocator.GetStats();
+    Expect(stats.plays == 8ull && stats.steals == 3ull && stats.created == 4ull, "plays, steals and created add up");
+}
+
+static void StealQuietest()
+{
+    printf("quietest voice is stolen, the older one on a tie\n");
+    VoiceAllocator allocator(4u, VoiceAllocator::StealMode::Quietest);
+    StubBackend backend = { allocator, {}, {} };
+    const float volumes[4] = { 0.5f, 0.2f, 0.9f, 0.2f };
+    for (int i = 0; i < 4; ++i) backend.Play(0u, &soundA, volumes[i]);
+    Expect(backend.Play(0u, &soundB, 1.0f) == 1, "the quietest and oldest of the two at 0.2 goes first");
+    Expect(backend.Play(0u, &soundB, 1.0f) == 3, "then the other one at 0.2");
+    allocator.SetVolume(2u, 0.1f);
+    Expect(backend.Play(0u, &soundB, 1.0f) == 2, "SetVolume() changes the order");
+    Expect(backend.EndStale(), "buffer ends of stolen voices are ignored");
+}
+
+static void Formats()
+{
+    printf("a voice of the same format is preferred\n");
+    VoiceAllocator allocator(3u, VoiceAllocator::StealMode::Oldest);
+    StubBackend backend = { allocator, {}, {} };
+    backend.Play(0u, &soundA);
+    backend.Play(1u, &soundA);
+    backend.Play(1u, &soundA);
+    Expect(backend.Play(1u, &soundB) == 1, "the oldest voice of format 1 is reused, not the older format 0 one");
+    Expect(backend.Play(2u, &soundB) == 3, "no voice has format 2, so the oldest is stopped and a slot created");
+    Expect(!backend.voices[0].playing && allocator.GetActiveCount() == 3u, "the stopped voice made the room");
+    Expect(backend.Play(0u, &soundC) == 0, "the stopped format 0 slot is free for the next format 0 play");
+    Expect(allocator.GetSlotCount() == 4u && allocator.GetSlotFormat(3u) == 2u, "slots keep their format");
+    Expect(backend.EndStale(), "buffer ends of stolen voices are ignored");
+}
+
+static void Reject()
+{
+    printf("StealMode::None rejects at the cap\n");
+    VoiceAllocator allocator(2u, VoiceAllocator::StealMode::None);
+    StubBackend backend = { allocator, {}, {} };
+    backend.Play(0u, &soundA);
+    backend.Play(0u, &soundB);
+    Expect(backend.Play(0u, &soundC) < 0, "the third play is rejected");
+    Expect(backend.Playing() == 2u && backend.stale.empty(), "nothing was stopped");
+    allocator.SetSoundLimit(&soundA, 1u);
+    backend.End(1u);
+    Expect(backend.Play(0u, &soundA) < 0, "a sound at its own limit is rejected too");
+    Expect(allocator.GetStats().rejects == 2ull, "both rejects are counted");
+    allocator.SetMaxVoices(3u);
+    Expect(backend.Play(0u, &soundC) >= 0, "a higher cap lets it play");
+}
+
+static void SoundLimits()
+{
+    printf("per-sound limits steal from the same sound\n");
+    VoiceAllocator allocator(8u, VoiceAllocator::StealMode::Oldest);
+    StubBackend backend = { allocator, {}, {} };
+    allocator.SetSoundLimit(&soundA, 2u);
+    backend.Play(0u, &soundB);
+    backend.Play(0u, &soundA);
+    backend.Play(0u, &soundA);
+    Expect(backend.Play(0u, &soundA) == 1, "a third A replaces the oldest A, not the older B");
+    Expect(allocator.GetActiveCount(&soundA) == 2u && allocator.GetActiveCount(&soundB) == 1u, "A stays at 2");
+
+    allocator.SetDefaultSoundLimit(1u);
+    backend.Play(0u, &soundC);
+    Expect(backend.Play(0u, &soundC) == 3 && allocator.GetActiveCount(&soundC) == 1u, "the default applies to C");
+    Expect(backend.Play(0u, &soundA) >= 0 && allocator.GetActiveCount(&soundA) == 2u, "A keeps its own limit");
+
+    allocator.ClearSoundLimit(&soundA);
+    backend.Play(0u, &soundA);
+    Expect(allocator.GetActiveCount(&soundA) == 2u, "a cleared limit falls back to the default, A stays at 2");
+    allocator.SetDefaultSoundLimit(0u);
+    backend.Play(0u, &soundA);
+    backend.Play(0u, &soundA);
+    Expect(allocator.GetActiveCount(&soundA) == 4u, "a default of 0 means no limit");
+    Expect(backend.EndStale(), "buffer ends of stolen voices are ignored");
+
+    for (unsigned int i = 0u; i < backend.voices.size(); ++i)
+    {
+        if (backend.voices[i].playing) Expect(backend.End(i), "a current buffer end releases its voice");
+    }
+    Expect(allocator.GetActiveCount() == 0u, "everything ended");
+    Expect(allocator.GetActiveCount(&soundA) == 0u && allocator.GetActiveCount(&soundB) == 0u &&
+        allocator.GetActiveCount(&soundC) == 0u, "no sound has a count left");
+}
+
+static void Generations()
+{
+    printf("stale and repeated releases are ignored\n");
+    VoiceAllocator allocator(1u, VoiceAllocator::StealMode::Oldest);
+    StubBackend backend = { allocator, {}, {} };
+    backend.Play(0u, &soundA);
+    const unsigned int first = backend.voices[0].generation;
+    backend.Play(0u, &soundB);
+    Expect(backend.voices[0].generation == first + 1u, "a steal hands the slot out with a new generation");
+    Expect(!allocator.Release(0u, first), "the stolen voice's buffer end doesn't release the new one");
+    Expect(allocator.GetActiveCount() == 1u && allocator.GetActiveCount(&soundB) == 1u, "the new voice plays on");
+    Expect(allocator.GetActiveCount(&soundA) == 0u, "the stolen sound isn't counted anymore");
+    backend.stale.clear();
+    Expect(backend.End(0u), "the current buffer end releases it");
+    Expect(!allocator.Release(0u, backend.voices[0].generation), "releasing twice does nothing");
+    Expect(!allocator.Release(5u, 1u), "an unknown slot does nothing");
+    Expect(allocator.GetActiveCount() == 0u, "the count never goes below zero");
+
+    backend.Play(0u, &soundC);
+    const unsigned int last = backend.voices[0].generation;
+    // StopAll() stops every voice, then releases them all at once
+    for (StubBackend::Voice& voice : backend.voices) voice.playing = false;
+    allocator.ReleaseAll();
+    Expect(allocator.GetActiveCount() == 0u && !allocator.Release(0u, last), "ReleaseAll() ends everything");
+    Expect(backend.Play(0u, &soundD) == 0 && backend.voices[0].generation == last + 1u, "and the slot is reused");
+}
+
+static void Threads(unsigned int count)
+{
+    // Acquires on this thread, buffer ends from another one, like XAudio2's callback thread
+    printf("%u acquires against a releasing thread\n", count);
+    VoiceAllocator allocator(32u, VoiceAllocator::StealMode::Oldest);
+    for (unsigned int i = 0u; i < 32u; ++i) allocator.AddSlot(i % 2u);
+    std::mutex mutex;
+    std::vector<VoiceAllocator::Allocation> ends;
+    std::atomic<bool> done(false);
+    std::atomic<unsigned long long> released(0ull);
+    std::thread ender([&]
+    {
+        std::vector<VoiceAllocator::Allocation> batch;
+        while (!done.load())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch.swap(ends);
+            }
+            for (const VoiceAllocator::Allocation& a : batch) released += allocator.Release(a.slot, a.generation);
+            batch.clear();
+            std::this_thread::yield();
+        }
+    });
+
+    static const char sounds[8] = {};
+    unsigned long long acquired = 0ull;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0u; i < count; ++i)
+    {
+        VoiceAllocator::Allocation allocation;
+        if (!allocator.Acquire(i % 2u, &sounds[i % 8u], (float)(i % 7u), allocation)) continue;
+        ++acquired;
+        if (i % 3u != 0u)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ends.push_back(allocation);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    done = true;
+    ender.join();
+
+    VoiceAllocator::Stats stats = allocator.GetStats();
+    printf("  %.0f ns per acquire, %llu steals, %llu released\n", seconds * 1e9 / count, stats.steals,
+        released.load());
+    Expect(acquired == count && stats.plays == count, "every acquire succeeds while stealing");
+    Expect(allocator.GetActiveCount() <= 32u, "the cap holds");
+    Expect(allocator.GetSlotCount() == 32u + stats.created, "slots are only added when the caller creates a voice");
+    unsigned int perSound = 0u;
+    for (const char& sound : sounds) perSound += allocator.GetActiveCount(&sound);
+    Expect(perSound == allocator.GetActiveCount(), "the per-sound counts add up to the active count");
+    allocator.ReleaseAll();
+    Expect(allocator.GetActiveCount() == 0u && allocator.GetActiveCount(&sounds[0]) == 0u, "ReleaseAll() ends all");
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int count = 1000000u;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--count") == 0) count = (unsigned int)atoi(argv[i + 1]);
+    }
+
+    StealOldest();
+    StealQuietest();
+    Formats();
+    Reject();
+    SoundLimits();
+    Generations();
+    Threads(count);
+    if (failures) printf("%d checks FAILED\n", failures);
+    else printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
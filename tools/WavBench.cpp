@@ -0,0 +1,437 @@
+// Checks Ice2D::WavParser on generated files, times it, and fuzzes it with mutated files.
+//
+//   WavBench [--runs n]
+//   WavBench --fuzz [iterations] [--seed n]
+//
+// The files are generated: every supported format, WAVE_FORMAT_EXTENSIBLE, extra and odd sized chunks, a data
+// chunk cut short, and files that have to be rejected for each reason Parse() knows. Without --fuzz, every file is
+// checked against what it should parse to, and the parse is timed for a one second clip, a ten minute track and a
+// file with a thousand chunks before the data. With --fuzz, the files are mutated (bit flips, size fields set to
+// edge values, truncation, spliced and removed ranges) and parsed from buffers of the exact size, so a sanitizer
+// build catches any read past the end. Every accepted file has to give a format and a sample range inside the
+// buffer, in whole frames. The tool exits with 1 when a check fails.
+#include "pch.h"
+
+#include "WavParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Ice2D;
+
+typedef std::vector<unsigned char> Bytes;
+
+struct Random
+{
+    uint32_t seed;
+    uint32_t Next()
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    }
+    uint32_t Next(uint32_t count)
+    {
+        return count ? Next() % count : 0u;
+    }
+};
+
+class WavWriter
+{
+public:
+    Bytes bytes;
+    void U8(uint8_t v) { bytes.push_back(v); }
+    void U16(uint16_t v) { U8((uint8_t)v); U8((uint8_t)(v >> 8)); }
+    void U32(uint32_t v) { U16((uint16_t)v); U16((uint16_t)(v >> 16)); }
+    void Tag(const char* id) { bytes.insert(bytes.end(), id, id + 4); }
+    size_t Begin(const char* id)
+    {
+        Tag(id);
+        U32(0u);
+        return bytes.size();
+    }
+    void End(size_t start)
+    {
+        // Writes the size and the pad byte that keeps the next chunk word aligned
+        Patch(start - 4u, (uint32_t)(bytes.size() - start));
+        if ((bytes.size() - start) & 1u) U8(0u);
+    }
+    void Patch(size_t offset, uint32_t v)
+    {
+        for (unsigned int i = 0u; i < 4u; ++i) bytes[offset + i] = (unsigned char)(v >> (i * 8u));
+    }
+};
+
+struct Format
+{
+    uint16_t tag, channels;
+    uint32_t rate;
+    uint16_t bits;
+    bool extensible;
+    uint16_t validBits;
+};
+
+static const unsigned char SUBFORMAT_TAIL[14] =
+    { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+static void WriteFormat(WavWriter& w, const Format& f, uint16_t blockAlign)
+{
+    size_t fmt = w.Begin("fmt ");
+    w.U16(f.extensible ? WavParser::FORMAT_EXTENSIBLE : f.tag);
+    w.U16(f.channels);
+    w.U32(f.rate);
+    w.U32(f.rate * blockAlign);
+    w.U16(blockAlign);
+    w.U16(f.bits);
+    if (f.extensible)
+    {
+        w.U16(22u);
+        w.U16(f.validBits);
+        w.U32(f.channels == 2u ? 3u : 4u);
+        w.U16(f.tag);
+        w.bytes.insert(w.bytes.end(), SUBFORMAT_TAIL, SUBFORMAT_TAIL + sizeof(SUBFORMAT_TAIL));
+    }
+    w.End(fmt);
+}
+
+struct Options
+{
+    uint32_t frames;
+    unsigned int chunksBefore;
+    bool oddChunk, truncate;
+    int blockAlignError;
+};
+
+static Bytes MakeWav(const Format& f, const Options& o)
+{
+    WavWriter w;
+    w.Tag("RIFF");
+    w.U32(0u);
+    w.Tag("WAVE");
+    const uint16_t blockAlign = (uint16_t)(f.channels * f.bits / 8u + o.blockAlignError);
+
+    // Chunks the parser has to step over, some before the format like many editors write them
+    for (unsigned int i = 0u; i < o.chunksBefore; ++i)
+    {
+        size_t list = w.Begin("LIST");
+        w.Tag("INFO");
+        for (unsigned int j = 0u; j < i % 5u; ++j) w.U8((uint8_t)j);
+        w.End(list);
+    }
+    WriteFormat(w, f, blockAlign);
+    if (o.oddChunk)
+    {
+        size_t junk = w.Begin("junk");
+        w.U8(1u);
+        w.U8(2u);
+        w.U8(3u);
+        w.End(junk);
+    }
+    size_t data = w.Begin("data");
+    const size_t dataSize = (size_t)o.frames * blockAlign;
+    for (size_t i = 0u; i < dataSize; ++i) w.U8((uint8_t)(i * 7u));
+    w.End(data);
+    if (o.truncate)
+    {
+        // The data chunk claims more than the file has, like a download or a recording cut short
+        w.Patch(data - 4u, (uint32_t)(dataSize + 1000u));
+        w.bytes.resize(data + dataSize);
+    }
+    w.Patch(4u, (uint32_t)(w.bytes.size() - 8u));
+    return w.bytes;
+}
+
+static int failures = 0;
+
+static void Expect(bool condition, const std::string& what)
+{
+    if (condition) return;
+    printf("  FAILED: %s\n", what.c_str());
+    ++failures;
+}
+
+// Everything an accepted file promises to the caller
+static bool Consistent(const unsigned char* p, size_t size, const WavParser::Info& info)
+{
+    const unsigned char* end = p + size;
+    if (!info.pFormat || info.pFormat < p || info.formatSize > (size_t)(end - info.pFormat)) return false;
+    if (!info.pSamples || info.pSamples < p || info.size > (size_t)(end - info.pSamples)) return false;
+    if (info.channels == 0u || info.sampleRate == 0u || info.blockAlign == 0u) return false;
+    if (info.blockAlign != info.channels * info.bitsPerSample / 8u) return false;
+    if (info.size % info.blockAlign != 0u || info.frameCount != info.size / info.blockAlign) return false;
+    if (info.validBitsPerSample == 0u || info.validBitsPerSample > info.bitsPerSample) return false;
+    if (info.sampleType == WavParser::SampleType::Float) return info.bitsPerSample == 32u;
+    return info.bitsPerSample == 8u || info.bitsPerSample == 16u || info.bitsPerSample == 24u ||
+        info.bitsPerSample == 32u;
+}
+
+static bool ChunksInBounds(const unsigned char* p, size_t size)
+{
+    WavParser parser(p, size);
+    WavParser::Chunk chunk;
+    while (parser.Next(chunk))
+    {
+        if (chunk.pData < p || chunk.size > (size_t)(p + size - chunk.pData)) return false;
+    }
+    return true;
+}
+
+struct Case
+{
+    const char* name;
+    Bytes bytes;
+    WavParser::Result expected;
+    uint32_t frames;
+};
+
+static std::vector<Case> MakeCases()
+{
+    const Options plain = { 1000u, 0u, false, false, 0 };
+    Options extras = plain;
+    extras.chunksBefore = 3u;
+    extras.oddChunk = true;
+    Options odd = plain;
+    odd.frames = 1001u;
+    Options truncated = plain;
+    truncated.truncate = true;
+    Options badAlign = plain;
+    badAlign.blockAlignError = 1;
+
+    std::vector<Case> cases;
+    cases.push_back({ "pcm 8 mono", MakeWav({ 1u, 1u, 22050u, 8u, false, 8u }, odd), WavParser::Result::Ok, 1001u });
+    cases.push_back({ "pcm 16 stereo", MakeWav({ 1u, 2u, 44100u, 16u, false, 16u }, plain), WavParser::Result::Ok,
+        1000u });
+    cases.push_back({ "pcm 24 stereo", MakeWav({ 1u, 2u, 48000u, 24u, false, 24u }, extras), WavParser::Result::Ok,
+        1000u });
+    cases.push_back({ "pcm 32 5.1", MakeWav({ 1u, 6u, 48000u, 32u, false, 32u }, plain), WavParser::Result::Ok,
+        1000u });
+    cases.push_back({ "float 32", MakeWav({ 3u, 2u, 48000u, 32u, false, 32u }, extras), WavParser::Result::Ok,
+        1000u });
+    cases.push_back({ "ext pcm 24/20", MakeWav({ 1u, 2u, 96000u, 24u, true, 20u }, extras), WavParser::Result::Ok,
+        1000u });
+    cases.push_back({ "ext float", MakeWav({ 3u, 2u, 48000u, 32u, true, 32u }, plain), WavParser::Result::Ok,
+        1000u });
+    cases.push_back({ "cut short", MakeWav({ 1u, 2u, 44100u, 16u, false, 16u }, truncated), WavParser::Result::Ok,
+        1000u });
+
+    Bytes notRiff = cases[1].bytes;
+    memcpy(notRiff.data(), "RIFX", 4u);
+    cases.push_back({ "not riff", notRiff, WavParser::Result::NotRiff, 0u });
+    Bytes notWave = cases[1].bytes;
+    memcpy(notWave.data() + 8u, "AVI ", 4u);
+    cases.push_back({ "not wave", notWave, WavParser::Result::NotWave, 0u });
+    Bytes noFormat = cases[1].bytes;
+    memcpy(noFormat.data() + 12u, "fmtX", 4u);
+    cases.push_back({ "no fmt", noFormat, WavParser::Result::MissingFormat, 0u });
+    Bytes noData = cases[1].bytes;
+    memcpy(noData.data() + 36u, "dat4", 4u);
+    cases.push_back({ "no data", noData, WavParser::Result::MissingData, 0u });
+    Bytes shortFormat = cases[1].bytes;
+    shortFormat[16] = 14u;
+    cases.push_back({ "short fmt", shortFormat, WavParser::Result::BadFormat, 0u });
+    cases.push_back({ "block align", MakeWav({ 1u, 2u, 44100u, 16u, false, 16u }, badAlign),
+        WavParser::Result::BadFormat, 0u });
+    cases.push_back({ "no channels", MakeWav({ 1u, 0u, 44100u, 16u, false, 16u }, plain),
+        WavParser::Result::BadFormat, 0u });
+    cases.push_back({ "adpcm", MakeWav({ 2u, 1u, 44100u, 4u, false, 4u }, plain), WavParser::Result::Unsupported,
+        0u });
+    cases.push_back({ "pcm 12", MakeWav({ 1u, 1u, 44100u, 12u, false, 12u }, plain), WavParser::Result::Unsupported,
+        0u });
+    cases.push_back({ "float 64", MakeWav({ 3u, 1u, 44100u, 64u, false, 64u }, plain), WavParser::Result::Unsupported,
+        0u });
+    Bytes badGuid = cases[6].bytes;
+    badGuid[20u + 26u + 13u] ^= 0xFFu;
+    cases.push_back({ "ext guid", badGuid, WavParser::Result::Unsupported, 0u });
+    Bytes cutList = MakeWav({ 1u, 2u, 44100u, 16u, false, 16u }, extras);
+    cutList.resize(20u);
+    cases.push_back({ "cut list", cutList, WavParser::Result::Truncated, 0u });
+    return cases;
+}
+
+static void Check(const std::vector<Case>& cases)
+{
+    printf("%-14s %-22s %s\n", "file", "result", "frames");
+    for (const Case& c : cases)
+    {
+        WavParser::Info info;
+        WavParser::Result result = WavParser::Parse(c.bytes.data(), c.bytes.size(), info);
+        printf("%-14s %-22s %u%s\n", c.name, WavParser::GetResultName(result), info.frameCount,
+            info.truncated ? " (truncated)" : "");
+        Expect(result == c.expected, std::string(c.name) + ": expected " + WavParser::GetResultName(c.expected));
+        if (result != WavParser::Result::Ok) continue;
+        Expect(Consistent(c.bytes.data(), c.bytes.size(), info), std::string(c.name) + ": inconsistent info");
+        Expect(info.frameCount == c.frames, std::string(c.name) + ": wrong frame count");
+    }
+}
+
+template<typename F>
+static double Best(unsigned int runs, F&& body)
+{
+    double best = 1e30;
+    for (unsigned int run = 0u; run < runs; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+static void Bench(unsigned int runs)
+{
+    Options second = { 44100u, 1u, true, false, 0 };
+    Options track = { 48000u * 600u, 1u, true, false, 0 };
+    Options chunks = { 44100u, 1000u, false, false, 0 };
+    struct Timed
+    {
+        const char* name;
+        Bytes bytes;
+        unsigned int iterations;
+    };
+    Timed timed[] =
+    {
+        { "1 s clip", MakeWav({ 1u, 2u, 44100u, 16u, false, 16u }, second), 1000000u },
+        { "10 min track", MakeWav({ 1u, 2u, 48000u, 16u, false, 16u }, track), 1000000u },
+        { "1000 chunks", MakeWav({ 1u, 2u, 44100u, 16u, false, 16u }, chunks), 20000u }
+    };
+
+    printf("\n%-14s %12s %12s %12s\n", "file", "bytes", "ns/parse", "chunks/us");
+    for (const Timed& t : timed)
+    {
+        unsigned long long frames = 0ull;
+        unsigned int chunkCount = 0u;
+        WavParser parser(t.bytes.data(), t.bytes.size());
+        WavParser::Chunk chunk;
+        while (parser.Next(chunk)) ++chunkCount;
+        double seconds = Best(runs, [&]
+        {
+            for (unsigned int i = 0u; i < t.iterations; ++i)
+            {
+                WavParser::Info info;
+                WavParser::Parse(t.bytes.data(), t.bytes.size(), info);
+                frames += info.frameCount;
+            }
+        });
+        const double perParse = seconds / t.iterations;
+        printf("%-14s %12zu %12.1f %12.1f\n", t.name, t.bytes.size(), perParse * 1e9, chunkCount / perParse * 1e-6);
+        Expect(frames > 0ull, std::string(t.name) + ": no frames");
+    }
+}
+
+static void Mutate(Bytes& bytes, Random& random)
+{
+    const unsigned int mutations = 1u + random.Next(8u);
+    for (unsigned int m = 0u; m < mutations; ++m)
+    {
+        const size_t size = bytes.size();
+        switch (random.Next(7u))
+        {
+        case 0:
+            if (size) bytes[random.Next((uint32_t)size)] ^= (unsigned char)(1u << random.Next(8u));
+            break;
+        case 1:
+            if (size) bytes[random.Next((uint32_t)size)] = (unsigned char)random.Next(256u);
+            break;
+        case 2:
+        {
+            // Size fields and format words are where the interesting values are
+            static const uint32_t values[] = { 0u, 1u, 2u, 3u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFEu, 0xFFFFFFFFu,
+                0xFFFFu, 0x10000u, 22u, 40u };
+            if (size < 4u) break;
+            size_t offset = random.Next((uint32_t)(size - 3u)) & ~(size_t)1u;
+            uint32_t v = values[random.Next(sizeof(values) / sizeof(values[0]))];
+            for (unsigned int i = 0u; i < 4u && offset + i < size; ++i) bytes[offset + i] = (unsigned char)(v >> (i * 8u));
+            break;
+        }
+        case 3:
+            bytes.resize(random.Next((uint32_t)size + 1u));
+            break;
+        case 4:
+        {
+            // Repeat a range somewhere else, which makes duplicate and overlapping chunks
+            if (!size) break;
+            size_t from = random.Next((uint32_t)size), length = random.Next((uint32_t)std::min<size_t>(size - from, 64u)) + 1u;
+            Bytes slice(bytes.begin() + from, bytes.begin() + from + std::min(length, size - from));
+            bytes.insert(bytes.begin() + random.Next((uint32_t)size + 1u), slice.begin(), slice.end());
+            break;
+        }
+        case 5:
+        {
+            if (!size) break;
+            size_t from = random.Next((uint32_t)size), length = random.Next((uint32_t)(size - from)) + 1u;
+            bytes.erase(bytes.begin() + from, bytes.begin() + from + std::min(length, size - from));
+            break;
+        }
+        default:
+            if (size >= 12u) bytes[12u + random.Next((uint32_t)(size - 12u))] = (unsigned char)random.Next(256u);
+            break;
+        }
+    }
+}
+
+static void Fuzz(const std::vector<Case>& cases, unsigned int iterations, uint32_t seed)
+{
+    // Small files only, the mutations are spread over every byte
+    std::vector<Bytes> seeds;
+    for (const Case& c : cases)
+    {
+        if (c.bytes.size() <= 8192u) seeds.push_back(c.bytes);
+    }
+    Random random = { seed };
+    std::map<std::string, unsigned int> results;
+    unsigned int bad = 0u;
+    for (unsigned int i = 0u; i < iterations; ++i)
+    {
+        Bytes bytes = seeds[random.Next((uint32_t)seeds.size())];
+        Mutate(bytes, random);
+
+        // Exactly as large as the file, so a sanitizer sees any read past the end
+        std::unique_ptr<unsigned char[]> exact(new unsigned char[bytes.size() ? bytes.size() : 1u]);
+        if (!bytes.empty()) memcpy(exact.get(), bytes.data(), bytes.size());
+        WavParser::Info info;
+        WavParser::Result result = WavParser::Parse(exact.get(), bytes.size(), info);
+        ++results[WavParser::GetResultName(result)];
+        bool ok = ChunksInBounds(exact.get(), bytes.size());
+        if (result == WavParser::Result::Ok) ok &= Consistent(exact.get(), bytes.size(), info);
+        if (!ok && bad++ < 10u) printf("  iteration %u: accepted span is out of bounds or not whole frames\n", i);
+    }
+    printf("%u mutated files, seed %u\n", iterations, seed);
+    for (const auto& entry : results) printf("  %-22s %u\n", entry.first.c_str(), entry.second);
+    Expect(bad == 0u, std::to_string(bad) + " mutated files broke the parser's promises");
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int runs = 5u, iterations = 300000u;
+    uint32_t seed = 1u;
+    bool fuzz = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--fuzz") == 0)
+        {
+            fuzz = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') iterations = (unsigned int)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) runs = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    }
+    if (runs == 0u) runs = 1u;
+
+    const std::vector<Case> cases = MakeCases();
+    if (fuzz)
+    {
+        Fuzz(cases, iterations, seed);
+    }
+    else
+    {
+        Check(cases);
+        Bench(runs);
+    }
+    if (failures) printf("%d checks FAILED\n", failures);
+    return failures ? 1 : 0;
+}